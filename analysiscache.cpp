@@ -0,0 +1,54 @@
+// ============================================================================
+// analysiscache.cpp - Implementation of the Analysis Cache
+// ============================================================================
+
+#include "analysiscache.h"
+
+#include <QCryptographicHash>    // SHA-1 of path + size + mtime = cache key.
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>             // Write to a temp file, rename when complete.
+#include <QStandardPaths>
+
+namespace AnalysisCache {
+
+QString cacheFile(const QString &mediaPath, const QString &kind) {
+    QFileInfo info(mediaPath);
+    if (!info.isFile()) return QString();
+
+    QByteArray identity = info.absoluteFilePath().toUtf8();
+    identity += '\n';
+    identity += QByteArray::number(info.size());
+    identity += '\n';
+    identity += QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    QString key = QString::fromLatin1(QCryptographicHash::hash(identity, QCryptographicHash::Sha1).toHex());
+
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/analysis";
+    if (!QDir().mkpath(dir)) return QString();
+
+    return dir + "/" + key + "." + kind;
+}
+
+bool load(const QString &mediaPath, const QString &kind, QByteArray &data) {
+    QString path = cacheFile(mediaPath, kind);
+    if (path.isEmpty()) return false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    data = file.readAll();
+    return true;
+}
+
+bool save(const QString &mediaPath, const QString &kind, const QByteArray &data) {
+    QString path = cacheFile(mediaPath, kind);
+    if (path.isEmpty()) return false;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(data);
+    return file.commit();
+}
+
+} // namespace AnalysisCache
@@ -0,0 +1,38 @@
+// ============================================================================
+// analysiscache.h - On-Disk Cache for Per-File Analysis Results
+// ============================================================================
+// Scanning a two-hour movie takes a while, and the same files tend to be
+// opened again and again. Results are therefore stored in the user's cache
+// directory, one file per media file and kind of analysis:
+//
+//     <cache>/analysis/<key>.<kind>        e.g. 3f2a...c1.loudness
+//
+// The key is a hash of the media file's absolute path, size and
+// modification time, so replacing or editing a file invalidates its entries
+// automatically. Only local files can be cached; for anything else the
+// functions below return an empty path / false.
+//
+// The cache doesn't look inside the data - every analyzer chooses its own
+// format (and should include a version number in it).
+// ============================================================================
+
+#ifndef ANALYSISCACHE_H
+#define ANALYSISCACHE_H
+
+#include <QString>
+#include <QByteArray>
+
+namespace AnalysisCache {
+
+// Path of the cache file for `mediaPath` and `kind`, or an empty string if
+// the media isn't a local file. The directory is created if needed.
+QString cacheFile(const QString &mediaPath, const QString &kind);
+
+// Read / write a whole entry. save() replaces the file atomically, so a
+// crash mid-write never leaves a half-written entry behind.
+bool load(const QString &mediaPath, const QString &kind, QByteArray &data);
+bool save(const QString &mediaPath, const QString &kind, const QByteArray &data);
+
+} // namespace AnalysisCache
+
+#endif // ANALYSISCACHE_H
@@ -0,0 +1,199 @@
+// ============================================================================
+// audioducker.cpp - Implementation of AudioDucker
+// ============================================================================
+
+#include "audioducker.h"
+#include "mpvwidget.h"           // MpvWidget
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QTimer>
+
+#include <cmath>                 // std::exp
+
+namespace {
+
+// Measures only what the envelope needs: the overall RMS of each frame,
+// reset after every frame so the value describes that frame alone.
+const char *TapFilter =
+    "@wa-duck:lavfi=[astats=metadata=1:reset=1:measure_perchannel=none:measure_overall=RMS_level]";
+
+// FFmpeg before 4.4 has no measure_* options; it measures everything,
+// which costs a little more but gives the same key.
+const char *TapFilterFallback = "@wa-duck:lavfi=[astats=metadata=1:reset=1]";
+
+const char *GainFilter = "@wa-duckgain:lavfi-volume=volume=0dB";
+
+const char *LevelKey = "lavfi.astats.Overall.RMS_level";
+
+const double Silence = -120.0;   // dBFS; what astats reports as "-inf".
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Worker - The Analysis Thread
+// ----------------------------------------------------------------------------
+// Talks to the players through MpvWidget's raw access, which only forwards
+// to the backends: those calls are safe from any thread (libmpv locks
+// internally), unlike the widgets' other methods.
+// ----------------------------------------------------------------------------
+class AudioDucker::Worker : public QThread {
+public:
+    Worker(AudioDucker *owner, MpvWidget *source, MpvWidget *target)
+        : owner(owner), source(source), target(target), stopping(false),
+          level(Silence), gain(0.0) {}
+
+    void stop() { stopping = true; }
+
+    std::atomic<double> &currentLevel() { return level; }
+    std::atomic<double> &currentGain() { return gain; }
+
+protected:
+    void run() override;
+
+private:
+    double readLevel();
+    void sendGain(double dB);
+
+    AudioDucker *owner;
+    MpvWidget *source;
+    MpvWidget *target;
+    std::atomic<bool> stopping;
+    std::atomic<double> level;
+    std::atomic<double> gain;
+};
+
+// One tick: read the newest frame's level, update the voice state and the
+// smoothed gain, send the gain if it moved by a noticeable step. The time
+// constants use the real time since the last tick, since sleeping is never
+// exact.
+void AudioDucker::Worker::run() {
+    QElapsedTimer clock;
+    clock.start();
+    qint64 lastNs = clock.nsecsElapsed();
+    qint64 voiceUntilMs = -1;
+    double smoothed = 0.0;
+    double sent = 0.0;
+
+    while (!stopping) {
+        QThread::msleep(PollMs);
+
+        qint64 nowNs = clock.nsecsElapsed();
+        double dt = (nowNs - lastNs) / 1e9;
+        lastNs = nowNs;
+
+        double dB = readLevel();
+        level = dB;
+        if (dB >= owner->threshold) voiceUntilMs = nowNs / 1000000 + HoldMs;
+        bool voice = nowNs / 1000000 < voiceUntilMs;
+
+        double goal = voice ? -owner->depth : 0.0;
+        double tau = (goal < smoothed ? owner->attackMs : owner->releaseMs) / 1000.0;
+        smoothed += (goal - smoothed) * (tau > 0.0 ? 1.0 - std::exp(-dt / tau) : 1.0);
+        if (qAbs(goal - smoothed) < 0.05) smoothed = goal;   // Land exactly.
+        gain = smoothed;
+
+        // 0.1 dB steps are inaudible; at rest nothing is sent at all.
+        if (qAbs(smoothed - sent) >= 0.1 || (smoothed == goal && smoothed != sent)) {
+            sendGain(smoothed);
+            sent = smoothed;
+        }
+    }
+}
+
+// While paused or between files the metadata keeps the last frame's value;
+// that's harmless - the movie isn't playing either.
+double AudioDucker::Worker::readLevel() {
+    QVariant metadata;
+    if (source->getNode("af-metadata/wa-duck", &metadata) < 0) return Silence;
+
+    bool ok = false;
+    double dB = metadata.toMap().value(LevelKey).toDouble(&ok);
+    return ok ? qMax(Silence, dB) : Silence;
+}
+
+void AudioDucker::Worker::sendGain(double dB) {
+    QByteArray value = QString("%1dB").arg(dB, 0, 'f', 2).toUtf8();
+    const char *cmd[] = {"af-command", "wa-duckgain", "volume", value.constData(), NULL};
+    target->command(cmd);
+}
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+AudioDucker::AudioDucker(MpvWidget *source, MpvWidget *target, QObject *parent)
+    : QObject(parent), source(source), target(target), worker(nullptr),
+      threshold(-40.0), depth(12.0), attackMs(30), releaseMs(600) {
+
+    displayTimer = new QTimer(this);
+    displayTimer->setInterval(DisplayIntervalMs);
+    connect(displayTimer, &QTimer::timeout, this, &AudioDucker::report);
+}
+
+AudioDucker::~AudioDucker() {
+    setEnabled(false);
+}
+
+// ----------------------------------------------------------------------------
+// setEnabled() - Insert the Filters and Start the Thread, or Undo It All
+// ----------------------------------------------------------------------------
+void AudioDucker::setEnabled(bool on) {
+    if (on == isEnabled()) return;
+
+    if (!on) {
+        displayTimer->stop();
+        worker->stop();
+        worker->wait();
+        delete worker;
+        worker = nullptr;
+
+        const char *removeTap[] = {"af", "remove", "@wa-duck", NULL};
+        const char *removeGain[] = {"af", "remove", "@wa-duckgain", NULL};
+        source->command(removeTap);
+        target->command(removeGain);
+        emit levelChanged(Silence, 0.0);
+        return;
+    }
+
+    if (!source->isReady() || !target->isReady()) return;
+
+    const char *addTap[] = {"af", "add", TapFilter, NULL};
+    if (source->command(addTap) < 0) {
+        const char *addFallback[] = {"af", "add", TapFilterFallback, NULL};
+        source->command(addFallback);
+    }
+    const char *addGain[] = {"af", "add", GainFilter, NULL};
+    target->command(addGain);
+
+    worker = new Worker(this, source, target);
+    worker->setObjectName("Audio ducker");
+    worker->start(QThread::TimeCriticalPriority);
+    displayTimer->start();
+}
+
+bool AudioDucker::isEnabled() const {
+    return worker != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// Parameters
+// ----------------------------------------------------------------------------
+void AudioDucker::setThreshold(double dBFS) {
+    threshold = dBFS;
+}
+
+void AudioDucker::setDepth(double dB) {
+    depth = qMax(0.0, dB);
+}
+
+void AudioDucker::setAttack(int ms) {
+    attackMs = qMax(0, ms);
+}
+
+void AudioDucker::setRelease(int ms) {
+    releaseMs = qMax(0, ms);
+}
+
+void AudioDucker::report() {
+    if (worker) emit levelChanged(worker->currentLevel(), worker->currentGain());
+}
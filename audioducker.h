@@ -0,0 +1,89 @@
+// ============================================================================
+// audioducker.h - Duck One Player Under the Other's Voice
+// ============================================================================
+// During a watchalong the commentary (player 2) should win over the movie
+// (player 1): whenever the streamer talks, the movie gets quieter, and it
+// comes back up when they stop. That's "sidechain ducking" - the level of
+// one signal (the sidechain) controls the gain of another.
+//
+// The sidechain is tapped inside player 2's own audio chain: a labelled
+// libavfilter "astats" filter (@wa-duck) measures the RMS level of every
+// audio frame (about 20 ms of sound) and attaches it to the frame as
+// metadata, which MPV exposes as the "af-metadata/wa-duck" property. The
+// frames are measured when they're filtered, before they sit in the audio
+// output's buffer, so the level is known a little BEFORE it is heard.
+//
+// A dedicated analysis thread reads that property every PollMs and runs
+// the envelope:
+//   - the voice is "on" while the level is above the threshold, and stays
+//     on for HoldMs after it drops (the gaps between words)
+//   - the gain moves towards -depth (voice on) or 0 dB (voice off) with a
+//     one-pole smoother: time constant "attack" going down, "release"
+//     coming back up
+// and sends the gain straight to player 1's own labelled volume filter
+// (@wa-duckgain) with "af-command" - a runtime parameter change, so the
+// audio chain is never rebuilt and nothing clicks. The polling adds at
+// most PollMs of delay; each tick is one property read and, only when the
+// gain actually moves, one command - negligible CPU.
+//
+// The GUI thread is never involved in the loop, so a busy UI can't make
+// the ducking late. It only reads the current level and gain for display.
+// ============================================================================
+
+#ifndef AUDIODUCKER_H
+#define AUDIODUCKER_H
+
+#include <QObject>
+
+#include <atomic>
+
+class MpvWidget;
+class QTimer;
+
+class AudioDucker : public QObject {
+    Q_OBJECT
+
+public:
+    static const int PollMs = 10;                // Analysis interval.
+    static const int HoldMs = 250;               // Voice stays "on" this long.
+    static const int DisplayIntervalMs = 100;    // levelChanged() rate.
+
+    // `source` is listened to (the commentary), `target` is ducked.
+    AudioDucker(MpvWidget *source, MpvWidget *target, QObject *parent = nullptr);
+    ~AudioDucker();                              // Stops the thread.
+
+    // On inserts the two filters and starts the analysis thread; off stops
+    // it and removes the filters, so player 1 is back at full volume. Must
+    // be switched off before either player shuts down.
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Parameters - may be changed while running.
+    void setThreshold(double dBFS);              // Voice detection level.
+    void setDepth(double dB);                    // How far the movie is lowered.
+    void setAttack(int ms);                      // Time constant going down.
+    void setRelease(int ms);                     // Time constant coming back.
+
+signals:
+    // Sidechain level (dBFS) and the gain applied to the target (dB, <= 0),
+    // every DisplayIntervalMs while enabled.
+    void levelChanged(double levelDb, double gainDb);
+
+private:
+    class Worker;                                // The analysis thread.
+
+    void report();
+
+    MpvWidget *source;
+    MpvWidget *target;
+    Worker *worker;                              // nullptr while disabled.
+    QTimer *displayTimer;
+
+    // Shared with the worker; written by the GUI thread.
+    std::atomic<double> threshold;
+    std::atomic<double> depth;
+    std::atomic<int> attackMs;
+    std::atomic<int> releaseMs;
+};
+
+#endif // AUDIODUCKER_H
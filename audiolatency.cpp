@@ -0,0 +1,153 @@
+// ============================================================================
+// audiolatency.cpp - Implementation of AudioLatency
+// ============================================================================
+
+#include "audiolatency.h"
+#include "mpvwidget.h"           // MpvWidget
+
+#include <QTimer>
+
+#include <algorithm>             // std::nth_element
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+AudioLatency::AudioLatency(const QList<MpvWidget *> &players, QObject *parent)
+    : QObject(parent), enabled(false) {
+
+    for (int i = 0; i < players.size(); i++) {
+        Entry entry;
+        entry.player = players[i];
+        entry.samples.reserve(WindowSize);
+        entry.settle.start();
+        entries.append(entry);
+
+        MpvWidget *player = players[i];
+        player->observeProperty("audio-device");
+        player->observeProperty("current-ao");
+        player->observeProperty("audio-out-params");
+        connect(player, &MpvWidget::propertyChanged, this, [this, i](const QString &name, const QVariant &) {
+            if (name == "audio-device" || name == "current-ao" || name == "audio-out-params") restart(i);
+        });
+
+        // After a seek or a new file the ao is refilled - the first
+        // readings would show a half-empty buffer.
+        connect(player, &MpvWidget::playbackRestarted, this, [this, i]() { entries[i].settle.restart(); });
+    }
+
+    timer = new QTimer(this);
+    timer->setInterval(SampleIntervalMs);
+    connect(timer, &QTimer::timeout, this, &AudioLatency::sample);
+    timer->start();
+}
+
+AudioLatency::~AudioLatency() {
+    timer->stop();
+}
+
+// ----------------------------------------------------------------------------
+// setEnabled() / accessors
+// ----------------------------------------------------------------------------
+void AudioLatency::setEnabled(bool on) {
+    enabled = on;
+    if (enabled) {
+        apply();
+    } else {
+        for (Entry &entry : entries) setDelay(entry, 0.0);
+    }
+    emit changed();
+}
+
+bool AudioLatency::isEnabled() const {
+    return enabled;
+}
+
+double AudioLatency::latency(int index) const {
+    return index >= 0 && index < entries.size() ? entries[index].latency : -1.0;
+}
+
+double AudioLatency::delay(int index) const {
+    return index >= 0 && index < entries.size() ? entries[index].delay : 0.0;
+}
+
+// ----------------------------------------------------------------------------
+// restart() - The Output Changed, Measure Again
+// ----------------------------------------------------------------------------
+// The applied delay stays until the new latency is known, so switching
+// devices doesn't make the sound jump twice.
+// ----------------------------------------------------------------------------
+void AudioLatency::restart(int index) {
+    Entry &entry = entries[index];
+    entry.samples.clear();
+    entry.next = 0;
+    entry.latency = -1.0;
+    entry.settle.restart();
+    emit changed();
+}
+
+// ----------------------------------------------------------------------------
+// sample() - One Reading per Playing Player
+// ----------------------------------------------------------------------------
+// While paused avsync isn't updated, so only playing players are sampled.
+// It is unavailable without both audio and video.
+// ----------------------------------------------------------------------------
+void AudioLatency::sample() {
+    bool updated = false;
+
+    for (Entry &entry : entries) {
+        MpvWidget *player = entry.player;
+        if (!player->isReady() || !player->hasFile() || player->isPrefilling() || player->isPaused()) continue;
+        if (entry.settle.elapsed() < SettleMs) continue;
+
+        // avsync is positive when the audio is ahead. MPV measures it
+        // against the delayed position it aims for, so the audio-delay set
+        // here doesn't feed back into it.
+        double avsync = 0.0;
+        if (player->getDouble("avsync", &avsync) < 0) continue;
+        double value = -avsync;
+        if (value < -0.1 || value > 2.0) continue;   // A seek in between.
+
+        if (entry.samples.size() < WindowSize) entry.samples.append(value);
+        else entry.samples[entry.next] = value;
+        entry.next = (entry.next + 1) % WindowSize;
+
+        if (entry.samples.size() < MinSamples) continue;
+
+        QVector<double> sorted = entry.samples;
+        auto middle = sorted.begin() + sorted.size() / 2;
+        std::nth_element(sorted.begin(), middle, sorted.end());
+        double median = qMax(0.0, *middle);
+
+        if (entry.latency < 0.0 || qAbs(median - entry.latency) >= 0.0005) {
+            entry.latency = median;
+            updated = true;
+        }
+    }
+
+    if (!updated) return;
+    if (enabled) apply();
+    emit changed();
+}
+
+// ----------------------------------------------------------------------------
+// apply() - Delay Everyone to the Slowest Output
+// ----------------------------------------------------------------------------
+// Players without a measurement (no audio) keep no delay and don't count.
+// ----------------------------------------------------------------------------
+void AudioLatency::apply() {
+    double slowest = -1.0;
+    for (const Entry &entry : entries) slowest = qMax(slowest, entry.latency);
+    if (slowest < 0.0) return;
+
+    for (Entry &entry : entries) {
+        if (entry.latency < 0.0) continue;
+        double target = qBound(0.0, slowest - entry.latency, MaxDelay);
+        if (qAbs(target - entry.delay) >= Hysteresis) setDelay(entry, target);
+    }
+}
+
+// A positive audio-delay plays the audio later relative to the video.
+void AudioLatency::setDelay(Entry &entry, double seconds) {
+    entry.delay = seconds;
+    entry.player->setDouble("audio-delay", seconds);
+}
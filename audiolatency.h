@@ -0,0 +1,94 @@
+// ============================================================================
+// audiolatency.h - Measure and Equalize Each Player's Residual A/V Offset
+// ============================================================================
+// Two players can show the same frame at the same moment and still SOUND
+// out of step if one of them hears its audio late against its own video.
+//
+// Most of an audio output's (ao's) buffering never gets that far: MPV
+// times every frame against the audio being HEARD - what was written to
+// the device minus the delay the ao reports - so a bigger buffer delays
+// that player's video along with its audio, and the group sync lines the
+// frames up. Comparing time-pos with audio-pts therefore shows nothing but
+// the frame steps of time-pos; the output latency itself is not visible
+// from outside MPV and is not what this measures.
+//
+// What MPV does report is what its own sync leaves over: "avsync", the
+// difference between the heard audio and the frame it just showed, taken
+// at that frame's exact time. A player whose video can't keep up, or that
+// drops to a coarser sync mode, carries a steady offset there. Sampled a
+// few times per second, the median of a rolling window is steady to about
+// a millisecond.
+//
+// With compensation on, every player is delayed (MPV's "audio-delay") by
+// the difference to the one whose audio lags most, so all of them keep the
+// same A/V offset. Changes smaller than Hysteresis aren't applied, so the
+// delay doesn't wander with measurement noise. An output that misreports
+// its delay - some Bluetooth devices do - looks in sync to MPV, and so to
+// this class; only an acoustic measurement could catch it.
+//
+// The measurement restarts from scratch when a player's output changes
+// (audio-device, current-ao, audio-out-params - e.g. headphones plugged in)
+// and skips the moments right after a seek, while the ao refills.
+// ============================================================================
+
+#ifndef AUDIOLATENCY_H
+#define AUDIOLATENCY_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QVector>
+
+class MpvWidget;
+class QTimer;
+
+class AudioLatency : public QObject {
+    Q_OBJECT
+
+public:
+    static const int SampleIntervalMs = 100;
+    static const int WindowSize = 31;            // Samples in the rolling median.
+    static const int MinSamples = 10;            // Before a latency is reported.
+    static const int SettleMs = 400;             // Ignored after a seek/restart.
+    static constexpr double Hysteresis = 0.002;  // Seconds.
+    static constexpr double MaxDelay = 0.5;      // Largest compensation, seconds.
+
+    explicit AudioLatency(const QList<MpvWidget *> &players, QObject *parent = nullptr);
+    ~AudioLatency();
+
+    // Off resets every player's audio-delay to 0. Measuring goes on.
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // How late player `index` is heard against its own picture, in seconds
+    // (0 if early or on time), or -1 while unknown - no audio or no video,
+    // or not enough samples yet.
+    double latency(int index) const;
+
+    // The audio-delay currently applied to player `index`, in seconds.
+    double delay(int index) const;
+
+signals:
+    void changed();                              // New latency or delay.
+
+private:
+    struct Entry {
+        MpvWidget *player = nullptr;
+        QVector<double> samples;                 // Ring buffer of WindowSize.
+        int next = 0;
+        double latency = -1.0;
+        double delay = 0.0;
+        QElapsedTimer settle;                    // Since the last restart/seek.
+    };
+
+    void sample();
+    void restart(int index);
+    void apply();
+    void setDelay(Entry &entry, double seconds);
+
+    QTimer *timer;
+    QVector<Entry> entries;
+    bool enabled;
+};
+
+#endif // AUDIOLATENCY_H
@@ -0,0 +1,128 @@
+// ============================================================================
+// backgroundanalysis.cpp - Implementation of BackgroundAnalysis
+// ============================================================================
+
+#include "backgroundanalysis.h"
+
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Job
+// ----------------------------------------------------------------------------
+BackgroundAnalysis::Job::~Job() {}
+
+void BackgroundAnalysis::Job::fail(const QString &reason) {
+    QMutexLocker lock(&errorMutex);
+    if (error.isEmpty()) error = reason;
+}
+
+QString BackgroundAnalysis::Job::errorOr(const QString &fallback) {
+    QMutexLocker lock(&errorMutex);
+    return error.isEmpty() ? fallback : error;
+}
+
+// ----------------------------------------------------------------------------
+// Task
+// ----------------------------------------------------------------------------
+BackgroundAnalysis::Task::Task(QSharedPointer<Job> job) : shared(job) {}
+
+void BackgroundAnalysis::Task::run() {
+    QThread::currentThread()->setPriority(QThread::LowPriority);
+    if (!shared->cancelled) work();
+    taskDone(shared);
+}
+
+// Last one out hands the job back to the GUI thread. If the analyzer is
+// gone by then, Qt drops the call.
+void BackgroundAnalysis::taskDone(const QSharedPointer<Job> &job) {
+    if (job->tasksLeft.fetch_sub(1) != 1) return;
+    QSharedPointer<Job> done = job;
+    BackgroundAnalysis *owner = done->owner;
+    QMetaObject::invokeMethod(owner, [owner, done]() { owner->completeJob(done); }, Qt::QueuedConnection);
+}
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+BackgroundAnalysis::BackgroundAnalysis(int threads, QObject *parent) : QObject(parent) {
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(qMax(1, threads));
+
+    progressTimer = new QTimer(this);
+    progressTimer->setInterval(250);
+    connect(progressTimer, &QTimer::timeout, this, &BackgroundAnalysis::reportProgress);
+}
+
+// The tasks only touch their job, so the analyzer's own members may
+// already be gone while this waits.
+BackgroundAnalysis::~BackgroundAnalysis() {
+    for (const QSharedPointer<Job> &job : jobs) job->cancelled = true;
+    pool->waitForDone();
+}
+
+// ----------------------------------------------------------------------------
+// start() / spawn() / cancel()
+// ----------------------------------------------------------------------------
+void BackgroundAnalysis::start(int slot, QSharedPointer<Job> job, Task *first) {
+    job->slot = slot;
+    job->owner = this;
+    job->pool = pool;
+    job->tasksLeft = 1;
+    jobs[slot] = job;
+
+    pool->start(first);
+    progressTimer->start();
+    emit progress(slot, 0);
+}
+
+// The spawning task still counts itself, so the job can't come back before
+// the new task is counted too.
+void BackgroundAnalysis::spawn(const QSharedPointer<Job> &job, Task *task) {
+    job->tasksLeft++;
+    job->pool->start(task);
+}
+
+void BackgroundAnalysis::cancel(int slot) {
+    QSharedPointer<Job> job = jobs.take(slot);
+    if (job) job->cancelled = true;
+    forget(slot);
+    if (jobs.isEmpty()) progressTimer->stop();
+}
+
+bool BackgroundAnalysis::isRunning(int slot) const {
+    return jobs.contains(slot);
+}
+
+QSharedPointer<BackgroundAnalysis::Job> BackgroundAnalysis::runningJob(int slot) const {
+    return jobs.value(slot);
+}
+
+int BackgroundAnalysis::segmentCount(const Job &job, double seconds, double minSegmentSeconds) {
+    if (seconds <= 0.0) return 1;
+    int byLength = static_cast<int>(std::ceil(seconds / minSegmentSeconds));
+    return qBound(1, byLength, job.pool->maxThreadCount() * 2);
+}
+
+// ----------------------------------------------------------------------------
+// reportProgress() / completeJob() (GUI Thread)
+// ----------------------------------------------------------------------------
+void BackgroundAnalysis::reportProgress() {
+    for (const QSharedPointer<Job> &job : jobs) {
+        qint64 total = job->total;
+        if (total <= 0) continue;
+        int percent = static_cast<int>(qMin<qint64>(99, job->done * 100 / total));
+        emit progress(job->slot, percent);
+    }
+}
+
+void BackgroundAnalysis::completeJob(QSharedPointer<Job> job) {
+    if (jobs.value(job->slot) != job) return;    // Cancelled or replaced.
+    jobs.remove(job->slot);
+    if (jobs.isEmpty()) progressTimer->stop();
+    finishJob(job);
+}
@@ -0,0 +1,136 @@
+// ============================================================================
+// backgroundanalysis.h - Shared Machinery of the Background File Scans
+// ============================================================================
+// Loudness, scene cuts, keyframes, waveforms, subtitles and the difference
+// heatmap are all worked out the same way: a JOB per player slot runs on a
+// low-priority thread pool, reports its progress every 250 ms, and is
+// handed back to the GUI thread when its last task is done. A new scan for
+// a slot replaces the running one; a job that was cancelled or replaced in
+// the meantime is dropped when it comes back. BackgroundAnalysis does all
+// of that, so each analyzer only describes its own work:
+//
+//   - a Job subclass with whatever the tasks fill in,
+//   - one or more Task subclasses that do the work,
+//   - finishJob(), which turns a finished job into the result,
+//   - forget(), which drops a slot's result.
+//
+// A job starts with ONE task. A task that splits the file into segments
+// (the "plan" task) starts the segment tasks with spawn() before it
+// returns, so the job only comes back once all of them are done:
+//
+//     analyze()  ->  start(slot, job, new PlanTask(job))
+//     PlanTask   ->  spawn(job, new SegmentTask(job, i))   for each segment
+//     last task  ->  finishJob(job)                        on the GUI thread
+//
+// Jobs are owned jointly (QSharedPointer) by the analyzer and its tasks, so
+// a cancelled job stays valid until its last task has noticed.
+// ============================================================================
+
+#ifndef BACKGROUNDANALYSIS_H
+#define BACKGROUNDANALYSIS_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QString>
+
+#include <atomic>
+
+class QThreadPool;
+class QTimer;
+
+class BackgroundAnalysis : public QObject {
+    Q_OBJECT
+
+public:
+    ~BackgroundAnalysis();                   // Cancels and waits for running jobs.
+
+    void cancel(int slot);                   // Also forgets the slot's result.
+    bool isRunning(int slot) const;
+
+signals:
+    void progress(int slot, int percent);
+    void finished(int slot);
+    void failed(int slot, const QString &reason);
+
+protected:
+    // ------------------------------------------------------------------------
+    // Job - Shared State of One Scan
+    // ------------------------------------------------------------------------
+    // Analyzers derive their own Job with the inputs and the places the
+    // tasks write to. Progress is counted in whatever unit suits the scan
+    // (frames, milliseconds, bytes) - only done/total matters.
+    // ------------------------------------------------------------------------
+    struct Job {
+        virtual ~Job();
+
+        int slot = 0;
+        QString path;
+
+        std::atomic<bool> cancelled{false};
+        std::atomic<qint64> done{0};
+        std::atomic<qint64> total{0};
+
+        void fail(const QString &reason);    // Any thread; the first reason wins.
+        QString errorOr(const QString &fallback);
+
+    private:
+        friend class BackgroundAnalysis;
+        BackgroundAnalysis *owner = nullptr;
+        QThreadPool *pool = nullptr;
+        std::atomic<int> tasksLeft{0};
+        QMutex errorMutex;
+        QString error;
+    };
+
+    // ------------------------------------------------------------------------
+    // Task - One Piece of Work on the Pool
+    // ------------------------------------------------------------------------
+    // run() lowers the thread's priority, calls work() unless the job was
+    // cancelled, and hands the job back if it was the last task.
+    // ------------------------------------------------------------------------
+    class Task : public QRunnable {
+    public:
+        explicit Task(QSharedPointer<Job> job);
+        void run() override;
+
+    protected:
+        virtual void work() = 0;
+
+    private:
+        QSharedPointer<Job> shared;          // Keeps the job alive; counts this task.
+    };
+
+    BackgroundAnalysis(int threads, QObject *parent);
+
+    // GUI thread: makes `job` the slot's running job (cancel() the old one
+    // first) and queues its first task.
+    void start(int slot, QSharedPointer<Job> job, Task *first);
+
+    // Any thread, from a running task of the same job: queue one more.
+    static void spawn(const QSharedPointer<Job> &job, Task *task);
+
+    // How many segments to split `seconds` into: at least minSegmentSeconds
+    // each, at most two per pool thread, one when the length is unknown.
+    static int segmentCount(const Job &job, double seconds, double minSegmentSeconds);
+
+    QSharedPointer<Job> runningJob(int slot) const;     // Null if none.
+
+    // GUI thread, for a job that is still the slot's running job: build
+    // the result and emit finished() or failed().
+    virtual void finishJob(QSharedPointer<Job> job) = 0;
+    virtual void forget(int slot) = 0;
+
+private:
+    static void taskDone(const QSharedPointer<Job> &job);
+    void completeJob(QSharedPointer<Job> job);
+    void reportProgress();
+
+    QThreadPool *pool;
+    QTimer *progressTimer;
+    QHash<int, QSharedPointer<Job>> jobs;    // Running jobs, by slot.
+};
+
+#endif // BACKGROUNDANALYSIS_H
@@ -0,0 +1,310 @@
+// ============================================================================
+// bufferingbarrier.cpp - Implementation of BufferingBarrier
+// ============================================================================
+
+#include "bufferingbarrier.h"
+#include "playergroup.h"
+#include "mpvwidget.h"           // For the full MpvWidget class definition.
+#include "keyframeindex.h"
+
+#include <QTimer>
+
+// ----------------------------------------------------------------------------
+// Tuning
+// ----------------------------------------------------------------------------
+// A local seek normally "stalls" for a few milliseconds; the grace period
+// keeps those from pausing the whole group. A real cache underrun lasts far
+// longer.
+// ----------------------------------------------------------------------------
+static const qint64 StallGraceMs = 250;     // Stall must last this long to count.
+static const qint64 MaxHoldMs    = 30000;   // Give up waiting after this.
+static const int    CheckMs      = 100;     // Re-evaluation interval.
+
+static const int    MaxStaggerMs = 1500;    // Longest delay of a planned seek.
+static const int    MinStaggerMs = 10;      // Shorter delays are sent right away.
+static const double LearnRate    = 0.3;     // Of each measured seek, for the model.
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+// Subscribes to the buffering-related properties of every group member. MPV
+// reports the current values straight away, so the state is complete a
+// moment after construction.
+// ----------------------------------------------------------------------------
+BufferingBarrier::BufferingBarrier(PlayerGroup *group, QObject *parent)
+    : QObject(parent), group(group), holding(false), holdStartMs(0), resumeAhead(2.0),
+      keyframes(nullptr), seekGeneration(0) {
+
+    const QList<MpvWidget *> &players = group->members();
+    states.resize(players.size());
+
+    static const char *properties[] = {
+        "idle-active", "pause", "paused-for-cache", "seeking", "core-idle",
+        "demuxer-cache-idle", "demuxer-cache-duration", "eof-reached"
+    };
+
+    for (int i = 0; i < players.size(); i++) {
+        for (const char *name : properties) {
+            players[i]->observeProperty(name);
+        }
+        connect(players[i], &MpvWidget::propertyChanged, this,
+                [this, i](const QString &name, const QVariant &value) { updateState(i, name, value); });
+        connect(players[i], &MpvWidget::playbackRestarted, this, [this, i]() {
+            learnSeek(i);
+            states[i].seekPending = false;
+            evaluate();
+        });
+    }
+
+    clock.start();
+
+    // The grace period and the give-up timeout need a clock tick even when
+    // no property changes, so re-check periodically as well.
+    checkTimer = new QTimer(this);
+    checkTimer->setInterval(CheckMs);
+    connect(checkTimer, &QTimer::timeout, this, &BufferingBarrier::evaluate);
+    checkTimer->start();
+}
+
+void BufferingBarrier::setResumeAhead(double seconds) {
+    resumeAhead = seconds;
+}
+
+bool BufferingBarrier::isHolding() const {
+    return holding;
+}
+
+void BufferingBarrier::setKeyframeIndexer(KeyframeIndexer *indexer) {
+    keyframes = indexer;
+}
+
+// ----------------------------------------------------------------------------
+// seekTo() - Barrier Seek
+// ----------------------------------------------------------------------------
+// The hold goes on BEFORE the seeks are sent, so no player can start
+// playing from its new position while another is still seeking. Each
+// seeking player is then waited for until MPV reports "playback-restart"
+// for it - the "seeking" property alone can flicker off before the seek
+// is sent. A player that was at the end forgets its EOF here: otherwise
+// the next property change would count the OLD end as "sought past the
+// end" and let the hold go before the seek has landed.
+// ----------------------------------------------------------------------------
+void BufferingBarrier::seekTo(double groupTime) {
+    seekTo(groupTime, group->currentOffsets());
+}
+
+void BufferingBarrier::seekTo(double groupTime, const QVector<double> &offsets) {
+    const QList<MpvWidget *> &players = group->members();
+    for (int i = 0; i < players.size(); i++) {
+        states[i].seekPending = players[i]->hasFile() && !players[i]->isPrefilling();
+        if (states[i].seekPending) states[i].eof = false;    // Only a new eof-reached counts.
+        states[i].gaveUp = false;
+        states[i].seekFrames = -1;
+        states[i].seekCostMs = -1.0;
+        states[i].seekSentMs = -1;
+    }
+
+    qint64 now = clock.elapsed();
+    if (holding) {
+        holdStartMs = now;        // A fresh wait for the new positions.
+    } else {
+        engage(now);
+    }
+
+    if (keyframes) planSeeks(groupTime, offsets);
+    else group->seekTo(groupTime, offsets);
+    evaluate();
+}
+
+// ----------------------------------------------------------------------------
+// planSeeks() - Send the Seeks So They Finish Together
+// ----------------------------------------------------------------------------
+// The seeks stay exact: a keyframe-only seek would be cheaper, but MPV may
+// then land on the keyframe AFTER the target, which breaks the offsets.
+// What is planned is the order and the timing. A player without an index
+// (yet) is sent right away - there is nothing to plan with.
+// ----------------------------------------------------------------------------
+void BufferingBarrier::planSeeks(double groupTime, const QVector<double> &offsets) {
+    const QList<MpvWidget *> &players = group->members();
+    const quint64 generation = ++seekGeneration;
+
+    QVector<double> targets(players.size(), 0.0);
+    double slowest = 0.0;
+    for (int i = 0; i < players.size(); i++) {
+        if (!states[i].seekPending) continue;
+        PlayerState &s = states[i];
+        targets[i] = qMax(0.0, groupTime + offsets.value(i));
+        s.seekFrames = keyframes->index(i).framesToDecode(targets[i]);
+        if (s.seekFrames < 0) continue;
+        s.seekCostMs = s.baseMs + s.seekFrames * s.frameMs;
+        slowest = qMax(slowest, s.seekCostMs);
+    }
+
+    for (int i = 0; i < players.size(); i++) {
+        if (!states[i].seekPending) continue;
+        MpvWidget *player = players[i];
+        const double target = targets[i];
+        auto send = [this, i, player, target, generation]() {
+            if (generation != seekGeneration || !states[i].seekPending) return;
+            states[i].seekSentMs = clock.elapsed();
+            player->seekAbsolute(target);
+        };
+
+        int delay = states[i].seekCostMs < 0.0 ? 0
+                  : qMin(MaxStaggerMs, static_cast<int>(slowest - states[i].seekCostMs));
+        if (delay < MinStaggerMs) send();
+        else QTimer::singleShot(delay, this, send);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// learnSeek() - Refine a Player's Cost Model
+// ----------------------------------------------------------------------------
+// Seeks onto (or right after) a keyframe measure the fixed part; all others
+// the per-frame part, after taking the fixed part off.
+// ----------------------------------------------------------------------------
+void BufferingBarrier::learnSeek(int player) {
+    PlayerState &s = states[player];
+    if (s.seekSentMs < 0 || s.seekFrames < 0) return;
+
+    double latency = clock.elapsed() - s.seekSentMs;
+    s.seekSentMs = -1;
+
+    if (s.seekFrames <= 2) {
+        s.baseMs += (latency - s.baseMs) * LearnRate;
+    } else {
+        double perFrame = (latency - s.baseMs) / s.seekFrames;
+        if (perFrame > 0.0) s.frameMs += (perFrame - s.frameMs) * LearnRate;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// updateState() - Record One Property Change
+// ----------------------------------------------------------------------------
+// An invalid value means "unavailable" (typically: no file loaded), which
+// is treated as false / zero.
+// ----------------------------------------------------------------------------
+void BufferingBarrier::updateState(int player, const QString &name, const QVariant &value) {
+    PlayerState &s = states[player];
+
+    if (name == "idle-active")                 s.loaded = value.isValid() && !value.toBool();
+    else if (name == "pause")                  s.paused = value.toBool();
+    else if (name == "paused-for-cache")       s.pausedForCache = value.toBool();
+    else if (name == "seeking")                s.seeking = value.toBool();
+    else if (name == "core-idle")              s.coreIdle = value.toBool();
+    else if (name == "demuxer-cache-idle")     s.cacheIdle = value.toBool();
+    else if (name == "demuxer-cache-duration") s.cacheAhead = value.toDouble();
+    else if (name == "eof-reached")            s.eof = value.toBool();
+    else return;
+
+    if (s.eof) s.seekPending = false;          // Sought past the end - no frame to wait for.
+
+    evaluate();
+}
+
+// ----------------------------------------------------------------------------
+// isStalled() / isReady()
+// ----------------------------------------------------------------------------
+// "Stalled" is judged while the group plays: waiting for the cache, stuck in
+// a seek, or not advancing although nobody paused it (an underrun).
+//
+// "Ready" is judged while the group is held. The players are paused then,
+// so paused-for-cache and core-idle say nothing; what counts is how much is
+// cached ahead. demuxer-cache-idle covers files whose readahead limit is
+// shorter than resumeAhead (local files read ahead only ~1 second).
+// ----------------------------------------------------------------------------
+bool BufferingBarrier::isStalled(const PlayerState &s) const {
+    if (!s.loaded || s.eof) return false;
+    return s.pausedForCache || s.seeking || (s.coreIdle && !s.paused);
+}
+
+bool BufferingBarrier::isReady(const PlayerState &s) const {
+    if (!s.loaded || s.gaveUp) return true;
+    if (s.seekPending) return false;
+    if (s.eof) return true;
+    if (s.seeking) return false;
+    return s.cacheAhead >= resumeAhead || s.cacheIdle;
+}
+
+// ----------------------------------------------------------------------------
+// evaluate() - The Barrier's State Machine
+// ----------------------------------------------------------------------------
+void BufferingBarrier::evaluate() {
+    qint64 now = clock.elapsed();
+
+    if (!holding) {
+        // Only a playing group can fall out of step.
+        bool groupPlaying = !group->isPaused();
+
+        for (PlayerState &s : states) {
+            if (!groupPlaying || !isStalled(s)) {
+                s.stallSinceMs = -1;
+                s.gaveUp = false;         // Recovered - eligible again.
+                continue;
+            }
+            if (s.gaveUp) continue;
+            if (s.stallSinceMs < 0) s.stallSinceMs = now;
+            if (now - s.stallSinceMs >= StallGraceMs) {
+                engage(now);
+                return;
+            }
+        }
+        return;
+    }
+
+    // Holding - find the player we're still waiting for, if any.
+    int waitingFor = -1;
+    for (int i = 0; i < states.size(); i++) {
+        if (!isReady(states[i])) {
+            waitingFor = i;
+            break;
+        }
+    }
+
+    if (waitingFor < 0) {
+        release();
+        return;
+    }
+
+    if (now - holdStartMs >= MaxHoldMs) {
+        // Don't freeze forever - let everyone else continue. The stalled
+        // player rejoins on its own once it has data again.
+        states[waitingFor].gaveUp = true;
+        release();
+        return;
+    }
+
+    const PlayerState &s = states[waitingFor];
+    if (s.seekPending) {
+        QString estimate = s.seekCostMs < 0.0 ? QString()
+            : QString(" (%1 frames from the keyframe, ~%2 ms)").arg(s.seekFrames).arg(qRound(s.seekCostMs));
+        emit statusChanged(QString("Seeking: waiting for Player %1%2").arg(waitingFor + 1).arg(estimate));
+        return;
+    }
+    emit statusChanged(QString("Buffering: waiting for Player %1 (%2 / %3 s cached)")
+                           .arg(waitingFor + 1)
+                           .arg(s.cacheAhead, 0, 'f', 1)
+                           .arg(resumeAhead, 0, 'f', 1));
+}
+
+// ----------------------------------------------------------------------------
+// engage() / release()
+// ----------------------------------------------------------------------------
+void BufferingBarrier::engage(qint64 now) {
+    holding = true;
+    holdStartMs = now;
+    group->setHeld(true);
+    emit holdChanged(true);
+}
+
+void BufferingBarrier::release() {
+    holding = false;
+    for (PlayerState &s : states) {
+        s.stallSinceMs = -1;
+        s.seekPending = false;
+    }
+
+    group->setHeld(false);        // Resumes every player at once.
+    emit holdChanged(false);
+    emit statusChanged(QString());
+}
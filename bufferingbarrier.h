@@ -0,0 +1,114 @@
+// ============================================================================
+// bufferingbarrier.h - Hold Both Players While Either One Is Buffering
+// ============================================================================
+// If one source lives on a slow disk or a network share, its player can run
+// out of data and stop ("paused-for-cache"), stay stuck in a seek, or simply
+// underrun. The other player doesn't notice and keeps going, so the two
+// drift apart by however long the stall lasted.
+//
+// The barrier watches the buffering state of every player in a PlayerGroup.
+// When any of them stalls for longer than a short grace period, it HOLDS
+// the whole group (see PlayerGroup::setHeld) and waits until every player
+// has enough data cached ahead of its position. Then it releases the hold,
+// which resumes all players together.
+//
+// If a player stays stuck for too long (e.g. the network is gone), the
+// barrier gives up and lets the others continue rather than freezing the
+// app forever.
+//
+// The same hold also serves BARRIER SEEKS (seekTo): the group is held,
+// every player seeks, and playback resumes only when all of them have
+// finished seeking and have data again - so a long jump doesn't leave one
+// player playing while the other is still searching for its frame.
+//
+// With keyframe indexes (see keyframeindex.h) barrier seeks are PLANNED:
+// each player's exact seek costs roughly
+//
+//   base + frames from the keyframe before its target * time per frame
+//
+// where base and time per frame are learned from that player's previous
+// seeks. The most expensive seek is sent first and the others are delayed
+// by the difference, so all players arrive on their frames at about the
+// same moment instead of one waiting, frozen, on the other.
+// ============================================================================
+
+#ifndef BUFFERINGBARRIER_H
+#define BUFFERINGBARRIER_H
+
+#include <QObject>
+#include <QVector>
+#include <QVariant>
+#include <QElapsedTimer>
+
+class QTimer;
+class PlayerGroup;
+class KeyframeIndexer;
+
+class BufferingBarrier : public QObject {
+    Q_OBJECT
+
+public:
+    explicit BufferingBarrier(PlayerGroup *group, QObject *parent = nullptr);
+
+    void setResumeAhead(double seconds);     // Cache needed before resuming.
+    bool isHolding() const;
+
+    // Seek the group to `groupTime` (see PlayerGroup::seekTo) and resume it,
+    // if it was playing, once every player is ready.
+    void seekTo(double groupTime);
+    void seekTo(double groupTime, const QVector<double> &offsets);
+
+    // Plan seeks with these indexes; group member i uses the indexer's
+    // slot i. Without one, every seek is sent right away.
+    void setKeyframeIndexer(KeyframeIndexer *indexer);
+
+signals:
+    void holdChanged(bool holding);
+    void statusChanged(const QString &text); // Empty when not holding.
+
+private slots:
+    void evaluate();                         // Re-check every player's state.
+
+private:
+    // What we know about one player, kept up to date by observed properties.
+    struct PlayerState {
+        bool loaded = false;          // !idle-active
+        bool paused = true;           // pause
+        bool pausedForCache = false;  // paused-for-cache
+        bool seeking = false;         // seeking
+        bool coreIdle = false;        // core-idle (not advancing, for any reason)
+        bool cacheIdle = false;       // demuxer-cache-idle (cache is full)
+        bool eof = false;             // eof-reached
+        double cacheAhead = 0.0;      // demuxer-cache-duration, seconds
+        qint64 stallSinceMs = -1;     // When the current stall began, or -1.
+        bool gaveUp = false;          // Barrier gave up on this stall.
+        bool seekPending = false;     // Barrier seek sent, playback-restart not yet seen.
+
+        // Seek planning - see the header comment.
+        double baseMs = 40.0;         // Learned cost of any seek.
+        double frameMs = 4.0;         // Learned cost per decoded frame.
+        int seekFrames = -1;          // Frames the pending seek decodes; -1 = unknown.
+        double seekCostMs = -1.0;     // Its estimated cost.
+        qint64 seekSentMs = -1;       // When it was sent, for learning.
+    };
+
+    void updateState(int player, const QString &name, const QVariant &value);
+    bool isStalled(const PlayerState &state) const;
+    bool isReady(const PlayerState &state) const;
+    void engage(qint64 now);
+    void release();
+    void planSeeks(double groupTime, const QVector<double> &offsets);
+    void learnSeek(int player);
+
+    PlayerGroup *group;
+    QVector<PlayerState> states;    // One per group member, same order.
+    QTimer *checkTimer;
+    QElapsedTimer clock;
+    bool holding;
+    qint64 holdStartMs;
+    double resumeAhead;
+    KeyframeIndexer *keyframes;
+    quint64 seekGeneration;         // Delayed seeks of older plans are dropped.
+};
+
+#endif // BUFFERINGBARRIER_H
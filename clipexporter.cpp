@@ -0,0 +1,313 @@
+// ============================================================================
+// clipexporter.cpp - Implementation of ClipExporter
+// ============================================================================
+
+#include "clipexporter.h"
+#include "compositeplayer.h"     // findTracks(), shiftedPath()
+#include "mpvwidget.h"           // MpvWidget
+#include "playerbackend.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+#include <mpv/client.h>          // MPV_END_FILE_REASON_*
+
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// FinishTask - Close the Encoder Off the GUI Thread
+// ----------------------------------------------------------------------------
+// The file is only complete once MPV has flushed the encoders and written
+// the container's index, which happens while the instance is destroyed.
+// terminate() (mpv_terminate_destroy) waits for that, so it runs in the pool.
+// An encoder that doesn't get there - its helper process died or was
+// killed while flushing - fails the export even if the file had ended.
+// ----------------------------------------------------------------------------
+class ClipExporter::FinishTask : public QRunnable {
+public:
+    FinishTask(ClipExporter *owner, PlayerBackend *encoder, const QString &reason)
+        : owner(owner), encoder(encoder), reason(reason) {}
+
+    void run() override {
+        bool flushed = encoder->terminate();
+        delete encoder;
+        if (!flushed && reason.isEmpty()) reason = "Export failed: the encoder quit before finishing the file";
+
+        ClipExporter *owner = this->owner;
+        QString reason = this->reason;
+        QMetaObject::invokeMethod(owner, [owner, reason]() { owner->finalized(reason); }, Qt::QueuedConnection);
+    }
+
+private:
+    ClipExporter *owner;
+    PlayerBackend *encoder;
+    QString reason;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+ClipExporter::ClipExporter(QObject *parent)
+    : QObject(parent), encoder(nullptr), rangeStart(0.0), rangeLength(0.0),
+      loaded(false), cancelled(false), finishing(false), lastReport(0) {
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(1);
+}
+
+ClipExporter::~ClipExporter() {
+    if (encoder) {
+        encoder->setWakeupCallback(nullptr, nullptr);
+        encoder->terminate();
+        delete encoder;
+        encoder = nullptr;
+        QFile::remove(job.output);           // Never finished.
+    }
+    pool->waitForDone();
+}
+
+QString ClipExporter::defaultDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::MoviesLocation) + "/mpv-watchalong";
+}
+
+double ClipExporter::gainOf(MpvWidget *player) {
+    double volume = 100.0;
+    player->getDouble("volume", &volume);
+    return std::pow(volume / 100.0, 3.0) * std::pow(10.0, player->levelGain() / 20.0);
+}
+
+bool ClipExporter::isBusy() const {
+    return encoder || finishing;
+}
+
+QString ClipExporter::error() const {
+    return errorText;
+}
+
+// ----------------------------------------------------------------------------
+// start()
+// ----------------------------------------------------------------------------
+// The instance starts with no tracks selected (vid/aid=no): the encoder is
+// set up by the first frame it receives, and that must already be the
+// composite - an encoder can't change its picture size halfway. The graph
+// is put in place in onFileLoaded(), once the track ids are known.
+// ----------------------------------------------------------------------------
+bool ClipExporter::start(const Job &newJob) {
+    if (isBusy()) {
+        errorText = "An export is already running";
+        return false;
+    }
+    if (newJob.outPoint <= newJob.inPoint) {
+        errorText = "The out point must be after the in point";
+        return false;
+    }
+
+    job = newJob;
+    QDir().mkpath(QFileInfo(job.output).absolutePath());
+
+    // Same time mapping as CompositePlayer: the file that is ahead starts
+    // later, so both share one timeline.
+    const double shift1 = qMax(0.0, -job.offset);
+    const double shift2 = qMax(0.0, job.offset);
+    rangeStart = qMax(0.0, job.inPoint - shift1);
+    rangeLength = job.outPoint - job.inPoint;
+    extraPath = CompositePlayer::shiftedPath(job.secondPath, shift2);
+
+    encoder = PlayerBackend::create();
+    if (!encoder->isValid()) {
+        delete encoder;
+        encoder = nullptr;
+        errorText = "Failed to create an MPV instance";
+        return false;
+    }
+
+    QByteArray output = job.output.toUtf8();
+    QByteArray start = QString::number(rangeStart, 'f', 3).toUtf8();
+    QByteArray end = QString::number(rangeStart + rangeLength, 'f', 3).toUtf8();
+
+    encoder->setOption("o", output.constData());
+    encoder->setOption("ovc", "libx264");
+    encoder->setOption("ovcopts", "preset=veryfast,crf=20");
+    encoder->setOption("oac", "aac");
+    encoder->setOption("oacopts", "b=192k");
+    encoder->setOption("start", start.constData());
+    encoder->setOption("end", end.constData());
+    encoder->setOption("hr-seek", "yes");
+    encoder->setOption("vid", "no");
+    encoder->setOption("aid", "no");
+    encoder->setOption("sid", "no");
+    encoder->setOption("terminal", "no");
+
+    if (encoder->initialize() < 0) {
+        delete encoder;
+        encoder = nullptr;
+        errorText = "This MPV library can't encode video";
+        return false;
+    }
+
+    encoder->setWakeupCallback(&ClipExporter::onMpvWakeup, this);
+    encoder->observeProperty(0, "time-pos");
+
+    errorText.clear();
+    loaded = false;
+    cancelled = false;
+    clock.start();
+
+    QByteArray mainPath = CompositePlayer::shiftedPath(job.firstPath, shift1).toUtf8();
+    const char *cmd[] = {"loadfile", mainPath.constData(), NULL};
+    encoder->command(cmd);
+    return true;
+}
+
+void ClipExporter::cancel() {
+    if (!encoder || finishing) return;
+    cancelled = true;
+    const char *cmd[] = {"stop", NULL};
+    encoder->command(cmd);
+}
+
+// ----------------------------------------------------------------------------
+// onMpvWakeup() / onMpvEvents()
+// ----------------------------------------------------------------------------
+// Same pattern as MpvWidget: the wakeup callback only posts a queued call,
+// the queue is drained in the GUI thread.
+// ----------------------------------------------------------------------------
+void ClipExporter::onMpvWakeup(void *ctx) {
+    ClipExporter *self = static_cast<ClipExporter *>(ctx);
+    QMetaObject::invokeMethod(self, &ClipExporter::onMpvEvents, Qt::QueuedConnection);
+}
+
+void ClipExporter::onMpvEvents() {
+    while (encoder) {
+        PlayerEvent event = encoder->waitEvent(0);
+        if (event.type == PlayerEvent::None) break;
+
+        switch (event.type) {
+        case PlayerEvent::FileLoaded:
+            onFileLoaded();
+            break;
+        case PlayerEvent::PropertyChange: {
+            if (!loaded || !event.value.isValid()) break;
+            if (clock.elapsed() - lastReport < ProgressIntervalMs) break;   // time-pos changes every frame.
+            lastReport = clock.elapsed();
+            double done = event.value.toDouble() - rangeStart;
+            double seconds = clock.elapsed() / 1000.0;
+            emit progress(qBound(0.0, done / rangeLength, 1.0), seconds > 0.0 ? done / seconds : 0.0);
+            break;
+        }
+        case PlayerEvent::EndFile:
+            if (cancelled) finish("Cancelled");
+            else if (event.endReason == MPV_END_FILE_REASON_EOF) finish(QString());
+            else if (event.endReason == MPV_END_FILE_REASON_ERROR) finish(QString("Export failed: %1").arg(PlayerBackend::errorString(event.error)));
+            else finish("Export stopped");
+            break;
+        case PlayerEvent::Shutdown:
+            finish("MPV shut down");
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// onFileLoaded() - Add Player 2's File and Start Encoding
+// ----------------------------------------------------------------------------
+void ClipExporter::onFileLoaded() {
+    QByteArray pathBytes = extraPath.toUtf8();
+    const char *videoCmd[] = {"video-add", pathBytes.constData(), "auto", NULL};
+    const char *audioCmd[] = {"audio-add", pathBytes.constData(), "auto", NULL};
+    if (encoder->command(videoCmd) < 0) {
+        finish("Player 2's file could not be opened");
+        return;
+    }
+    encoder->command(audioCmd);              // Fails harmlessly without audio.
+
+    QVariant trackList;
+    encoder->getNode("track-list", &trackList);
+    CompositePlayer::Tracks tracks = CompositePlayer::findTracks(trackList, job.firstAudio);
+    if (tracks.mainVid == 0 || tracks.extraVid == 0) {
+        finish("Both files need a video track");
+        return;
+    }
+
+    QByteArray graph = exportGraph(job.layout, tracks.mainVid, tracks.extraVid, tracks.mainAid, tracks.extraAid,
+                                   tracks.width, tracks.height, job.firstGain, job.secondGain).toUtf8();
+    if (encoder->setString("lavfi-complex", graph.constData()) < 0) {
+        finish("MPV rejected the export filter graph");
+        return;
+    }
+
+    loaded = true;
+    clock.restart();
+    lastReport = 0;
+}
+
+// ----------------------------------------------------------------------------
+// exportGraph()
+// ----------------------------------------------------------------------------
+// Player 2 is scaled to player 1's size (to a quarter of it in a corner for
+// picture-in-picture); x264 needs even sizes. Each soundtrack gets its
+// player's gain, then amix mixes them - amix itself scales the sum down so
+// two loud tracks can't clip.
+// ----------------------------------------------------------------------------
+QString ClipExporter::exportGraph(Layout layout, int mainVid, int extraVid, int mainAid, int extraAid,
+                                  int width, int height, double mainGain, double extraGain) {
+    if (width <= 0 || height <= 0) {
+        width = 1920;
+        height = 1080;
+    }
+    width &= ~1;
+    height &= ~1;
+
+    auto prepare = [](int w, int h) { return QString("scale=%1:%2,setsar=1,format=yuv420p").arg(w).arg(h); };
+
+    QString graph = QString("[vid%1]%2[a];").arg(mainVid).arg(prepare(width, height));
+    if (layout == PictureInPicture) {
+        graph += QString("[vid%1]%2[b];").arg(extraVid).arg(prepare((width / 4) & ~1, (height / 4) & ~1));
+        graph += "[a][b]overlay=x=main_w-overlay_w-24:y=main_h-overlay_h-24[vo]";
+    } else {
+        graph += QString("[vid%1]%2[b];").arg(extraVid).arg(prepare(width, height));
+        graph += "[a][b]hstack[vo]";
+    }
+
+    auto gain = [](double g) { return QString::number(g, 'f', 4); };
+    if (mainAid > 0 && extraAid > 0) {
+        graph += QString(";[aid%1]volume=%2[a1];[aid%3]volume=%4[a2];[a1][a2]amix=inputs=2:duration=longest[ao]")
+                     .arg(mainAid).arg(gain(mainGain)).arg(extraAid).arg(gain(extraGain));
+    } else if (mainAid > 0 || extraAid > 0) {
+        graph += QString(";[aid%1]volume=%2[ao]")
+                     .arg(mainAid > 0 ? mainAid : extraAid).arg(gain(mainAid > 0 ? mainGain : extraGain));
+    }
+    return graph;
+}
+
+// ----------------------------------------------------------------------------
+// finish() / finalized()
+// ----------------------------------------------------------------------------
+// Anything but a clean end deletes the output - a half-written file
+// without its index wouldn't play anyway.
+// ----------------------------------------------------------------------------
+void ClipExporter::finish(const QString &reason) {
+    if (!encoder || finishing) return;
+    finishing = true;
+
+    encoder->setWakeupCallback(nullptr, nullptr);
+    PlayerBackend *instance = encoder;
+    encoder = nullptr;
+    pool->start(new FinishTask(this, instance, reason));
+}
+
+void ClipExporter::finalized(const QString &reason) {
+    finishing = false;
+    if (reason.isEmpty()) {
+        emit finished(job.output);
+        return;
+    }
+    QFile::remove(job.output);
+    errorText = reason;
+    emit failed(reason);
+}
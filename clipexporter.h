@@ -0,0 +1,102 @@
+// ============================================================================
+// clipexporter.h - Render Both Players Into One Video File
+// ============================================================================
+// Shares a comparison or a watchalong highlight as a single clip: the
+// in/out range of the group timeline, both files at their current offset,
+// side by side or picture-in-picture, with both soundtracks mixed.
+//
+// The work is done by MPV's ENCODING MODE in a private MPV instance with no
+// window: the same lavfi-complex approach as CompositePlayer (one clock for
+// both files, the offset built in with an EDL), but instead of a video
+// output the frames go to libavcodec. MPV runs the stages in their own
+// threads - demuxing and decoding per file, the filter graph, the encoder
+// (x264 with its own worker threads) - and in encoding mode nothing waits
+// for a clock, so a clip is usually done in less than its own length.
+//
+// Playback isn't touched: the players keep their own instances, and the
+// GUI thread only sees progress events.
+// ============================================================================
+
+#ifndef CLIPEXPORTER_H
+#define CLIPEXPORTER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+
+class MpvWidget;
+class PlayerBackend;
+class QThreadPool;
+
+class ClipExporter : public QObject {
+    Q_OBJECT
+
+public:
+    enum Layout { SideBySide, PictureInPicture };
+
+    struct Job {
+        QString firstPath;            // Player 1's file.
+        QString secondPath;           // Player 2's file.
+        double offset = 0.0;          // position(P2) - position(P1).
+        double inPoint = 0.0;         // Range, in player 1's time.
+        double outPoint = 0.0;
+        Layout layout = SideBySide;
+        qint64 firstAudio = 0;        // Player 1's audio track (0 = none).
+        double firstGain = 1.0;       // Linear audio gain of each player,
+        double secondGain = 1.0;      // see gainOf().
+        QString output;               // .mp4 or .mkv.
+    };
+
+    static const int ProgressIntervalMs = 200;
+
+    explicit ClipExporter(QObject *parent = nullptr);
+    ~ClipExporter();
+
+    // Default output folder: <Movies>/mpv-watchalong.
+    static QString defaultDirectory();
+
+    // The gain a player applies to its audio right now: the volume slider
+    // (MPV's volume is cubic) times the loudness matching gain.
+    static double gainOf(MpvWidget *player);
+
+    // Returns false, with the reason in error(), if the export can't start.
+    bool start(const Job &job);
+    void cancel();                    // The partial file is deleted.
+
+    bool isBusy() const;
+    QString error() const;
+
+    // The graph for the encoder - public so it can be inspected.
+    static QString exportGraph(Layout layout, int mainVid, int extraVid, int mainAid, int extraAid,
+                               int width, int height, double mainGain, double extraGain);
+
+signals:
+    // `fraction` 0-1 of the range, `speed` = clip seconds per second.
+    void progress(double fraction, double speed);
+    void finished(const QString &path);
+    void failed(const QString &reason);
+
+private:
+    class FinishTask;
+
+    static void onMpvWakeup(void *ctx);
+    void onMpvEvents();
+    void onFileLoaded();
+    void finish(const QString &reason);      // Empty reason = success.
+    void finalized(const QString &reason);
+
+    QThreadPool *pool;
+    PlayerBackend *encoder;                  // The private encoding instance.
+    Job job;
+    QString extraPath;
+    double rangeStart;                       // Composite time of inPoint.
+    double rangeLength;
+    bool loaded;
+    bool cancelled;
+    bool finishing;
+    QString errorText;
+    QElapsedTimer clock;
+    qint64 lastReport;                       // clock at the last progress().
+};
+
+#endif // CLIPEXPORTER_H
@@ -0,0 +1,304 @@
+// ============================================================================
+// compareview.cpp - Implementation of CompareView
+// ============================================================================
+
+#include "compareview.h"
+#include "mpvwidget.h"           // MpvWidget
+#include "simdkernels.h"         // blend() / absDiff()
+
+#include <QElapsedTimer>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <atomic>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+// Grab - State Shared with the Worker
+// ----------------------------------------------------------------------------
+struct CompareView::Grab {
+    std::atomic<bool> busy{false};
+    std::atomic<int> skipped{0};
+    double lastA = -1.0;               // GUI thread only: positions of the
+    double lastB = -1.0;               // frames on screen.
+};
+
+// ----------------------------------------------------------------------------
+// GrabTask - Copy Both Frames, Bring Them to One Size and Format
+// ----------------------------------------------------------------------------
+// Player 2's frame is scaled to player 1's size when they differ (e.g. a
+// 720p VOD against a 1080p movie), so every pixel compares like for like.
+// ----------------------------------------------------------------------------
+class CompareView::GrabTask : public QRunnable {
+public:
+    GrabTask(CompareView *owner, MpvWidget *first, MpvWidget *second, QSharedPointer<Grab> grab)
+        : owner(owner), first(first), second(second), grab(grab) {}
+
+    void run() override {
+        QElapsedTimer clock;
+        clock.start();
+
+        QImage a = first->grabFrame();
+        QImage b = second->grabFrame();
+        if (!a.isNull() && a.format() != QImage::Format_RGB32) a = a.convertToFormat(QImage::Format_RGB32);
+        if (!b.isNull() && b.format() != QImage::Format_RGB32) b = b.convertToFormat(QImage::Format_RGB32);
+        if (!a.isNull() && !b.isNull() && b.size() != a.size()) {
+            b = b.scaled(a.size(), Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        }
+
+        CompareView *owner = this->owner;
+        int ms = int(clock.elapsed());
+        QMetaObject::invokeMethod(owner, [owner, a, b, ms]() { owner->deliver(a, b, ms); }, Qt::QueuedConnection);
+        grab->busy = false;
+    }
+
+private:
+    CompareView *owner;
+    MpvWidget *first;
+    MpvWidget *second;
+    QSharedPointer<Grab> grab;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+CompareView::CompareView(MpvWidget *first, MpvWidget *second, QWidget *parent)
+    : QWidget(parent), first(first), second(second), grab(new Grab),
+      mode(Wipe), split(0.5), diffShift(2), showingB(false) {
+
+    setMinimumSize(320, 180);
+    setFocusPolicy(Qt::StrongFocus);         // For Space in flicker mode.
+    setMouseTracking(false);
+
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(1);
+
+    frameTimer = new QTimer(this);
+    frameTimer->setInterval(FrameIntervalMs);
+    connect(frameTimer, &QTimer::timeout, this, &CompareView::requestFrames);
+
+    flickerTimer = new QTimer(this);
+    connect(flickerTimer, &QTimer::timeout, this, &CompareView::toggleFlicker);
+}
+
+CompareView::~CompareView() {
+    stop();
+}
+
+QSize CompareView::sizeHint() const {
+    return QSize(960, 540);
+}
+
+void CompareView::stop() {
+    frameTimer->stop();
+    flickerTimer->stop();
+    pool->waitForDone();
+}
+
+// ----------------------------------------------------------------------------
+// Settings
+// ----------------------------------------------------------------------------
+void CompareView::setMode(Mode newMode) {
+    mode = newMode;
+    setCursor(mode == Wipe || mode == Blend ? Qt::SplitHCursor : Qt::ArrowCursor);
+    composite();
+}
+
+void CompareView::setDifferenceShift(int shift) {
+    diffShift = qBound(0, shift, 4);
+    if (mode == Difference) composite();
+}
+
+void CompareView::setAutoFlicker(int intervalMs) {
+    if (intervalMs <= 0) {
+        flickerTimer->stop();
+    } else {
+        flickerTimer->start(intervalMs);
+    }
+}
+
+void CompareView::toggleFlicker() {
+    showingB = !showingB;
+    if (mode == Flicker) update();
+}
+
+// ----------------------------------------------------------------------------
+// showEvent() / hideEvent() - Only Grab While Visible
+// ----------------------------------------------------------------------------
+void CompareView::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    grab->lastA = grab->lastB = -1.0;
+    frameTimer->start();
+}
+
+void CompareView::hideEvent(QHideEvent *event) {
+    QWidget::hideEvent(event);
+    frameTimer->stop();
+}
+
+// ----------------------------------------------------------------------------
+// requestFrames() / deliver()
+// ----------------------------------------------------------------------------
+// Paused players show the same frames, so nothing is grabbed until one of
+// them moves.
+// ----------------------------------------------------------------------------
+void CompareView::requestFrames() {
+    if (!first->hasFile() && !second->hasFile()) {
+        if (!frameA.isNull() || !frameB.isNull()) deliver(QImage(), QImage(), 0);
+        return;
+    }
+
+    double posA = first->hasFile() ? first->position() : -1.0;
+    double posB = second->hasFile() ? second->position() : -1.0;
+    if (posA == grab->lastA && posB == grab->lastB && (!frameA.isNull() || !frameB.isNull())) return;
+
+    if (grab->busy) {
+        grab->skipped++;
+        return;
+    }
+
+    grab->busy = true;
+    grab->lastA = posA;
+    grab->lastB = posB;
+    pool->start(new GrabTask(this, first, second, grab));
+}
+
+void CompareView::deliver(const QImage &a, const QImage &b, int grabMs) {
+    frameA = a;
+    frameB = b;
+    composite();
+    emit statsChanged(grabMs, grab->skipped);
+}
+
+// ----------------------------------------------------------------------------
+// composite() - Build the Displayed Image
+// ----------------------------------------------------------------------------
+// `composed` is written in place; scanLine() doesn't reallocate because
+// nothing else holds a reference to it. Flicker needs no compositing at
+// all - paintEvent() just picks a frame.
+// ----------------------------------------------------------------------------
+void CompareView::composite() {
+    if (frameA.isNull() || frameB.isNull() || mode == Flicker) {
+        update();
+        return;
+    }
+
+    if (composed.size() != frameA.size()) composed = QImage(frameA.size(), QImage::Format_RGB32);
+
+    const int w = frameA.width();
+    const size_t bytes = size_t(w) * 4;
+    const size_t cut = size_t(qBound(0, int(split * w + 0.5), w)) * 4;
+    const int weight = int(split * 256 + 0.5);
+
+    for (int y = 0; y < frameA.height(); y++) {
+        const uchar *a = frameA.constScanLine(y);
+        const uchar *b = frameB.constScanLine(y);
+        uchar *out = composed.scanLine(y);
+
+        switch (mode) {
+        case Wipe:
+            std::memcpy(out, a, cut);
+            std::memcpy(out + cut, b + cut, bytes - cut);
+            break;
+        case Blend:
+            SimdKernels::blend(a, b, out, bytes, weight);
+            break;
+        case Difference: {
+            SimdKernels::absDiff(a, b, out, bytes, diffShift);
+            quint32 *px = reinterpret_cast<quint32 *>(out);
+            for (int x = 0; x < w; x++) px[x] |= 0xff000000u;   // RGB32 wants opaque alpha.
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    update();
+}
+
+// ----------------------------------------------------------------------------
+// paintEvent()
+// ----------------------------------------------------------------------------
+// If only one player has a frame, it is shown on its own whatever the mode.
+// Scaling uses the fast (nearest) path - at 60 frames a second smooth
+// scaling would cost more than all the compositing.
+// ----------------------------------------------------------------------------
+void CompareView::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    const QImage *shown = nullptr;
+    QString label;
+    if (frameA.isNull() || frameB.isNull()) {
+        shown = frameA.isNull() ? (frameB.isNull() ? nullptr : &frameB) : &frameA;
+        label = frameA.isNull() ? "P2" : "P1";
+    } else if (mode == Flicker) {
+        shown = showingB ? &frameB : &frameA;
+        label = showingB ? "P2" : "P1";
+    } else {
+        shown = &composed;
+        if (mode == Blend) label = QString("P1 %1% / P2 %2%").arg(qRound((1.0 - split) * 100)).arg(qRound(split * 100));
+        if (mode == Difference) label = QString("|P1 - P2| x%1").arg(1 << diffShift);
+    }
+
+    painter.setPen(Qt::lightGray);
+    if (!shown) {
+        painter.drawText(rect(), Qt::AlignCenter, "Load a video in both players to compare them");
+        return;
+    }
+
+    QRect r = imageRect();
+    painter.drawImage(r, *shown);
+
+    if (mode == Wipe && !frameA.isNull() && !frameB.isNull()) {
+        int x = r.left() + int(split * r.width());
+        painter.setPen(QPen(Qt::white, 1));
+        painter.drawLine(x, r.top(), x, r.bottom());
+        painter.drawText(r.adjusted(6, 4, -6, -4), Qt::AlignLeft | Qt::AlignTop, "P1");
+        painter.drawText(r.adjusted(6, 4, -6, -4), Qt::AlignRight | Qt::AlignTop, "P2");
+    } else {
+        painter.drawText(r.adjusted(6, 4, -6, -4), Qt::AlignLeft | Qt::AlignTop, label);
+    }
+}
+
+QRect CompareView::imageRect() const {
+    QSize frame = !frameA.isNull() ? frameA.size() : frameB.size();
+    if (frame.isEmpty()) return rect();
+    QSize fitted = frame.scaled(size(), Qt::KeepAspectRatio);
+    return QRect((width() - fitted.width()) / 2, (height() - fitted.height()) / 2, fitted.width(), fitted.height());
+}
+
+// ----------------------------------------------------------------------------
+// Mouse and Keyboard
+// ----------------------------------------------------------------------------
+// Wipe/Blend: press or drag to move the split / change the mix.
+// Flicker: click or Space to switch players.
+// ----------------------------------------------------------------------------
+void CompareView::setSplitFromX(int x) {
+    QRect r = imageRect();
+    if (r.width() <= 0) return;
+    split = qBound(0.0, double(x - r.left()) / r.width(), 1.0);
+    composite();
+}
+
+void CompareView::mousePressEvent(QMouseEvent *event) {
+    if (mode == Flicker) toggleFlicker();
+    else if (mode == Wipe || mode == Blend) setSplitFromX(event->pos().x());
+}
+
+void CompareView::mouseMoveEvent(QMouseEvent *event) {
+    if ((event->buttons() & Qt::LeftButton) && (mode == Wipe || mode == Blend)) setSplitFromX(event->pos().x());
+}
+
+void CompareView::keyPressEvent(QKeyEvent *event) {
+    if (event->key() == Qt::Key_Space && mode == Flicker) {
+        toggleFlicker();
+        return;
+    }
+    QWidget::keyPressEvent(event);
+}
@@ -0,0 +1,332 @@
+// ============================================================================
+// compositeplayer.cpp - Implementation of CompositePlayer
+// ============================================================================
+
+#include "compositeplayer.h"
+#include "mpvwidget.h"           // MpvWidget
+#include "playerbackend.h"       // PlayerBackend::cpuSeconds()
+#include "playergroup.h"
+
+#include <QTimer>
+
+namespace {
+
+const int MinSamples = 3;        // Seconds of playback before a load is shown.
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+// The composite MPV instance is only created on the first enter(); most
+// sessions never use it.
+// ----------------------------------------------------------------------------
+CompositePlayer::CompositePlayer(PlayerGroup *group, QObject *parent)
+    : QObject(parent), group(group), composite(nullptr),
+      active(false), loading(false), currentLayout(SideBySide),
+      offset(0.0), startTime(0.0), startPaused(true), startAid(0), startVolume(-1.0), pausedOnLeave(true),
+      lastCpu(0.0), lastWall(0) {
+
+    load[Split] = load[Composite] = -1.0;
+    samples[Split] = samples[Composite] = 0;
+
+    wallClock.start();
+    restartSample();
+
+    costTimer = new QTimer(this);
+    costTimer->setInterval(CostIntervalMs);
+    connect(costTimer, &QTimer::timeout, this, &CompositePlayer::sampleCost);
+    costTimer->start();
+}
+
+CompositePlayer::~CompositePlayer() {
+    shutdown();
+}
+
+void CompositePlayer::shutdown() {
+    costTimer->stop();
+    if (composite) {
+        composite->shutdown();
+        composite->deleteLater();
+        composite = nullptr;
+    }
+    active = loading = false;
+}
+
+// ----------------------------------------------------------------------------
+// State Queries
+// ----------------------------------------------------------------------------
+bool CompositePlayer::isActive() const { return active; }
+CompositePlayer::Mode CompositePlayer::mode() const { return active ? Composite : Split; }
+QString CompositePlayer::error() const { return errorText; }
+CompositePlayer::Layout CompositePlayer::layout() const { return currentLayout; }
+QVector<double> CompositePlayer::offsets() const { return { 0.0, offset }; }
+bool CompositePlayer::wasPaused() const { return pausedOnLeave; }
+MpvWidget *CompositePlayer::player() const { return composite; }
+
+// ----------------------------------------------------------------------------
+// enter() - Take Over From the Two Players
+// ----------------------------------------------------------------------------
+// The players are paused first and their positions read afterwards, so the
+// offset can't change between reading it and the composite seeking there.
+// The composite opens paused; onFileLoaded() finishes the setup.
+// ----------------------------------------------------------------------------
+bool CompositePlayer::enter(Layout layout) {
+    if (active) {
+        setLayout(layout);
+        return true;
+    }
+
+    const QList<MpvWidget *> &members = group->members();
+    if (members.size() < 2) {
+        errorText = "Composite mode needs two players";
+        return false;
+    }
+    MpvWidget *first = members[0];
+    MpvWidget *second = members[1];
+    if (!first->hasFile() || first->isPrefilling() || !second->hasFile() || second->isPrefilling()) {
+        errorText = "Load a file in both players first";
+        return false;
+    }
+
+    startPaused = group->isPaused();
+    group->setPaused(true);
+
+    offset = group->currentOffsets().value(1);
+    const double shift1 = qMax(0.0, -offset);
+    const double shift2 = qMax(0.0, offset);
+    startTime = qMax(0.0, first->position() - shift1);
+
+    startAid = 0;
+    first->getInt("aid", &startAid);   // Stays 0 if "no".
+    startVolume = -1.0;
+    first->getDouble("volume", &startVolume);
+
+    QString mainPath = shiftedPath(first->currentPath(), shift1);
+    extraPath = shiftedPath(second->currentPath(), shift2);
+
+    if (!composite) {
+        composite = new MpvWidget();
+        composite->setVisible(false);
+        connect(composite, &MpvWidget::fileLoaded, this, &CompositePlayer::onFileLoaded);
+    }
+
+    errorText.clear();
+    currentLayout = layout;
+    active = true;
+    loading = true;
+
+    composite->setPaused(true);
+    composite->loadVideo(mainPath);
+    restartSample();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// onFileLoaded() - Add Player 2's File and Build the Graph
+// ----------------------------------------------------------------------------
+// "video-add ... auto" adds the second file as an extra (unselected) video
+// track; lavfi-complex then picks both tracks up by their ids. Frame sizes
+// come from the track list, because every filter here needs inputs of
+// identical size - player 2 is scaled to player 1's.
+// ----------------------------------------------------------------------------
+void CompositePlayer::onFileLoaded() {
+    if (!loading) return;
+    loading = false;
+
+    QByteArray pathBytes = extraPath.toUtf8();
+    const char *addCmd[] = {"video-add", pathBytes.constData(), "auto", NULL};
+    if (composite->command(addCmd) < 0) {
+        fail("Player 2's file could not be opened");
+        return;
+    }
+
+    QVariant trackList;
+    composite->getNode("track-list", &trackList);
+    tracks = findTracks(trackList, startAid);
+    if (tracks.mainVid == 0 || tracks.extraVid == 0) {
+        fail("Composite mode needs a video track in both files");
+        return;
+    }
+    if (!applyGraph()) {
+        fail("MPV rejected the composite filter graph");
+        return;
+    }
+
+    if (startVolume >= 0.0) composite->setDouble("volume", startVolume);
+    composite->seekAbsolute(startTime);
+    composite->setPaused(startPaused);
+
+    restartSample();
+    emit activeChanged(true);
+}
+
+bool CompositePlayer::applyGraph() {
+    QByteArray graph = layoutGraph(currentLayout, tracks.mainVid, tracks.extraVid, tracks.mainAid,
+                                   tracks.width, tracks.height).toUtf8();
+    return composite->setString("lavfi-complex", graph.constData()) >= 0;
+}
+
+void CompositePlayer::fail(const QString &reason) {
+    errorText = reason;
+    composite->closeVideo();
+    active = loading = false;
+    group->setPaused(startPaused);           // The players never moved.
+    restartSample();
+    emit failed(reason);
+}
+
+// ----------------------------------------------------------------------------
+// setLayout()
+// ----------------------------------------------------------------------------
+// Changing lavfi-complex at runtime makes MPV rebuild the graph in place -
+// the position and the pause state stay as they are.
+// ----------------------------------------------------------------------------
+void CompositePlayer::setLayout(Layout layout) {
+    currentLayout = layout;
+    if (active && !loading && !applyGraph()) fail("MPV rejected the composite filter graph");
+}
+
+// ----------------------------------------------------------------------------
+// leave() - Hand the Position Back
+// ----------------------------------------------------------------------------
+double CompositePlayer::leave() {
+    if (!active) return group->position();
+
+    double time = loading ? startTime : composite->position();
+    pausedOnLeave = loading ? startPaused : composite->isPaused();
+
+    composite->closeVideo();
+    active = loading = false;
+    restartSample();
+    emit activeChanged(false);
+
+    return time + qMax(0.0, -offset);        // Composite time -> player 1's time.
+}
+
+// ----------------------------------------------------------------------------
+// findTracks()
+// ----------------------------------------------------------------------------
+// Files added with video-add/audio-add are the "external" tracks. If the
+// preferred audio track is gone, the main file's first one is used.
+// ----------------------------------------------------------------------------
+CompositePlayer::Tracks CompositePlayer::findTracks(const QVariant &trackList, qint64 preferredAid) {
+    Tracks found;
+
+    const QVariantList list = trackList.toList();
+
+    int firstAid = 0;
+    for (const QVariant &entry : list) {
+        QVariantMap track = entry.toMap();
+        QString type = track.value("type").toString();
+        int id = track.value("id").toInt();
+        bool external = track.value("external").toBool();
+
+        if (type == "video" && !external && found.mainVid == 0) {
+            found.mainVid = id;
+            found.width = track.value("demux-w").toInt();
+            found.height = track.value("demux-h").toInt();
+        } else if (type == "video" && external) {
+            found.extraVid = id;             // The track video-add just added.
+        } else if (type == "audio" && external) {
+            found.extraAid = id;
+        } else if (type == "audio") {
+            if (firstAid == 0) firstAid = id;
+            if (id == preferredAid) found.mainAid = id;
+        }
+    }
+    if (found.mainAid == 0 && preferredAid != 0) found.mainAid = firstAid;
+    return found;
+}
+
+// ----------------------------------------------------------------------------
+// layoutGraph() - The lavfi-complex String
+// ----------------------------------------------------------------------------
+// Both inputs are brought to the same size, sample aspect and pixel format
+// first; hstack and blend refuse anything else. The difference is taken in
+// RGB (in YUV the chroma of "no difference" would be mid-grey, i.e. green)
+// and scaled up so small compression errors become visible. Player 1's
+// audio is passed through; without an [ao] output the composite is silent.
+// ----------------------------------------------------------------------------
+QString CompositePlayer::layoutGraph(Layout layout, int mainVid, int extraVid, int aid, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        width = 1920;                        // The file doesn't say - any size
+        height = 1080;                       // works as long as both match.
+    }
+    const QString format = layout == Difference ? "gbrp" : "yuv420p";
+    const QString prepare = QString("scale=%1:%2,setsar=1,format=%3").arg(width).arg(height).arg(format);
+
+    QString graph = QString("[vid%1]%3[a];[vid%2]%3[b];").arg(mainVid).arg(extraVid).arg(prepare);
+    switch (layout) {
+    case Blend:
+        graph += "[a][b]blend=all_mode=average[vo]";
+        break;
+    case Difference:
+        graph += QString("[a][b]blend=all_mode=difference,lutrgb=r=val*%1:g=val*%1:b=val*%1[vo]").arg(DifferenceGain);
+        break;
+    default:
+        graph += "[a][b]hstack[vo]";
+        break;
+    }
+    if (aid > 0) graph += QString(";[aid%1]anull[ao]").arg(aid);
+    return graph;
+}
+
+// ----------------------------------------------------------------------------
+// shiftedPath() - A Path That Starts Later
+// ----------------------------------------------------------------------------
+// An EDL with a single segment: "edl://%<bytes>%<path>,<start>". The
+// %bytes% prefix makes any path safe, commas and semicolons included; no
+// length means "to the end of the file".
+// ----------------------------------------------------------------------------
+QString CompositePlayer::shiftedPath(const QString &path, double start) {
+    if (start < 0.0005) return path;
+    return QString("edl://%") + QString::number(path.toUtf8().size()) + "%" + path + ","
+         + QString::number(start, 'f', 3);
+}
+
+// ----------------------------------------------------------------------------
+// Decode Cost
+// ----------------------------------------------------------------------------
+// Once a second, the CPU time used since the last sample - with
+// --out-of-process the helpers' too, where the players decode - is
+// divided by the wall time and credited to the current mode - if that mode was actually
+// playing (both players in split mode, the composite otherwise). A moving
+// average smooths out keyframes and seeks.
+// ----------------------------------------------------------------------------
+void CompositePlayer::restartSample() {
+    lastCpu = PlayerBackend::cpuSeconds();
+    lastWall = wallClock.elapsed();
+}
+
+void CompositePlayer::sampleCost() {
+    double cpu = PlayerBackend::cpuSeconds();
+    qint64 wall = wallClock.elapsed();
+    double usedCpu = cpu - lastCpu;
+    qint64 elapsed = wall - lastWall;
+    lastCpu = cpu;
+    lastWall = wall;
+    if (elapsed <= 0) return;
+
+    Mode current = mode();
+    bool playing = false;
+    if (current == Composite) {
+        playing = !loading && composite->hasFile() && !composite->isPaused();
+    } else {
+        const QList<MpvWidget *> &members = group->members();
+        playing = members.size() >= 2 && !group->isPaused();
+        for (int i = 0; playing && i < 2; i++) {
+            playing = members[i]->hasFile() && !members[i]->isPrefilling();
+        }
+    }
+    if (!playing) return;
+
+    double value = 100.0 * usedCpu / (elapsed / 1000.0);
+    load[current] = load[current] < 0.0 ? value : load[current] + (value - load[current]) * 0.2;
+    samples[current]++;
+    if (samples[current] >= MinSamples) emit costChanged();
+}
+
+double CompositePlayer::cpuLoad(Mode mode) const {
+    return samples[mode] >= MinSamples ? load[mode] : -1.0;
+}
@@ -0,0 +1,163 @@
+// ============================================================================
+// compositeplayer.h - Both Files in ONE MPV Instance (lavfi-complex)
+// ============================================================================
+// Two MpvWidgets mean two clocks, two audio outputs and two decoders; they
+// drift apart and have to be pulled back together all the time. For pure
+// comparison (two encodes of the same source) CompositePlayer offers the
+// alternative: a third MPV instance opens player 1's file with player 2's
+// file as an extra video track, and libavfilter combines them into one
+// picture ("lavfi-complex"):
+//
+//   SIDE BY SIDE - hstack
+//   BLEND        - 50/50 average
+//   DIFFERENCE   - |P1 - P2| in RGB, amplified
+//
+// One demuxer clock drives both tracks, so alignment is exact by
+// construction - no barrier, no drift correction.
+//
+// The players' offset is built into the files themselves: whichever file
+// is AHEAD is opened as an EDL ("edl://file,start") that starts `offset`
+// seconds into it, so both tracks share timestamps:
+//
+//     offset = position(P2) - position(P1)       (see playergroup.h)
+//     composite time = position(P1) - max(0, -offset)
+//                    = position(P2) - max(0,  offset)
+//
+// enter() takes the group's position, offset and pause state over (the two
+// players are paused and keep their files); leave() hands the composite's
+// position back, so switching modes never loses the place.
+//
+// The cost meter samples the whole process's CPU time while something plays, so
+// the cost of composite mode can be compared to dual-instance mode under
+// the same conditions. With hardware decoding most of the work moves to
+// the GPU and doesn't show up here.
+// ============================================================================
+
+#ifndef COMPOSITEPLAYER_H
+#define COMPOSITEPLAYER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+class MpvWidget;
+class PlayerGroup;
+class QTimer;
+
+class CompositePlayer : public QObject {
+    Q_OBJECT
+
+public:
+    enum Layout { SideBySide, Blend, Difference };
+    enum Mode { Split, Composite };
+
+    static const int DifferenceGain = 4;     // Amplification of the difference.
+    static const int CostIntervalMs = 1000;  // CPU sampling period.
+
+    explicit CompositePlayer(PlayerGroup *group, QObject *parent = nullptr);
+    ~CompositePlayer();
+
+    // ------------------------------------------------------------------------
+    // Switching Modes
+    // ------------------------------------------------------------------------
+    // enter() needs the first two group members to have a file (and not be
+    // prefilling). It returns false, with the reason in error(), otherwise.
+    // The composite is ready once activeChanged(true) is emitted.
+    //
+    // leave() returns the group time (player 1's position) the composite
+    // was at; the caller seeks the group there with offsets() - e.g. through
+    // the BufferingBarrier - and restores wasPaused().
+    // ------------------------------------------------------------------------
+
+    bool enter(Layout layout);
+    double leave();
+
+    bool isActive() const;                   // Entered (loading or playing).
+    Mode mode() const;
+    QString error() const;
+
+    void setLayout(Layout layout);           // Switch layouts while active.
+    Layout layout() const;
+
+    QVector<double> offsets() const;         // {0, offset} as taken in enter().
+    bool wasPaused() const;                  // Pause state when leave() was called.
+
+    MpvWidget *player() const;               // The composite instance, for the
+    // transport controls while active. Null until the first enter().
+
+    void shutdown();                         // Before the application quits.
+
+    // ------------------------------------------------------------------------
+    // Decode Cost
+    // ------------------------------------------------------------------------
+    // Average CPU load of the app and its player helpers (100 = one core)
+    // while playing in the given mode, or -1 if that mode hasn't played
+    // long enough to tell.
+    // ------------------------------------------------------------------------
+
+    double cpuLoad(Mode mode) const;
+
+    // ------------------------------------------------------------------------
+    // Building Blocks (also used by ClipExporter)
+    // ------------------------------------------------------------------------
+    // Track ids and the main video's size in an MPV instance whose extra
+    // file was added with video-add/audio-add. `preferredAid` is the audio
+    // track to use from the main file if it exists (0 = none wanted).
+    // ------------------------------------------------------------------------
+    struct Tracks {
+        int mainVid = 0;
+        int extraVid = 0;
+        int mainAid = 0;
+        int extraAid = 0;
+        int width = 0;
+        int height = 0;
+    };
+    static Tracks findTracks(const QVariant &trackList, qint64 preferredAid);   // From "track-list".
+
+    // The lavfi-complex graph for a layout, and a path that starts `start`
+    // seconds into the file (itself if start is 0).
+    static QString layoutGraph(Layout layout, int mainVid, int extraVid, int aid,
+                               int width, int height);
+    static QString shiftedPath(const QString &path, double start);
+
+signals:
+    void activeChanged(bool active);
+    void failed(const QString &reason);
+    void costChanged();
+
+private:
+    void onFileLoaded();
+    bool applyGraph();
+    void fail(const QString &reason);
+    void restartSample();                    // Don't count the switch itself.
+    void sampleCost();
+
+    PlayerGroup *group;
+    MpvWidget *composite;
+    QTimer *costTimer;
+
+    bool active;
+    bool loading;                            // Between enter() and fileLoaded.
+    Layout currentLayout;
+    QString errorText;
+
+    QString extraPath;                       // Player 2's file, possibly shifted.
+    double offset;                           // position(P2) - position(P1).
+    double startTime;                        // Composite time to seek to after loading.
+    bool startPaused;
+    qint64 startAid;                         // Player 1's audio track.
+    double startVolume;
+    bool pausedOnLeave;
+
+    Tracks tracks;                           // Inside the composite.
+
+    QElapsedTimer wallClock;
+    double lastCpu;                          // PlayerBackend::cpuSeconds() at the last sample.
+    qint64 lastWall;                         // wallClock at the last sample.
+    double load[2];                          // Per mode, averaged; -1 = unknown.
+    int samples[2];
+};
+
+#endif // COMPOSITEPLAYER_H
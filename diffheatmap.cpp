@@ -0,0 +1,386 @@
+// ============================================================================
+// diffheatmap.cpp - Implementation of DiffSeries and DiffAnalyzer
+// ============================================================================
+
+#include "diffheatmap.h"
+#include "framedecoder.h"
+#include "simdkernels.h"
+#include "analysiscache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QThread>
+
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Constants
+// ----------------------------------------------------------------------------
+static const double PrerollSeconds = 1.0;            // Decode from a keyframe before this.
+static const double MinSegmentSeconds = 60.0;        // Shorter segments aren't worth a seek.
+static const double MatchTolerance = 0.005;          // Timestamp jitter between the files.
+static const int MaxLevels = 32;
+
+static const quint32 CacheMagic = 0x57414446;        // "WADF"
+static const quint32 CacheVersion = 1;
+
+namespace {
+struct FrameScore {
+    double time;                                     // File 1's time, seconds.
+    quint8 score;                                    // Mean |difference| * ScoreScale.
+};
+}
+
+// ============================================================================
+// DiffSeries
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// build() - Level 0 In, the Pyramid Out
+// ----------------------------------------------------------------------------
+// Each level halves the previous one: the mean of the two means (the
+// buckets cover equal time) and the larger peak.
+// ----------------------------------------------------------------------------
+QSharedPointer<DiffSeries> DiffSeries::build(const QVector<quint8> &scores, double offset,
+                                             double firstTime, double lastTime) {
+    if (scores.isEmpty()) return {};
+
+    QSharedPointer<DiffSeries> series(new DiffSeries);
+    series->alignment = offset;
+    series->first = firstTime;
+    series->last = lastTime;
+
+    QVector<Bucket> base(scores.size());
+    for (int i = 0; i < scores.size(); i++) base[i] = { scores[i], scores[i] };
+    series->levels.append(base);
+
+    while (series->levels.last().size() > 1 && series->levels.size() < MaxLevels) {
+        const QVector<Bucket> &fine = series->levels.last();
+        QVector<Bucket> coarse((fine.size() + 1) / 2);
+        for (int i = 0; i < coarse.size(); i++) {
+            const Bucket &a = fine[2 * i];
+            if (2 * i + 1 >= fine.size()) {
+                coarse[i] = a;
+                continue;
+            }
+            const Bucket &b = fine[2 * i + 1];
+            coarse[i].mean = static_cast<quint8>((a.mean + b.mean + 1) / 2);
+            coarse[i].peak = qMax(a.peak, b.peak);
+        }
+        series->levels.append(coarse);
+    }
+    return series;
+}
+
+// ----------------------------------------------------------------------------
+// serialize() / deserialize() - Cache Format
+// ----------------------------------------------------------------------------
+// Only level 0 is stored; the upper levels are rebuilt on loading, which
+// takes a few milliseconds.
+// ----------------------------------------------------------------------------
+QByteArray DiffSeries::serialize() const {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << CacheMagic << CacheVersion << qint32(BucketMs) << alignment << first << last;
+
+    QByteArray scores;
+    scores.reserve(levels.value(0).size());
+    for (const Bucket &bucket : levels.value(0)) scores.append(static_cast<char>(bucket.mean));
+    out << scores;
+    return data;
+}
+
+QSharedPointer<DiffSeries> DiffSeries::deserialize(const QByteArray &data) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0, version = 0;
+    qint32 bucketMs = 0;
+    double offset = 0.0, firstTime = 0.0, lastTime = 0.0;
+    QByteArray scores;
+    in >> magic >> version >> bucketMs;
+    if (magic != CacheMagic || version != CacheVersion || bucketMs != BucketMs) return {};
+    in >> offset >> firstTime >> lastTime >> scores;
+    if (in.status() != QDataStream::Ok) return {};
+
+    QVector<quint8> base(scores.size());
+    for (int i = 0; i < scores.size(); i++) base[i] = static_cast<quint8>(scores[i]);
+    return build(base, offset, firstTime, lastTime);
+}
+
+int DiffSeries::levelCount() const { return levels.size(); }
+int DiffSeries::bucketCount(int level) const { return levels.value(level).size(); }
+double DiffSeries::bucketSeconds(int level) const { return BucketMs / 1000.0 * double(qint64(1) << level); }
+double DiffSeries::duration() const { return bucketCount(0) * bucketSeconds(0); }
+double DiffSeries::offset() const { return alignment; }
+double DiffSeries::firstTime() const { return first; }
+double DiffSeries::lastTime() const { return last; }
+
+const DiffSeries::Bucket *DiffSeries::buckets(int level) const {
+    if (level < 0 || level >= levels.size()) return nullptr;
+    return levels[level].constData();
+}
+
+quint8 DiffSeries::peak() const {
+    return levels.isEmpty() ? 0 : levels.last()[0].peak;
+}
+
+// ============================================================================
+// DiffAnalyzer
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Job - Shared State of One Pass
+// ----------------------------------------------------------------------------
+// `path` is file 1. Progress is counted in milliseconds of file 1 covered.
+// ----------------------------------------------------------------------------
+struct DiffAnalyzer::Job : BackgroundAnalysis::Job {
+    QString path2;
+    double offset = 0.0;
+
+    double firstTime = 0.0;                  // File 1's time range both files cover.
+    double lastTime = 0.0;
+
+    // One entry per segment. Every task writes only its own entry.
+    struct Segment {
+        double start = 0.0;
+        double end = 0.0;
+        QVector<FrameScore> frames;
+    };
+    QVector<Segment> segments;
+};
+
+// ----------------------------------------------------------------------------
+// SegmentTask - Decode Both Files Over One Segment, Score Every Frame
+// ----------------------------------------------------------------------------
+// File 1 leads: for each of its frames, file 2 is decoded up to the last
+// frame that is shown at that moment (time + offset). Different frame
+// rates therefore compare each frame with what is on screen next to it,
+// exactly as in the players.
+// ----------------------------------------------------------------------------
+class DiffAnalyzer::SegmentTask : public Task {
+public:
+    SegmentTask(QSharedPointer<Job> job, int index) : Task(job), job(job), index(index) {}
+
+private:
+    void work() override {
+        Job::Segment &segment = job->segments[index];
+
+        FrameDecoder first, second;
+        if (!first.open(job->path)) {
+            job->fail("Player 1's file: " + first.errorString());
+            return;
+        }
+        if (!second.open(job->path2)) {
+            job->fail("Player 2's file: " + second.errorString());
+            return;
+        }
+        first.seek(qMax(0.0, segment.start - PrerollSeconds));
+        second.seek(qMax(0.0, segment.start + job->offset - PrerollSeconds));
+
+        const size_t pixels = FrameDecoder::ThumbWidth * FrameDecoder::ThumbHeight;
+        QVector<quint8> thumb1, shown2, next2;
+        double next2Time = 0.0;
+        bool haveShown = false, haveNext = false, secondEnded = false;
+        double reached = segment.start;      // For the progress counter.
+
+        while (!job->cancelled) {
+            double time = 0.0;
+            int r = first.decode(thumb1, time);
+            if (r < 0) {
+                if (segment.frames.isEmpty()) job->fail("Player 1's file: " + first.errorString());
+                return;
+            }
+            if (r == 0) return;
+            if (time < 0.0 || time < segment.start) continue;
+            if (time >= segment.end) return;
+
+            const double target = time + job->offset + MatchTolerance;
+            while (!secondEnded) {
+                if (!haveNext) {
+                    int r2 = second.decode(next2, next2Time);
+                    if (r2 <= 0) {
+                        secondEnded = true;
+                        break;
+                    }
+                    if (next2Time < 0.0) continue;
+                    haveNext = true;
+                }
+                if (next2Time > target) break;
+                shown2.swap(next2);
+                haveShown = true;
+                haveNext = false;
+            }
+            if (!haveShown) continue;        // File 2 hasn't started yet here.
+
+            quint64 sad = SimdKernels::sumAbsDiff(thumb1.constData(), shown2.constData(), pixels);
+            double mean = double(sad) / pixels;
+            int score = qMin(255, static_cast<int>(std::lround(mean * DiffSeries::ScoreScale)));
+            segment.frames.append({ time, static_cast<quint8>(score) });
+
+            if (time > reached) {
+                job->done += static_cast<qint64>((time - reached) * 1000.0);
+                reached = time;
+            }
+        }
+    }
+
+    QSharedPointer<Job> job;
+    int index;
+};
+
+// ----------------------------------------------------------------------------
+// PlanTask - Find the Overlap and Split It Into Segments
+// ----------------------------------------------------------------------------
+class DiffAnalyzer::PlanTask : public Task {
+public:
+    explicit PlanTask(QSharedPointer<Job> job) : Task(job), job(job) {}
+
+private:
+    void work() override {
+        FrameDecoder probe1, probe2;
+        double duration1 = probe1.open(job->path) ? probe1.duration() : 0.0;
+        double duration2 = probe2.open(job->path2) ? probe2.duration() : 0.0;
+        QString error = duration1 <= 0.0 ? "Player 1's file: " + probe1.errorString()
+                                         : "Player 2's file: " + probe2.errorString();
+        probe1.close();
+        probe2.close();
+
+        // File 1's times that have a counterpart in file 2.
+        job->firstTime = qMax(0.0, -job->offset);
+        job->lastTime = qMin(duration1, duration2 - job->offset);
+        const double span = job->lastTime - job->firstTime;
+        if (duration1 <= 0.0 || duration2 <= 0.0 || span <= 0.0) {
+            // No segments: the job comes straight back and finishJob()
+            // reports the failure.
+            job->fail(duration1 <= 0.0 || duration2 <= 0.0 ? error : QString("The files don't overlap"));
+            return;
+        }
+
+        int count = segmentCount(*job, span, MinSegmentSeconds);
+
+        job->segments.resize(count);
+        for (int i = 0; i < count; i++) {
+            job->segments[i].start = job->firstTime + span * i / count;
+            job->segments[i].end = job->firstTime + span * (i + 1) / count;
+        }
+        job->total = static_cast<qint64>(span * 1000.0);
+
+        for (int i = 0; i < count; i++) {
+            spawn(job, new SegmentTask(job, i));
+        }
+    }
+
+    QSharedPointer<Job> job;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor - One Thread per Core
+// ----------------------------------------------------------------------------
+DiffAnalyzer::DiffAnalyzer(QObject *parent)
+    : BackgroundAnalysis(QThread::idealThreadCount(), parent) {}
+
+bool DiffAnalyzer::isAvailable() {
+    return FrameDecoder::isAvailable();
+}
+
+// ----------------------------------------------------------------------------
+// cacheKind() - One Cache Entry per Pair and Offset
+// ----------------------------------------------------------------------------
+// The entry belongs to file 1 (see analysiscache.h); its kind names file 2
+// by the same identity (path, size, modification time) and the offset in
+// milliseconds.
+// ----------------------------------------------------------------------------
+QString DiffAnalyzer::cacheKind(const QString &path2, double offset) {
+    QString second = QFileInfo(AnalysisCache::cacheFile(path2, "diff")).completeBaseName();
+    if (second.isEmpty()) return QString();
+    QByteArray identity = second.toLatin1() + '\n' + QByteArray::number(qRound64(offset * 1000.0));
+    return "diff-" + QString::fromLatin1(QCryptographicHash::hash(identity, QCryptographicHash::Sha1).toHex().left(16));
+}
+
+// ----------------------------------------------------------------------------
+// analyze() / cancel() / series()
+// ----------------------------------------------------------------------------
+void DiffAnalyzer::analyze(const QString &path1, const QString &path2, double offset) {
+    cancel();
+
+    if (!isAvailable()) {
+        emit failed(0, "Built without libav");
+        return;
+    }
+
+    QString kind = cacheKind(path2, offset);
+    QByteArray cached;
+    if (!kind.isEmpty() && AnalysisCache::load(path1, kind, cached)) {
+        result = DiffSeries::deserialize(cached);
+        if (result) {
+            emit finished(0);
+            return;
+        }
+    }
+
+    QSharedPointer<Job> job(new Job);
+    job->path = path1;
+    job->path2 = path2;
+    job->offset = offset;
+    start(0, job, new PlanTask(job));
+}
+
+void DiffAnalyzer::cancel() {
+    BackgroundAnalysis::cancel(0);
+}
+
+bool DiffAnalyzer::isRunning() const {
+    return BackgroundAnalysis::isRunning(0);
+}
+
+void DiffAnalyzer::forget(int) {
+    result.reset();
+}
+
+QSharedPointer<DiffSeries> DiffAnalyzer::series() const {
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// finishJob() - Frames Into Buckets (GUI Thread)
+// ----------------------------------------------------------------------------
+// A bucket takes the largest score of the frames starting in it; a bucket
+// no frame starts in shows the frame before it, which is still on screen.
+// Before the overlap the buckets stay 0.
+// ----------------------------------------------------------------------------
+void DiffAnalyzer::finishJob(QSharedPointer<BackgroundAnalysis::Job> done) {
+    QSharedPointer<Job> job = done.staticCast<Job>();
+    const double bucketSeconds = DiffSeries::BucketMs / 1000.0;
+    const int count = static_cast<int>(std::ceil(job->lastTime / bucketSeconds));
+
+    QVector<quint8> scores(qMax(0, count), 0);
+    QVector<bool> filled(scores.size(), false);
+    int frames = 0;
+    for (const Job::Segment &segment : job->segments) {
+        for (const FrameScore &frame : segment.frames) {
+            int i = static_cast<int>(frame.time / bucketSeconds);
+            if (i < 0 || i >= scores.size()) continue;
+            scores[i] = filled[i] ? qMax(scores[i], frame.score) : frame.score;
+            filled[i] = true;
+            frames++;
+        }
+    }
+
+    if (frames == 0) {
+        emit failed(0, job->errorOr("No frames compared"));
+        return;
+    }
+
+    int previous = -1;
+    for (int i = 0; i < scores.size(); i++) {
+        if (filled[i]) previous = i;
+        else if (previous >= 0 && i * bucketSeconds < job->lastTime) scores[i] = scores[previous];
+    }
+
+    result = DiffSeries::build(scores, job->offset, job->firstTime, job->lastTime);
+    QString kind = cacheKind(job->path2, job->offset);
+    if (!kind.isEmpty()) AnalysisCache::save(job->path, kind, result->serialize());
+    emit finished(0);
+}
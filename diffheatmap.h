@@ -0,0 +1,113 @@
+// ============================================================================
+// diffheatmap.h - Whole-File Difference Series of Two Aligned Encodes
+// ============================================================================
+// Reviewing an encode means finding the few places where it went wrong -
+// smeared motion, banding, a dropped frame - in two hours of picture. The
+// DiffAnalyzer compares player 1's file with player 2's, frame by frame,
+// BEFORE anyone scrubs, and the heatmap under the players (see
+// diffheatmapview.h) shows where the differences are.
+//
+// How it works: both files are decoded at thumbnail resolution with
+// FrameDecoder, aligned by the players' offset
+//
+//     time in file 2 = time in file 1 + offset          (see playergroup.h)
+//
+// and every frame of file 1 is scored against the frame of file 2 shown at
+// the same moment: the mean absolute luma difference (SimdKernels::
+// sumAbsDiff). Like the scene scan, the overlap is split into segments
+// that are decoded in parallel on a low-priority pool with one thread per
+// core (see backgroundanalysis.h) - each with a decoder for each file - so
+// a pass runs many times faster than real time.
+//
+// The scores are kept as a small PYRAMID, like the waveform's:
+//
+//   level 0  - one bucket per BucketMs of file 1's time
+//   level n  - one bucket per 2 level n-1 buckets, down to a single bucket
+//
+// Each bucket holds the mean and the peak score of its frames, one byte
+// each, so a two-hour pair takes about 1.5 MB, and drawing W pixels reads
+// about W buckets. Results are cached for the file pair AND the offset -
+// moving one player against the other is a different comparison.
+// ============================================================================
+
+#ifndef DIFFHEATMAP_H
+#define DIFFHEATMAP_H
+
+#include "backgroundanalysis.h"
+
+#include <QByteArray>
+#include <QVector>
+
+// ----------------------------------------------------------------------------
+// DiffSeries - The Scores of One Comparison
+// ----------------------------------------------------------------------------
+class DiffSeries {
+public:
+    static const int BucketMs = 20;          // Finer than a frame up to 50 fps.
+    static const int ScoreScale = 4;         // Stored byte = mean |difference| * 4.
+
+    struct Bucket {
+        quint8 mean;
+        quint8 peak;
+    };
+
+    // Builds the upper levels from per-bucket scores (level 0).
+    static QSharedPointer<DiffSeries> build(const QVector<quint8> &scores, double offset,
+                                            double firstTime, double lastTime);
+
+    QByteArray serialize() const;
+    static QSharedPointer<DiffSeries> deserialize(const QByteArray &data);
+
+    int levelCount() const;
+    int bucketCount(int level) const;
+    double bucketSeconds(int level) const;   // Time covered by one bucket.
+    const Bucket *buckets(int level) const;
+    double duration() const;                 // Of the level-0 series.
+
+    double offset() const;                   // The alignment that was compared.
+    double firstTime() const;                // File 1's time covered by both files.
+    double lastTime() const;
+    quint8 peak() const;                     // Largest score anywhere.
+
+private:
+    QVector<QVector<Bucket>> levels;
+    double alignment = 0.0;
+    double first = 0.0;
+    double last = 0.0;
+};
+
+// ----------------------------------------------------------------------------
+// DiffAnalyzer - Runs One Comparison at a Time
+// ----------------------------------------------------------------------------
+// The comparison covers both players, so it always runs in slot 0; the
+// signals inherited from BackgroundAnalysis carry that 0.
+// ----------------------------------------------------------------------------
+class DiffAnalyzer : public BackgroundAnalysis {
+    Q_OBJECT
+
+public:
+    explicit DiffAnalyzer(QObject *parent = nullptr);
+
+    static bool isAvailable();               // False when built without libav.
+
+    // Compare `path1` with `path2` at `offset`. A cached result finishes
+    // immediately; a running pass is cancelled first.
+    void analyze(const QString &path1, const QString &path2, double offset);
+    void cancel();                           // Also forgets the result.
+    bool isRunning() const;
+
+    QSharedPointer<DiffSeries> series() const;   // Null until finished().
+
+private:
+    struct Job;                              // One pass - see the .cpp file.
+    class PlanTask;
+    class SegmentTask;
+
+    static QString cacheKind(const QString &path2, double offset);
+    void finishJob(QSharedPointer<BackgroundAnalysis::Job> done) override;
+    void forget(int slot) override;
+
+    QSharedPointer<DiffSeries> result;
+};
+
+#endif // DIFFHEATMAP_H
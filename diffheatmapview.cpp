@@ -0,0 +1,137 @@
+// ============================================================================
+// diffheatmapview.cpp - Implementation of DiffHeatmapView
+// ============================================================================
+
+#include "diffheatmapview.h"
+#include "diffheatmap.h"
+#include "mpvwidget.h"           // For the full MpvWidget class definition.
+
+#include <QMouseEvent>
+#include <QPainter>
+
+static const int MinScalePeak = 4 * DiffSeries::ScoreScale;  // Mean |difference| of 4 = full red.
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+DiffHeatmapView::DiffHeatmapView(MpvWidget *player, QWidget *parent)
+    : QWidget(parent), player(player), playhead(0.0) {
+
+    setMinimumHeight(18);
+    setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Fixed);
+    setCursor(Qt::PointingHandCursor);
+
+    player->observeProperty("time-pos");
+    connect(player, &MpvWidget::propertyChanged, this, [this](const QString &name, const QVariant &value) {
+        if (name != "time-pos") return;
+        playhead = value.toDouble();
+        if (data) update();
+    });
+}
+
+QSize DiffHeatmapView::sizeHint() const {
+    return QSize(200, 22);
+}
+
+void DiffHeatmapView::setSeries(QSharedPointer<DiffSeries> series) {
+    data = series;
+    message.clear();
+    update();
+}
+
+void DiffHeatmapView::setMessage(const QString &text) {
+    data.reset();
+    message = text;
+    update();
+}
+
+QSharedPointer<DiffSeries> DiffHeatmapView::series() const {
+    return data;
+}
+
+// ----------------------------------------------------------------------------
+// paintEvent()
+// ----------------------------------------------------------------------------
+// Same level choice as the waveform: the coarsest level whose buckets are
+// no longer than a pixel, then the peak of the buckets under each column.
+// Colour ramp: base colour -> orange -> red.
+// ----------------------------------------------------------------------------
+void DiffHeatmapView::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    const QColor base = palette().color(QPalette::Base);
+    painter.fillRect(rect(), base);
+
+    const int w = width();
+    const int h = height();
+
+    if (!data || data->duration() <= 0.0 || w <= 0) {
+        if (!message.isEmpty()) {
+            painter.setPen(palette().color(QPalette::PlaceholderText));
+            painter.drawText(rect(), Qt::AlignCenter, message);
+        }
+        return;
+    }
+
+    const double span = data->duration();
+    const double secondsPerPixel = span / w;
+
+    int level = 0;
+    while (level + 1 < data->levelCount() && data->bucketSeconds(level + 1) <= secondsPerPixel) {
+        level++;
+    }
+    const DiffSeries::Bucket *buckets = data->buckets(level);
+    const int count = data->bucketCount(level);
+    const double bucketSeconds = data->bucketSeconds(level);
+    const double scale = qMax<int>(MinScalePeak, data->peak());
+
+    const QColor warm("#ff9900");
+    const QColor hot("#cc0000");
+    auto mix = [](const QColor &a, const QColor &b, double t) {
+        return QColor::fromRgbF(a.redF() + (b.redF() - a.redF()) * t,
+                                a.greenF() + (b.greenF() - a.greenF()) * t,
+                                a.blueF() + (b.blueF() - a.blueF()) * t);
+    };
+
+    for (int x = 0; x < w; x++) {
+        double t0 = x * secondsPerPixel;
+        if (t0 + secondsPerPixel < data->firstTime() || t0 > data->lastTime()) {
+            painter.setPen(palette().color(QPalette::Mid));
+            if (x % 4 == 0) painter.drawLine(QPointF(x + 0.5, 0), QPointF(x + 0.5, h));
+            continue;
+        }
+
+        int first = static_cast<int>(t0 / bucketSeconds);
+        int last = static_cast<int>((t0 + secondsPerPixel) / bucketSeconds);
+        if (first >= count) break;
+        last = qBound(first, last, count - 1);
+
+        int peak = 0;
+        for (int i = first; i <= last; i++) peak = qMax(peak, int(buckets[i].peak));
+
+        double level01 = qMin(1.0, peak / scale);
+        QColor colour = level01 < 0.5 ? mix(base, warm, level01 * 2.0) : mix(warm, hot, level01 * 2.0 - 1.0);
+        painter.setPen(colour);
+        painter.drawLine(QPointF(x + 0.5, 0), QPointF(x + 0.5, h));
+    }
+
+    // Playback position
+    double px = playhead / secondsPerPixel;
+    if (px >= 0.0 && px <= w) {
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawLine(QPointF(px, 0), QPointF(px, h));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Mouse Handling
+// ----------------------------------------------------------------------------
+void DiffHeatmapView::mousePressEvent(QMouseEvent *event) {
+    if (!data || event->button() != Qt::LeftButton) return;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)         // QMouseEvent::position() is Qt 6.
+    double x = event->position().x();
+#else
+    double x = event->localPos().x();
+#endif
+    emit seekRequested(x * data->duration() / qMax(1, width()));
+}
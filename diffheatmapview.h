@@ -0,0 +1,52 @@
+// ============================================================================
+// diffheatmapview.h - Difference Heatmap Under the Players
+// ============================================================================
+// Draws a DiffSeries (see diffheatmap.h) across the whole of player 1's
+// file: dark where the two encodes agree, through orange to red where they
+// differ most. The colour follows the PEAK score under each pixel, so a
+// single bad frame still shows up when two hours are squeezed into a few
+// hundred pixels. The scale runs up to the largest score of the pass.
+//
+//   Click - jump both players there (seekRequested); the caller seeks with
+//           the offset the series was computed for.
+//
+// Times outside the overlap of the two files are hatched.
+// ============================================================================
+
+#ifndef DIFFHEATMAPVIEW_H
+#define DIFFHEATMAPVIEW_H
+
+#include <QWidget>
+#include <QSharedPointer>
+#include <QString>
+
+class MpvWidget;
+class DiffSeries;
+
+class DiffHeatmapView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit DiffHeatmapView(MpvWidget *player, QWidget *parent = nullptr);
+
+    void setSeries(QSharedPointer<DiffSeries> series);
+    void setMessage(const QString &text);    // Shown while there is no series.
+    QSharedPointer<DiffSeries> series() const;
+
+    QSize sizeHint() const override;
+
+signals:
+    void seekRequested(double time);         // Player 1's time.
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private:
+    MpvWidget *player;                       // Player 1, for the playhead.
+    QSharedPointer<DiffSeries> data;
+    QString message;
+    double playhead;                         // Seconds.
+};
+
+#endif // DIFFHEATMAPVIEW_H
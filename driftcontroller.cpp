@@ -0,0 +1,113 @@
+// ============================================================================
+// driftcontroller.cpp - Implementation of DriftController
+// ============================================================================
+
+#include "driftcontroller.h"
+#include "playergroup.h"
+#include "bufferingbarrier.h"
+#include "mpvwidget.h"           // MpvWidget
+
+#include <QTimer>
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+DriftController::DriftController(PlayerGroup *group, BufferingBarrier *barrier, QObject *parent)
+    : QObject(parent), group(group), barrier(barrier), enabled(false), locked(false) {
+
+    const QList<MpvWidget *> &members = group->members();
+    targets.fill(0.0, members.size());
+    errors.fill(0.0, members.size());
+
+    for (MpvWidget *player : members) {
+        connect(player, &MpvWidget::playbackRestarted, this, &DriftController::unlock);
+        connect(player, &MpvWidget::fileLoaded, this, &DriftController::unlock);
+    }
+    connect(barrier, &BufferingBarrier::holdChanged, this, [this](bool holding) {
+        if (holding) resetCorrections();
+    });
+
+    timer = new QTimer(this);
+    timer->setInterval(IntervalMs);
+    connect(timer, &QTimer::timeout, this, &DriftController::tick);
+    settle.start();
+}
+
+// ----------------------------------------------------------------------------
+// setEnabled() / error()
+// ----------------------------------------------------------------------------
+void DriftController::setEnabled(bool on) {
+    enabled = on;
+    if (enabled) {
+        unlock();
+        timer->start();
+    } else {
+        timer->stop();
+        resetCorrections();
+        errors.fill(0.0);
+        emit updated();
+    }
+}
+
+bool DriftController::isEnabled() const {
+    return enabled;
+}
+
+double DriftController::error(int index) const {
+    return errors.value(index, 0.0);
+}
+
+// ----------------------------------------------------------------------------
+// unlock() / resetCorrections()
+// ----------------------------------------------------------------------------
+// Corrections are dropped together with the lock: the seek that caused it
+// has already put every member where it should be.
+// ----------------------------------------------------------------------------
+void DriftController::unlock() {
+    locked = false;
+    settle.restart();
+    errors.fill(0.0);
+    resetCorrections();
+}
+
+void DriftController::resetCorrections() {
+    for (int i = 0; i < group->members().size(); i++) group->setMemberCorrection(i, 1.0);
+}
+
+// ----------------------------------------------------------------------------
+// tick() - Measure Every Member's Error, Nudge Its Speed
+// ----------------------------------------------------------------------------
+void DriftController::tick() {
+    if (!group->hasMedia() || group->isPaused() || barrier->isHolding()) return;
+    if (settle.elapsed() < SettleMs) return;
+
+    QVector<double> offsets = group->currentOffsets();
+    if (!locked) {
+        targets = offsets;
+        locked = true;
+        return;
+    }
+
+    const QList<MpvWidget *> &members = group->members();
+    MpvWidget *reference = group->reference();
+    double nominal = group->speed();
+
+    for (int i = 0; i < members.size(); i++) {
+        MpvWidget *player = members[i];
+        if (player == reference || !player->hasFile() || player->isPrefilling()) continue;
+
+        errors[i] += (offsets[i] - targets[i] - errors[i]) * Smoothing;
+
+        if (qAbs(errors[i]) > ResyncError) {
+            barrier->seekTo(group->position(), targets);   // Unlocks via playback-restart.
+            return;
+        }
+
+        double correction = 1.0;
+        if (qAbs(errors[i]) >= DeadBand) {
+            correction = 1.0 - qBound(-MaxCorrection, Gain * errors[i] / nominal, MaxCorrection);
+        }
+        group->setMemberCorrection(i, correction);
+    }
+    emit updated();
+}
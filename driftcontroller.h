@@ -0,0 +1,77 @@
+// ============================================================================
+// driftcontroller.h - Keep the Players in Step With Each Other
+// ============================================================================
+// Two MPV players started at the same moment with the same speed still
+// drift apart slowly: each one follows its own audio device's clock, and at
+// 2x or 4x the difference grows twice or four times as fast. The drift
+// controller watches each member's offset (see playergroup.h) and nudges
+// that member's speed by a fraction of a percent to bring it back:
+//
+//   error       = offset now - offset it is supposed to have
+//   correction  = 1 - Gain * error / nominal speed      (clamped)
+//
+// Dividing by the nominal speed makes the correction relative to the rate
+// the players are running at, so the same error is gone in the same wall
+// time at 0.25x as at 4x. Errors smaller than DeadBand (about a frame) are
+// left alone - they're below what time-pos can resolve anyway.
+//
+// The offset a member is "supposed to have" is locked SettleMs after its
+// last seek: a seek (by the user, the barrier or a group control) is how
+// offsets are deliberately changed. Speed changes don't seek, so the locked
+// offsets carry straight across them - if a speed change makes the players
+// slip, the slip is corrected back.
+//
+// An error above ResyncError can't be fixed by nudging in reasonable time;
+// the players are then realigned with a barrier seek.
+// ============================================================================
+
+#ifndef DRIFTCONTROLLER_H
+#define DRIFTCONTROLLER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QVector>
+
+class PlayerGroup;
+class BufferingBarrier;
+class QTimer;
+
+class DriftController : public QObject {
+    Q_OBJECT
+
+public:
+    static const int IntervalMs = 200;
+    static const int SettleMs = 600;             // After a seek, before locking.
+    static constexpr double DeadBand = 0.010;    // Seconds.
+    static constexpr double Gain = 0.5;          // 1/s - half the error per second.
+    static constexpr double MaxCorrection = 0.05;
+    static constexpr double ResyncError = 0.5;   // Seconds.
+    static constexpr double Smoothing = 0.3;     // Of the error, per tick.
+
+    DriftController(PlayerGroup *group, BufferingBarrier *barrier, QObject *parent = nullptr);
+
+    void setEnabled(bool enabled);               // Off resets every correction.
+    bool isEnabled() const;
+
+    // Smoothed error of member `index` in seconds (0 for the reference).
+    double error(int index) const;
+
+signals:
+    void updated();                              // After every tick that measured.
+
+private:
+    void tick();
+    void unlock();
+    void resetCorrections();
+
+    PlayerGroup *group;
+    BufferingBarrier *barrier;
+    QTimer *timer;
+    bool enabled;
+    bool locked;
+    QElapsedTimer settle;                        // Since the last seek.
+    QVector<double> targets;                     // Locked offsets, per member.
+    QVector<double> errors;                      // Smoothed, per member.
+};
+
+#endif // DRIFTCONTROLLER_H
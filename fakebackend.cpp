@@ -0,0 +1,576 @@
+// ============================================================================
+// fakebackend.cpp - Implementation of FakeBackend
+// ============================================================================
+
+#include "fakebackend.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include <mpv/client.h>          // Error codes and end-file reasons, to match MpvBackend.
+
+#include <climits>               // ULONG_MAX
+#include <cmath>                 // std::floor
+#include <cstring>               // std::strcmp
+
+namespace {
+
+// Option and "set" values arrive as strings; store them the way MPV would
+// report them back.
+QVariant parseValue(const QString &text) {
+    if (text == "yes") return true;
+    if (text == "no") return false;
+    bool ok = false;
+    double number = text.toDouble(&ok);
+    if (ok) return number;
+    return text;
+}
+
+QVariantMap track(int id, const QString &type, bool external) {
+    QVariantMap entry;
+    entry["id"] = id;
+    entry["type"] = type;
+    entry["external"] = external;
+    entry["selected"] = !external;
+    if (type == "video") {
+        entry["demux-w"] = FakeBackend::FrameWidth;
+        entry["demux-h"] = FakeBackend::FrameHeight;
+        entry["demux-fps"] = FakeBackend::FrameRate;
+    } else if (type == "audio") {
+        entry["demux-channel-count"] = 2;
+        entry["demux-samplerate"] = 48000;
+    }
+    return entry;
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+FakeBackend::FakeBackend(int callLatencyUs)
+    : anchorNs(0), anchorPosition(0.0), frameSteps(false), duration(0.0), loaded(false), encoding(false),
+      latencyUs(callLatencyUs), wakeupCallback(nullptr), wakeupContext(nullptr) {
+    properties["idle-active"] = true;
+    properties["pause"] = false;
+    properties["speed"] = 1.0;
+    properties["volume"] = 100.0;
+    properties["mute"] = false;
+    clock.start();
+}
+
+FakeBackend::~FakeBackend() {}
+
+bool FakeBackend::isValid() const {
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Scripting
+// ----------------------------------------------------------------------------
+void FakeBackend::inject(const QString &name, const QVariant &value) {
+    QMutexLocker lock(&mutex);
+    properties[name] = value;
+    bool needed = notify(name);
+    lock.unlock();
+    wake(needed);
+}
+
+void FakeBackend::pushEvent(const PlayerEvent &event) {
+    QMutexLocker lock(&mutex);
+    bool needed = queue(event);
+    lock.unlock();
+    wake(needed);
+}
+
+void FakeBackend::setCallLatency(int microseconds) {
+    QMutexLocker lock(&mutex);
+    latencyUs = microseconds;
+}
+
+void FakeBackend::simulateLatency() const {
+    int delay;
+    {
+        QMutexLocker lock(&mutex);
+        delay = latencyUs;
+    }
+    if (delay > 0) QThread::usleep(delay);
+}
+
+void FakeBackend::wake(bool needed) {
+    void (*callback)(void *ctx);
+    void *ctx;
+    {
+        QMutexLocker lock(&mutex);
+        callback = wakeupCallback;
+        ctx = wakeupContext;
+    }
+    if (needed && callback) callback(ctx);
+}
+
+// ----------------------------------------------------------------------------
+// Setup
+// ----------------------------------------------------------------------------
+int FakeBackend::setOption(const char *name, const char *value) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    if (std::strcmp(name, "o") == 0) encoding = true;
+    properties[QString::fromUtf8(name)] = parseValue(QString::fromUtf8(value));
+    return 0;
+}
+
+int FakeBackend::initialize() {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    return encoding ? MPV_ERROR_UNSUPPORTED : 0;
+}
+
+void FakeBackend::setWakeupCallback(void (*callback)(void *ctx), void *ctx) {
+    QMutexLocker lock(&mutex);
+    wakeupCallback = callback;
+    wakeupContext = ctx;
+}
+
+// ----------------------------------------------------------------------------
+// Commands
+// ----------------------------------------------------------------------------
+int FakeBackend::command(const char **args) {
+    simulateLatency();
+    QStringList list;
+    for (int i = 0; args[i]; i++) list.append(QString::fromUtf8(args[i]));
+
+    QMutexLocker lock(&mutex);
+    bool needed = false;
+    int error = run(list, nullptr, &needed);
+    lock.unlock();
+    wake(needed);
+    return error;
+}
+
+int FakeBackend::commandAsync(quint64 id, const char **args) {
+    simulateLatency();
+    QStringList list;
+    for (int i = 0; args[i]; i++) list.append(QString::fromUtf8(args[i]));
+
+    QMutexLocker lock(&mutex);
+    bool needed = false;
+    PlayerEvent reply;
+    reply.type = PlayerEvent::Other;         // MPV_EVENT_COMMAND_REPLY
+    reply.id = id;
+    reply.error = run(list, nullptr, &needed);
+    needed = queue(reply) || needed;
+    lock.unlock();
+    wake(needed);
+    return 0;
+}
+
+// Named arguments (a map) are only understood for the commands the app
+// sends that way - loadfile and seek.
+int FakeBackend::commandNode(const QVariant &args, QVariant *result) {
+    simulateLatency();
+    QStringList list;
+    if (args.userType() == QMetaType::QVariantMap) {
+        QVariantMap map = args.toMap();
+        list << map.value("name").toString();
+        if (map.contains("url")) list << map.value("url").toString();
+        if (map.contains("target")) list << map.value("target").toString() << map.value("flags").toString();
+    } else {
+        for (const QVariant &arg : args.toList()) list.append(arg.toString());
+    }
+
+    QMutexLocker lock(&mutex);
+    bool needed = false;
+    int error = run(list, result, &needed);
+
+    // loadfile's per-file options: only the ones that decide where and how
+    // the file starts are simulated.
+    QVariantMap options = args.toMap().value("options").toMap();
+    if (error >= 0 && list.value(0) == "loadfile" && !options.isEmpty()) {
+        if (options.contains("pause")) needed |= assign("pause", options.value("pause").toString() == "yes");
+        if (options.contains("start")) needed |= seekTo(options.value("start").toDouble());
+    }
+    lock.unlock();
+    wake(needed);
+    return error;
+}
+
+// ----------------------------------------------------------------------------
+// run() - The Commands the Fake Understands
+// ----------------------------------------------------------------------------
+int FakeBackend::run(const QStringList &args, QVariant *result, bool *needed) {
+    if (args.isEmpty() || args[0].isEmpty()) return MPV_ERROR_INVALID_PARAMETER;
+    const QString &name = args[0];
+
+    if (name == "loadfile") {
+        if (args.size() < 2) return MPV_ERROR_INVALID_PARAMETER;
+        *needed = load(args[1]);
+    } else if (name == "stop") {
+        *needed = unload(MPV_END_FILE_REASON_STOP);
+    } else if (name == "quit") {
+        unload(MPV_END_FILE_REASON_QUIT);
+        PlayerEvent shutdown;
+        shutdown.type = PlayerEvent::Shutdown;
+        *needed = queue(shutdown);
+    } else if (name == "seek") {
+        if (!loaded) return MPV_ERROR_COMMAND;
+        bool ok = false;
+        double target = args.value(1).toDouble(&ok);
+        if (!ok) return MPV_ERROR_INVALID_PARAMETER;
+        QString flags = args.value(2);
+        if (flags.contains("absolute-percent")) target = target / 100.0 * duration;
+        else if (!flags.contains("absolute")) target += position();
+        *needed = seekTo(target);
+    } else if (name == "cycle") {
+        QVariant current = value(args.value(1));
+        if (current.userType() != QMetaType::Bool) return MPV_ERROR_PROPERTY_FORMAT;
+        *needed = assign(args[1], !current.toBool());
+    } else if (name == "set") {
+        if (args.size() < 3) return MPV_ERROR_INVALID_PARAMETER;
+        *needed = assign(args[1], parseValue(args[2]));
+    } else if (name == "video-add" || name == "audio-add" || name == "sub-add") {
+        if (!loaded) return MPV_ERROR_COMMAND;
+        QString type = name == "video-add" ? "video" : name == "audio-add" ? "audio" : "sub";
+        QVariantList tracks = properties.value("track-list").toList();
+        int id = 1;
+        for (const QVariant &entry : tracks) {
+            if (entry.toMap().value("type") == type) id = qMax(id, entry.toMap().value("id").toInt() + 1);
+        }
+        tracks.append(track(id, type, true));
+        *needed = assign("track-list", tracks);
+    } else if (name == "screenshot-raw") {
+        if (!loaded) return MPV_ERROR_COMMAND;
+        if (result) *result = frame();
+    }
+    // Anything else (af, vf, script messages...) is accepted and ignored -
+    // the fake models timing and state, not filters.
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// load() / unload() / seekTo()
+// ----------------------------------------------------------------------------
+bool FakeBackend::load(const QString &path) {
+    if (loaded) unload(MPV_END_FILE_REASON_STOP);
+
+    duration = DefaultDuration;
+    if (path.startsWith("fake://")) {
+        bool ok = false;
+        double seconds = path.mid(7).toDouble(&ok);
+        if (ok && seconds > 0.0) duration = seconds;
+    }
+
+    QVariantMap range;
+    range["start"] = 0.0;
+    range["end"] = duration;
+    QVariantMap cacheState;
+    cacheState["seekable-ranges"] = QVariantList{range};
+
+    loaded = true;
+    properties["path"] = path;
+    properties["filename"] = path.section('/', -1);
+    properties["duration"] = duration;
+    properties["track-list"] = QVariantList{track(1, "video", false), track(1, "audio", false)};
+    properties["vid"] = 1;
+    properties["aid"] = 1;
+    properties["container-fps"] = FrameRate;
+    properties["estimated-vf-fps"] = FrameRate;
+    properties["video-bitrate"] = 8e6;
+    properties["audio-bitrate"] = 192e3;
+    properties["demuxer-cache-state"] = cacheState;
+    properties["demuxer-cache-duration"] = duration;
+    properties["demuxer-cache-idle"] = true;
+    properties["idle-active"] = false;
+    anchor(0.0);
+
+    // MPV leaves idle mode when loading starts, before FILE_LOADED.
+    notify("idle-active");
+    PlayerEvent event;
+    event.type = PlayerEvent::FileLoaded;
+    queue(event);
+    event.type = PlayerEvent::PlaybackRestart;
+    queue(event);
+    for (const QString &name : properties.keys()) {
+        if (name != "idle-active") notify(name);
+    }
+    notify("time-pos");
+    return true;
+}
+
+bool FakeBackend::unload(int reason) {
+    if (!loaded) return false;
+
+    loaded = false;
+    duration = 0.0;
+    const QStringList fileProperties = {
+        "path", "filename", "duration", "track-list", "vid", "aid", "container-fps", "estimated-vf-fps",
+        "video-bitrate", "audio-bitrate", "demuxer-cache-state", "demuxer-cache-duration", "demuxer-cache-idle"
+    };
+    for (const QString &name : fileProperties) properties.remove(name);
+    properties["idle-active"] = true;
+    anchor(0.0);
+
+    PlayerEvent event;
+    event.type = PlayerEvent::EndFile;
+    event.endReason = reason;
+    queue(event);
+    for (const QString &name : fileProperties) notify(name);
+    notify("idle-active");
+    notify("time-pos");
+    return true;
+}
+
+bool FakeBackend::seekTo(double target) {
+    anchor(qBound(0.0, target, duration));
+
+    PlayerEvent event;
+    event.type = PlayerEvent::PlaybackRestart;
+    queue(event);
+    notify("time-pos");
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// The Clock
+// ----------------------------------------------------------------------------
+// time-pos is computed on every read from the last anchor, so it moves
+// smoothly (or a frame at a time) and pause/speed changes re-anchor first.
+// Like keep-open=yes, playback stops at the end.
+// ----------------------------------------------------------------------------
+void FakeBackend::setClock(const std::function<qint64()> &now) {
+    QMutexLocker lock(&mutex);
+    double pos = clockPosition();
+    testClock = now;
+    anchor(pos);
+}
+
+void FakeBackend::setFrameSteps(bool enabled) {
+    QMutexLocker lock(&mutex);
+    frameSteps = enabled;
+}
+
+double FakeBackend::truePosition() const {
+    QMutexLocker lock(&mutex);
+    return clockPosition();
+}
+
+qint64 FakeBackend::nowNs() const {
+    return testClock ? testClock() : clock.nsecsElapsed();
+}
+
+double FakeBackend::clockPosition() const {
+    double pos = anchorPosition;
+    if (!properties.value("pause").toBool()) {
+        pos += (nowNs() - anchorNs) / 1e9 * properties.value("speed").toDouble();
+    }
+    return qBound(0.0, pos, duration);
+}
+
+double FakeBackend::position() const {
+    double pos = clockPosition();
+    if (frameSteps) pos = std::floor(pos * FrameRate + 1e-6) / FrameRate;
+    return pos;
+}
+
+void FakeBackend::anchor(double pos) {
+    anchorPosition = pos;
+    anchorNs = nowNs();
+}
+
+QVariant FakeBackend::value(const QString &name) const {
+    if (name == "time-pos" || name == "playback-time") return loaded ? QVariant(position()) : QVariant();
+    if (name == "percent-pos") return loaded ? QVariant(position() / duration * 100.0) : QVariant();
+    if (name == "eof-reached") return loaded && position() >= duration;
+    return properties.value(name);
+}
+
+// bgr0, like MPV's default screenshot format. The brightness steps once a
+// second so frame analysis sees the picture change.
+QVariantMap FakeBackend::frame() const {
+    const int level = 16 + (int(position()) * 37) % 220;
+    QByteArray data(FrameWidth * FrameHeight * 4, char(level));
+
+    QVariantMap image;
+    image["w"] = FrameWidth;
+    image["h"] = FrameHeight;
+    image["stride"] = FrameWidth * 4;
+    image["format"] = "bgr0";
+    image["data"] = data;
+    return image;
+}
+
+// ----------------------------------------------------------------------------
+// assign() / notify() / queue()
+// ----------------------------------------------------------------------------
+bool FakeBackend::assign(const QString &name, const QVariant &newValue) {
+    if (name == "time-pos" || name == "playback-time") {
+        return loaded && seekTo(newValue.toDouble());
+    }
+    if (name == "pause" || name == "speed") anchor(clockPosition());
+
+    QVariant stored = newValue;
+    if (name == "pause") stored = newValue.toBool();
+    else if (name == "speed") stored = qBound(0.01, newValue.toDouble(), 100.0);
+
+    if (properties.value(name) == stored) return false;
+    properties[name] = stored;
+    return notify(name);
+}
+
+bool FakeBackend::notify(const QString &name) {
+    const QList<quint64> ids = observers.values(name);
+    if (ids.isEmpty()) return false;
+
+    PlayerEvent event;
+    event.type = PlayerEvent::PropertyChange;
+    event.name = name;
+    event.value = value(name);
+    for (quint64 id : ids) {
+        event.id = id;
+        queue(event);
+    }
+    return true;
+}
+
+bool FakeBackend::queue(const PlayerEvent &event) {
+    events.enqueue(event);
+    queued.wakeAll();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Properties
+// ----------------------------------------------------------------------------
+int FakeBackend::getDouble(const char *name, double *out) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    QVariant v = value(QString::fromUtf8(name));
+    if (!v.isValid()) return MPV_ERROR_PROPERTY_UNAVAILABLE;
+    bool ok = false;
+    double number = v.toDouble(&ok);
+    if (!ok) return MPV_ERROR_PROPERTY_FORMAT;
+    *out = number;
+    return 0;
+}
+
+int FakeBackend::getInt(const char *name, qint64 *out) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    QVariant v = value(QString::fromUtf8(name));
+    if (!v.isValid()) return MPV_ERROR_PROPERTY_UNAVAILABLE;
+    bool ok = false;
+    double number = v.toDouble(&ok);
+    if (!ok || v.userType() == QMetaType::Bool) return MPV_ERROR_PROPERTY_FORMAT;
+    *out = qint64(number);
+    return 0;
+}
+
+int FakeBackend::getFlag(const char *name, bool *out) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    QVariant v = value(QString::fromUtf8(name));
+    if (!v.isValid()) return MPV_ERROR_PROPERTY_UNAVAILABLE;
+    if (v.userType() != QMetaType::Bool) return MPV_ERROR_PROPERTY_FORMAT;
+    *out = v.toBool();
+    return 0;
+}
+
+int FakeBackend::getString(const char *name, QString *out) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    QVariant v = value(QString::fromUtf8(name));
+    if (!v.isValid()) return MPV_ERROR_PROPERTY_UNAVAILABLE;
+    if (v.userType() == QMetaType::Bool) *out = v.toBool() ? "yes" : "no";
+    else if (v.userType() == QMetaType::Double) *out = QString::number(v.toDouble(), 'f', 6);
+    else *out = v.toString();
+    return 0;
+}
+
+int FakeBackend::getNode(const char *name, QVariant *out) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    QVariant v = value(QString::fromUtf8(name));
+    if (!v.isValid()) return MPV_ERROR_PROPERTY_UNAVAILABLE;
+    *out = v;
+    return 0;
+}
+
+int FakeBackend::setDouble(const char *name, double newValue) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    bool needed = assign(QString::fromUtf8(name), newValue);
+    lock.unlock();
+    wake(needed);
+    return 0;
+}
+
+int FakeBackend::setInt(const char *name, qint64 newValue) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    bool needed = assign(QString::fromUtf8(name), qlonglong(newValue));
+    lock.unlock();
+    wake(needed);
+    return 0;
+}
+
+int FakeBackend::setFlag(const char *name, bool newValue) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    bool needed = assign(QString::fromUtf8(name), newValue);
+    lock.unlock();
+    wake(needed);
+    return 0;
+}
+
+int FakeBackend::setString(const char *name, const char *newValue) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    bool needed = assign(QString::fromUtf8(name), parseValue(QString::fromUtf8(newValue)));
+    lock.unlock();
+    wake(needed);
+    return 0;
+}
+
+// Like MPV, the current value is reported once right away.
+int FakeBackend::observeProperty(quint64 id, const char *name) {
+    simulateLatency();
+    QMutexLocker lock(&mutex);
+    QString key = QString::fromUtf8(name);
+    observers.insert(key, id);
+
+    PlayerEvent event;
+    event.type = PlayerEvent::PropertyChange;
+    event.id = id;
+    event.name = key;
+    event.value = value(key);
+    bool needed = queue(event);
+    lock.unlock();
+    wake(needed);
+    return 0;
+}
+
+// The fake player has no log of its own.
+int FakeBackend::requestLogMessages(const char *) {
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Events and Teardown
+// ----------------------------------------------------------------------------
+PlayerEvent FakeBackend::waitEvent(double timeout) {
+    QMutexLocker lock(&mutex);
+    if (events.isEmpty() && timeout != 0.0) {
+        queued.wait(&mutex, timeout < 0.0 ? ULONG_MAX : static_cast<unsigned long>(timeout * 1000.0));
+    }
+    return events.isEmpty() ? PlayerEvent() : events.dequeue();
+}
+
+bool FakeBackend::terminate() {
+    QMutexLocker lock(&mutex);
+    unload(MPV_END_FILE_REASON_QUIT);
+    wakeupCallback = nullptr;
+    return true;
+}
+
+mpv_handle *FakeBackend::createClient(const char *) {
+    return nullptr;
+}
@@ -0,0 +1,141 @@
+// ============================================================================
+// fakebackend.h - A Scripted Player Without libmpv
+// ============================================================================
+// Behaves like an MPV instance as far as the app can tell, but nothing is
+// decoded or shown: a "file" is a duration, a clock and a property table.
+//
+//   - loadfile/stop/seek/pause/speed change the state and queue the same
+//     events MPV would (FILE_LOADED, PLAYBACK_RESTART, END_FILE, property
+//     changes for observed properties).
+//   - time-pos follows a real clock times the speed, so players drift and
+//     sync logic has something to correct. Tests can substitute their own
+//     clock, and make time-pos step a frame at a time as MPV's does.
+//   - The track list has one video and one audio track; video-add and
+//     audio-add add external ones, so composite mode finds its tracks.
+//   - screenshot-raw returns a small grey frame whose brightness follows
+//     the position.
+//   - Everything else (filters, options) is accepted and ignored.
+//
+// Paths of the form fake://<seconds> set the duration; anything else plays
+// for DefaultDuration. Encoding mode (the "o" option) isn't simulated -
+// initialize() fails, as it does with a libmpv built without encoding.
+//
+// A simulated per-call latency turns the fake into a stand-in for a busy
+// player in benchmarks: every call sleeps that long, like a call waiting
+// for MPV's core lock would.
+//
+// Thread-safe like libmpv: calls may come from any thread.
+// ============================================================================
+
+#ifndef FAKEBACKEND_H
+#define FAKEBACKEND_H
+
+#include "playerbackend.h"
+
+#include <QElapsedTimer>
+#include <QMultiHash>
+#include <QMutex>
+#include <QQueue>
+#include <QStringList>
+#include <QVariantMap>
+#include <QWaitCondition>
+
+#include <functional>
+
+class FakeBackend : public PlayerBackend {
+public:
+    static constexpr double DefaultDuration = 600.0;
+    static const int FrameWidth = 64;
+    static const int FrameHeight = 36;
+    static constexpr double FrameRate = 25.0;
+
+    explicit FakeBackend(int callLatencyUs = 0);
+    ~FakeBackend() override;
+
+    // ------------------------------------------------------------------------
+    // Scripting
+    // ------------------------------------------------------------------------
+    // inject() sets any property as if MPV had changed it (e.g. a growing
+    // "demuxer-cache-duration" for a stream) and notifies its observers.
+    // pushEvent() queues an arbitrary event.
+    //
+    // setClock() replaces the real clock with the caller's (nanoseconds, any
+    // origin), so a test decides when time passes. With frame steps on,
+    // time-pos only moves in whole frames of FrameRate; truePosition() is
+    // where playback really is between two steps.
+    // ------------------------------------------------------------------------
+    void inject(const QString &name, const QVariant &value);
+    void pushEvent(const PlayerEvent &event);
+    void setCallLatency(int microseconds);
+    void setClock(const std::function<qint64()> &now);
+    void setFrameSteps(bool enabled);
+    double truePosition() const;
+
+    bool isValid() const override;
+
+    int setOption(const char *name, const char *value) override;
+    int initialize() override;
+    void setWakeupCallback(void (*callback)(void *ctx), void *ctx) override;
+
+    int command(const char **args) override;
+    int commandAsync(quint64 id, const char **args) override;
+    int commandNode(const QVariant &args, QVariant *result = nullptr) override;
+
+    int getDouble(const char *name, double *value) override;
+    int getInt(const char *name, qint64 *value) override;
+    int getFlag(const char *name, bool *value) override;
+    int getString(const char *name, QString *value) override;
+    int getNode(const char *name, QVariant *value) override;
+
+    int setDouble(const char *name, double value) override;
+    int setInt(const char *name, qint64 value) override;
+    int setFlag(const char *name, bool value) override;
+    int setString(const char *name, const char *value) override;
+
+    int observeProperty(quint64 id, const char *name) override;
+    int requestLogMessages(const char *minLevel) override;
+
+    PlayerEvent waitEvent(double timeout) override;
+    bool terminate() override;
+    mpv_handle *createClient(const char *name) override;
+
+private:
+    // All of these expect the mutex to be held; they return true if the
+    // wakeup callback has to be called (after unlocking).
+    int run(const QStringList &args, QVariant *result, bool *needed);
+    bool load(const QString &path);
+    bool unload(int reason);
+    bool seekTo(double target);
+    bool assign(const QString &name, const QVariant &value);
+    bool notify(const QString &name);
+    bool queue(const PlayerEvent &event);
+
+    QVariant value(const QString &name) const;
+    qint64 nowNs() const;
+    double clockPosition() const;            // Between frame steps.
+    double position() const;                 // As time-pos reports it.
+    void anchor(double position);            // Restart the clock from here.
+    QVariantMap frame() const;
+
+    void simulateLatency() const;
+    void wake(bool needed);
+
+    mutable QMutex mutex;
+    QVariantMap properties;
+    QMultiHash<QString, quint64> observers;
+    QQueue<PlayerEvent> events;
+    QWaitCondition queued;                   // For waitEvent() with a timeout.
+    QElapsedTimer clock;
+    std::function<qint64()> testClock;       // Replaces `clock` if set.
+    qint64 anchorNs;                         // nowNs() at the last anchor().
+    double anchorPosition;                   // Position at the last anchor().
+    bool frameSteps;
+    double duration;
+    bool loaded;
+    bool encoding;
+    int latencyUs;
+    void (*wakeupCallback)(void *ctx);
+    void *wakeupContext;
+};
+
+#endif // FAKEBACKEND_H
@@ -0,0 +1,52 @@
+// ============================================================================
+// fileidentity.cpp - Implementation of FileIdentity
+// ============================================================================
+
+#include "fileidentity.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QtEndian>
+
+namespace FileIdentity {
+
+// ----------------------------------------------------------------------------
+// fingerprint()
+// ----------------------------------------------------------------------------
+// Small files (up to SampleCount blocks) are hashed completely. Mapping can
+// fail on some file systems (network shares, FUSE); those blocks are read
+// the ordinary way instead, which gives the same bytes and the same hash.
+// ----------------------------------------------------------------------------
+QString fingerprint(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+
+    const qint64 size = file.size();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    quint64 sizeLE = qToLittleEndian(static_cast<quint64>(size));
+    hash.addData(reinterpret_cast<const char *>(&sizeLE), sizeof(sizeLE));
+
+    const qint64 total = qint64(SampleCount) * SampleBytes;
+    const int blocks = size <= total ? 1 : SampleCount;
+    const qint64 length = size <= total ? size : SampleBytes;
+
+    for (int i = 0; i < blocks && length > 0; i++) {
+        qint64 offset = blocks == 1 ? 0 : (size - length) * i / (blocks - 1);
+
+        uchar *mapped = file.map(offset, length);
+        if (mapped) {
+            hash.addData(reinterpret_cast<const char *>(mapped), static_cast<int>(length));
+            file.unmap(mapped);
+        } else {
+            if (!file.seek(offset)) return QString();
+            QByteArray data = file.read(length);
+            if (data.size() != length) return QString();
+            hash.addData(data);
+        }
+    }
+
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+} // namespace FileIdentity
@@ -0,0 +1,33 @@
+// ============================================================================
+// fileidentity.h - Recognize a Media File by Its Content
+// ============================================================================
+// Paths change - files get renamed, moved to another disk, copied to a
+// laptop - but the content doesn't. To remember things about a file (see
+// pairmemory.h), it is identified by a FINGERPRINT of its content.
+//
+// Hashing a whole 50 GB remux would take minutes, so the fingerprint only
+// samples it: the file size plus SampleCount blocks of SampleBytes spread
+// evenly from the first to the last byte, each read through a memory
+// mapping (QFile::map) so only those pages are ever touched. Two different
+// video files practically never share their size AND all sampled blocks;
+// identical copies always do.
+// ============================================================================
+
+#ifndef FILEIDENTITY_H
+#define FILEIDENTITY_H
+
+#include <QString>
+
+namespace FileIdentity {
+
+const int SampleCount = 16;
+const int SampleBytes = 64 * 1024;
+
+// Hex SHA-1 over the size and the sampled blocks, or an empty string if the
+// file can't be read. Blocks on a slow disk mean a few seeks, so call this
+// off the GUI thread.
+QString fingerprint(const QString &path);
+
+} // namespace FileIdentity
+
+#endif // FILEIDENTITY_H
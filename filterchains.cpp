@@ -0,0 +1,395 @@
+// ============================================================================
+// filterchains.cpp - Implementation of FilterChains
+// ============================================================================
+
+#include "filterchains.h"
+#include "mpvwidget.h"           // MpvWidget
+#include "playergroup.h"
+
+#include <QMap>
+#include <QRegularExpression>
+#include <QVariantMap>
+
+namespace {
+
+// Filters the graph itself is built from; a chain using one of them can't
+// be told apart by its name in a command.
+const QStringList GraphFilters = { "split", "bench", "null", "hstack", "xstack", "streamselect" };
+
+// ----------------------------------------------------------------------------
+// Parsing Chains - Just Enough for Filter Commands
+// ----------------------------------------------------------------------------
+// "name=key=value:key=value,name..." only. Quoting, escapes, labels,
+// instance names and positional options can't be compared option by
+// option; such chains simply always rebuild the graph.
+// ----------------------------------------------------------------------------
+struct ParsedFilter {
+    QString name;
+    QVariantMap options;
+};
+
+struct OptionChange {
+    QString filter, option, value;
+};
+
+bool parseChain(const QString &chain, QList<ParsedFilter> &filters) {
+    static const QRegularExpression special("['\"\\\\\\[\\];@]");
+    if (chain.contains(special)) return false;
+
+    filters.clear();
+    const QStringList parts = chain.split(',', Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        ParsedFilter filter;
+        filter.name = part.section('=', 0, 0).trimmed();
+        QString args = part.section('=', 1);
+        if (filter.name.isEmpty()) return false;
+
+        if (!args.isEmpty()) {
+            for (const QString &option : args.split(':')) {
+                int equals = option.indexOf('=');
+                if (equals <= 0) return false;
+                filter.options.insert(option.left(equals).trimmed(), option.mid(equals + 1).trimmed());
+            }
+        }
+        filters.append(filter);
+    }
+    return true;
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+// Like the composite, the extra MPV instance is only created on the first
+// enter().
+// ----------------------------------------------------------------------------
+FilterChains::FilterChains(PlayerGroup *group, QObject *parent)
+    : QObject(parent), group(group), instance(nullptr),
+      active(false), loading(false), currentView(AllChains),
+      startTime(0.0), startPaused(true), pausedOnLeave(true), unnamedLines(0) {
+    sinceUpdate.start();
+}
+
+FilterChains::~FilterChains() {
+    shutdown();
+}
+
+void FilterChains::shutdown() {
+    if (instance) {
+        instance->shutdown();
+        instance->deleteLater();
+        instance = nullptr;
+    }
+    active = loading = false;
+}
+
+// ----------------------------------------------------------------------------
+// State Queries
+// ----------------------------------------------------------------------------
+bool FilterChains::isActive() const { return active; }
+QString FilterChains::error() const { return errorText; }
+QVector<double> FilterChains::offsets() const { return startOffsets; }
+bool FilterChains::wasPaused() const { return pausedOnLeave; }
+MpvWidget *FilterChains::player() const { return instance; }
+QStringList FilterChains::chains() const { return current; }
+int FilterChains::view() const { return currentView; }
+
+double FilterChains::cost(int index) const {
+    return costs.value(index, -1.0);
+}
+
+// ----------------------------------------------------------------------------
+// enter() - Open the Reference Player's File Once
+// ----------------------------------------------------------------------------
+// The file is opened with start=<position> and pause=yes as per-file
+// options, so it comes up on the group's frame without a separate seek.
+// Hardware decoding is off: the filters need the frames in memory.
+// ----------------------------------------------------------------------------
+bool FilterChains::enter(const QStringList &chains) {
+    if (active) return setChains(chains);
+
+    if (chains.isEmpty() || chains.size() > MaxChains) {
+        errorText = QString("Use 1 to %1 filter chains").arg(MaxChains);
+        return false;
+    }
+    MpvWidget *source = group->reference();
+    if (!source || !source->hasFile() || source->isPrefilling()) {
+        errorText = "Load a file first";
+        return false;
+    }
+
+    startPaused = group->isPaused();
+    group->setPaused(true);
+    startOffsets = group->currentOffsets();
+    startTime = source->position();
+
+    double volume = -1.0;
+    source->getDouble("volume", &volume);
+
+    if (!instance) {
+        instance = new MpvWidget();
+        instance->setVisible(false);
+        connect(instance, &MpvWidget::fileLoaded, this, &FilterChains::onFileLoaded);
+        connect(instance, &MpvWidget::logMessage, this, &FilterChains::onLogMessage);
+        instance->setString("hwdec", "no");
+        instance->requestLogMessages("v");       // bench reports at "info" = MPV's "v".
+    }
+    if (volume >= 0.0) instance->setDouble("volume", volume);
+    instance->setSpeed(group->speed());
+
+    errorText.clear();
+    current = chains;
+    active = true;
+    loading = true;
+    resetCosts();
+
+    QVariantMap options;
+    options["start"] = QString::number(startTime, 'f', 3);
+    options["pause"] = startPaused ? "yes" : "no";
+    instance->loadVideo(source->currentPath(), options);
+    return true;
+}
+
+void FilterChains::onFileLoaded() {
+    if (!loading) return;
+    loading = false;
+
+    if (!applyGraph()) {
+        fail("MPV rejected the filter chains: " + errorText);
+        return;
+    }
+    emit activeChanged(true);
+}
+
+void FilterChains::fail(const QString &reason) {
+    errorText = reason;
+    instance->closeVideo();
+    active = loading = false;
+    group->setPaused(startPaused);               // The players never moved.
+    emit failed(reason);
+}
+
+// ----------------------------------------------------------------------------
+// leave() - Hand the Position Back
+// ----------------------------------------------------------------------------
+double FilterChains::leave() {
+    if (!active) return group->position();
+
+    double time = loading ? startTime : instance->position();
+    pausedOnLeave = loading ? startPaused : instance->isPaused();
+
+    instance->closeVideo();
+    active = loading = false;
+    emit activeChanged(false);
+    return time;
+}
+
+// ----------------------------------------------------------------------------
+// buildGraph() - The lavfi String
+// ----------------------------------------------------------------------------
+// Every chain sits between its own pair of bench filters, named after the
+// chain's index so their log lines can be told apart. The unlabeled input
+// of split and output of the last filter are the graph's own input and
+// output. hstack needs chains of equal height and xstack's grid assumes
+// equal sizes; a chain that scales makes MPV reject the graph.
+// ----------------------------------------------------------------------------
+QString FilterChains::buildGraph(const QStringList &chains, int view) {
+    const int count = chains.size();
+
+    QString graph = QString("split=%1").arg(count);
+    for (int i = 0; i < count; i++) graph += QString("[s%1]").arg(i);
+
+    for (int i = 0; i < count; i++) {
+        QString chain = chains[i].trimmed();
+        if (chain.isEmpty()) chain = "null";
+        const QString index = QString::number(i);
+        graph += ";[s" + index + "]bench@wa" + index + "s=start," + chain
+               + ",bench@wa" + index + "e=stop[c" + index + "]";
+    }
+
+    graph += ";";
+    for (int i = 0; i < count; i++) graph += QString("[c%1]").arg(i);
+
+    if (count == 1) {
+        graph += "null";
+    } else if (view >= 0 && view < count) {
+        graph += QString("streamselect=inputs=%1:map=%2").arg(count).arg(view);
+    } else if (count == 4) {
+        graph += "xstack=inputs=4:layout=0_0|w0_0|0_h0|w0_h0";
+    } else {
+        graph += QString("hstack=inputs=%1").arg(count);
+    }
+    return graph;
+}
+
+// ----------------------------------------------------------------------------
+// applyGraph() - Replace the Whole Graph
+// ----------------------------------------------------------------------------
+// "%<bytes>%" quotes the graph for MPV's option parser - it is full of
+// characters (=, :, |, commas) that would otherwise split it up. On
+// failure MPV keeps the previous filters.
+// ----------------------------------------------------------------------------
+bool FilterChains::applyGraph() {
+    QByteArray graph = buildGraph(current, currentView).toUtf8();
+    QByteArray filter = "@wa-chains:lavfi=graph=%" + QByteArray::number(graph.size()) + "%" + graph;
+
+    const char *cmd[] = {"vf", "set", filter.constData(), NULL};
+    int result = instance->command(cmd);
+    if (result < 0) {
+        errorText = PlayerBackend::errorString(result);
+        return false;
+    }
+    resetCosts();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// setChains() - Apply Edits While Playing
+// ----------------------------------------------------------------------------
+bool FilterChains::setChains(const QStringList &chains) {
+    if (chains.isEmpty() || chains.size() > MaxChains) {
+        errorText = QString("Use 1 to %1 filter chains").arg(MaxChains);
+        return false;
+    }
+    if (!active || loading) {
+        current = chains;
+        return true;
+    }
+    if (chains == current) return true;
+
+    QStringList previous = current;
+    int previousView = currentView;
+    current = chains;
+    if (currentView >= current.size()) currentView = AllChains;
+    if (currentView == previousView && sendCommands(previous, chains)) return true;
+    if (applyGraph()) return true;
+
+    current = previous;
+    currentView = previousView;
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// sendCommands() - Change Option Values Without Touching the Graph
+// ----------------------------------------------------------------------------
+// Returns false if the edit can't be done with commands - the caller then
+// rebuilds the graph, which also sets any values already sent here.
+// A command is addressed to a filter by its name, which reaches every
+// filter of that name in the graph; so only names that appear once qualify.
+// ----------------------------------------------------------------------------
+bool FilterChains::sendCommands(const QStringList &from, const QStringList &to) {
+    if (from.size() != to.size()) return false;
+
+    QList<OptionChange> changes;
+    QMap<QString, int> uses;
+
+    for (int i = 0; i < to.size(); i++) {
+        QList<ParsedFilter> before, after;
+        if (!parseChain(from[i], before) || !parseChain(to[i], after)) return false;
+        if (before.size() != after.size()) return false;
+
+        for (int k = 0; k < after.size(); k++) {
+            const ParsedFilter &old = before[k];
+            const ParsedFilter &now = after[k];
+            if (old.name != now.name || GraphFilters.contains(now.name)) return false;
+            if (old.options.keys() != now.options.keys()) return false;   // Sorted.
+
+            uses[now.name]++;
+            for (auto it = now.options.begin(); it != now.options.end(); ++it) {
+                if (old.options.value(it.key()) != it.value()) {
+                    changes.append({ now.name, it.key(), it.value().toString() });
+                }
+            }
+        }
+    }
+
+    for (const OptionChange &change : changes) {
+        if (uses.value(change.filter) != 1) return false;
+    }
+
+    for (const OptionChange &change : changes) {
+        QByteArray option = change.option.toUtf8();
+        QByteArray value = change.value.toUtf8();
+        QByteArray target = change.filter.toUtf8();
+        const char *cmd[] = {"vf-command", "wa-chains", option.constData(), value.constData(),
+                             target.constData(), NULL};
+        if (instance->command(cmd) < 0) return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// setView() - All Chains, or Only One
+// ----------------------------------------------------------------------------
+// Between single chains only streamselect's "map" changes; switching to or
+// from the combined view is a different graph.
+// ----------------------------------------------------------------------------
+void FilterChains::setView(int view) {
+    if (view < AllChains || view >= current.size()) view = AllChains;
+    if (view == currentView) return;
+
+    int previous = currentView;
+    currentView = view;
+    if (!active || loading || current.size() == 1) return;
+
+    if (previous != AllChains && view != AllChains) {
+        QByteArray map = QByteArray::number(view);
+        const char *cmd[] = {"vf-command", "wa-chains", "map", map.constData(), "streamselect", NULL};
+        if (instance->command(cmd) >= 0) return;
+    }
+    if (!applyGraph()) {
+        currentView = previous;
+        emit failed("MPV rejected the filter chains: " + errorText);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Chain Cost - bench's Log Lines
+// ----------------------------------------------------------------------------
+// bench=stop logs "t:<seconds> avg:... max:... min:..." for every frame.
+// MPV prefixes the line with the filter's instance name, which contains
+// "wa<index>e" - or, with libavfilter versions that name filters by
+// position ("Parsed_bench_7"), is at least distinct per chain: the chains
+// process each frame in order, so the first names seen are chains 0, 1...
+// Without any name the lines are taken in turn.
+// ----------------------------------------------------------------------------
+void FilterChains::resetCosts() {
+    costs.fill(-1.0, current.size());
+    benchNames.clear();
+    unnamedLines = 0;
+    emit costChanged();
+}
+
+void FilterChains::onLogMessage(const QString &, const QString &text) {
+    static const QRegularExpression timing("(?:^|\\s)t:([0-9.]+)\\s+avg:");
+    static const QRegularExpression named("@wa(\\d+)e");
+
+    if (!active || loading || costs.isEmpty()) return;
+    QRegularExpressionMatch match = timing.match(text);
+    if (!match.hasMatch()) return;
+
+    int index = -1;
+    QRegularExpressionMatch id = named.match(text);
+    QString name = text.left(match.capturedStart()).trimmed();
+    if (id.hasMatch()) {
+        index = id.captured(1).toInt();
+    } else if (!name.isEmpty()) {
+        index = benchNames.indexOf(name);
+        if (index < 0) {
+            benchNames << name;
+            index = benchNames.size() - 1;
+        }
+    } else {
+        index = unnamedLines++ % costs.size();
+    }
+    if (index < 0 || index >= costs.size()) return;
+
+    double ms = match.captured(1).toDouble() * 1000.0;
+    costs[index] = costs[index] < 0.0 ? ms : costs[index] + (ms - costs[index]) * CostSmoothing;
+
+    if (sinceUpdate.elapsed() >= CostUpdateMs) {
+        sinceUpdate.restart();
+        emit costChanged();
+    }
+}
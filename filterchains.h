@@ -0,0 +1,143 @@
+// ============================================================================
+// filterchains.h - One Decode, Several Filter Chains Side by Side
+// ============================================================================
+// Comparing processing settings (denoise, sharpen, deband...) by opening
+// the same file twice decodes it twice, and the two copies drift. The
+// FilterChains mode opens the reference player's file ONCE in an extra MPV
+// instance and splits every decoded frame into up to MaxChains filter
+// chains inside a single libavfilter graph:
+//
+//                        +-> chain A -+
+//   decoder -> split=N --+-> chain B -+--> hstack / 2x2 grid   (all chains)
+//                        +-> chain C -+    or streamselect     (one chain)
+//
+// A chain is an ordinary libavfilter chain ("hqdn3d=4:3:6:4.5,unsharp");
+// an empty chain is the untouched source. Every frame goes through every
+// chain, so the pictures are always of the same frame, and a view showing
+// only one chain ("separate outputs") can be switched without a seek.
+//
+// Editing a chain while playing never reloads or seeks:
+//
+//   - If only option VALUES changed, and the filter's name appears once in
+//     the graph, the new values are sent as filter commands
+//     ("vf-command ... <option> <value> <filter>") - instantaneous.
+//   - Anything else (a filter added, removed or renamed, or one that takes
+//     no commands) replaces the graph in place ("vf set"). MPV keeps the
+//     position and the pause state; if it rejects the new graph, the old
+//     one stays and setChains() returns false.
+//
+// The cost of each chain is measured with a pair of libavfilter "bench"
+// filters around it: the time a frame spent in that chain, read from the
+// lines bench writes to MPV's log. That is the chain's CPU time per frame,
+// except for filters running on several slice threads, where it's the
+// time until the slowest thread finished.
+//
+// enter() / leave() work like CompositePlayer's: the group is paused and
+// its position handed over, and the position is handed back on leaving.
+// ============================================================================
+
+#ifndef FILTERCHAINS_H
+#define FILTERCHAINS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class MpvWidget;
+class PlayerGroup;
+
+class FilterChains : public QObject {
+    Q_OBJECT
+
+public:
+    static const int MaxChains = 4;
+    static const int AllChains = -1;             // view(): every chain at once.
+    static const int CostUpdateMs = 500;         // Rate of costChanged().
+    static constexpr double CostSmoothing = 0.1; // Of each new frame's time.
+
+    explicit FilterChains(PlayerGroup *group, QObject *parent = nullptr);
+    ~FilterChains();
+
+    // ------------------------------------------------------------------------
+    // Switching Modes
+    // ------------------------------------------------------------------------
+    // enter() needs a file in the group (not a stream still prefilling) and
+    // 1 to MaxChains chains. It returns false, with the reason in error(),
+    // otherwise; the chains are showing once activeChanged(true) is emitted.
+    //
+    // leave() returns the group time the chains were at; the caller seeks
+    // the group there with offsets() and restores wasPaused().
+    // ------------------------------------------------------------------------
+
+    bool enter(const QStringList &chains);
+    double leave();
+
+    bool isActive() const;                       // Entered (loading or playing).
+    QString error() const;
+
+    QVector<double> offsets() const;             // The group's, as taken in enter().
+    bool wasPaused() const;                      // Pause state when leave() was called.
+
+    MpvWidget *player() const;                   // The chains' instance, for the
+    // transport controls while active. Null until the first enter().
+
+    void shutdown();                             // Before the application quits.
+
+    // ------------------------------------------------------------------------
+    // Live Editing
+    // ------------------------------------------------------------------------
+    // setChains() applies new chains to the running graph (see above); a
+    // different number of chains always rebuilds. setView() shows all
+    // chains, or only chain `view`.
+    // ------------------------------------------------------------------------
+
+    bool setChains(const QStringList &chains);
+    QStringList chains() const;
+
+    void setView(int view);
+    int view() const;
+
+    // Average time per frame spent in chain `index`, in ms, or -1 until
+    // the chain has processed a frame.
+    double cost(int index) const;
+
+    // The libavfilter graph for `chains` shown as `view`.
+    static QString buildGraph(const QStringList &chains, int view);
+
+signals:
+    void activeChanged(bool active);
+    void failed(const QString &reason);
+    void costChanged();
+
+private:
+    void onFileLoaded();
+    bool applyGraph();
+    bool sendCommands(const QStringList &from, const QStringList &to);
+    void onLogMessage(const QString &prefix, const QString &text);
+    void resetCosts();
+    void fail(const QString &reason);
+
+    PlayerGroup *group;
+    MpvWidget *instance;
+
+    bool active;
+    bool loading;                                // Between enter() and fileLoaded.
+    QString errorText;
+
+    QStringList current;                         // The chains in the running graph.
+    int currentView;
+
+    QVector<double> startOffsets;
+    double startTime;
+    bool startPaused;
+    bool pausedOnLeave;
+
+    QVector<double> costs;                       // Per chain, ms; -1 = unknown.
+    QStringList benchNames;                      // Log names, in chain order.
+    int unnamedLines;                            // Lines that carried no name.
+    QElapsedTimer sinceUpdate;
+};
+
+#endif // FILTERCHAINS_H
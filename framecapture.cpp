@@ -0,0 +1,274 @@
+// ============================================================================
+// framecapture.cpp - Implementation of FrameCapture
+// ============================================================================
+
+#include "framecapture.h"
+#include "mpvwidget.h"           // MpvWidget
+#include "playergroup.h"
+#include "bufferingbarrier.h"
+#include "simdkernels.h"         // absDiff() for the difference image.
+
+#include <QDateTime>
+#include <QDir>
+#include <QImage>
+#include <QImageWriter>
+#include <QMutex>
+#include <QPainter>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <atomic>
+
+// ----------------------------------------------------------------------------
+// Job - One Capture (Single Frame or Burst)
+// ----------------------------------------------------------------------------
+// The GUI thread owns the capture state; the encode tasks only share the
+// options (read-only) and the counters.
+// ----------------------------------------------------------------------------
+struct FrameCapture::Job {
+    Options options;
+    QString stem;                      // File name prefix (capture start time).
+    FrameCapture *owner = nullptr;
+
+    double startTime = 0.0;            // Group time of the first frame.
+    double frameStep = 0.0;            // Seconds per frame of the reference player.
+    QVector<double> offsets;           // Alignment at the start; kept for the burst.
+    QVector<int> players;              // Group members taking part.
+    int framesCaptured = 0;
+
+    std::atomic<int> tasksLeft{0};
+    std::atomic<int> filesWritten{0};
+
+    QMutex errorMutex;
+    QString error;
+
+    void fail(const QString &reason) {
+        QMutexLocker lock(&errorMutex);
+        if (error.isEmpty()) error = reason;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// EncodeTask - Write One Frame's Images
+// ----------------------------------------------------------------------------
+class FrameCapture::EncodeTask : public QRunnable {
+public:
+    EncodeTask(QSharedPointer<Job> job, int frame, const QVector<QImage> &images, const QVector<int> &players)
+        : job(job), frame(frame), images(images), players(players) {}
+
+    void run() override {
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+
+        for (int i = 0; i < images.size(); i++) save(images[i], QString("p%1").arg(players[i] + 1));
+
+        if (images.size() == 2) {
+            if (job->options.sideBySide) save(sideBySide(images[0], images[1]), "side");
+            if (job->options.difference) save(difference(images[0], images[1]), "diff");
+        }
+
+        job->tasksLeft--;
+        QSharedPointer<Job> done = job;
+        FrameCapture *owner = done->owner;
+        QMetaObject::invokeMethod(owner, [owner, done]() { owner->finishEncoding(done); }, Qt::QueuedConnection);
+    }
+
+private:
+    void save(const QImage &image, const QString &tag) {
+        QString name = QString("%1_%2_%3.%4").arg(job->stem, QString("%1").arg(frame, 3, 10, QChar('0')),
+                                                  tag, job->options.format);
+        QImageWriter writer(job->options.directory + "/" + name, job->options.format.toLatin1());
+        if (job->options.format == "webp") writer.setQuality(100);   // Lossless - it's for artifacts.
+
+        if (writer.write(image)) job->filesWritten++;
+        else job->fail(QString("%1: %2").arg(name, writer.errorString()));
+    }
+
+    // Both frames at the taller one's height, left to right.
+    static QImage sideBySide(const QImage &a, const QImage &b) {
+        int h = qMax(a.height(), b.height());
+        QImage left = a.height() == h ? a : a.scaledToHeight(h, Qt::SmoothTransformation);
+        QImage right = b.height() == h ? b : b.scaledToHeight(h, Qt::SmoothTransformation);
+
+        QImage out(left.width() + right.width(), h, QImage::Format_RGB32);
+        QPainter painter(&out);
+        painter.drawImage(0, 0, left);
+        painter.drawImage(left.width(), 0, right);
+        return out;
+    }
+
+    // |a - b| per channel, amplified by DiffShift. Player 2's frame is
+    // scaled to player 1's size if they differ.
+    static QImage difference(const QImage &a, const QImage &b) {
+        QImage first = a.convertToFormat(QImage::Format_RGB32);
+        QImage second = (b.size() == a.size() ? b : b.scaled(a.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation))
+                            .convertToFormat(QImage::Format_RGB32);
+
+        QImage out(first.size(), QImage::Format_RGB32);
+        const int w = first.width();
+        for (int y = 0; y < first.height(); y++) {
+            quint32 *row = reinterpret_cast<quint32 *>(out.scanLine(y));
+            SimdKernels::absDiff(first.constScanLine(y), second.constScanLine(y),
+                                 reinterpret_cast<uint8_t *>(row), size_t(w) * 4, DiffShift);
+            for (int x = 0; x < w; x++) row[x] |= 0xff000000u;   // RGB32 wants opaque alpha.
+        }
+        return out;
+    }
+
+    QSharedPointer<Job> job;
+    int frame;
+    QVector<QImage> images;
+    QVector<int> players;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+FrameCapture::FrameCapture(PlayerGroup *group, BufferingBarrier *barrier, QObject *parent)
+    : QObject(parent), group(group), barrier(barrier) {
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+
+    seekTimeout = new QTimer(this);
+    seekTimeout->setSingleShot(true);
+    seekTimeout->setInterval(SeekTimeoutMs);
+    connect(seekTimeout, &QTimer::timeout, this, &FrameCapture::grab);
+
+    const QList<MpvWidget *> &players = group->members();
+    waiting.fill(false, players.size());
+    for (int i = 0; i < players.size(); i++) {
+        connect(players[i], &MpvWidget::playbackRestarted, this, [this, i]() { onPlaybackRestarted(i); });
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    pool->waitForDone();
+}
+
+QStringList FrameCapture::formats() {
+    QStringList list{ "png" };
+    if (QImageWriter::supportedImageFormats().contains("webp")) list << "webp";
+    return list;
+}
+
+QString FrameCapture::defaultDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::PicturesLocation) + "/mpv-watchalong";
+}
+
+bool FrameCapture::isBusy() const {
+    return !job.isNull();
+}
+
+// ----------------------------------------------------------------------------
+// capture()
+// ----------------------------------------------------------------------------
+void FrameCapture::capture(const Options &options) {
+    if (job) return;
+
+    const QList<MpvWidget *> &players = group->members();
+    QVector<int> taking;
+    for (int i = 0; i < players.size(); i++) {
+        if (players[i]->hasFile() && !players[i]->isPrefilling()) taking.append(i);
+    }
+    if (taking.isEmpty()) {
+        emit failed("Nothing to capture - no file is loaded");
+        return;
+    }
+    if (!QDir().mkpath(options.directory)) {
+        emit failed("Can't create " + options.directory);
+        return;
+    }
+
+    group->setPaused(true);
+
+    QSharedPointer<Job> next(new Job);
+    next->options = options;
+    next->options.frames = qBound(1, options.frames, MaxFrames);
+    next->stem = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+    next->owner = this;
+    next->startTime = group->position();
+    next->offsets = group->currentOffsets();
+    next->players = taking;
+
+    double fps = players[taking.first()]->frameRate();
+    next->frameStep = fps > 0.0 ? 1.0 / fps : 1.0 / 25.0;
+
+    job = next;
+    emit progress(0, job->options.frames);
+    seekNext();
+}
+
+// ----------------------------------------------------------------------------
+// seekNext() / onPlaybackRestarted()
+// ----------------------------------------------------------------------------
+// Even the first frame is sought to, not just grabbed: a paused player may
+// be a little off its aligned position, and the capture must be of the
+// same moment in both.
+// ----------------------------------------------------------------------------
+void FrameCapture::seekNext() {
+    for (int i = 0; i < waiting.size(); i++) waiting[i] = job->players.contains(i);
+    seekTimeout->start();
+    barrier->seekTo(job->startTime + job->framesCaptured * job->frameStep, job->offsets);
+}
+
+void FrameCapture::onPlaybackRestarted(int player) {
+    if (!job || !seekTimeout->isActive()) return;
+
+    waiting[player] = false;
+    if (waiting.contains(true)) return;
+
+    seekTimeout->stop();
+    grab();
+}
+
+// ----------------------------------------------------------------------------
+// grab() - Copy the Frames, Hand Them to the Encoders
+// ----------------------------------------------------------------------------
+void FrameCapture::grab() {
+    if (!job) return;
+
+    const QList<MpvWidget *> &players = group->members();
+    QVector<QImage> images;
+    QVector<int> from;
+    for (int i : job->players) {
+        QImage image = players[i]->grabFrame();
+        if (image.isNull()) continue;       // Audio-only file, or no frame yet.
+        images.append(image);
+        from.append(i);
+    }
+
+    if (images.isEmpty()) {
+        job->fail("No video frame to capture");
+    } else {
+        job->tasksLeft++;
+        pool->start(new EncodeTask(job, job->framesCaptured, images, from));
+    }
+
+    job->framesCaptured++;
+    emit progress(job->framesCaptured, job->options.frames);
+
+    if (job->framesCaptured < job->options.frames) seekNext();
+    else finishEncoding(job);
+}
+
+// ----------------------------------------------------------------------------
+// finishEncoding()
+// ----------------------------------------------------------------------------
+// Called after every encode task and after the last grab; only the call
+// that finds everything captured AND written reports the result.
+// ----------------------------------------------------------------------------
+void FrameCapture::finishEncoding(QSharedPointer<Job> done) {
+    if (done != job || job->framesCaptured < job->options.frames || job->tasksLeft > 0) return;
+
+    job.reset();
+
+    QString error;
+    {
+        QMutexLocker lock(&done->errorMutex);
+        error = done->error;
+    }
+    if (done->filesWritten == 0) emit failed(error.isEmpty() ? QString("Nothing was written") : error);
+    else emit finished(done->filesWritten, done->options.directory);
+}
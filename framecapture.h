@@ -0,0 +1,86 @@
+// ============================================================================
+// framecapture.h - Capture the Same Frame from Both Players
+// ============================================================================
+// Reporting an encoding artifact needs the exact same frame from both
+// players. FrameCapture pauses the group, puts every player on the same
+// aligned timestamp with a barrier seek (see BufferingBarrier::seekTo),
+// waits until each one shows its frame, and copies the frames with
+// MpvWidget::grabFrame().
+//
+// A BURST repeats this for N consecutive frames: the group time advances
+// by one frame of player 1 each step, while the offsets captured at the
+// start stay fixed.
+//
+// Copying a frame is quick; compressing it to PNG/WebP is not. The copies
+// go to a worker pool, which also builds the optional side-by-side and
+// difference images, so the UI never waits for an encoder. Files are named
+//
+//   <timestamp>_<frame>_p1.png, _p2.png, _side.png, _diff.png
+// ============================================================================
+
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class PlayerGroup;
+class BufferingBarrier;
+class QThreadPool;
+class QTimer;
+
+class FrameCapture : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        int frames = 1;               // 1 = a single capture, more = a burst.
+        QString format = "png";       // One of formats().
+        bool sideBySide = false;      // Also save both frames next to each other.
+        bool difference = false;      // Also save |player 1 - player 2|.
+        QString directory;            // Where the files go.
+    };
+
+    FrameCapture(PlayerGroup *group, BufferingBarrier *barrier, QObject *parent = nullptr);
+    ~FrameCapture();
+
+    static const int MaxFrames = 300;
+    static const int SeekTimeoutMs = 5000;   // Grab anyway if a player never reports back.
+    static const int DiffShift = 2;          // Difference images are amplified 4x.
+
+    // "png", plus "webp" when Qt's image format plugin for it is installed.
+    static QStringList formats();
+
+    // Default output folder: <Pictures>/mpv-watchalong.
+    static QString defaultDirectory();
+
+    bool isBusy() const;
+    void capture(const Options &options);
+
+signals:
+    void progress(int framesCaptured, int framesTotal);
+    void finished(int filesWritten, const QString &directory);
+    void failed(const QString &reason);
+
+private:
+    struct Job;
+    class EncodeTask;
+
+    void seekNext();
+    void onPlaybackRestarted(int player);
+    void grab();
+    void finishEncoding(QSharedPointer<Job> job);
+
+    PlayerGroup *group;
+    BufferingBarrier *barrier;
+    QThreadPool *pool;
+    QTimer *seekTimeout;
+
+    QSharedPointer<Job> job;          // The capture in progress, if any.
+    QVector<bool> waiting;            // Per group member: seek not done yet.
+};
+
+#endif // FRAMECAPTURE_H
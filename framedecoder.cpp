@@ -0,0 +1,291 @@
+// ============================================================================
+// framedecoder.cpp - Implementation of FrameDecoder
+// ============================================================================
+
+#include "framedecoder.h"
+#include "simdkernels.h"
+
+#ifdef HAVE_LIBAV
+extern "C" {                         // FFmpeg is a C library.
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/pixdesc.h>
+}
+#endif
+
+static const int RowsPerCell = 4;    // Source rows sampled per thumbnail row.
+
+// ----------------------------------------------------------------------------
+// Private Data
+// ----------------------------------------------------------------------------
+struct FrameDecoder::Private {
+    QString error;
+    double duration = 0.0;
+
+#ifdef HAVE_LIBAV
+    AVFormatContext *format = nullptr;
+    AVCodecContext *codec = nullptr;
+    AVPacket *packet = nullptr;
+    AVFrame *frame = nullptr;
+    int stream = -1;
+    double startOffset = 0.0;            // Container start time, seconds.
+    bool draining = false;               // End of file - only buffered frames left.
+
+    QVector<quint32> columnSums;         // One per source column.
+    QVector<quint8> rowBuffer;           // A row converted to 8 bits, when needed.
+
+    bool shrink(const AVFrame *f, QVector<quint8> &thumb);
+#endif
+};
+
+#ifdef HAVE_LIBAV
+static QString avError(int code) {
+    char text[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(code, text, sizeof(text));
+    return QString::fromUtf8(text);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+FrameDecoder::FrameDecoder() : d(new Private) {
+}
+
+FrameDecoder::~FrameDecoder() {
+    close();
+    delete d;
+}
+
+bool FrameDecoder::isAvailable() {
+#ifdef HAVE_LIBAV
+    return true;
+#else
+    return false;
+#endif
+}
+
+double FrameDecoder::duration() const   { return d->duration; }
+QString FrameDecoder::errorString() const { return d->error; }
+
+// ----------------------------------------------------------------------------
+// open()
+// ----------------------------------------------------------------------------
+// Cover art in audio files shows up as a one-frame "video" stream; that
+// doesn't count as video here.
+// ----------------------------------------------------------------------------
+bool FrameDecoder::open(const QString &path) {
+    close();
+
+#ifndef HAVE_LIBAV
+    Q_UNUSED(path);
+    d->error = "Built without libav - video analysis is unavailable";
+    return false;
+#else
+    QByteArray file = path.toUtf8();
+    int r = avformat_open_input(&d->format, file.constData(), nullptr, nullptr);
+    if (r < 0) {
+        d->error = "Can't open file: " + avError(r);
+        return false;
+    }
+    r = avformat_find_stream_info(d->format, nullptr);
+    if (r < 0) {
+        d->error = "Can't read stream info: " + avError(r);
+        close();
+        return false;
+    }
+
+    d->stream = av_find_best_stream(d->format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (d->stream < 0 || (d->format->streams[d->stream]->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+        d->error = "No video stream";
+        close();
+        return false;
+    }
+    for (unsigned i = 0; i < d->format->nb_streams; i++) {
+        if (static_cast<int>(i) != d->stream) d->format->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    AVStream *st = d->format->streams[d->stream];
+    const AVCodec *decoder = avcodec_find_decoder(st->codecpar->codec_id);
+    if (!decoder) {
+        d->error = "No decoder for the video stream";
+        close();
+        return false;
+    }
+
+    d->codec = avcodec_alloc_context3(decoder);
+    avcodec_parameters_to_context(d->codec, st->codecpar);
+    d->codec->pkt_timebase = st->time_base;
+    d->codec->thread_count = 1;                     // Analyzers run one decoder per core.
+    d->codec->skip_loop_filter = AVDISCARD_ALL;
+    d->codec->flags2 |= AV_CODEC_FLAG2_FAST;
+    r = avcodec_open2(d->codec, decoder, nullptr);
+    if (r < 0) {
+        d->error = "Can't open the video decoder: " + avError(r);
+        close();
+        return false;
+    }
+
+    if (d->format->start_time != AV_NOPTS_VALUE) {
+        d->startOffset = d->format->start_time / static_cast<double>(AV_TIME_BASE);
+    }
+    if (d->format->duration != AV_NOPTS_VALUE && d->format->duration > 0) {
+        d->duration = d->format->duration / static_cast<double>(AV_TIME_BASE);
+    } else if (st->duration != AV_NOPTS_VALUE && st->duration > 0) {
+        d->duration = st->duration * av_q2d(st->time_base);
+    }
+
+    d->packet = av_packet_alloc();
+    d->frame = av_frame_alloc();
+    d->error.clear();
+    return true;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// close()
+// ----------------------------------------------------------------------------
+void FrameDecoder::close() {
+#ifdef HAVE_LIBAV
+    av_frame_free(&d->frame);
+    av_packet_free(&d->packet);
+    avcodec_free_context(&d->codec);
+    avformat_close_input(&d->format);
+    d->stream = -1;
+    d->startOffset = 0.0;
+    d->draining = false;
+#endif
+    d->duration = 0.0;
+}
+
+// ----------------------------------------------------------------------------
+// seek()
+// ----------------------------------------------------------------------------
+bool FrameDecoder::seek(double seconds) {
+#ifndef HAVE_LIBAV
+    Q_UNUSED(seconds);
+    return false;
+#else
+    if (!d->codec) return false;
+
+    int64_t target = static_cast<int64_t>((seconds + d->startOffset) * AV_TIME_BASE);
+    if (av_seek_frame(d->format, -1, target, AVSEEK_FLAG_BACKWARD) < 0) return false;
+
+    avcodec_flush_buffers(d->codec);
+    d->draining = false;
+    return true;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// decode() - Same send_packet / receive_frame Loop as MediaDecoder
+// ----------------------------------------------------------------------------
+int FrameDecoder::decode(QVector<quint8> &thumb, double &time) {
+    time = -1.0;
+
+#ifndef HAVE_LIBAV
+    Q_UNUSED(thumb);
+    return -1;
+#else
+    if (!d->codec) return -1;
+
+    for (;;) {
+        int r = avcodec_receive_frame(d->codec, d->frame);
+        if (r == 0) {
+            bool ok = d->shrink(d->frame, thumb);
+            if (ok && d->frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+                double pts = d->frame->best_effort_timestamp * av_q2d(d->format->streams[d->stream]->time_base);
+                time = pts - d->startOffset;
+            }
+            av_frame_unref(d->frame);
+            return ok ? 1 : -1;
+        }
+        if (r == AVERROR_EOF) return 0;
+        if (r != AVERROR(EAGAIN)) {
+            d->error = "Decoding failed: " + avError(r);
+            return -1;
+        }
+        if (d->draining) return 0;
+
+        r = av_read_frame(d->format, d->packet);
+        if (r < 0) {
+            d->draining = true;
+            avcodec_send_packet(d->codec, nullptr);
+            continue;
+        }
+        if (d->packet->stream_index == d->stream) {
+            avcodec_send_packet(d->codec, d->packet);
+        }
+        av_packet_unref(d->packet);
+    }
+#endif
+}
+
+#ifdef HAVE_LIBAV
+// ----------------------------------------------------------------------------
+// Private::shrink() - Box-Filter the Luma Plane Down to a Thumbnail
+// ----------------------------------------------------------------------------
+// Each thumbnail row averages RowsPerCell evenly spaced source rows (all
+// columns); that's plenty to see a cut and keeps the cost per frame low.
+// The common 8-bit planar formats are summed straight from the frame;
+// anything else (10-bit, packed YUYV...) is converted one row at a time
+// first. RGB video uses its green channel, which is close enough to luma.
+// ----------------------------------------------------------------------------
+bool FrameDecoder::Private::shrink(const AVFrame *f, QVector<quint8> &thumb) {
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(f->format));
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_PAL))) {
+        error = "Unsupported pixel format";
+        return false;
+    }
+    const AVComponentDescriptor &luma = desc->comp[(desc->flags & AV_PIX_FMT_FLAG_RGB) ? 1 : 0];
+    const bool direct = luma.step == 1 && luma.depth == 8 && luma.shift == 0;
+    const bool wide = luma.depth > 8;
+    const bool bigEndian = desc->flags & AV_PIX_FMT_FLAG_BE;
+
+    const int w = f->width;
+    const int h = f->height;
+    if (w < ThumbWidth || h < ThumbHeight) {
+        error = "Video is too small";
+        return false;
+    }
+
+    const uint8_t *plane = f->data[luma.plane] + luma.offset;
+    const int stride = f->linesize[luma.plane];
+
+    thumb.resize(ThumbWidth * ThumbHeight);
+    columnSums.resize(w);
+    if (!direct) rowBuffer.resize(w);
+
+    for (int ty = 0; ty < ThumbHeight; ty++) {
+        const int y0 = ty * h / ThumbHeight;
+        const int y1 = (ty + 1) * h / ThumbHeight;
+        const int rowStep = qMax(1, (y1 - y0) / RowsPerCell);
+
+        columnSums.fill(0);
+        int rows = 0;
+        for (int y = y0; y < y1; y += rowStep, rows++) {
+            const uint8_t *row = plane + static_cast<ptrdiff_t>(y) * stride;
+            if (!direct) {
+                for (int x = 0; x < w; x++) {
+                    const uint8_t *p = row + x * luma.step;
+                    unsigned v = wide ? (bigEndian ? (p[0] << 8 | p[1]) : (p[1] << 8 | p[0])) : p[0];
+                    v >>= luma.shift;
+                    rowBuffer[x] = static_cast<quint8>(luma.depth > 8 ? v >> (luma.depth - 8) : v << (8 - luma.depth));
+                }
+                row = rowBuffer.constData();
+            }
+            SimdKernels::accumulateRow(row, static_cast<size_t>(w), columnSums.data());
+        }
+
+        quint8 *out = thumb.data() + ty * ThumbWidth;
+        for (int tx = 0; tx < ThumbWidth; tx++) {
+            const int x0 = tx * w / ThumbWidth;
+            const int x1 = (tx + 1) * w / ThumbWidth;
+            quint64 sum = 0;
+            for (int x = x0; x < x1; x++) sum += columnSums[x];
+            out[tx] = static_cast<quint8>(sum / (quint64(rows) * (x1 - x0)));
+        }
+    }
+    return true;
+}
+#endif
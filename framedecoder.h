@@ -0,0 +1,58 @@
+// ============================================================================
+// framedecoder.h - Decode a File's Video to Small Grayscale Thumbnails
+// ============================================================================
+// The video counterpart of MediaDecoder. Analyzers that look at the picture
+// (the scene detector) don't need full frames - a tiny grayscale version of
+// each frame is enough to tell whether the picture changed. FrameDecoder
+// decodes the best video stream with libavcodec and shrinks the luma of
+// every frame to a ThumbWidth x ThumbHeight thumbnail (box filter, via
+// SimdKernels::accumulateRow).
+//
+// To decode faster than a player would, the codec skips its loop filter
+// and uses the "fast" shortcuts. The pictures come out slightly blockier,
+// which makes no difference at thumbnail size.
+//
+// libav is optional: without it (HAVE_LIBAV not defined) open() always
+// fails. Like MediaDecoder, one FrameDecoder per thread.
+// ============================================================================
+
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QString>
+#include <QVector>
+
+class FrameDecoder {
+public:
+    static const int ThumbWidth = 64;       // Regardless of the aspect ratio -
+    static const int ThumbHeight = 36;      // thumbnails are only compared.
+
+    FrameDecoder();
+    ~FrameDecoder();
+
+    static bool isAvailable();              // False when built without libav.
+
+    bool open(const QString &path);         // False on failure - see errorString().
+    void close();
+
+    double duration() const;                // Seconds, or 0 if unknown.
+    QString errorString() const;
+
+    // Jumps to the last keyframe at or before `seconds`.
+    bool seek(double seconds);
+
+    // Decodes the next frame into `thumb` (resized to ThumbWidth *
+    // ThumbHeight bytes, row by row). `time` receives the frame's position
+    // in seconds, or a negative value if the file doesn't say. Returns 1 for
+    // a frame, 0 at the end of the file, -1 on error.
+    int decode(QVector<quint8> &thumb, double &time);
+
+private:
+    FrameDecoder(const FrameDecoder &) = delete;
+    FrameDecoder &operator=(const FrameDecoder &) = delete;
+
+    struct Private;                         // libav types stay out of this header.
+    Private *d;
+};
+
+#endif // FRAMEDECODER_H
@@ -0,0 +1,218 @@
+// ============================================================================
+// grouploop.cpp - Implementation of GroupLoop
+// ============================================================================
+
+#include "grouploop.h"
+#include "bufferingbarrier.h"
+#include "mpvwidget.h"           // MpvWidget
+#include "playergroup.h"
+
+#include <QTimer>
+
+#include <utility>               // std::swap
+
+namespace {
+
+const double FallbackBitrate = 40e6;     // bits/s, when MPV doesn't know yet.
+const qint64 MinBackBytes = 64LL << 20;
+const qint64 MaxBackBytes = 2LL << 30;
+
+QString propertyString(MpvWidget *player, const char *name) {
+    QString value;
+    player->getString(name, &value);
+    return value;
+}
+
+void setPropertyString(MpvWidget *player, const char *name, const QString &value) {
+    QByteArray bytes = value.toUtf8();
+    player->setString(name, bytes.constData());
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+GroupLoop::GroupLoop(PlayerGroup *group, BufferingBarrier *barrier, QObject *parent)
+    : QObject(parent), group(group), barrier(barrier),
+      pointA(-1.0), pointB(-1.0), active(false), wraps(0) {
+
+    tickTimer = new QTimer(this);
+    tickTimer->setInterval(TickMs);
+    connect(tickTimer, &QTimer::timeout, this, &GroupLoop::tick);
+
+    wrapTimer = new QTimer(this);
+    wrapTimer->setSingleShot(true);
+    wrapTimer->setTimerType(Qt::PreciseTimer);
+    connect(wrapTimer, &QTimer::timeout, this, &GroupLoop::wrap);
+}
+
+GroupLoop::~GroupLoop() {
+    tickTimer->stop();
+    wrapTimer->stop();
+}
+
+// ----------------------------------------------------------------------------
+// setA() / setB() / clear()
+// ----------------------------------------------------------------------------
+void GroupLoop::setA(double groupTime) {
+    pointA = groupTime;
+    if (pointB >= 0.0 && pointB < pointA) std::swap(pointA, pointB);
+    activate();
+}
+
+void GroupLoop::setB(double groupTime) {
+    pointB = groupTime;
+    if (pointA >= 0.0 && pointB < pointA) std::swap(pointA, pointB);
+    activate();
+}
+
+void GroupLoop::clear() {
+    tickTimer->stop();
+    wrapTimer->stop();
+    unpinCache();
+    pointA = pointB = -1.0;
+    active = false;
+    wraps = 0;
+    emit changed();
+}
+
+bool GroupLoop::isActive() const { return active; }
+bool GroupLoop::hasA() const { return pointA >= 0.0; }
+double GroupLoop::a() const { return pointA; }
+double GroupLoop::b() const { return pointB; }
+int GroupLoop::passes() const { return wraps; }
+
+// ----------------------------------------------------------------------------
+// activate() - Start Looping Once Both Points Are Known
+// ----------------------------------------------------------------------------
+void GroupLoop::activate() {
+    active = pointA >= 0.0 && pointB - pointA >= MinLength && group->hasMedia();
+    wrapTimer->stop();
+    wraps = 0;
+
+    if (active) {
+        offsets = group->currentOffsets();
+        pinCache();
+        sinceWrap.start();
+        tickTimer->start();
+    } else {
+        tickTimer->stop();
+    }
+    emit changed();
+}
+
+// ----------------------------------------------------------------------------
+// tick() - Watch for B
+// ----------------------------------------------------------------------------
+// Polling every TickMs alone would overshoot B by up to TickMs. So once B is
+// less than two ticks away, a precise single shot is set for the moment the
+// group reaches it. A position BEFORE A is left alone - playback runs into
+// the loop - but anything past B wraps at once (e.g. after a seek).
+// ----------------------------------------------------------------------------
+void GroupLoop::tick() {
+    if (!active || wrapTimer->isActive() || sinceWrap.elapsed() < WrapGuardMs) return;
+    if (!group->hasMedia() || group->isPaused() || barrier->isHolding()) return;
+
+    double remaining = (pointB - group->position()) / qMax(0.01, group->speed());
+    if (remaining <= 0.0) {
+        wrap();
+    } else if (remaining < 2.0 * TickMs / 1000.0) {
+        wrapTimer->start(int(remaining * 1000.0));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// wrap() - Everyone Back to A
+// ----------------------------------------------------------------------------
+// With the range cached everywhere, a plain group seek is quickest: both
+// seeks are served from memory and playback never stops. Otherwise the
+// barrier holds the group until every player has found A.
+//
+// The precise single shot can fire after the group was paused or the
+// barrier took hold; then nothing moves toward B, and tick() wraps once
+// playback carries on.
+// ----------------------------------------------------------------------------
+void GroupLoop::wrap() {
+    if (!active || group->isPaused() || barrier->isHolding()) return;
+
+    bool cached = true;
+    for (int i = 0; i < group->members().size(); i++) cached = cached && isCached(i);
+
+    if (cached) group->seekTo(pointA, offsets);
+    else barrier->seekTo(pointA, offsets);
+
+    wraps++;
+    sinceWrap.restart();
+    emit changed();
+}
+
+// ----------------------------------------------------------------------------
+// isCached()
+// ----------------------------------------------------------------------------
+// "demuxer-cache-state" lists the byte ranges the demuxer can seek in
+// without touching the file, as {start, end} times. Players without a file
+// don't hold anyone up.
+// ----------------------------------------------------------------------------
+bool GroupLoop::isCached(int index) const {
+    const QList<MpvWidget *> &players = group->members();
+    if (index < 0 || index >= players.size()) return false;
+    MpvWidget *player = players[index];
+    if (!player->hasFile() || player->isPrefilling()) return true;
+
+    QVariant node;
+    player->getNode("demuxer-cache-state", &node);
+    QVariantMap state = node.toMap();
+
+    const double from = pointA + offsets.value(index);
+    const double to = pointB + offsets.value(index) - 0.25;   // Up to the last few frames.
+    for (const QVariant &entry : state.value("seekable-ranges").toList()) {
+        QVariantMap range = entry.toMap();
+        if (range.value("start").toDouble() <= from && range.value("end").toDouble() >= to) return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// pinCache() / unpinCache()
+// ----------------------------------------------------------------------------
+// The back buffer is sized from the file's bitrate (with room to spare for
+// bitrate peaks) and capped at MaxBackBytes - but a larger value the user
+// already had is kept as it is, cap or not.
+// Demuxer options can be changed while a file plays.
+// ----------------------------------------------------------------------------
+void GroupLoop::pinCache() {
+    unpinCache();
+
+    const double length = pointB - pointA;
+    for (MpvWidget *player : group->members()) {
+        if (!player->hasFile()) continue;
+
+        SavedCache entry;
+        entry.player = player;
+        entry.maxBackBytes = propertyString(player, "demuxer-max-back-bytes");
+        entry.seekableCache = propertyString(player, "demuxer-seekable-cache");
+        saved.append(entry);
+
+        double videoRate = 0.0, audioRate = 0.0;
+        player->getDouble("video-bitrate", &videoRate);
+        player->getDouble("audio-bitrate", &audioRate);
+        double bitrate = videoRate + audioRate > 0.0 ? videoRate + audioRate : FallbackBitrate;
+
+        qint64 needed = qint64(bitrate / 8.0 * (length + 5.0) * 2.0);
+        qint64 current = 0;
+        player->getInt("demuxer-max-back-bytes", &current);
+        qint64 bytes = qMax(current, qBound(MinBackBytes, needed, MaxBackBytes));
+
+        setPropertyString(player, "demuxer-seekable-cache", "yes");
+        player->setInt("demuxer-max-back-bytes", bytes);
+    }
+}
+
+void GroupLoop::unpinCache() {
+    for (const SavedCache &entry : saved) {
+        if (!entry.maxBackBytes.isEmpty()) setPropertyString(entry.player, "demuxer-max-back-bytes", entry.maxBackBytes);
+        if (!entry.seekableCache.isEmpty()) setPropertyString(entry.player, "demuxer-seekable-cache", entry.seekableCache);
+    }
+    saved.clear();
+}
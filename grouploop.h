@@ -0,0 +1,92 @@
+// ============================================================================
+// grouploop.h - Synchronized A-B Loop Over All Players
+// ============================================================================
+// Reviewing one scene over and over. A and B are GROUP times; every player
+// loops its own stretch (A + offset to B + offset, offsets frozen when the
+// loop is set), and all of them wrap back at the same moment.
+//
+// MPV has an A-B loop of its own, but each player would wrap on its own
+// clock. Here the loop is driven from the group timeline instead: shortly
+// before B a precise single-shot timer fires at the exact wrap time and
+// seeks every player to A together.
+//
+// To make the jump back free, the looped range is PINNED in each player's
+// demuxer cache: the seekable cache is switched on and the back buffer
+// ("demuxer-max-back-bytes") made large enough to hold the whole range, so
+// after the first pass the wrap is a seek within memory. Until a player has
+// the whole range cached, the wrap goes through the BufferingBarrier
+// instead, so a slow disk can't leave one player behind. The cache
+// settings are restored when the loop is cleared.
+// ============================================================================
+
+#ifndef GROUPLOOP_H
+#define GROUPLOOP_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+class PlayerGroup;
+class BufferingBarrier;
+class MpvWidget;
+class QTimer;
+
+class GroupLoop : public QObject {
+    Q_OBJECT
+
+public:
+    GroupLoop(PlayerGroup *group, BufferingBarrier *barrier, QObject *parent = nullptr);
+    ~GroupLoop();
+
+    static const int TickMs = 40;            // Position check while looping.
+    static const int WrapGuardMs = 300;      // Ignore stale positions after a wrap.
+    static constexpr double MinLength = 0.2; // Shortest loop, seconds.
+
+    // Setting both points (B after A) starts the loop. Setting A again
+    // after B moves the start; B before A swaps them.
+    void setA(double groupTime);
+    void setB(double groupTime);
+    void clear();
+
+    bool isActive() const;
+    bool hasA() const;
+    double a() const;
+    double b() const;
+    int passes() const;                      // Wraps since the loop was set.
+
+    // True once player `index` has the whole looped range in its cache.
+    bool isCached(int index) const;
+
+signals:
+    void changed();                          // Points set/cleared, or a wrap.
+
+private:
+    void activate();
+    void tick();
+    void wrap();
+    void pinCache();
+    void unpinCache();
+
+    PlayerGroup *group;
+    BufferingBarrier *barrier;
+    QTimer *tickTimer;
+    QTimer *wrapTimer;                       // Single shot at the exact wrap time.
+    QElapsedTimer sinceWrap;
+
+    double pointA;                           // Group times; -1 = not set.
+    double pointB;
+    bool active;
+    int wraps;
+    QVector<double> offsets;                 // Frozen when the loop starts.
+
+    // Each player's cache settings before pinning, to restore them.
+    struct SavedCache {
+        MpvWidget *player = nullptr;
+        QString maxBackBytes;
+        QString seekableCache;
+    };
+    QVector<SavedCache> saved;
+};
+
+#endif // GROUPLOOP_H
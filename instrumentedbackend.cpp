@@ -0,0 +1,191 @@
+// ============================================================================
+// instrumentedbackend.cpp - Implementation of InstrumentedBackend
+// ============================================================================
+
+#include "instrumentedbackend.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QStringList>
+
+#include <algorithm>             // std::sort
+#include <atomic>
+
+namespace {
+
+std::atomic<int> instances(0);
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+InstrumentedBackend::InstrumentedBackend(PlayerBackend *inner)
+    : wrapped(inner), number(++instances) {}
+
+InstrumentedBackend::~InstrumentedBackend() {
+    if (totalCalls() > 0) {
+        qInfo().noquote() << QString("Player backend #%1:\n").arg(number) + report();
+    }
+    delete wrapped;
+}
+
+PlayerBackend *InstrumentedBackend::inner() const {
+    return wrapped;
+}
+
+// ----------------------------------------------------------------------------
+// timed() / record()
+// ----------------------------------------------------------------------------
+template <typename Call>
+auto InstrumentedBackend::timed(const char *kind, const QString &name, Call call) -> decltype(call()) {
+    QElapsedTimer timer;
+    timer.start();
+    auto result = call();
+    record(name.isEmpty() ? QString::fromLatin1(kind) : QString::fromLatin1(kind) + ' ' + name, timer.nsecsElapsed());
+    return result;
+}
+
+void InstrumentedBackend::record(const QString &key, qint64 ns) {
+    QMutexLocker lock(&mutex);
+    CallStats &entry = table[key];
+    entry.calls++;
+    entry.totalNs += ns;
+    entry.maxNs = qMax(entry.maxNs, ns);
+}
+
+QMap<QString, InstrumentedBackend::CallStats> InstrumentedBackend::stats() const {
+    QMutexLocker lock(&mutex);
+    return table;
+}
+
+qint64 InstrumentedBackend::totalCalls() const {
+    QMutexLocker lock(&mutex);
+    qint64 total = 0;
+    for (const CallStats &entry : table) total += entry.calls;
+    return total;
+}
+
+void InstrumentedBackend::reset() {
+    QMutexLocker lock(&mutex);
+    table.clear();
+}
+
+QString InstrumentedBackend::report() const {
+    QMap<QString, CallStats> snapshot = stats();
+
+    QStringList keys = snapshot.keys();
+    std::sort(keys.begin(), keys.end(), [&snapshot](const QString &a, const QString &b) {
+        return snapshot[a].calls > snapshot[b].calls;
+    });
+
+    QString text;
+    for (const QString &key : keys) {
+        const CallStats &entry = snapshot[key];
+        text += QString("  %1 %2 calls, %3 ms total, %4 us max\n")
+                    .arg(key, -32)
+                    .arg(entry.calls, 8)
+                    .arg(entry.totalNs / 1e6, 9, 'f', 2)
+                    .arg(entry.maxNs / 1e3, 9, 'f', 1);
+    }
+    return text;
+}
+
+// ----------------------------------------------------------------------------
+// Forwarding
+// ----------------------------------------------------------------------------
+// Commands are booked under their first argument ("command seek"), so
+// different commands don't blur into one line.
+// ----------------------------------------------------------------------------
+bool InstrumentedBackend::isValid() const {
+    return wrapped->isValid();
+}
+
+int InstrumentedBackend::setOption(const char *name, const char *value) {
+    return timed("option", QString::fromUtf8(name), [&]() { return wrapped->setOption(name, value); });
+}
+
+int InstrumentedBackend::initialize() {
+    return timed("initialize", QString(), [&]() { return wrapped->initialize(); });
+}
+
+void InstrumentedBackend::setWakeupCallback(void (*callback)(void *ctx), void *ctx) {
+    timed("wakeup-callback", QString(), [&]() { wrapped->setWakeupCallback(callback, ctx); return 0; });
+}
+
+int InstrumentedBackend::command(const char **args) {
+    return timed("command", QString::fromUtf8(args[0]), [&]() { return wrapped->command(args); });
+}
+
+int InstrumentedBackend::commandAsync(quint64 id, const char **args) {
+    return timed("command-async", QString::fromUtf8(args[0]), [&]() { return wrapped->commandAsync(id, args); });
+}
+
+int InstrumentedBackend::commandNode(const QVariant &args, QVariant *result) {
+    QString name = args.userType() == QMetaType::QVariantMap ? args.toMap().value("name").toString()
+                                                             : args.toList().value(0).toString();
+    return timed("command", name, [&]() { return wrapped->commandNode(args, result); });
+}
+
+int InstrumentedBackend::getDouble(const char *name, double *value) {
+    return timed("get", QString::fromUtf8(name), [&]() { return wrapped->getDouble(name, value); });
+}
+
+int InstrumentedBackend::getInt(const char *name, qint64 *value) {
+    return timed("get", QString::fromUtf8(name), [&]() { return wrapped->getInt(name, value); });
+}
+
+int InstrumentedBackend::getFlag(const char *name, bool *value) {
+    return timed("get", QString::fromUtf8(name), [&]() { return wrapped->getFlag(name, value); });
+}
+
+int InstrumentedBackend::getString(const char *name, QString *value) {
+    return timed("get", QString::fromUtf8(name), [&]() { return wrapped->getString(name, value); });
+}
+
+int InstrumentedBackend::getNode(const char *name, QVariant *value) {
+    return timed("get", QString::fromUtf8(name), [&]() { return wrapped->getNode(name, value); });
+}
+
+int InstrumentedBackend::setDouble(const char *name, double value) {
+    return timed("set", QString::fromUtf8(name), [&]() { return wrapped->setDouble(name, value); });
+}
+
+int InstrumentedBackend::setInt(const char *name, qint64 value) {
+    return timed("set", QString::fromUtf8(name), [&]() { return wrapped->setInt(name, value); });
+}
+
+int InstrumentedBackend::setFlag(const char *name, bool value) {
+    return timed("set", QString::fromUtf8(name), [&]() { return wrapped->setFlag(name, value); });
+}
+
+int InstrumentedBackend::setString(const char *name, const char *value) {
+    return timed("set", QString::fromUtf8(name), [&]() { return wrapped->setString(name, value); });
+}
+
+int InstrumentedBackend::observeProperty(quint64 id, const char *name) {
+    return timed("observe", QString::fromUtf8(name), [&]() { return wrapped->observeProperty(id, name); });
+}
+
+int InstrumentedBackend::requestLogMessages(const char *minLevel) {
+    return timed("request-log", QString::fromUtf8(minLevel), [&]() { return wrapped->requestLogMessages(minLevel); });
+}
+
+// Draining the queue ends with an empty read every time; those are booked
+// separately so the real events stand out.
+PlayerEvent InstrumentedBackend::waitEvent(double timeout) {
+    QElapsedTimer timer;
+    timer.start();
+    PlayerEvent event = wrapped->waitEvent(timeout);
+    record(event.type == PlayerEvent::None ? "wait-event (empty)" : "wait-event", timer.nsecsElapsed());
+    return event;
+}
+
+bool InstrumentedBackend::terminate() {
+    return timed("terminate", QString(), [&]() { return wrapped->terminate(); });
+}
+
+mpv_handle *InstrumentedBackend::createClient(const char *name) {
+    return timed("create-client", QString::fromUtf8(name), [&]() { return wrapped->createClient(name); });
+}
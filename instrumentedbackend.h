@@ -0,0 +1,84 @@
+// ============================================================================
+// instrumentedbackend.h - Count Every Call to a Player
+// ============================================================================
+// A decorator around any PlayerBackend that records, per call kind and
+// name ("get time-pos", "command seek", "set pause"...), how often it was
+// made and how long it took. That answers questions like "how many libmpv
+// calls does a global seek cost per player?" or "which property read
+// dominates the sync tick?" without a profiler.
+//
+// Only created when instrumentation is switched on (--instrument), so the
+// normal build pays nothing for it - not even a branch per call. On
+// destruction the table is written to the debug output.
+// ============================================================================
+
+#ifndef INSTRUMENTEDBACKEND_H
+#define INSTRUMENTEDBACKEND_H
+
+#include "playerbackend.h"
+
+#include <QMap>
+#include <QMutex>
+
+class InstrumentedBackend : public PlayerBackend {
+public:
+    struct CallStats {
+        qint64 calls = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+    };
+
+    explicit InstrumentedBackend(PlayerBackend *inner);     // Takes ownership.
+    ~InstrumentedBackend() override;
+
+    PlayerBackend *inner() const;
+
+    QMap<QString, CallStats> stats() const;
+    qint64 totalCalls() const;
+    void reset();
+
+    // One line per call name, busiest first: calls, total and max time.
+    QString report() const;
+
+    bool isValid() const override;
+
+    int setOption(const char *name, const char *value) override;
+    int initialize() override;
+    void setWakeupCallback(void (*callback)(void *ctx), void *ctx) override;
+
+    int command(const char **args) override;
+    int commandAsync(quint64 id, const char **args) override;
+    int commandNode(const QVariant &args, QVariant *result = nullptr) override;
+
+    int getDouble(const char *name, double *value) override;
+    int getInt(const char *name, qint64 *value) override;
+    int getFlag(const char *name, bool *value) override;
+    int getString(const char *name, QString *value) override;
+    int getNode(const char *name, QVariant *value) override;
+
+    int setDouble(const char *name, double value) override;
+    int setInt(const char *name, qint64 value) override;
+    int setFlag(const char *name, bool value) override;
+    int setString(const char *name, const char *value) override;
+
+    int observeProperty(quint64 id, const char *name) override;
+    int requestLogMessages(const char *minLevel) override;
+
+    PlayerEvent waitEvent(double timeout) override;
+    bool terminate() override;
+    mpv_handle *createClient(const char *name) override;
+
+private:
+    // Runs `call` and books its duration under "<kind> <name>".
+    template <typename Call>
+    auto timed(const char *kind, const QString &name, Call call) -> decltype(call());
+
+    void record(const QString &key, qint64 ns);
+
+    PlayerBackend *wrapped;
+    int number;                              // For the report header.
+    mutable QMutex mutex;                    // Calls may come from any thread.
+    QMap<QString, CallStats> table;
+};
+
+#endif // INSTRUMENTEDBACKEND_H
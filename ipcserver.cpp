@@ -0,0 +1,690 @@
+// ============================================================================
+// ipcserver.cpp - Implementation of the JSON IPC Control Server
+// ============================================================================
+// See ipcserver.h for the protocol. The request flow is:
+//
+//   socket readyRead -> onReadyRead() -> handleRequest() for each request
+//     -> runGroupCommand() or runPlayerCommand() -> MPV client API
+//     -> replies collected and written back in one go
+//
+// Group commands take a detour through the GUI thread:
+//
+//   runGroupCommand() -> groupXxxRequested(key) -> IpcServer (GUI thread)
+//     -> PlayerGroup / barrier -> finishGroupCommand(key) -> reply
+//
+// MPV events flow the other way: MPV calls wakeup() from one of its own
+// threads, wakeup() queues drainEvents() into the IPC thread, and
+// drainEvents() turns each event into a JSON line for the interested
+// clients.
+// ============================================================================
+
+#include "ipcserver.h"
+#include "mpvwidget.h"           // For the full MpvWidget class definition.
+#include "mpvhelpers.h"
+
+#include <QLocalServer>          // Unix domain socket / Windows named pipe server.
+#include <QLocalSocket>
+#include <QThread>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDebug>
+
+// ============================================================================
+//
+//                          IpcWorker IMPLEMENTATION
+//
+// ============================================================================
+
+IpcWorker::IpcWorker(const QVector<mpv_handle *> &handles)
+    : QObject(nullptr), server(nullptr), nextUserdata(1), groupHeld(false) {
+    for (int i = 0; i < handles.size(); i++) {
+        PlayerLink *link = new PlayerLink;
+        link->owner = this;
+        link->index = i;
+        link->handle = handles[i];
+        link->wakeupQueued = false;
+        links.append(link);
+    }
+}
+
+IpcWorker::~IpcWorker() {
+    shutdown();
+    qDeleteAll(links);
+}
+
+// ----------------------------------------------------------------------------
+// listen() - Open the Socket and Start Receiving MPV Events
+// ----------------------------------------------------------------------------
+bool IpcWorker::listen(const QString &name) {
+    server = new QLocalServer(this);
+
+    // Only the current user may connect - the socket can pause, seek and
+    // load files, so other accounts on the machine shouldn't reach it.
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    // A crashed previous run can leave a stale socket file behind on Unix,
+    // which would make listen() fail with "address in use".
+    QLocalServer::removeServer(name);
+
+    if (!server->listen(name)) {
+        qDebug() << "IPC server: cannot listen on" << name << "-" << server->errorString();
+        delete server;
+        server = nullptr;
+        return false;
+    }
+    connect(server, &QLocalServer::newConnection, this, &IpcWorker::onNewConnection);
+
+    // The wakeup callback is registered only now, from inside this thread,
+    // so the drainEvents() calls it queues are delivered to this thread.
+    for (PlayerLink *link : links) {
+        if (link->handle) mpv_set_wakeup_callback(link->handle, &IpcWorker::wakeup, link);
+    }
+
+    qDebug() << "IPC server listening on" << server->fullServerName();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// shutdown() - Close All Connections and Release the MPV Client Handles
+// ----------------------------------------------------------------------------
+void IpcWorker::shutdown() {
+    for (PlayerLink *link : links) {
+        if (!link->handle) continue;
+        mpv_set_wakeup_callback(link->handle, nullptr, nullptr);
+        mpv_destroy(link->handle);           // Only this client - the player lives on.
+        link->handle = nullptr;
+    }
+    observers.clear();
+    pending.clear();
+
+    for (QLocalSocket *socket : clients) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+    clients.clear();
+
+    if (server) {
+        server->close();
+        delete server;
+        server = nullptr;
+    }
+}
+
+void IpcWorker::setGroupHeld(bool held) {
+    groupHeld = held;
+}
+
+// ----------------------------------------------------------------------------
+// Connection Handling
+// ----------------------------------------------------------------------------
+void IpcWorker::onNewConnection() {
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        clients.append(socket);
+        connect(socket, &QLocalSocket::readyRead, this, &IpcWorker::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &IpcWorker::onDisconnected);
+    }
+}
+
+void IpcWorker::onDisconnected() {
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if (!socket) return;
+
+    removeObservers(socket);
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (it->socket == socket) it = pending.erase(it);
+        else ++it;
+    }
+    clients.removeAll(socket);
+    socket->deleteLater();
+}
+
+void IpcWorker::removeObservers(QLocalSocket *socket) {
+    for (auto it = observers.begin(); it != observers.end();) {
+        if (it->socket == socket) {
+            mpv_handle *handle = links[it->player]->handle;
+            if (handle) mpv_unobserve_property(handle, it.key());
+            it = observers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// onReadyRead() - Parse and Execute Incoming Lines
+// ----------------------------------------------------------------------------
+// Every complete line is handled right away. All replies produced by one
+// readyRead are concatenated and written with a single write() + flush(),
+// so a burst of requests costs one syscall on the way back.
+// ----------------------------------------------------------------------------
+void IpcWorker::onReadyRead() {
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if (!socket) return;
+
+    QByteArray out;
+    while (socket->canReadLine()) {
+        QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        // Like mpv, lines that aren't JSON are input.conf-style commands
+        // ("cycle pause", "seek 10") for player 1, with no reply.
+        if (line[0] != '{' && line[0] != '[') {
+            if (links[0]->handle) mpv_command_string(links[0]->handle, line.constData());
+            continue;
+        }
+
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError) {
+            QJsonObject reply;
+            reply["error"] = QString::fromUtf8(mpv_error_string(MPV_ERROR_INVALID_PARAMETER));
+            out += QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n';
+            continue;
+        }
+
+        if (doc.isArray()) {
+            // Batch - deferred ("async") requests are left out of the array
+            // and answered on their own line when MPV finishes them.
+            QJsonArray replies;
+            const QJsonArray requests = doc.array();
+            for (const QJsonValue &request : requests) {
+                QJsonObject reply;
+                if (handleRequest(socket, request, reply)) replies.append(reply);
+            }
+            out += QJsonDocument(replies).toJson(QJsonDocument::Compact) + '\n';
+        } else {
+            QJsonObject reply;
+            if (handleRequest(socket, doc.object(), reply)) {
+                out += QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n';
+            }
+        }
+    }
+
+    if (!out.isEmpty()) {
+        socket->write(out);
+        socket->flush();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// handleRequest() - Execute One Request Object
+// ----------------------------------------------------------------------------
+// Fills in `reply` and returns true, or returns false if the reply will be
+// sent later (async or group command).
+// ----------------------------------------------------------------------------
+bool IpcWorker::handleRequest(QLocalSocket *socket, const QJsonValue &request, QJsonObject &reply) {
+    QJsonObject object = request.toObject();
+    QJsonValue requestId = object.contains("request_id") ? object.value("request_id") : QJsonValue(0);
+    reply["request_id"] = requestId;
+
+    QVariant command = object.value("command").toVariant();
+    QVariantList commandList = command.toList();
+
+    Result result;
+
+    // Group commands ignore the player selector - they always mean "all".
+    if (!commandList.isEmpty() && commandList[0].toString().startsWith("group-")) {
+        bool deferred = false;
+        result = runGroupCommand(socket, commandList, requestId, deferred);
+        if (deferred) return false;
+    } else {
+        QList<int> players;
+        if (!selectPlayers(object.value("player"), players)) {
+            result.error = MPV_ERROR_INVALID_PARAMETER;
+        } else if (players.size() == 1) {
+            bool deferred = false;
+            bool async = object.value("async").toBool();
+            result = runPlayerCommand(socket, players[0], command, async, requestId, deferred);
+            if (deferred) return false;
+        } else {
+            // "all" - run on every player, report the first failure (if any).
+            QVariantList data;
+            for (int player : players) {
+                bool deferred = false;
+                Result one = runPlayerCommand(socket, player, command, false, requestId, deferred);
+                if (one.error < 0 && result.error >= 0) result.error = one.error;
+                data.append(one.data);
+            }
+            result.data = data;
+        }
+    }
+
+    reply["error"] = QString::fromUtf8(mpv_error_string(result.error));
+    reply["data"] = QJsonValue::fromVariant(result.data);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// selectPlayers() - Interpret the "player" Field
+// ----------------------------------------------------------------------------
+bool IpcWorker::selectPlayers(const QJsonValue &selector, QList<int> &players) const {
+    if (selector.isUndefined() || selector.isNull()) {
+        players.append(0);
+        return true;
+    }
+    if (selector.isString() && selector.toString() == "all") {
+        for (int i = 0; i < links.size(); i++) players.append(i);
+        return true;
+    }
+    if (selector.isDouble()) {
+        int number = selector.toInt();
+        if (number >= 1 && number <= links.size()) {
+            players.append(number - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// Small Property Helpers for group-status
+// ----------------------------------------------------------------------------
+static bool hasFile(mpv_handle *handle) {
+    int idle = 1;
+    if (!handle || mpv_get_property(handle, "idle-active", MPV_FORMAT_FLAG, &idle) < 0) return false;
+    return idle == 0;
+}
+
+static double timePos(mpv_handle *handle) {
+    double pos = 0.0;
+    if (handle) mpv_get_property(handle, "time-pos", MPV_FORMAT_DOUBLE, &pos);
+    return pos;
+}
+
+// ----------------------------------------------------------------------------
+// runGroupCommand() - Commands That Act on Every Player
+// ----------------------------------------------------------------------------
+// These go through PlayerGroup and the BufferingBarrier, which belong to
+// the GUI thread, so apart from group-status they are only checked here
+// and forwarded. Their reply waits in `pending` until the GUI thread has
+// applied them (finishGroupCommand()).
+// ----------------------------------------------------------------------------
+IpcWorker::Result IpcWorker::runGroupCommand(QLocalSocket *socket, const QVariantList &command,
+                                             const QJsonValue &requestId, bool &deferred) {
+    Result result;
+    QString name = command.value(0).toString();
+    auto defer = [&]() {
+        quint64 key = nextUserdata++;
+        pending.insert(key, PendingReply{socket, requestId});
+        deferred = true;
+        return key;
+    };
+
+    if (name == "group-pause" || name == "group-play") {
+        emit groupPauseRequested(defer(), name == "group-pause");
+
+    } else if (name == "group-seek") {
+        bool ok = false;
+        double seconds = command.value(1).toDouble(&ok);
+        QString mode = command.value(2).toString();
+        if (!ok || (!mode.isEmpty() && mode != "relative" && mode != "absolute")) {
+            result.error = MPV_ERROR_INVALID_PARAMETER;
+            return result;
+        }
+        emit groupSeekRequested(defer(), seconds, mode != "absolute");
+
+    } else if (name == "group-speed") {
+        bool ok = false;
+        double speed = command.value(1).toDouble(&ok);
+        if (!ok || speed <= 0.0) {
+            result.error = MPV_ERROR_INVALID_PARAMETER;
+            return result;
+        }
+        emit groupSpeedRequested(defer(), speed);
+
+    } else if (name == "group-status") {
+        QVariantList players;
+        bool allPaused = true;
+        double groupPos = 0.0;
+        bool haveReference = false;
+        for (PlayerLink *link : links) {
+            QVariantMap player;
+            bool loaded = hasFile(link->handle);
+            int paused = 1;
+            if (link->handle) mpv_get_property(link->handle, "pause", MPV_FORMAT_FLAG, &paused);
+            double pos = loaded ? timePos(link->handle) : 0.0;
+
+            player["player"] = link->index + 1;
+            player["loaded"] = loaded;
+            player["paused"] = paused != 0;
+            player["position"] = pos;
+            players.append(player);
+
+            if (loaded) {
+                if (!paused) allPaused = false;
+                if (!haveReference) {
+                    groupPos = pos;
+                    haveReference = true;
+                }
+            }
+        }
+        QVariantMap status;
+        status["position"] = groupPos;
+        status["paused"] = allPaused;
+        status["held"] = groupHeld.load();
+        status["players"] = players;
+        result.data = status;
+
+    } else {
+        result.error = MPV_ERROR_INVALID_PARAMETER;
+    }
+    return result;
+}
+
+// Group commands can't fail once accepted. The client may have gone away
+// in the meantime; then there's nobody left to tell.
+void IpcWorker::finishGroupCommand(quint64 key) {
+    if (!pending.contains(key)) return;
+    PendingReply waiting = pending.take(key);
+
+    QJsonObject answer;
+    answer["request_id"] = waiting.requestId;
+    answer["error"] = QString::fromUtf8(mpv_error_string(MPV_ERROR_SUCCESS));
+    answer["data"] = QJsonValue();
+    sendEvent(waiting.socket, answer);
+}
+
+// ----------------------------------------------------------------------------
+// runPlayerCommand() - One mpv IPC Command on One Player
+// ----------------------------------------------------------------------------
+// The property commands are special-cased exactly like mpv's own IPC server
+// does. Everything else is passed to mpv_command_node(), which accepts both
+// the array form ["seek", 10] and the named-argument form {"name": "seek",
+// "target": 10}.
+// ----------------------------------------------------------------------------
+IpcWorker::Result IpcWorker::runPlayerCommand(QLocalSocket *socket, int player, const QVariant &command,
+                                              bool async, const QJsonValue &requestId, bool &deferred) {
+    Result result;
+    mpv_handle *handle = links[player]->handle;
+    if (!handle) {
+        result.error = MPV_ERROR_UNINITIALIZED;
+        return result;
+    }
+
+    QVariantList args = command.toList();
+    QString name = args.value(0).toString();
+    QByteArray property = args.value(1).toString().toUtf8();
+
+    if (name == "get_property") {
+        mpv_node node;
+        result.error = mpv_get_property(handle, property.constData(), MPV_FORMAT_NODE, &node);
+        if (result.error >= 0) {
+            result.data = MpvHelpers::nodeToVariant(&node);
+            mpv_free_node_contents(&node);
+        }
+
+    } else if (name == "get_property_string") {
+        char *value = mpv_get_property_string(handle, property.constData());
+        if (value) {
+            result.data = QString::fromUtf8(value);
+            mpv_free(value);
+        } else {
+            result.error = MPV_ERROR_PROPERTY_UNAVAILABLE;
+        }
+
+    } else if (name == "set_property") {
+        MpvHelpers::NodeBuilder value(args.value(2));
+        result.error = mpv_set_property(handle, property.constData(), MPV_FORMAT_NODE, value.node());
+
+    } else if (name == "set_property_string") {
+        QByteArray value = args.value(2).toString().toUtf8();
+        result.error = mpv_set_property_string(handle, property.constData(), value.constData());
+
+    } else if (name == "observe_property" || name == "observe_property_string") {
+        // ["observe_property", <client id>, <name>]
+        QByteArray observed = args.value(2).toString().toUtf8();
+        quint64 key = nextUserdata++;
+        mpv_format format = (name == "observe_property") ? MPV_FORMAT_NODE : MPV_FORMAT_STRING;
+        result.error = mpv_observe_property(handle, key, observed.constData(), format);
+        if (result.error >= 0) {
+            observers.insert(key, Observer{socket, QJsonValue::fromVariant(args.value(1)), player});
+        }
+
+    } else if (name == "unobserve_property") {
+        QJsonValue clientId = QJsonValue::fromVariant(args.value(1));
+        for (auto it = observers.begin(); it != observers.end();) {
+            if (it->socket == socket && it->player == player && it->clientId == clientId) {
+                mpv_unobserve_property(handle, it.key());
+                it = observers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+    } else if (name == "client_name") {
+        result.data = QString::fromUtf8(mpv_client_name(handle));
+
+    } else if (name == "get_time_us") {
+        result.data = static_cast<qlonglong>(mpv_get_time_us(handle));
+
+    } else if (name == "get_version") {
+        result.data = static_cast<qlonglong>(mpv_client_api_version());
+
+    } else if (async) {
+        quint64 key = nextUserdata++;
+        MpvHelpers::NodeBuilder node(command);
+        result.error = mpv_command_node_async(handle, key, node.node());
+        if (result.error >= 0) {
+            pending.insert(key, PendingReply{socket, requestId});
+            deferred = true;
+        }
+
+    } else {
+        MpvHelpers::NodeBuilder node(command);
+        mpv_node out;
+        result.error = mpv_command_node(handle, node.node(), &out);
+        if (result.error >= 0) {
+            result.data = MpvHelpers::nodeToVariant(&out);
+            mpv_free_node_contents(&out);
+        }
+    }
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// wakeup() - Called by MPV From an Arbitrary Thread
+// ----------------------------------------------------------------------------
+// MPV's rule: the callback must return quickly and must not call the MPV
+// API. It just queues drainEvents() into the IPC thread. The atomic flag
+// stops a burst of events from queuing a burst of identical calls.
+// ----------------------------------------------------------------------------
+void IpcWorker::wakeup(void *context) {
+    PlayerLink *link = static_cast<PlayerLink *>(context);
+    if (link->wakeupQueued.exchange(true)) return;
+
+    IpcWorker *worker = link->owner;
+    QMetaObject::invokeMethod(worker, [worker, link]() { worker->drainEvents(link); },
+                              Qt::QueuedConnection);
+}
+
+// ----------------------------------------------------------------------------
+// drainEvents() - Forward Everything MPV Has Queued for This Player
+// ----------------------------------------------------------------------------
+void IpcWorker::drainEvents(PlayerLink *link) {
+    // Clear the flag BEFORE draining, so an event arriving while we drain
+    // queues another call instead of being missed.
+    link->wakeupQueued = false;
+
+    while (link->handle) {
+        mpv_event *event = mpv_wait_event(link->handle, 0);
+        if (event->event_id == MPV_EVENT_NONE) break;
+
+        QJsonObject message;
+        message["event"] = QString::fromUtf8(mpv_event_name(event->event_id));
+        message["player"] = link->index + 1;
+
+        switch (event->event_id) {
+        case MPV_EVENT_PROPERTY_CHANGE: {
+            auto it = observers.constFind(event->reply_userdata);
+            if (it == observers.constEnd()) break;
+
+            mpv_event_property *prop = static_cast<mpv_event_property *>(event->data);
+            message["id"] = it->clientId;
+            message["name"] = QString::fromUtf8(prop->name);
+            if (prop->format == MPV_FORMAT_NODE) {
+                message["data"] = QJsonValue::fromVariant(
+                    MpvHelpers::nodeToVariant(static_cast<mpv_node *>(prop->data)));
+            } else if (prop->format == MPV_FORMAT_STRING) {
+                message["data"] = QString::fromUtf8(*static_cast<char **>(prop->data));
+            }
+            sendEvent(it->socket, message);
+            break;
+        }
+
+        case MPV_EVENT_COMMAND_REPLY: {
+            if (!pending.contains(event->reply_userdata)) break;
+            PendingReply waiting = pending.take(event->reply_userdata);
+
+            mpv_event_command *reply = static_cast<mpv_event_command *>(event->data);
+            QJsonObject answer;
+            answer["request_id"] = waiting.requestId;
+            answer["error"] = QString::fromUtf8(mpv_error_string(event->error));
+            answer["data"] = QJsonValue::fromVariant(MpvHelpers::nodeToVariant(&reply->result));
+            sendEvent(waiting.socket, answer);
+            break;
+        }
+
+        case MPV_EVENT_SHUTDOWN:
+            // The player itself is going away - release our client handle
+            // so MPV can finish shutting down.
+            broadcastEvent(message);
+            mpv_set_wakeup_callback(link->handle, nullptr, nullptr);
+            mpv_destroy(link->handle);
+            link->handle = nullptr;
+            break;
+
+        case MPV_EVENT_END_FILE: {
+            mpv_event_end_file *end = static_cast<mpv_event_end_file *>(event->data);
+            switch (end->reason) {
+            case MPV_END_FILE_REASON_EOF:      message["reason"] = "eof"; break;
+            case MPV_END_FILE_REASON_STOP:     message["reason"] = "stop"; break;
+            case MPV_END_FILE_REASON_QUIT:     message["reason"] = "quit"; break;
+            case MPV_END_FILE_REASON_ERROR:    message["reason"] = "error"; break;
+            case MPV_END_FILE_REASON_REDIRECT: message["reason"] = "redirect"; break;
+            }
+            broadcastEvent(message);
+            break;
+        }
+
+        default:
+            broadcastEvent(message);
+            break;
+        }
+    }
+}
+
+void IpcWorker::sendEvent(QLocalSocket *socket, const QJsonObject &event) {
+    if (!clients.contains(socket)) return;    // Disconnected in the meantime.
+    socket->write(QJsonDocument(event).toJson(QJsonDocument::Compact) + '\n');
+    socket->flush();
+}
+
+void IpcWorker::broadcastEvent(const QJsonObject &event) {
+    QByteArray line = QJsonDocument(event).toJson(QJsonDocument::Compact) + '\n';
+    for (QLocalSocket *socket : clients) {
+        socket->write(line);
+        socket->flush();
+    }
+}
+
+// ============================================================================
+//
+//                          IpcServer IMPLEMENTATION
+//
+// ============================================================================
+
+IpcServer::IpcServer(QObject *parent)
+    : QObject(parent), thread(nullptr), worker(nullptr), groupHeld(false) {
+}
+
+void IpcServer::setGroupHeld(bool held) {
+    groupHeld = held;
+    if (worker) worker->setGroupHeld(held);
+}
+
+IpcServer::~IpcServer() {
+    stop();
+}
+
+bool IpcServer::isRunning() const {
+    return worker != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// start() - Create the Client Handles, the Thread and the Worker
+// ----------------------------------------------------------------------------
+bool IpcServer::start(const QString &name, const QList<MpvWidget *> &players) {
+    stop();
+
+    // A client handle is a second, independent connection to the same player.
+    // It is safe to use from another thread and gets its own event queue, so
+    // observing properties here never steals events from the GUI side.
+    // This is the one place that talks to libmpv directly rather than through
+    // PlayerBackend: the worker speaks mpv's own protocol. Backends without
+    // libmpv behind them (the fake) have no client handle to give, so those
+    // players answer with errors.
+    QVector<mpv_handle *> handles;
+    for (MpvWidget *player : players) {
+        handles.append(player ? player->createClient("ipc") : nullptr);
+    }
+
+    worker = new IpcWorker(handles);
+    thread = new QThread(this);
+    thread->setObjectName("IPC server");
+    worker->moveToThread(thread);
+
+    // Queued into this (GUI) thread; the reply goes back once applied.
+    IpcWorker *w = worker;
+    connect(worker, &IpcWorker::groupPauseRequested, this, [this, w](quint64 key, bool paused) {
+        emit groupPauseRequested(paused);
+        finishGroupCommand(w, key);
+    });
+    connect(worker, &IpcWorker::groupSeekRequested, this, [this, w](quint64 key, double seconds, bool relative) {
+        emit groupSeekRequested(seconds, relative);
+        finishGroupCommand(w, key);
+    });
+    connect(worker, &IpcWorker::groupSpeedRequested, this, [this, w](quint64 key, double speed) {
+        emit groupSpeedRequested(speed);
+        finishGroupCommand(w, key);
+    });
+    worker->setGroupHeld(groupHeld);
+
+    // Above-normal priority keeps the reply latency low while the GUI thread
+    // or the players are busy.
+    thread->start(QThread::HighPriority);
+
+    bool ok = false;
+    QMetaObject::invokeMethod(worker, [w, name]() { return w->listen(name); },
+                              Qt::BlockingQueuedConnection, &ok);
+    if (!ok) stop();
+    return ok;
+}
+
+// The server may have been stopped (or restarted) while the command was
+// queued here; then its worker and client are gone.
+void IpcServer::finishGroupCommand(IpcWorker *from, quint64 key) {
+    if (!worker || worker != from) return;
+    QMetaObject::invokeMethod(from, [from, key]() { from->finishGroupCommand(key); }, Qt::QueuedConnection);
+}
+
+// ----------------------------------------------------------------------------
+// stop() - Shut the Worker Down Inside Its Thread, Then Join the Thread
+// ----------------------------------------------------------------------------
+// Must be called before the players are shut down: the client handles keep
+// each MPV core alive until they are destroyed.
+// ----------------------------------------------------------------------------
+void IpcServer::stop() {
+    if (!worker) return;
+
+    IpcWorker *w = worker;
+    QMetaObject::invokeMethod(worker, [w]() { w->shutdown(); }, Qt::BlockingQueuedConnection);
+
+    thread->quit();
+    thread->wait();
+
+    delete worker;         // Safe: its thread has finished.
+    worker = nullptr;
+    delete thread;
+    thread = nullptr;
+}
@@ -0,0 +1,190 @@
+// ============================================================================
+// ipcserver.h - JSON IPC Control Server for Both Players
+// ============================================================================
+// Lets external tools (stream decks, OBS scripts, shell scripts...) control
+// the app through a local socket, using the same JSON dialect as mpv's own
+// --input-ipc-server. Start the app with
+//
+//     MPV-watchalong --input-ipc-server=/tmp/watchalong      (Linux/macOS)
+//     MPV-watchalong --input-ipc-server=watchalong           (Windows pipe)
+//
+// and send one JSON object per line:
+//
+//     {"command": ["set_property", "pause", true], "request_id": 7}
+//     -> {"error": "success", "data": null, "request_id": 7}
+//
+// Extensions on top of mpv's dialect:
+//
+//   * "player": 1, 2 or "all" selects which player a request goes to.
+//     Without it, requests go to player 1, so existing mpv scripts work
+//     unchanged. With "all", "data" is an array with one entry per player.
+//
+//   * Group commands act on both players at once, like the Global buttons:
+//       ["group-pause"]  ["group-play"]  ["group-status"]
+//       ["group-seek", <seconds>, "relative" | "absolute"]
+//       ["group-speed", <factor>]
+//
+//   * Batching: a line may contain a JSON ARRAY of requests. The replies
+//     come back as one array, in the same order, in a single write -
+//     except those of group and "async" commands, which come on their own
+//     line once the command is done.
+//
+// Property observers (observe_property) receive "property-change" events,
+// and every client receives mpv's playback events, each tagged with the
+// "player" it came from.
+//
+// Threading: the server runs in its own thread and talks to MPV through
+// separate client handles (mpv_create_client), so requests never wait for
+// the GUI thread. Group commands are the exception: the group's state
+// (hold, prefill, nominal speed, composite and filter-chain modes) lives on
+// the GUI thread, so they are validated here, queued there and applied
+// exactly as if the Global buttons had been clicked. Their reply is held
+// back until the GUI thread has applied them - when a client reads
+// "success" for group-pause, both players are paused. With an idle GUI
+// thread that is well under a millisecond from request to reply.
+// ============================================================================
+
+#ifndef IPCSERVER_H
+#define IPCSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QVariant>
+#include <QJsonObject>       // One request/reply/event on the wire.
+#include <QJsonValue>
+
+#include <atomic>            // Lock-free "wakeup already queued" flag.
+
+#include <mpv/client.h>
+
+class QLocalServer;
+class QLocalSocket;
+class QThread;
+class MpvWidget;
+
+// ============================================================================
+// IpcWorker - Lives in the Server Thread
+// ============================================================================
+// Everything in here runs in the IPC thread. IpcServer (below) is the small
+// GUI-thread front end that creates the thread and starts/stops the worker.
+// ============================================================================
+class IpcWorker : public QObject {
+    Q_OBJECT
+
+public:
+    // Takes ownership of the client handles (one per player, may be nullptr).
+    explicit IpcWorker(const QVector<mpv_handle *> &handles);
+    ~IpcWorker();
+
+public slots:
+    bool listen(const QString &name);   // Must run in the worker thread.
+    void shutdown();                    // Closes everything, destroys handles.
+
+public:
+    void setGroupHeld(bool held);       // Any thread - see IpcServer::setGroupHeld.
+    void finishGroupCommand(quint64 key);   // Worker thread: send its reply.
+
+signals:
+    // Group commands, handled by the GUI thread, which then calls
+    // finishGroupCommand(key).
+    void groupPauseRequested(quint64 key, bool paused);
+    void groupSeekRequested(quint64 key, double seconds, bool relative);
+    void groupSpeedRequested(quint64 key, double speed);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    // One per player. Allocated separately so its address can be handed to
+    // MPV as the wakeup callback context.
+    struct PlayerLink {
+        IpcWorker *owner;
+        int index;                              // 0-based player index.
+        mpv_handle *handle;                     // Client handle, or nullptr.
+        std::atomic<bool> wakeupQueued;
+    };
+
+    // An observe_property registration. The key in the hash is the
+    // reply_userdata we gave MPV.
+    struct Observer {
+        QLocalSocket *socket;
+        QJsonValue clientId;                    // The id the client chose.
+        int player;
+    };
+
+    // An "async": true command waiting for MPV_EVENT_COMMAND_REPLY, or a
+    // group command waiting for the GUI thread.
+    struct PendingReply {
+        QLocalSocket *socket;
+        QJsonValue requestId;
+    };
+
+    // Result of one command on one player (error is an mpv error code).
+    struct Result {
+        int error = MPV_ERROR_SUCCESS;
+        QVariant data;
+    };
+
+    static void wakeup(void *context);
+    void drainEvents(PlayerLink *link);
+    void sendEvent(QLocalSocket *socket, const QJsonObject &event);
+    void broadcastEvent(const QJsonObject &event);
+
+    bool handleRequest(QLocalSocket *socket, const QJsonValue &request, QJsonObject &reply);
+    bool selectPlayers(const QJsonValue &selector, QList<int> &players) const;
+    Result runGroupCommand(QLocalSocket *socket, const QVariantList &command,
+                           const QJsonValue &requestId, bool &deferred);
+    Result runPlayerCommand(QLocalSocket *socket, int player, const QVariant &command,
+                            bool async, const QJsonValue &requestId, bool &deferred);
+
+    void removeObservers(QLocalSocket *socket);
+
+    QLocalServer *server;
+    QList<QLocalSocket *> clients;
+    QVector<PlayerLink *> links;
+    QHash<quint64, Observer> observers;
+    QHash<quint64, PendingReply> pending;   // By reply_userdata or group key.
+    quint64 nextUserdata;
+    std::atomic<bool> groupHeld;
+};
+
+// ============================================================================
+// IpcServer - GUI-Thread Front End
+// ============================================================================
+class IpcServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit IpcServer(QObject *parent = nullptr);
+    ~IpcServer();
+
+    bool start(const QString &name, const QList<MpvWidget *> &players);
+    void stop();                         // Blocks until the thread has exited.
+    bool isRunning() const;
+
+    // Whether a PlayerGroup hold is active (see bufferingbarrier.h), for
+    // group-status to report.
+    void setGroupHeld(bool held);
+
+signals:
+    // Group commands from a client, in the order they arrived. Absolute
+    // seeks are in group time (see PlayerGroup::seekTo). The client gets
+    // its reply once the connected slots have returned, so they must apply
+    // the command directly.
+    void groupPauseRequested(bool paused);
+    void groupSeekRequested(double seconds, bool relative);
+    void groupSpeedRequested(double speed);
+
+private:
+    void finishGroupCommand(IpcWorker *from, quint64 key);
+
+    QThread *thread;
+    IpcWorker *worker;
+    bool groupHeld;
+};
+
+#endif // IPCSERVER_H
@@ -0,0 +1,258 @@
+// ============================================================================
+// keyframeindex.cpp - Implementation of KeyframeIndex and KeyframeIndexer
+// ============================================================================
+
+#include "keyframeindex.h"
+#include "analysiscache.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef HAVE_LIBAV
+extern "C" {                         // FFmpeg is a C library.
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+#endif
+
+static const quint32 CacheMagic = 0x57414b46;        // "WAKF"
+static const quint8 CacheVersion = 1;
+
+// ----------------------------------------------------------------------------
+// KeyframeIndex - Lookups
+// ----------------------------------------------------------------------------
+// Half a frame of tolerance: a target that IS a keyframe often comes out a
+// hair before it after rounding.
+// ----------------------------------------------------------------------------
+double KeyframeIndex::keyframeBefore(double target) const {
+    double slack = frameRate > 0.0 ? 0.5 / frameRate : 0.001;
+    auto it = std::upper_bound(times.begin(), times.end(), target + slack);
+    return it == times.begin() ? 0.0 : *(it - 1);
+}
+
+int KeyframeIndex::framesToDecode(double target) const {
+    if (times.isEmpty()) return -1;
+    double rate = frameRate > 0.0 ? frameRate : 25.0;
+    return qMax(0, static_cast<int>(std::lround((target - keyframeBefore(target)) * rate)));
+}
+
+double KeyframeIndex::averageGop() const {
+    if (times.size() < 2) return 0.0;
+    return (times.last() - times.first()) / (times.size() - 1);
+}
+
+// ----------------------------------------------------------------------------
+// KeyframeIndex - Cache Format
+// ----------------------------------------------------------------------------
+//   magic (4), version (1), frame rate in mHz (varint), count (varint),
+//   then per keyframe the ms since the previous one (varint).
+// A varint stores 7 bits per byte, low bits first; the high bit says
+// "more follows". Typical GOPs (0.5 - 10 s) take two bytes.
+// ----------------------------------------------------------------------------
+static void putVarint(QByteArray &out, quint64 value) {
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+static bool getVarint(const QByteArray &in, int &pos, quint64 &value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        quint8 byte = static_cast<quint8>(in[pos++]);
+        value |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+QByteArray KeyframeIndex::serialize() const {
+    QByteArray data;
+    for (int shift = 24; shift >= 0; shift -= 8) data.append(static_cast<char>((CacheMagic >> shift) & 0xff));
+    data.append(static_cast<char>(CacheVersion));
+    putVarint(data, static_cast<quint64>(std::llround(frameRate * 1000.0)));
+    putVarint(data, static_cast<quint64>(times.size()));
+
+    qint64 previous = 0;
+    for (double time : times) {
+        qint64 ms = qMax(previous, static_cast<qint64>(std::llround(time * 1000.0)));
+        putVarint(data, static_cast<quint64>(ms - previous));
+        previous = ms;
+    }
+    return data;
+}
+
+bool KeyframeIndex::deserialize(const QByteArray &data, KeyframeIndex &index) {
+    if (data.size() < 5) return false;
+    quint32 magic = 0;
+    for (int i = 0; i < 4; i++) magic = (magic << 8) | static_cast<quint8>(data[i]);
+    if (magic != CacheMagic || static_cast<quint8>(data[4]) != CacheVersion) return false;
+
+    int pos = 5;
+    quint64 rate = 0, count = 0;
+    if (!getVarint(data, pos, rate) || !getVarint(data, pos, count)) return false;
+    if (count > quint64(data.size() - pos)) return false;     // At least a byte each.
+
+    index.frameRate = rate / 1000.0;
+    index.times.clear();
+    index.times.reserve(static_cast<int>(count));
+    quint64 ms = 0;
+    for (quint64 i = 0; i < count; i++) {
+        quint64 delta = 0;
+        if (!getVarint(data, pos, delta)) return false;
+        ms += delta;
+        index.times.append(ms / 1000.0);
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Job - Shared State of One Scan
+// ----------------------------------------------------------------------------
+// Progress is counted in bytes read, since the scan is bound by reading.
+// ----------------------------------------------------------------------------
+struct KeyframeIndexer::Job : BackgroundAnalysis::Job {
+    KeyframeIndex index;                     // Written by the task only.
+};
+
+// ----------------------------------------------------------------------------
+// ScanTask - Read the Video Stream's Packets, Keep the Keyframes
+// ----------------------------------------------------------------------------
+class KeyframeIndexer::ScanTask : public Task {
+public:
+    explicit ScanTask(QSharedPointer<Job> job) : Task(job), job(job) {}
+
+private:
+    void work() override {
+#ifndef HAVE_LIBAV
+        job->fail("Built without libav");
+#else
+        AVFormatContext *format = nullptr;
+        QByteArray file = job->path.toUtf8();
+        if (avformat_open_input(&format, file.constData(), nullptr, nullptr) < 0) {
+            job->fail("Can't open file");
+            return;
+        }
+        if (avformat_find_stream_info(format, nullptr) < 0) {
+            job->fail("Can't read stream info");
+            avformat_close_input(&format);
+            return;
+        }
+
+        int stream = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (stream < 0 || (format->streams[stream]->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+            job->fail("No video stream");
+            avformat_close_input(&format);
+            return;
+        }
+        for (unsigned i = 0; i < format->nb_streams; i++) {
+            if (static_cast<int>(i) != stream) format->streams[i]->discard = AVDISCARD_ALL;
+        }
+
+        // Same time origin as MPV's time-pos: the container's start time.
+        AVStream *st = format->streams[stream];
+        const double timeBase = av_q2d(st->time_base);
+        const double startOffset = format->start_time != AV_NOPTS_VALUE
+                                 ? format->start_time / static_cast<double>(AV_TIME_BASE) : 0.0;
+        if (st->avg_frame_rate.num > 0 && st->avg_frame_rate.den > 0) {
+            job->index.frameRate = av_q2d(st->avg_frame_rate);
+        }
+        if (format->pb) job->total = qMax<qint64>(0, avio_size(format->pb));
+
+        AVPacket *packet = av_packet_alloc();
+        qint64 packets = 0;
+        double first = -1.0, last = -1.0;
+        while (!job->cancelled && av_read_frame(format, packet) >= 0) {
+            if (packet->stream_index == stream) {
+                int64_t ts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+                if (ts != AV_NOPTS_VALUE) {
+                    double time = ts * timeBase - startOffset;
+                    if (packet->flags & AV_PKT_FLAG_KEY) job->index.times.append(qMax(0.0, time));
+                    if (first < 0.0 || time < first) first = time;
+                    last = qMax(last, time);
+                    packets++;
+                }
+            }
+            if (format->pb) job->done = avio_tell(format->pb);
+            av_packet_unref(packet);
+        }
+        av_packet_free(&packet);
+        avformat_close_input(&format);
+
+        // No usable frame rate in the header: one packet is one frame.
+        if (job->index.frameRate <= 0.0 && packets > 1 && last > first) {
+            job->index.frameRate = (packets - 1) / (last - first);
+        }
+
+        std::sort(job->index.times.begin(), job->index.times.end());
+        job->index.times.erase(std::unique(job->index.times.begin(), job->index.times.end()),
+                               job->index.times.end());
+        if (job->index.times.isEmpty() && !job->cancelled) job->fail("No keyframes found");
+#endif
+    }
+
+    QSharedPointer<Job> job;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+// Reading is what takes the time, so two scans at once (both players) is
+// as parallel as it gets.
+// ----------------------------------------------------------------------------
+KeyframeIndexer::KeyframeIndexer(QObject *parent) : BackgroundAnalysis(2, parent) {}
+
+bool KeyframeIndexer::isAvailable() {
+#ifdef HAVE_LIBAV
+    return true;
+#else
+    return false;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// analyze() / forget() / index()
+// ----------------------------------------------------------------------------
+void KeyframeIndexer::analyze(int slot, const QString &path) {
+    cancel(slot);
+
+    if (!isAvailable()) {
+        emit failed(slot, "Built without libav");
+        return;
+    }
+
+    QByteArray cached;
+    KeyframeIndex index;
+    if (AnalysisCache::load(path, "keyframes", cached) && KeyframeIndex::deserialize(cached, index)) {
+        results[slot] = index;
+        emit finished(slot);
+        return;
+    }
+
+    QSharedPointer<Job> job(new Job);
+    job->path = path;
+    start(slot, job, new ScanTask(job));
+}
+
+void KeyframeIndexer::forget(int slot) {
+    results.remove(slot);
+}
+
+KeyframeIndex KeyframeIndexer::index(int slot) const {
+    return results.value(slot);
+}
+
+// ----------------------------------------------------------------------------
+// finishJob() (GUI Thread)
+// ----------------------------------------------------------------------------
+void KeyframeIndexer::finishJob(QSharedPointer<BackgroundAnalysis::Job> done) {
+    QSharedPointer<Job> job = done.staticCast<Job>();
+    if (job->index.isEmpty()) {
+        emit failed(job->slot, job->errorOr("No keyframes found"));
+        return;
+    }
+    results[job->slot] = job->index;
+    AnalysisCache::save(job->path, "keyframes", job->index.serialize());
+    emit finished(job->slot);
+}
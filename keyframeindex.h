@@ -0,0 +1,78 @@
+// ============================================================================
+// keyframeindex.h - Background Keyframe Index, for Predictable Seeks
+// ============================================================================
+// An exact seek makes MPV jump to the keyframe before the target and decode
+// every frame from there on; only the last one is shown. How long that
+// takes depends on how far back the keyframe is - a few frames in one
+// encode, ten seconds' worth in another. Two players with different GOP
+// structures therefore finish the "same" seek at very different times.
+//
+// The KeyframeIndexer reads each loaded file once in the background and
+// records where its keyframes are. It only demuxes - packets of the video
+// stream are looked at, nothing is decoded - so indexing a movie is
+// limited by how fast the file can be read. The BufferingBarrier uses the
+// index to plan its seeks (see BufferingBarrier::setKeyframeIndexer).
+//
+// Indexes are cached per file (see analysiscache.h) in a compact form:
+// the distances between keyframes in milliseconds as variable-length
+// integers, about two bytes per keyframe.
+// ============================================================================
+
+#ifndef KEYFRAMEINDEX_H
+#define KEYFRAMEINDEX_H
+
+#include "backgroundanalysis.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+// ----------------------------------------------------------------------------
+// KeyframeIndex - One File's Keyframes
+// ----------------------------------------------------------------------------
+struct KeyframeIndex {
+    QVector<double> times;                   // Seconds, ascending.
+    double frameRate = 0.0;                  // Of the video stream; 0 = unknown.
+
+    bool isEmpty() const { return times.isEmpty(); }
+
+    // The keyframe an exact seek to `target` starts decoding from.
+    double keyframeBefore(double target) const;
+
+    // Frames decoded by an exact seek to `target` (0 when it is a keyframe),
+    // or -1 without an index.
+    int framesToDecode(double target) const;
+
+    double averageGop() const;               // Seconds between keyframes.
+
+    QByteArray serialize() const;
+    static bool deserialize(const QByteArray &data, KeyframeIndex &index);
+};
+
+// ----------------------------------------------------------------------------
+// KeyframeIndexer - Builds and Holds the Indexes, by Player Slot
+// ----------------------------------------------------------------------------
+class KeyframeIndexer : public BackgroundAnalysis {
+    Q_OBJECT
+
+public:
+    explicit KeyframeIndexer(QObject *parent = nullptr);
+
+    static bool isAvailable();               // False when built without libav.
+
+    // Same pattern as SceneDetector: a cached index finishes immediately.
+    void analyze(int slot, const QString &path);
+
+    KeyframeIndex index(int slot) const;     // Empty until finished().
+
+private:
+    struct Job;                              // One scan - see the .cpp file.
+    class ScanTask;
+
+    void finishJob(QSharedPointer<BackgroundAnalysis::Job> done) override;
+    void forget(int slot) override;
+
+    QHash<int, KeyframeIndex> results;       // Finished indexes, by slot.
+};
+
+#endif // KEYFRAMEINDEX_H
@@ -0,0 +1,353 @@
+// ============================================================================
+// loudnessanalyzer.cpp - Implementation of LoudnessAnalyzer
+// ============================================================================
+// The measurement follows ITU-R BS.1770-4. Channel weights are all 1.0,
+// which is exact for mono and stereo. Surround files are downmixed to stereo
+// by the decoder first; that shifts their absolute loudness slightly, but
+// matching two files against each other is barely affected.
+// ============================================================================
+
+#include "loudnessanalyzer.h"
+#include "mediadecoder.h"
+#include "simdkernels.h"
+#include "analysiscache.h"
+
+#include <QDataStream>
+#include <QThread>
+
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Constants
+// ----------------------------------------------------------------------------
+static const int SampleRate = 48000;                 // The K-weighting below is for 48 kHz.
+static const int BlockFrames = SampleRate / 10;      // 100 ms energy blocks.
+static const int GateBlocks = 4;                     // 400 ms gating blocks (75% overlap).
+static const int ShortTermBlocks = 30;               // 3 s short-term window.
+static const double PrerollSeconds = 0.5;            // Filter settling before a segment.
+static const double MinSegmentSeconds = 120.0;       // Shorter segments aren't worth a seek.
+static const double AbsoluteGate = -70.0;            // LUFS
+static const double RelativeGate = -10.0;            // LU below the ungated mean.
+
+static const quint32 CacheMagic = 0x57414c44;        // "WALD"
+static const quint32 CacheVersion = 1;
+
+// K-weighting at 48 kHz (BS.1770-4, table 1 and 2): a high-shelf modelling
+// the head, then the "RLB" high-pass.
+static const SimdKernels::Biquad ShelfFilter = {
+    1.53512485958697, -2.69169618940638, 1.19839281085285,
+    -1.69065929318241, 0.73248077421585
+};
+static const SimdKernels::Biquad HighPassFilter = {
+    1.0, -2.0, 1.0,
+    -1.99004745483398, 0.99007225036621
+};
+
+static double toLufs(double meanSquare) {
+    if (meanSquare <= 0.0) return -120.0;
+    return -0.691 + 10.0 * std::log10(meanSquare);
+}
+
+// ----------------------------------------------------------------------------
+// Job - Shared State of One Scan
+// ----------------------------------------------------------------------------
+// Progress is counted in frames decoded.
+// ----------------------------------------------------------------------------
+struct LoudnessAnalyzer::Job : BackgroundAnalysis::Job {
+    // One entry per segment. Every task writes only its own entry.
+    struct Segment {
+        qint64 firstBlock = 0;
+        qint64 endBlock = -1;                // -1 = until the end of the file.
+        QVector<double> energy;              // Sum of squares per 100 ms block.
+        bool complete = false;               // Reached endBlock (or the end of the file).
+        QString error;                       // Why not, if decoding broke off.
+    };
+    QVector<Segment> segments;
+};
+
+// ----------------------------------------------------------------------------
+// SegmentTask - Decode and Measure One Segment
+// ----------------------------------------------------------------------------
+class LoudnessAnalyzer::SegmentTask : public Task {
+public:
+    SegmentTask(QSharedPointer<Job> job, int index) : Task(job), job(job), index(index) {}
+
+private:
+    void work() override {
+        Job::Segment &segment = job->segments[index];
+
+        MediaDecoder decoder;
+        if (!decoder.open(job->path, SampleRate, 2)) {
+            segment.error = decoder.errorString();
+            job->fail(segment.error);
+            return;
+        }
+        const int channels = decoder.channels();
+
+        const qint64 startFrame = segment.firstBlock * BlockFrames;
+        const qint64 endFrame = segment.endBlock < 0 ? -1 : segment.endBlock * BlockFrames;
+        if (startFrame > 0) {
+            decoder.seek(qMax(0.0, startFrame / double(SampleRate) - PrerollSeconds));
+        }
+
+        SimdKernels::BiquadState shelf[2];
+        SimdKernels::BiquadState highPass[2];
+        QVector<float> buffer;
+        qint64 position = -1;                // Frame index of buffer[0] in the file.
+
+        while (!job->cancelled) {
+            buffer.clear();
+            double startTime = 0.0;
+            int frames = decoder.decode(buffer, startTime);
+            if (frames < 0) {
+                // Whether this is a broken tail (fine) or a hole in the
+                // middle (not) is decided in finishJob().
+                segment.error = decoder.errorString();
+                if (segment.energy.isEmpty()) job->fail(segment.error);
+                return;
+            }
+            if (frames == 0) {
+                segment.complete = true;
+                return;
+            }
+
+            // Timestamps only anchor the first chunk; after that, frames are
+            // counted, which is exact and immune to timestamp jitter.
+            if (position < 0) {
+                position = startTime >= 0.0 ? std::llround(startTime * SampleRate)
+                                            : startFrame;
+            }
+
+            float *samples = buffer.data();
+            SimdKernels::biquad(samples, samples, frames, channels, ShelfFilter, shelf);
+            SimdKernels::biquad(samples, samples, frames, channels, HighPassFilter, highPass);
+
+            // Only frames inside [startFrame, endFrame) count; the preroll
+            // just warms up the filters.
+            qint64 from = qMax(position, startFrame);
+            qint64 to = position + frames;
+            if (endFrame >= 0) to = qMin(to, endFrame);
+
+            while (from < to) {
+                qint64 block = from / BlockFrames;
+                qint64 blockEnd = qMin(to, (block + 1) * BlockFrames);
+
+                double energy = SimdKernels::sumOfSquares(samples + (from - position) * channels,
+                                                          static_cast<size_t>((blockEnd - from) * channels));
+
+                int slot = static_cast<int>(block - segment.firstBlock);
+                if (slot >= segment.energy.size()) segment.energy.resize(slot + 1);
+                segment.energy[slot] += energy;
+                from = blockEnd;
+            }
+
+            job->done += frames;
+            position += frames;
+            if (endFrame >= 0 && position >= endFrame) {
+                segment.complete = true;
+                return;
+            }
+        }
+    }
+
+    QSharedPointer<Job> job;
+    int index;
+};
+
+// ----------------------------------------------------------------------------
+// PlanTask - Split the File Into Segments
+// ----------------------------------------------------------------------------
+// Opening a file can block (network shares, sleeping disks), so even the
+// duration probe happens in the pool rather than in analyze().
+// ----------------------------------------------------------------------------
+class LoudnessAnalyzer::PlanTask : public Task {
+public:
+    explicit PlanTask(QSharedPointer<Job> job) : Task(job), job(job) {}
+
+private:
+    void work() override {
+        MediaDecoder probe;
+        double duration = 0.0;
+        if (probe.open(job->path, SampleRate, 2)) duration = probe.duration();
+        probe.close();
+
+        // Unknown duration (or a short file): one segment, start to end.
+        int count = segmentCount(*job, duration, MinSegmentSeconds);
+
+        qint64 totalBlocks = static_cast<qint64>(std::ceil(duration * 10.0));
+        qint64 perSegment = (totalBlocks + count - 1) / count;
+
+        job->segments.resize(count);
+        for (int i = 0; i < count; i++) {
+            job->segments[i].firstBlock = i * perSegment;
+            job->segments[i].endBlock = (i == count - 1) ? -1 : (i + 1) * perSegment;
+        }
+        job->total = totalBlocks * BlockFrames;
+
+        // The segments list is complete before any task can touch it.
+        for (int i = 0; i < count; i++) {
+            spawn(job, new SegmentTask(job, i));
+        }
+    }
+
+    QSharedPointer<Job> job;
+};
+
+// ----------------------------------------------------------------------------
+// Cache Format
+// ----------------------------------------------------------------------------
+static QByteArray serialize(const LoudnessInfo &info) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);   // Same bytes from Qt 5 and Qt 6 builds.
+    out << CacheMagic << CacheVersion << info.integrated << info.maxShortTerm << info.shortTerm;
+    return data;
+}
+
+static bool deserialize(const QByteArray &data, LoudnessInfo &info) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != CacheMagic || version != CacheVersion) return false;
+    in >> info.integrated >> info.maxShortTerm >> info.shortTerm;
+    info.valid = in.status() == QDataStream::Ok;
+    return info.valid;
+}
+
+// ----------------------------------------------------------------------------
+// computeLoudness() - Gating and Short-Term Values From the Block Energies
+// ----------------------------------------------------------------------------
+static LoudnessInfo computeLoudness(const QVector<double> &energy) {
+    LoudnessInfo info;
+    info.valid = true;
+    const int blocks = energy.size();
+
+    // Integrated: 400 ms gating blocks every 100 ms, gated twice.
+    QVector<double> gated;
+    for (int j = 0; j + GateBlocks <= blocks; j++) {
+        double sum = 0.0;
+        for (int k = 0; k < GateBlocks; k++) sum += energy[j + k];
+        double z = sum / (GateBlocks * BlockFrames);
+        if (toLufs(z) > AbsoluteGate) gated.append(z);
+    }
+    if (!gated.isEmpty()) {
+        double mean = 0.0;
+        for (double z : gated) mean += z;
+        double threshold = toLufs(mean / gated.size()) + RelativeGate;
+
+        double sum = 0.0;
+        int count = 0;
+        for (double z : gated) {
+            if (toLufs(z) > threshold) {
+                sum += z;
+                count++;
+            }
+        }
+        if (count > 0) info.integrated = toLufs(sum / count);
+    }
+
+    // Short-term: a running 3 s sum, one value per 100 ms.
+    int window = qMin(ShortTermBlocks, blocks);
+    if (window > 0) {
+        double sum = 0.0;
+        for (int k = 0; k < window; k++) sum += energy[k];
+        info.shortTerm.reserve(blocks - window + 1);
+        for (int i = 0; ; i++) {
+            double lufs = toLufs(sum / (window * BlockFrames));
+            info.shortTerm.append(static_cast<float>(lufs));
+            info.maxShortTerm = qMax(info.maxShortTerm, lufs);
+            if (i + window >= blocks) break;
+            sum += energy[i + window] - energy[i];
+            if (sum < 0.0) sum = 0.0;        // Rounding after long silences.
+        }
+    }
+    return info;
+}
+
+// ----------------------------------------------------------------------------
+// Constructor - One Thread per Core
+// ----------------------------------------------------------------------------
+LoudnessAnalyzer::LoudnessAnalyzer(QObject *parent)
+    : BackgroundAnalysis(QThread::idealThreadCount(), parent) {}
+
+bool LoudnessAnalyzer::isAvailable() {
+    return MediaDecoder::isAvailable();
+}
+
+// ----------------------------------------------------------------------------
+// analyze() / forget() / result()
+// ----------------------------------------------------------------------------
+void LoudnessAnalyzer::analyze(int slot, const QString &path) {
+    cancel(slot);
+
+    if (!isAvailable()) {
+        emit failed(slot, "Built without libav");
+        return;
+    }
+
+    QByteArray cached;
+    LoudnessInfo info;
+    if (AnalysisCache::load(path, "loudness", cached) && deserialize(cached, info)) {
+        results[slot] = info;
+        emit finished(slot);
+        return;
+    }
+
+    QSharedPointer<Job> job(new Job);
+    job->path = path;
+    start(slot, job, new PlanTask(job));
+}
+
+void LoudnessAnalyzer::forget(int slot) {
+    results.remove(slot);
+}
+
+LoudnessInfo LoudnessAnalyzer::result(int slot) const {
+    return results.value(slot);
+}
+
+// ----------------------------------------------------------------------------
+// finishJob() - Combine the Segments (GUI Thread)
+// ----------------------------------------------------------------------------
+// A segment that broke off early is only acceptable at the end of what was
+// measured: a broken tail just makes the scan a little shorter. Anywhere
+// else it leaves a run of empty blocks - silence as far as the gating can
+// tell - which would skew both the integrated value and the short-term
+// curve, so the whole scan fails instead.
+// ----------------------------------------------------------------------------
+void LoudnessAnalyzer::finishJob(QSharedPointer<BackgroundAnalysis::Job> done) {
+    QSharedPointer<Job> job = done.staticCast<Job>();
+
+    int lastMeasured = -1;
+    for (int i = 0; i < job->segments.size(); i++) {
+        if (!job->segments[i].energy.isEmpty()) lastMeasured = i;
+    }
+    for (int i = 0; i < lastMeasured; i++) {
+        const Job::Segment &segment = job->segments[i];
+        if (segment.complete) continue;
+        QString reason = segment.error.isEmpty() ? QString("decoding stopped early") : segment.error;
+        emit failed(job->slot, QString("Could not decode %1 s - %2 s: %3")
+                                   .arg(segment.firstBlock / 10).arg(segment.endBlock / 10).arg(reason));
+        return;
+    }
+
+    QVector<double> energy;
+    for (const Job::Segment &segment : job->segments) {
+        qint64 end = segment.firstBlock + segment.energy.size();
+        if (end > energy.size()) energy.resize(static_cast<int>(end));
+        for (int i = 0; i < segment.energy.size(); i++) {
+            energy[static_cast<int>(segment.firstBlock) + i] += segment.energy[i];
+        }
+    }
+
+    if (energy.isEmpty()) {
+        emit failed(job->slot, job->errorOr("No audio decoded"));
+        return;
+    }
+
+    LoudnessInfo info = computeLoudness(energy);
+    results[job->slot] = info;
+    AnalysisCache::save(job->path, "loudness", serialize(info));
+    emit finished(job->slot);
+}
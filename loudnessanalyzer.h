@@ -0,0 +1,75 @@
+// ============================================================================
+// loudnessanalyzer.h - Background EBU R128 Loudness Scan
+// ============================================================================
+// The movie and the VOD are usually mastered at very different levels, so
+// the volume sliders need constant fiddling. The analyzer measures each
+// file's loudness as defined by EBU R128 / ITU-R BS.1770-4:
+//
+//   Integrated loudness - one number for the whole file, in LUFS, with the
+//                         standard absolute (-70 LUFS) and relative (-10 LU)
+//                         gates, so silence and quiet passages don't drag
+//                         the value down.
+//   Short-term loudness - loudness of a sliding 3-second window, one value
+//                         every 100 ms.
+//
+// Knowing both files' integrated loudness, MainWindow can match the two
+// players with a gain filter (see MpvWidget::setLevelGain).
+//
+// How it works: the file is split into segments that are decoded in
+// parallel on a thread pool (one MediaDecoder each; see backgroundanalysis.h
+// for the jobs and tasks). Every segment runs the K-weighting filter
+// (SimdKernels::biquad) and sums the energy of each 100 ms block
+// (SimdKernels::sumOfSquares). The blocks are independent, so the
+// segments' results are simply concatenated before the gating. Each
+// segment starts decoding half a second early to let the filters settle.
+//
+// Results are cached per file (see analysiscache.h), so opening a file
+// again shows its loudness instantly.
+// ============================================================================
+
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include "backgroundanalysis.h"
+
+#include <QHash>
+#include <QVector>
+
+// ----------------------------------------------------------------------------
+// LoudnessInfo - The Result of One Scan
+// ----------------------------------------------------------------------------
+struct LoudnessInfo {
+    bool valid = false;
+    double integrated = -70.0;   // LUFS
+    double maxShortTerm = -70.0; // LUFS, loudest 3 s window
+    QVector<float> shortTerm;    // LUFS; entry i = the 3 s starting at i * 100 ms
+};
+
+class LoudnessAnalyzer : public BackgroundAnalysis {
+    Q_OBJECT
+
+public:
+    explicit LoudnessAnalyzer(QObject *parent = nullptr);
+
+    static bool isAvailable();               // False when built without libav.
+
+    // Scan `path` for the player in `slot` (0 = player 1...). A scan already
+    // running for that slot is cancelled. If the file is in the cache,
+    // finished() is emitted before this returns. cancel() also forgets the
+    // slot's result.
+    void analyze(int slot, const QString &path);
+
+    LoudnessInfo result(int slot) const;     // Invalid until finished().
+
+private:
+    struct Job;                              // One scan - see the .cpp file.
+    class PlanTask;
+    class SegmentTask;
+
+    void finishJob(QSharedPointer<BackgroundAnalysis::Job> done) override;
+    void forget(int slot) override;
+
+    QHash<int, LoudnessInfo> results;        // Finished scans, by slot.
+};
+
+#endif // LOUDNESSANALYZER_H
@@ -7,10 +7,15 @@
 // ============================================================================
 
 #include "mainwindow.h"      // Our custom MainWindow class (the app's main UI)
+#include "playerbackend.h"   // Which player implementation the players get.
+#include "playerhost.h"      // The helper process side of --out-of-process.
+#include "voprobe.h"         // Fastest video output, measured on first start.
 
 #include <QApplication>      // Qt's application class - manages app-wide resources
 // and settings. Required for any Qt GUI application.
 
+#include <QCommandLineParser> // Parses options like --input-ipc-server=<path>.
+
 #include <locale.h>          // C standard library for locale (language/region) settings.
 // We need this to fix a compatibility issue with MPV.
 
@@ -60,11 +65,67 @@ int main(int argc, char *argv[])
     // settings (like date/time, currency) unchanged.
     setlocale(LC_NUMERIC, "C");
 
+    // Parse our own command-line options. QApplication has already removed
+    // the Qt ones (-style, -platform, ...) from the argument list.
+    //   --input-ipc-server=<name>  Enable the JSON control socket (same
+    //                              option name and protocol as mpv's).
+    //   --backend=fake             Run the players on the scripted fake
+    //                              backend (no libmpv playback) - for
+    //                              benchmarks and trying the UI.
+    //   --out-of-process           Run each player in a helper process (this
+    //                              executable again), restarted at the same
+    //                              position if it crashes or hangs.
+    //   --instrument               Count every player call and its latency;
+    //                              the tables are printed on exit.
+    //   --probe-vo                 Measure the video outputs again instead
+    //                              of using the stored choice.
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Watch two videos side by side in sync.");
+    parser.addHelpOption();
+    QCommandLineOption ipcOption("input-ipc-server",
+                                 "Listen for JSON IPC commands on <name> (socket path or pipe name).",
+                                 "name");
+    parser.addOption(ipcOption);
+    QCommandLineOption backendOption("backend", "Player backend: mpv (default) or fake.", "kind", "mpv");
+    parser.addOption(backendOption);
+    QCommandLineOption outOfProcessOption("out-of-process",
+                                          "Run each player in its own process, restarted if it crashes.");
+    parser.addOption(outOfProcessOption);
+    QCommandLineOption instrumentOption("instrument", "Record the count and latency of every player call.");
+    parser.addOption(instrumentOption);
+    // Internal: how a RemoteBackend starts its helper.
+    QCommandLineOption hostOption("player-host", "Serve one player over the channel <key>.", "key");
+    hostOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOption(hostOption);
+    QCommandLineOption probeOption("probe-vo", "Measure the available video outputs again.");
+    parser.addOption(probeOption);
+    parser.process(a);
+
+    // A helper process: one player, no window of our own.
+    if (parser.isSet(hostOption)) {
+        return PlayerHost::run(parser.value(hostOption));
+    }
+
+    // Must be settled before the first player is created (in MainWindow).
+    if (parser.value(backendOption) == "fake") PlayerBackend::setDefaultKind(PlayerBackend::Fake);
+    PlayerBackend::setOutOfProcessEnabled(parser.isSet(outOfProcessOption));
+    PlayerBackend::setInstrumentationEnabled(parser.isSet(instrumentOption));
+
+    // Load the video output before the players are created - they read
+    // the choice in their constructor. Without one (the first start on this
+    // machine, or --probe-vo), MainWindow measures the outputs in the
+    // background and switches the players over afterwards.
+    VoProbe::load(parser.isSet(probeOption));
+
     // Create our main window instance.
     // This constructs the entire UI and sets up all the MPV players.
     // At this point, the window exists in memory but is not yet visible.
     MainWindow w;
 
+    if (parser.isSet(ipcOption)) {
+        w.startIpcServer(parser.value(ipcOption));
+    }
+
     // Make the window visible on screen.
     // Windows are hidden by default when created, so we must explicitly show them.
     w.show();
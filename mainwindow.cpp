@@ -1,10 +1,10 @@
 // ============================================================================
-// mainwindow.cpp - Implementation of MpvWidget and MainWindow Classes
+// mainwindow.cpp - Implementation of the MainWindow Class
 // ============================================================================
-// This file contains all the actual code (implementation) for the classes
-// declared in mainwindow.h. In C++, it's common to separate declarations
-// (header files) from implementations (.cpp files) for better organization
-// and faster compilation times.
+// This file contains all the actual code (implementation) for the class
+// declared in mainwindow.h; MpvWidget has its own pair of files. In C++,
+// it's common to separate declarations (header files) from implementations
+// (.cpp files) for better organization and faster compilation times.
 // ============================================================================
 
 // ----------------------------------------------------------------------------
@@ -14,8 +14,35 @@
 // This gives us access to class definitions and function declarations.
 // ----------------------------------------------------------------------------
 
-#include "mainwindow.h"          // Our own header - class declarations for MpvWidget
-// and MainWindow
+#include "mainwindow.h"          // Our own header - the MainWindow class declaration
+
+#include "playergroup.h"         // PlayerGroup - global controls for both players
+#include "watchpartysync.h"      // WatchPartySync - multi-instance sync over UDP
+#include "ipcserver.h"           // IpcServer - JSON control socket for external tools
+#include "bufferingbarrier.h"    // BufferingBarrier - hold both players while one buffers
+#include "driftcontroller.h"     // DriftController - players kept at their offsets
+#include "openurldialog.h"       // OpenUrlDialog - stream URL plus cache settings
+#include "loudnessanalyzer.h"    // LoudnessAnalyzer - background R128 scans
+#include "audiolatency.h"        // AudioLatency - equal residual A/V offset
+#include "audioducker.h"         // AudioDucker - movie ducked under the commentary
+#include "waveformpyramid.h"     // WaveformBuilder - background waveform pyramids
+#include "waveformview.h"        // WaveformView - waveform strip under each player
+#include "diffheatmap.h"         // DiffAnalyzer - whole-file difference of both players
+#include "diffheatmapview.h"     // DiffHeatmapView - the difference as a heatmap
+#include "scenedetector.h"       // SceneDetector - background scene-cut index
+#include "keyframeindex.h"       // KeyframeIndexer - keyframe positions, for planned seeks
+#include "subtitleindex.h"       // SubtitleIndexer - full-text subtitle search
+#include "pairmemory.h"          // PairMemory - offsets/tracks/volumes per file pair
+#include "sessionstore.h"        // SessionStore - last session, resumed on launch
+#include "framecapture.h"        // FrameCapture - same frame from both players as images
+#include "videoscopes.h"         // ScopeAnalyzer - histogram/waveform/vectorscope data
+#include "scopeview.h"           // ScopeView - draws one scope
+#include "compareview.h"         // CompareView - wipe/flicker/blend/difference of both players
+#include "compositeplayer.h"     // CompositePlayer - both files in one MPV instance
+#include "filterchains.h"        // FilterChains - one decode through several filter chains
+#include "clipexporter.h"        // ClipExporter - both players rendered to one video file
+#include "grouploop.h"           // GroupLoop - A-B loop over both players
+#include "voprobe.h"             // VoProbe - fastest video output on this machine
 
 #include "ui_mainwindow.h"       // Auto-generated by Qt's UI compiler (uic) from
 // mainwindow.ui. Contains the Ui::MainWindow class
@@ -29,677 +56,36 @@
 
 #include <QPushButton>           // A clickable button widget.
 
-#include <QFileInfo>             // Provides file information (name, path, size, etc.).
-// We use it to extract just the filename from a full path.
-
-#include <QApplication>          // Application-wide functionality. We use it here for
-// processEvents() to flush the event queue.
-
-#include <QDebug>                // Qt's debugging output. qDebug() is like cout but
-// integrates with Qt Creator's output panel.
-
-#include <locale.h>              // Needed for using standardized locale data
-
-// ============================================================================
-//
-//                          MpvWidget IMPLEMENTATION
-//
-// ============================================================================
-// MpvWidget wraps the MPV media player library, providing a clean C++/Qt
-// interface for video playback. Each instance manages one independent player.
-// ============================================================================
-
-// ----------------------------------------------------------------------------
-// Constructor: MpvWidget::MpvWidget
-// ----------------------------------------------------------------------------
-// Initializes a new MPV player instance and sets up the timer for UI updates.
-//
-// The syntax "MpvWidget(QWidget *parent) : QWidget(parent), mpv(nullptr), ..."
-// is called a "member initializer list". It's the preferred way to initialize
-// member variables in C++ because:
-//   1. It's more efficient (initializes directly, no assignment after construction)
-//   2. It's required for const members and references
-//   3. It ensures proper initialization order
-// ----------------------------------------------------------------------------
-MpvWidget::MpvWidget(QWidget *parent) : QWidget(parent), mpv(nullptr), statusLabel(nullptr), timeLabel(nullptr), subtitleCombo(nullptr), audioCombo(nullptr) {
-
-    // Set the widget's background color to black using CSS-like syntax.
-    // Qt's stylesheets work similarly to CSS in web development.
-    // This widget is actually hidden in our app, but we set it anyway.
-    setStyleSheet("background-color: black;");
-
-    // ------------------------------------------------------------------------
-    // Create the MPV Player Instance
-    // ------------------------------------------------------------------------
-    // mpv_create() allocates and returns a new MPV player handle.
-    // This handle is used for ALL subsequent MPV API calls.
-    // Returns nullptr if allocation fails (rare, usually means out of memory).
-    // ------------------------------------------------------------------------
-    mpv = mpv_create();
-    if (!mpv) {
-        // qDebug() outputs to the debug console (visible in Qt Creator).
-        // The "<<" operator works like cout - you can chain multiple values.
-        qDebug() << "Failed to create MPV instance!";
-        return;  // Early return - don't try to configure a null player
-    }
-
-    // ------------------------------------------------------------------------
-    // Configure MPV Options (BEFORE initialization)
-    // ------------------------------------------------------------------------
-    // IMPORTANT: mpv_set_option_* functions MUST be called BEFORE mpv_initialize().
-    // After initialization, you must use mpv_set_property_* instead.
-    //
-    // We intentionally do NOT set the "wid" (window ID) option. When wid is set,
-    // MPV embeds its video output into that window. By not setting it, MPV
-    // creates its own separate window for video playback. This allows users
-    // to freely position and resize the video windows independently.
-    // ------------------------------------------------------------------------
-
-    // "keep-open=yes" keeps the player window open after the video ends,
-    // showing the last frame. Without this, the window would close immediately.
-    mpv_set_option_string(mpv, "keep-open", "yes");
-
-    // Disable MPV's built-in keyboard shortcuts. We want our Qt UI to handle
-    // all user input, not MPV's default bindings (which could conflict).
-    mpv_set_option_string(mpv, "input-default-bindings", "no");
-
-    // Disable keyboard input to the video output window specifically.
-    // This prevents the video window from capturing keyboard events.
-    mpv_set_option_string(mpv, "input-vo-keyboard", "no");
-
-    // Disable terminal/console output from MPV.
-    // This prevents MPV from printing status messages to stdout/stderr,
-    // which could clutter logs or cause issues on some platforms.
-    mpv_set_option_string(mpv, "terminal", "no");
-
-    #if defined(Q_OS_LINUX)
-        // These settings are necessary for stability on Linux to prevent
-        // driver conflicts between the two players.
-
-        // mpv_set_option_string(mpv, "hwdec", "no");
-        // Keep this option commented unless issues come up.
-
-        mpv_set_option_string(mpv, "vo", "x11");
-    #endif
-
-    // ------------------------------------------------------------------------
-    // Initialize MPV
-    // ------------------------------------------------------------------------
-    // mpv_initialize() finalizes the player setup. After this call:
-    //   - Options can no longer be set (only properties)
-    //   - The player is ready to load and play files
-    // Returns 0 on success, negative error code on failure.
-    // ------------------------------------------------------------------------
-    mpv_initialize(mpv);
-
-    // ------------------------------------------------------------------------
-    // Setup the Polling Timer
-    // ------------------------------------------------------------------------
-    // We use a QTimer to periodically update the time display (current position
-    // and duration). This is a simple polling approach.
-    //
-    // Alternative: MPV supports an event-based approach using mpv_observe_property()
-    // which is more efficient but more complex to implement.
-    //
-    // IMPORTANT: We create the timer but do NOT start it yet!
-    // Starting it before a file is loaded would cause issues because we'd be
-    // polling for time-pos on an empty player, which can return errors or
-    // cause freezes during the sensitive initialization period.
-    // ------------------------------------------------------------------------
-    pollTimer = new QTimer(this);  // "this" makes MpvWidget the timer's parent.
-    // Qt's parent-child system automatically
-    // deletes children when parent is deleted.
-
-    pollTimer->setInterval(500);    // Fire every 500 milliseconds (twice per second).
-    // This gives smooth time updates without
-    // excessive CPU usage.
-
-    // Connect the timer's timeout signal to our onTimerTick slot.
-    // This is Qt's signal-slot mechanism:
-    //   - When pollTimer emits timeout(), Qt automatically calls onTimerTick()
-    //   - The & syntax takes the address of the member functions
-    //   - Qt handles all the plumbing automatically
-    connect(pollTimer, &QTimer::timeout, this, &MpvWidget::onTimerTick);
-}
-
-// ----------------------------------------------------------------------------
-// Destructor: MpvWidget::~MpvWidget
-// ----------------------------------------------------------------------------
-// Called when the MpvWidget is destroyed (deleted or goes out of scope).
-// We delegate to shutdown() to ensure clean MPV termination.
-// ----------------------------------------------------------------------------
-MpvWidget::~MpvWidget() {
-    shutdown();
-}
-
-// ----------------------------------------------------------------------------
-// shutdown() - Clean MPV Termination
-// ----------------------------------------------------------------------------
-// This function safely shuts down the MPV player. It's carefully designed to
-// avoid deadlocks and crashes that can occur if MPV isn't shut down properly.
-//
-// This was one of the trickiest parts of the application to get right!
-// Different approaches were tried, and this sequence was found to work
-// reliably across platforms (especially important on macOS).
-// ----------------------------------------------------------------------------
-void MpvWidget::shutdown() {
-    // Step 1: Stop the polling timer FIRST.
-    // If the timer fires while we're shutting down MPV, it would try to
-    // query properties from a partially-destroyed player = crash!
-    if (pollTimer) {
-        pollTimer->stop();           // Stop firing events
-        pollTimer->deleteLater();    // Schedule for deletion (safer than delete)
-        // deleteLater() waits for the event loop
-        // to be clear before actually deleting
-        pollTimer = nullptr;         // Mark as gone to prevent double-delete
-    }
-
-    if (mpv) {
-        // Step 2: Pause playback immediately.
-        // This stops any ongoing decoding/rendering, making subsequent
-        // operations safer and faster.
-        int flag = 1;  // 1 = true = paused
-        mpv_set_property(mpv, "pause", MPV_FORMAT_FLAG, &flag);
-
-        // Step 3: Stop playback and unload the current file.
-        // The "stop" command clears the playlist and releases resources
-        // associated with the current video (decoders, video output, etc.).
-        const char *stopCmd[] = {"stop", NULL};  // MPV commands are NULL-terminated
-        // arrays of strings
-        mpv_command(mpv, stopCmd);
-
-        // Step 4: Send the quit command ASYNCHRONOUSLY.
-        // The async version returns immediately without waiting for MPV to
-        // fully shut down. This is crucial to avoid deadlocks!
-        //
-        // The first argument (0) is a "reply userdata" that would be included
-        // in the reply event - we don't use it here.
-        const char *quitCmd[] = {"quit", NULL};
-        mpv_command_async(mpv, 0, quitCmd);
-
-        // Step 5: Release our handle to MPV.
-        // IMPORTANT: We use mpv_destroy(), NOT mpv_terminate_destroy()!
-        //
-        // mpv_terminate_destroy() waits for MPV to fully shut down, which can
-        // cause deadlocks on some platforms (especially macOS) when the video
-        // output is still attached to a window.
-        //
-        // mpv_destroy() just releases our handle immediately. MPV continues
-        // cleaning up in the background on its own threads.
-        mpv_destroy(mpv);
-        mpv = nullptr;  // Mark as gone to prevent use-after-free bugs
-    }
-}
-
-// ----------------------------------------------------------------------------
-// loadVideo() - Load and Play a Video File
-// ----------------------------------------------------------------------------
-// Loads a video file and starts playback. This function also updates the UI
-// and triggers refresh of audio/subtitle track lists.
-//
-// Parameter:
-//   path - Full path to the video file (QString is Qt's string class)
-// ----------------------------------------------------------------------------
-void MpvWidget::loadVideo(QString path) {
-    // Guard clause: do nothing if MPV isn't initialized
-    if (!mpv) return;
-
-    // Enforce "C" locale right here.
-    // This protects us even if QProcessEvents or a Dialog reset it
-    // milliseconds earlier. This is crucial for MPV parsing.
-    setlocale(LC_NUMERIC, "C");
-
-    // Step 1: STOP the polling timer during loading.
-    // The load operation can take time (file probing, decoder init, etc.).
-    // Polling during this sensitive period can cause hangs or incorrect data.
-    pollTimer->stop();
-
-    // Step 2: Convert QString to UTF-8 bytes for MPV's C API.
-    // MPV's API uses C strings (char*), but Qt uses QString.
-    // toUtf8() converts to a QByteArray containing UTF-8 encoded bytes.
-    // .data() returns a pointer to the raw bytes (char*).
-    QByteArray pathBytes = path.toUtf8();
-
-    // Step 3: Execute the "loadfile" command.
-    // MPV commands are arrays of C strings, terminated with NULL.
-    // "loadfile" takes the path as its argument.
-    const char *cmd[] = {"loadfile", pathBytes.data(), NULL};
-    mpv_command(mpv, cmd);  // This blocks until the file is probed and ready
-    // (or fails). For large files over network, this
-    // could take a moment.
-
-    // Step 4: Update the filename display in the UI.
-    // QFileInfo extracts file information from a path.
-    // fileName() returns just the filename without the directory path.
-    if (statusLabel) {
-        QFileInfo fileInfo(path);
-        statusLabel->setText(fileInfo.fileName());
-    }
-
-    // Step 5: RESTART the polling timer now that loading is complete.
-    // It's now safe to query time-pos and duration.
-    pollTimer->start();
-
-    // Step 6: Refresh the audio and subtitle track dropdowns.
-    // We use QTimer::singleShot to delay this by 500ms because:
-    //   - MPV needs time to fully parse the file and enumerate tracks
-    //   - If we query immediately, we might get incomplete results
-    //
-    // singleShot() fires once after the specified delay, then stops.
-    // The syntax connects directly to our member functions.
-    QTimer::singleShot(500, this, &MpvWidget::refreshSubtitleTracks);
-    QTimer::singleShot(500, this, &MpvWidget::refreshAudioTracks);
-}
-
-// ----------------------------------------------------------------------------
-// closeVideo() - Stop Playback and Reset UI
-// ----------------------------------------------------------------------------
-// Unloads the current video and resets all UI elements to their default state.
-// This doesn't destroy the MPV instance - it's ready to load another file.
-// ----------------------------------------------------------------------------
-void MpvWidget::closeVideo() {
-    if (!mpv) return;
-
-    // Stop the timer - no need to poll when nothing is playing
-    pollTimer->stop();
-
-    // Execute the "stop" command to unload the file and clear the playlist
-    const char *cmd[] = {"stop", NULL};
-    mpv_command(mpv, cmd);
-
-    // Reset the filename label
-    if (statusLabel) {
-        statusLabel->setText("No file loaded");
-    }
-
-    // Reset the time display
-    if (timeLabel) {
-        timeLabel->setText("--:--:-- / --:--:--");
-    }
-
-    // Reset the subtitle dropdown to just "Off"
-    if (subtitleCombo) {
-        // blockSignals(true) temporarily prevents the combo box from emitting
-        // signals when we modify it. Without this, our modifications would
-        // trigger currentIndexChanged, which would call setSubtitleTrack(),
-        // which would be wasteful and could cause issues.
-        subtitleCombo->blockSignals(true);
-        subtitleCombo->clear();            // Remove all items
-        subtitleCombo->addItem("Off", 0);  // Add back just the "Off" option
-        subtitleCombo->blockSignals(false);// Re-enable signals
-    }
-
-    // Reset the audio dropdown (empty since no file is loaded)
-    if (audioCombo) {
-        audioCombo->blockSignals(true);
-        audioCombo->clear();
-        audioCombo->blockSignals(false);
-    }
-}
-
-// ----------------------------------------------------------------------------
-// onTimerTick() - Timer Callback for Time Display Updates
-// ----------------------------------------------------------------------------
-// This slot is called every 500ms by pollTimer. It queries MPV for the
-// current playback position and duration, then updates the time label.
-// ----------------------------------------------------------------------------
-void MpvWidget::onTimerTick() {
-    if (!mpv) return;
-
-    double timePos = 0;   // Current playback position in seconds
-    double duration = 0;  // Total video duration in seconds
-
-    // Query MPV properties using mpv_get_property().
-    // Parameters:
-    //   - mpv: the player handle
-    //   - property name: "time-pos" or "duration"
-    //   - format: MPV_FORMAT_DOUBLE for floating-point seconds
-    //   - pointer to variable to receive the value
-    //
-    // These properties return the current playback time and total duration.
-    // If no file is loaded, they return 0 or an error (which we ignore).
-    mpv_get_property(mpv, "time-pos", MPV_FORMAT_DOUBLE, &timePos);
-    mpv_get_property(mpv, "duration", MPV_FORMAT_DOUBLE, &duration);
-
-    // Update the time label with formatted time strings
-    if (timeLabel) {
-        // QString's arg() method replaces %1, %2, etc. with the provided values.
-        // It's Qt's type-safe alternative to printf-style formatting.
-        QString text = QString("%1 / %2")
-                           .arg(formatTime(timePos))     // Current position
-                           .arg(formatTime(duration));   // Total duration
-        timeLabel->setText(text);
-    }
-}
-
-// ----------------------------------------------------------------------------
-// formatTime() - Convert Seconds to HH:MM:SS String
-// ----------------------------------------------------------------------------
-// Utility function to convert a time in seconds (e.g., 3661.5) to a
-// human-readable string (e.g., "01:01:01").
-//
-// Parameter:
-//   totalSeconds - Time in seconds (can be fractional)
-//
-// Returns:
-//   QString in "HH:mm:ss" format
-// ----------------------------------------------------------------------------
-QString MpvWidget::formatTime(double totalSeconds) {
-    // Handle negative values (shouldn't happen, but defensive programming)
-    if (totalSeconds < 0) totalSeconds = 0;
-
-    // Start with a QTime of 00:00:00
-    QTime t(0, 0, 0);
-
-    // Add the seconds (truncated to integer).
-    // static_cast<int> safely converts double to int (C++ style cast).
-    t = t.addSecs(static_cast<int>(totalSeconds));
-
-    // Format as string using Qt's date/time formatting.
-    // "HH" = hours with leading zero, "mm" = minutes, "ss" = seconds
-    return t.toString("HH:mm:ss");
-}
-
-// ----------------------------------------------------------------------------
-// setVolume() - Set Playback Volume
-// ----------------------------------------------------------------------------
-// Sets the audio volume level.
-//
-// Parameter:
-//   value - Volume level from 0 (mute) to 100 (full)
-// ----------------------------------------------------------------------------
-void MpvWidget::setVolume(int value) {
-    if (!mpv) return;
-
-    // MPV's volume property expects a double, so we convert.
-    // Note: MPV supports values > 100 for amplification, but we limit to 0-100.
-    double v = static_cast<double>(value);
-
-    // Set the "volume" property. Unlike options, properties can be changed
-    // at any time after initialization.
-    mpv_set_property(mpv, "volume", MPV_FORMAT_DOUBLE, &v);
-}
-
-// ----------------------------------------------------------------------------
-// togglePause() - Toggle Play/Pause State
-// ----------------------------------------------------------------------------
-// Toggles between playing and paused states. If playing, pauses. If paused,
-// resumes playback.
-// ----------------------------------------------------------------------------
-void MpvWidget::togglePause() {
-    if (!mpv) return;
-
-    // The "cycle" command toggles a property between its possible values.
-    // For "pause" (a boolean), it toggles between true and false.
-    // This is simpler than reading the current state and setting the opposite.
-    const char *cmd[] = {"cycle", "pause", NULL};
-    mpv_command(mpv, cmd);
-}
-
-// ----------------------------------------------------------------------------
-// seek() - Seek Forward or Backward
-// ----------------------------------------------------------------------------
-// Seeks the playback position by the specified number of seconds.
-//
-// Parameter:
-//   seconds - Number of seconds to seek (positive = forward, negative = back)
-// ----------------------------------------------------------------------------
-void MpvWidget::seek(double seconds) {
-    if (!mpv) return;
-
-    // Use QString::number to guarantee a DOT decimal separator regardless of locale.
-    // std::to_string() uses the global locale, which is risky if it ever drifts.
-    std::string timeStr = QString::number(seconds, 'f', 3).toStdString();
-
-    const char *cmd[] = {"seek", timeStr.c_str(), "relative+exact", NULL};
-    mpv_command(mpv, cmd);
-
-    // Update the time display immediately for better UI responsiveness.
-    // Without this, there would be up to a 500ms delay before the display updates.
-    onTimerTick();
-}
-
-// ----------------------------------------------------------------------------
-// refreshSubtitleTracks() - Populate Subtitle Track Dropdown
-// ----------------------------------------------------------------------------
-// Queries MPV for all available subtitle tracks and populates the subtitle
-// dropdown with them. This includes embedded subtitles and any external
-// subtitle files that have been loaded.
-// ----------------------------------------------------------------------------
-void MpvWidget::refreshSubtitleTracks() {
-    if (!mpv || !subtitleCombo) return;
-
-    // Block signals while modifying the combo box (see closeVideo for explanation)
-    subtitleCombo->blockSignals(true);
-    subtitleCombo->clear();
-
-    // Add "Off" option first. The second parameter (0) is the "user data" -
-    // we store the subtitle ID (sid) there. sid=0 means no subtitles.
-    subtitleCombo->addItem("Off", 0);
-
-    // ------------------------------------------------------------------------
-    // Query MPV's Track List
-    // ------------------------------------------------------------------------
-    // "track-list" is a complex property that returns information about all
-    // tracks (video, audio, subtitle) in the current file. It's returned as
-    // an mpv_node, which is MPV's way of representing complex data structures
-    // (similar to JSON).
-    // ------------------------------------------------------------------------
-    mpv_node trackList;
-    if (mpv_get_property(mpv, "track-list", MPV_FORMAT_NODE, &trackList) >= 0) {
-        // The track list is an array of tracks
-        if (trackList.format == MPV_FORMAT_NODE_ARRAY) {
-            // Iterate through each track
-            for (int i = 0; i < trackList.u.list->num; i++) {
-                mpv_node *track = &trackList.u.list->values[i];
-
-                // Each track is a map (dictionary) of properties
-                if (track->format != MPV_FORMAT_NODE_MAP) continue;
-
-                // Variables to store track properties as we parse them
-                QString type;          // "video", "audio", or "sub"
-                int64_t id = 0;        // Track ID (used to select it)
-                QString title;         // Track title (if any)
-                QString lang;          // Language code (e.g., "eng", "jpn")
-                bool isExternal = false; // Whether it's from an external file
-
-                // Parse the track's properties by iterating through the map
-                for (int j = 0; j < track->u.list->num; j++) {
-                    const char *key = track->u.list->keys[j];
-                    mpv_node *val = &track->u.list->values[j];
-
-                    // strcmp compares C strings - returns 0 if equal
-                    if (strcmp(key, "type") == 0 && val->format == MPV_FORMAT_STRING) {
-                        type = QString::fromUtf8(val->u.string);
-                    } else if (strcmp(key, "id") == 0 && val->format == MPV_FORMAT_INT64) {
-                        id = val->u.int64;
-                    } else if (strcmp(key, "title") == 0 && val->format == MPV_FORMAT_STRING) {
-                        title = QString::fromUtf8(val->u.string);
-                    } else if (strcmp(key, "lang") == 0 && val->format == MPV_FORMAT_STRING) {
-                        lang = QString::fromUtf8(val->u.string);
-                    } else if (strcmp(key, "external") == 0 && val->format == MPV_FORMAT_FLAG) {
-                        isExternal = val->u.flag;
-                    }
-                }
-
-                // Only process subtitle tracks (skip video and audio)
-                if (type == "sub") {
-                    // Build a descriptive label for the dropdown
-                    QString label = QString("#%1").arg(id);
-                    if (!lang.isEmpty()) label += " [" + lang + "]";
-                    if (!title.isEmpty()) label += " " + title;
-                    if (isExternal) label += " (external)";
-
-                    // Add to dropdown with track ID as user data
-                    subtitleCombo->addItem(label, static_cast<int>(id));
-                }
-            }
-        }
-        // IMPORTANT: Free the memory allocated by MPV for the node data
-        mpv_free_node_contents(&trackList);
-    }
-
-    // Select the currently active subtitle track in the dropdown
-    int64_t currentSid = 0;
-    mpv_get_property(mpv, "sid", MPV_FORMAT_INT64, &currentSid);
-    for (int i = 0; i < subtitleCombo->count(); i++) {
-        if (subtitleCombo->itemData(i).toInt() == currentSid) {
-            subtitleCombo->setCurrentIndex(i);
-            break;
-        }
-    }
-
-    subtitleCombo->blockSignals(false);  // Re-enable signals
-}
-
-// ----------------------------------------------------------------------------
-// setSubtitleTrack() - Switch Subtitle Track
-// ----------------------------------------------------------------------------
-// Changes the active subtitle track based on dropdown selection.
-//
-// Parameter:
-//   index - Index of the selected item in the subtitle dropdown
-// ----------------------------------------------------------------------------
-void MpvWidget::setSubtitleTrack(int index) {
-    if (!mpv || !subtitleCombo) return;
-
-    // Get the subtitle ID (sid) stored as user data for this item
-    int sid = subtitleCombo->itemData(index).toInt();
-    int64_t sidValue = sid;
-
-    // Set MPV's "sid" (subtitle ID) property to switch tracks.
-    // sid=0 means no subtitles (Off).
-    mpv_set_property(mpv, "sid", MPV_FORMAT_INT64, &sidValue);
-}
+#include <QLineEdit>             // Single-line text input (watch party host address).
 
-// ----------------------------------------------------------------------------
-// loadExternalSubtitles() - Load Subtitle File from Disk
-// ----------------------------------------------------------------------------
-// Loads an external subtitle file (e.g., .srt, .ass) and adds it to the
-// available subtitle tracks.
-//
-// Parameter:
-//   path - Full path to the subtitle file
-// ----------------------------------------------------------------------------
-void MpvWidget::loadExternalSubtitles(QString path) {
-    if (!mpv) return;
+#include <QSpinBox>              // Integer input with up/down arrows (watch party port).
 
-    setlocale(LC_NUMERIC, "C");
+#include <QDoubleSpinBox>        // Decimal input (export in/out points, in seconds).
 
-    // Convert QString to UTF-8 for MPV's C API
-    QByteArray pathBytes = path.toUtf8();
+#include <QCheckBox>             // On/off option (automatic level matching).
 
-    // "sub-add" command adds an external subtitle file.
-    // "auto" means MPV should auto-select it if it's the first subtitle.
-    const char *cmd[] = {"sub-add", pathBytes.data(), "auto", NULL};
-    mpv_command(mpv, cmd);
+#include <QListWidget>           // Simple list of text items (subtitle search results).
 
-    // Refresh the track list to show the newly added subtitle
-    refreshSubtitleTracks();
+#include <QHostInfo>             // Turns a host name like "alice-pc" into an IP address.
 
-    // Select the newly added track (it should be the last one in the list)
-    if (subtitleCombo && subtitleCombo->count() > 0) {
-        subtitleCombo->setCurrentIndex(subtitleCombo->count() - 1);
-    }
-}
+#include <QFileInfo>             // Provides file information (name, path, size, etc.).
+// We use it to extract just the filename from a full path.
 
-// ----------------------------------------------------------------------------
-// refreshAudioTracks() - Populate Audio Track Dropdown
-// ----------------------------------------------------------------------------
-// Similar to refreshSubtitleTracks(), but for audio tracks.
-// Queries MPV for all available audio tracks and populates the dropdown.
-// ----------------------------------------------------------------------------
-void MpvWidget::refreshAudioTracks() {
-    if (!mpv || !audioCombo) return;
-
-    audioCombo->blockSignals(true);
-    audioCombo->clear();
-
-    // Query the track list (same as for subtitles)
-    mpv_node trackList;
-    if (mpv_get_property(mpv, "track-list", MPV_FORMAT_NODE, &trackList) >= 0) {
-        if (trackList.format == MPV_FORMAT_NODE_ARRAY) {
-            for (int i = 0; i < trackList.u.list->num; i++) {
-                mpv_node *track = &trackList.u.list->values[i];
-                if (track->format != MPV_FORMAT_NODE_MAP) continue;
-
-                QString type;
-                int64_t id = 0;
-                QString title;
-                QString lang;
-                int64_t channels = 0;  // Number of audio channels
-
-                // Parse track properties
-                for (int j = 0; j < track->u.list->num; j++) {
-                    const char *key = track->u.list->keys[j];
-                    mpv_node *val = &track->u.list->values[j];
-
-                    if (strcmp(key, "type") == 0 && val->format == MPV_FORMAT_STRING) {
-                        type = QString::fromUtf8(val->u.string);
-                    } else if (strcmp(key, "id") == 0 && val->format == MPV_FORMAT_INT64) {
-                        id = val->u.int64;
-                    } else if (strcmp(key, "title") == 0 && val->format == MPV_FORMAT_STRING) {
-                        title = QString::fromUtf8(val->u.string);
-                    } else if (strcmp(key, "lang") == 0 && val->format == MPV_FORMAT_STRING) {
-                        lang = QString::fromUtf8(val->u.string);
-                    } else if (strcmp(key, "demux-channel-count") == 0 && val->format == MPV_FORMAT_INT64) {
-                        channels = val->u.int64;  // Audio channel count
-                    }
-                }
+#include <QDir>                  // Native separators for the capture folder.
 
-                // Only process audio tracks
-                if (type == "audio") {
-                    // Build descriptive label
-                    QString label = QString("#%1").arg(id);
-                    if (!lang.isEmpty()) label += " [" + lang + "]";
-                    if (!title.isEmpty()) label += " " + title;
-
-                    // Add human-readable channel configuration
-                    if (channels > 0) {
-                        if (channels == 1) label += " (Mono)";
-                        else if (channels == 2) label += " (Stereo)";
-                        else if (channels == 6) label += " (5.1)";    // 5.1 surround
-                        else if (channels == 8) label += " (7.1)";    // 7.1 surround
-                        else label += QString(" (%1ch)").arg(channels);
-                    }
-
-                    audioCombo->addItem(label, static_cast<int>(id));
-                }
-            }
-        }
-        mpv_free_node_contents(&trackList);
-    }
+#include <QDateTime>             // Time stamp in default export file names.
 
-    // Select current audio track
-    int64_t currentAid = 0;
-    mpv_get_property(mpv, "aid", MPV_FORMAT_INT64, &currentAid);
-    for (int i = 0; i < audioCombo->count(); i++) {
-        if (audioCombo->itemData(i).toInt() == currentAid) {
-            audioCombo->setCurrentIndex(i);
-            break;
-        }
-    }
+#include <QUrl>                  // Splits stream URLs, for a readable display name.
 
-    audioCombo->blockSignals(false);
-}
+#include <QApplication>          // Application-wide functionality. We use it here for
+// processEvents() to flush the event queue.
 
-// ----------------------------------------------------------------------------
-// setAudioTrack() - Switch Audio Track
-// ----------------------------------------------------------------------------
-// Changes the active audio track based on dropdown selection.
-//
-// Parameter:
-//   index - Index of the selected item in the audio dropdown
-// ----------------------------------------------------------------------------
-void MpvWidget::setAudioTrack(int index) {
-    if (!mpv || !audioCombo) return;
+#include <QDebug>                // Qt's debugging output. qDebug() is like cout but
+// integrates with Qt Creator's output panel.
 
-    int aid = audioCombo->itemData(index).toInt();
-    int64_t aidValue = aid;
+#include <algorithm>             // std::upper_bound / lower_bound on the scene index.
 
-    // Set MPV's "aid" (audio ID) property to switch tracks
-    mpv_set_property(mpv, "aid", MPV_FORMAT_INT64, &aidValue);
-}
+#include <locale.h>              // Needed for using standardized locale data
 
 // ============================================================================
 //
@@ -720,6 +106,23 @@ void MpvWidget::setAudioTrack(int index) {
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)                    // Call parent constructor
     , ui(new Ui::MainWindow)                 // Create the UI object
+    , group(nullptr)                         // Created once both players exist
+    , partySync(nullptr)
+    , ipcServer(nullptr)                     // Only started on request, see main.cpp
+    , barrier(nullptr)
+    , loudness(nullptr)
+    , ducker(nullptr)
+    , waveforms(nullptr)
+    , diffs(nullptr)
+    , scenes(nullptr)
+    , keyframes(nullptr)
+    , subtitles(nullptr)
+    , pairMemory(nullptr)
+    , session(nullptr)
+    , videoScopes(nullptr)
+    , compareView(nullptr)
+    , compositePlayer(nullptr)
+    , filterChains(nullptr)
 {
     // Setup the UI from the .ui file (required even if we override everything)
     ui->setupUi(this);
@@ -778,10 +181,14 @@ MainWindow::MainWindow(QWidget *parent)
     //
     // Lambda syntax: [capture](parameters) -> return_type { body }
     // [this] captures "this" pointer so we can access MainWindow members.
-    // The (MpvWidget*& playerRef, QString title) are parameters.
+    // The (MpvWidget*& playerRef, WaveformView*& waveRef, QString title) are
+    // parameters; the references are filled in with the new widgets.
     // -> QVBoxLayout* specifies the return type.
     // ------------------------------------------------------------------------
-    auto createPlayerColumn = [this](MpvWidget*& playerRef, QString title) -> QVBoxLayout* {
+    WaveformView *waveform1 = nullptr;
+    WaveformView *waveform2 = nullptr;
+
+    auto createPlayerColumn = [this](MpvWidget*& playerRef, WaveformView*& waveRef, QString title) -> QVBoxLayout* {
         // Create a vertical layout for this player's controls
         QVBoxLayout *col = new QVBoxLayout();
         col->setSpacing(4);  // Compact spacing
@@ -834,6 +241,18 @@ MainWindow::MainWindow(QWidget *parent)
         playerRef->statusLabel = fileLabel;
         playerRef->timeLabel = timeLabel;
 
+        // Stream cache status - only shown while a network stream is loaded
+        QLabel *cacheLabel = new QLabel();
+        cacheLabel->setStyleSheet("color: #0055aa; font-family: monospace;");
+        cacheLabel->setVisible(false);
+        col->addWidget(cacheLabel);
+        playerRef->cacheLabel = cacheLabel;
+
+        // Waveform strip - filled in by the WaveformBuilder once it's ready
+        waveRef = new WaveformView(playerRef);
+        waveRef->setFixedHeight(48);
+        col->addWidget(waveRef);
+
         // --------------------------------------------------------------------
         // Seek Controls Row: << 1m, < 10s, 10s >, 1m >>
         // --------------------------------------------------------------------
@@ -849,11 +268,12 @@ MainWindow::MainWindow(QWidget *parent)
         col->addLayout(seekRow);
 
         // --------------------------------------------------------------------
-        // Main Controls Row: Load, Close, Play/Pause, Volume
+        // Main Controls Row: Load, URL, Close, Play/Pause, Volume
         // --------------------------------------------------------------------
         QHBoxLayout *controls = new QHBoxLayout();
 
         QPushButton *btnLoad = new QPushButton("Load");    // Open file dialog
+        QPushButton *btnUrl = new QPushButton("URL...");   // Open network stream
         QPushButton *btnClose = new QPushButton("Close");  // Unload video
         QPushButton *btnPlay = new QPushButton("Play/Pause");
 
@@ -866,6 +286,7 @@ MainWindow::MainWindow(QWidget *parent)
         btnClose->setStyleSheet("color: #aa0000;");
 
         controls->addWidget(btnLoad);
+        controls->addWidget(btnUrl);
         controls->addWidget(btnClose);
         controls->addWidget(btnPlay);
         controls->addWidget(new QLabel("Vol:"));  // Label created inline
@@ -907,6 +328,7 @@ MainWindow::MainWindow(QWidget *parent)
         col->addLayout(audioRow);
 
         playerRef->audioCombo = audioCombo;
+        playerRef->volumeSlider = volSlider;
 
         // --------------------------------------------------------------------
         // Connect Signals to Slots (Wire Up the UI)
@@ -951,6 +373,17 @@ MainWindow::MainWindow(QWidget *parent)
             }
         });
 
+        // URL button - asks for a stream URL and its cache settings
+        connect(btnUrl, &QPushButton::clicked, this, [=]() {
+            OpenUrlDialog dialog(this);
+            bool accepted = dialog.exec() == QDialog::Accepted;
+            setlocale(LC_NUMERIC, "C");   // Same reason as after QFileDialog.
+
+            if (accepted) {
+                playerRef->loadStream(dialog.url(), dialog.readaheadSeconds(), dialog.prefillSeconds());
+            }
+        });
+
         // Close button
         connect(btnClose, &QPushButton::clicked, [=]() { playerRef->closeVideo(); });
 
@@ -990,7 +423,7 @@ MainWindow::MainWindow(QWidget *parent)
     // ------------------------------------------------------------------------
 
     // Create Player 1's UI column
-    QVBoxLayout *leftCol = createPlayerColumn(player1, "Player 1 (Left)");
+    QVBoxLayout *leftCol = createPlayerColumn(player1, waveform1, "Player 1 (Left)");
     videoArea->addLayout(leftCol);
 
     // Add a vertical dividing line between the two players.
@@ -1001,12 +434,26 @@ MainWindow::MainWindow(QWidget *parent)
     videoArea->addWidget(vLine);
 
     // Create Player 2's UI column
-    QVBoxLayout *rightCol = createPlayerColumn(player2, "Player 2 (Right)");
+    QVBoxLayout *rightCol = createPlayerColumn(player2, waveform2, "Player 2 (Right)");
     videoArea->addLayout(rightCol);
 
     // Add the video area (both players) to the main layout
     mainLayout->addLayout(videoArea);
 
+    // Difference heatmap of the two files, across player 1's timeline
+    QHBoxLayout *diffRow = new QHBoxLayout();
+    DiffHeatmapView *diffView = new DiffHeatmapView(player1);
+    diffView->setMessage("Compare both files to see where they differ");
+    QPushButton *btnDiff = new QPushButton("Compare files");
+    QLabel *diffStatus = new QLabel();
+    diffStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    diffRow->addWidget(new QLabel("Differences:"));
+    diffRow->addWidget(diffView, 1);
+    diffRow->addWidget(btnDiff);
+    diffRow->addWidget(diffStatus);
+    mainLayout->addLayout(diffRow);
+
     // ------------------------------------------------------------------------
     // Global Controls Section (affects both players simultaneously)
     // ------------------------------------------------------------------------
@@ -1030,6 +477,68 @@ MainWindow::MainWindow(QWidget *parent)
     globalSeek->addWidget(gFwd1m);
     mainLayout->addLayout(globalSeek);
 
+    // Scene navigation - enabled per player once its scene index is built
+    QHBoxLayout *sceneRow = new QHBoxLayout();
+    QPushButton *btnPrevScene = new QPushButton("|< Previous scene");
+    QPushButton *btnNextScene = new QPushButton("Next scene >|");
+    QLabel *scenes1 = new QLabel("P1: -");
+    QLabel *scenes2 = new QLabel("P2: -");
+    scenes1->setStyleSheet("color: #0055aa; font-family: monospace;");
+    scenes2->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    sceneRow->addWidget(btnPrevScene);
+    sceneRow->addWidget(new QLabel("Scenes:"));
+    sceneRow->addWidget(scenes1, 1);
+    sceneRow->addWidget(scenes2, 1);
+    sceneRow->addWidget(btnNextScene);
+    mainLayout->addLayout(sceneRow);
+
+    // Keyframe index of each player, used to time barrier seeks
+    QHBoxLayout *keyframeRow = new QHBoxLayout();
+    QLabel *keyframes1 = new QLabel("P1: -");
+    QLabel *keyframes2 = new QLabel("P2: -");
+    keyframes1->setStyleSheet("color: #0055aa; font-family: monospace;");
+    keyframes2->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    keyframeRow->addWidget(new QLabel("Keyframes:"));
+    keyframeRow->addWidget(keyframes1, 1);
+    keyframeRow->addWidget(keyframes2, 1);
+    mainLayout->addLayout(keyframeRow);
+
+    // A-B loop over both players - see grouploop.h
+    QHBoxLayout *loopRow = new QHBoxLayout();
+    QPushButton *btnLoopA = new QPushButton("Loop A");
+    QPushButton *btnLoopB = new QPushButton("Loop B");
+    QPushButton *btnLoopClear = new QPushButton("Clear loop");
+    QLabel *loopStatus = new QLabel("Loop: off");
+    loopStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    loopRow->addWidget(btnLoopA);
+    loopRow->addWidget(btnLoopB);
+    loopRow->addWidget(btnLoopClear);
+    loopRow->addWidget(loopStatus, 1);
+    mainLayout->addLayout(loopRow);
+
+    // Subtitle search - results appear below while typing
+    QHBoxLayout *searchRow = new QHBoxLayout();
+    QLineEdit *subtitleSearch = new QLineEdit();
+    subtitleSearch->setPlaceholderText("Search subtitles...");
+    subtitleSearch->setClearButtonEnabled(true);
+    QLabel *subtitles1 = new QLabel("P1: -");
+    QLabel *subtitles2 = new QLabel("P2: -");
+    subtitles1->setStyleSheet("color: #0055aa; font-family: monospace;");
+    subtitles2->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    searchRow->addWidget(subtitleSearch, 2);
+    searchRow->addWidget(subtitles1, 1);
+    searchRow->addWidget(subtitles2, 1);
+    mainLayout->addLayout(searchRow);
+
+    QListWidget *searchResults = new QListWidget();
+    searchResults->setMaximumHeight(140);
+    searchResults->setVisible(false);
+    mainLayout->addWidget(searchResults);
+
     // Global play/pause buttons
     QHBoxLayout *globalControls = new QHBoxLayout();
     QPushButton *btnGlobalPause = new QPushButton("Global Pause");
@@ -1043,66 +552,1502 @@ MainWindow::MainWindow(QWidget *parent)
     globalControls->addWidget(btnGlobalPlay);
     mainLayout->addLayout(globalControls);
 
+    // Group speed - one speed for both players, kept in step by the drift
+    // controller. "Lockstep" shows how far each player is off its offset.
+    QHBoxLayout *speedRow = new QHBoxLayout();
+
+    QDoubleSpinBox *speedBox = new QDoubleSpinBox();
+    speedBox->setRange(PlayerGroup::MinSpeed, PlayerGroup::MaxSpeed);
+    speedBox->setSingleStep(0.05);
+    speedBox->setDecimals(2);
+    speedBox->setSuffix("x");
+    speedBox->setValue(1.0);
+    QPushButton *btnSpeedReset = new QPushButton("1x");
+    QCheckBox *lockstep = new QCheckBox("Lockstep");
+    lockstep->setChecked(true);
+    QLabel *driftStatus = new QLabel("-");
+    driftStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    speedRow->addWidget(new QLabel("Speed:"));
+    speedRow->addWidget(speedBox);
+    speedRow->addWidget(btnSpeedReset);
+    speedRow->addWidget(lockstep);
+    speedRow->addWidget(driftStatus, 1);
+    mainLayout->addLayout(speedRow);
+
+    // Shown only while the buffering barrier holds the players
+    QLabel *barrierStatus = new QLabel();
+    barrierStatus->setStyleSheet("color: #aa5500;");
+    barrierStatus->setVisible(false);
+    mainLayout->addWidget(barrierStatus);
+
     // ------------------------------------------------------------------------
-    // Connect Global Controls
+    // Loudness Row (level matching between the two players)
     // ------------------------------------------------------------------------
-    // Global buttons affect BOTH players simultaneously.
+    // Every loaded file is scanned in the background. Once both are known,
+    // "Match levels" turns the louder player down to the quieter one's
+    // loudness; with "Auto" ticked this happens whenever a scan finishes.
     // ------------------------------------------------------------------------
+    QHBoxLayout *loudnessRow = new QHBoxLayout();
 
-    // Global seek - applies seek to both players
-    connect(gBack1m,  &QPushButton::clicked, [=]() { player1->seek(-60); player2->seek(-60); });
-    connect(gBack10s, &QPushButton::clicked, [=]() { player1->seek(-10); player2->seek(-10); });
-    connect(gFwd10s,  &QPushButton::clicked, [=]() { player1->seek(10);  player2->seek(10); });
-    connect(gFwd1m,   &QPushButton::clicked, [=]() { player1->seek(60);  player2->seek(60); });
+    QLabel *loudness1 = new QLabel("P1: -");
+    QLabel *loudness2 = new QLabel("P2: -");
+    loudness1->setStyleSheet("color: #0055aa; font-family: monospace;");
+    loudness2->setStyleSheet("color: #0055aa; font-family: monospace;");
 
-    // Global Pause - sets pause=true on both players
-    connect(btnGlobalPause, &QPushButton::clicked, this, [=]() {
-        int flag = 1;  // 1 = paused
-        // Check that MPV is valid before accessing it
-        if (player1->mpv) mpv_set_property(player1->mpv, "pause", MPV_FORMAT_FLAG, &flag);
-        if (player2->mpv) mpv_set_property(player2->mpv, "pause", MPV_FORMAT_FLAG, &flag);
-    });
+    QPushButton *btnMatchLevels = new QPushButton("Match levels");
+    QCheckBox *autoMatch = new QCheckBox("Auto");
+    autoMatch->setChecked(true);
 
-    // Global Play - sets pause=false on both players
-    connect(btnGlobalPlay, &QPushButton::clicked, this, [=]() {
-        int flag = 0;  // 0 = not paused = playing
-        if (player1->mpv) mpv_set_property(player1->mpv, "pause", MPV_FORMAT_FLAG, &flag);
-        if (player2->mpv) mpv_set_property(player2->mpv, "pause", MPV_FORMAT_FLAG, &flag);
-    });
-}
+    loudnessRow->addWidget(new QLabel("Loudness:"));
+    loudnessRow->addWidget(loudness1, 1);
+    loudnessRow->addWidget(loudness2, 1);
+    loudnessRow->addWidget(btnMatchLevels);
+    loudnessRow->addWidget(autoMatch);
+    mainLayout->addLayout(loudnessRow);
 
-// ----------------------------------------------------------------------------
-// Destructor: MainWindow::~MainWindow
-// ----------------------------------------------------------------------------
-// Cleans up resources when the window is destroyed.
-// ----------------------------------------------------------------------------
-MainWindow::~MainWindow()
-{
-    // Shut down both players (safe to call even if already shut down)
-    if (player1) player1->shutdown();
-    if (player2) player2->shutdown();
+    // ------------------------------------------------------------------------
+    // Audio Latency Row (A/V offset MPV's own sync leaves per player)
+    // ------------------------------------------------------------------------
+    // Shows how late each player's sound is heard against its picture. With
+    // "Compensate" ticked, the others are delayed to match the latest.
+    // ------------------------------------------------------------------------
+    QHBoxLayout *latencyRow = new QHBoxLayout();
 
-    // Delete the UI object created in the constructor
-    delete ui;
-}
+    QLabel *latencyStatus = new QLabel("P1: - | P2: -");
+    latencyStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+    QCheckBox *latencyCompensate = new QCheckBox("Compensate");
+    latencyCompensate->setChecked(true);
+
+    latencyRow->addWidget(new QLabel("A/V offset:"));
+    latencyRow->addWidget(latencyStatus, 1);
+    latencyRow->addWidget(latencyCompensate);
+    mainLayout->addLayout(latencyRow);
+
+    // ------------------------------------------------------------------------
+    // Ducking Row (player 1 lowered while player 2's commentary talks)
+    // ------------------------------------------------------------------------
+    // Threshold is the level at which player 2 counts as talking; depth is
+    // how far player 1 goes down. Attack and release are how fast it goes
+    // down and comes back up.
+    // ------------------------------------------------------------------------
+    QHBoxLayout *duckRow = new QHBoxLayout();
+
+    QCheckBox *duckEnable = new QCheckBox("Duck P1 under P2");
+
+    auto duckBox = [](int min, int max, int value, const QString &suffix) {
+        QSpinBox *box = new QSpinBox();
+        box->setRange(min, max);
+        box->setValue(value);
+        box->setSuffix(suffix);
+        return box;
+    };
+    QSpinBox *duckThreshold = duckBox(-70, 0, -40, " dBFS");
+    QSpinBox *duckDepth = duckBox(1, 40, 12, " dB");
+    QSpinBox *duckAttack = duckBox(0, 1000, 30, " ms");
+    QSpinBox *duckRelease = duckBox(0, 5000, 600, " ms");
+
+    QLabel *duckStatus = new QLabel("-");
+    duckStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    duckRow->addWidget(duckEnable);
+    duckRow->addWidget(new QLabel("Threshold:"));
+    duckRow->addWidget(duckThreshold);
+    duckRow->addWidget(new QLabel("Depth:"));
+    duckRow->addWidget(duckDepth);
+    duckRow->addWidget(new QLabel("Attack:"));
+    duckRow->addWidget(duckAttack);
+    duckRow->addWidget(new QLabel("Release:"));
+    duckRow->addWidget(duckRelease);
+    duckRow->addWidget(duckStatus, 1);
+    mainLayout->addLayout(duckRow);
+
+    // ------------------------------------------------------------------------
+    // Video Output Row (which MPV output the players draw with)
+    // ------------------------------------------------------------------------
+    // Chosen by the startup probe (see voprobe.h); the tooltip lists every
+    // candidate's numbers.
+    // ------------------------------------------------------------------------
+    QHBoxLayout *voRow = new QHBoxLayout();
+
+    QLabel *voStatus = new QLabel();
+    voStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+    QPushButton *btnProbeVo = new QPushButton("Probe again");
+    btnProbeVo->setEnabled(PlayerBackend::defaultKind() == PlayerBackend::Mpv);
+
+    voRow->addWidget(new QLabel("Video output:"));
+    voRow->addWidget(voStatus, 1);
+    voRow->addWidget(btnProbeVo);
+    mainLayout->addLayout(voRow);
+
+    // ------------------------------------------------------------------------
+    // Capture Row (the same frame from both players, saved as images)
+    // ------------------------------------------------------------------------
+    // A burst captures that many consecutive frames. "Side by side" and
+    // "Difference" add a combined image per frame when both players have
+    // video; the difference is amplified so compression artifacts stand out.
+    // ------------------------------------------------------------------------
+    QHBoxLayout *captureRow = new QHBoxLayout();
+
+    QPushButton *btnCapture = new QPushButton("Capture frame");
+
+    QSpinBox *captureFrames = new QSpinBox();
+    captureFrames->setRange(1, FrameCapture::MaxFrames);
+    captureFrames->setSuffix(" frame(s)");
+
+    QComboBox *captureFormat = new QComboBox();
+    for (const QString &format : FrameCapture::formats()) captureFormat->addItem(format.toUpper(), format);
+
+    QCheckBox *captureSide = new QCheckBox("Side by side");
+    QCheckBox *captureDiff = new QCheckBox("Difference");
+
+    QLabel *captureStatus = new QLabel();
+    captureStatus->setStyleSheet("color: #0055aa;");
+    captureStatus->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Preferred);
+
+    captureRow->addWidget(btnCapture);
+    captureRow->addWidget(captureFrames);
+    captureRow->addWidget(captureFormat);
+    captureRow->addWidget(captureSide);
+    captureRow->addWidget(captureDiff);
+    captureRow->addWidget(captureStatus, 1);
+
+    QPushButton *btnCompare = new QPushButton("A/B compare...");
+    captureRow->addWidget(btnCompare);
+    mainLayout->addLayout(captureRow);
+
+    // ------------------------------------------------------------------------
+    // View Row (split players, or both files in one composite instance)
+    // ------------------------------------------------------------------------
+    // The composite modes open both files in ONE extra MPV instance, so they
+    // share a clock (see compositeplayer.h). The label compares the CPU load
+    // of both ways of playing.
+    // ------------------------------------------------------------------------
+    QHBoxLayout *viewRow = new QHBoxLayout();
+
+    QComboBox *viewMode = new QComboBox();
+    viewMode->addItem("Split (two players)", -1);
+    viewMode->addItem("Composite: side by side", static_cast<int>(CompositePlayer::SideBySide));
+    viewMode->addItem("Composite: blend", static_cast<int>(CompositePlayer::Blend));
+    viewMode->addItem("Composite: difference", static_cast<int>(CompositePlayer::Difference));
+
+    QLabel *viewStatus = new QLabel();
+    viewStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    viewRow->addWidget(new QLabel("View:"));
+    viewRow->addWidget(viewMode);
+    viewRow->addWidget(viewStatus, 1);
+    mainLayout->addLayout(viewRow);
+
+    // ------------------------------------------------------------------------
+    // Filters Row (one file through several filter chains)
+    // ------------------------------------------------------------------------
+    // Player 1's file - or whichever player defines group time - decoded
+    // once and split into chains A, B and optionally C (see filterchains.h).
+    // A chain is applied when its box loses focus or Enter is pressed; an
+    // empty A or B shows the untouched source. The label is each chain's
+    // time per frame.
+    // ------------------------------------------------------------------------
+    QHBoxLayout *chainsRow = new QHBoxLayout();
+
+    QList<QLineEdit *> chainEdits;
+    const QStringList chainHints = { "A: e.g. hqdn3d=luma_spatial=4", "B: e.g. nlmeans=s=3", "C: (optional)" };
+    for (const QString &hint : chainHints) {
+        QLineEdit *edit = new QLineEdit();
+        edit->setPlaceholderText(hint);
+        chainEdits.append(edit);
+    }
+
+    QComboBox *chainsView = new QComboBox();
+    chainsView->addItem("All chains", FilterChains::AllChains);
+    chainsView->addItem("Chain A only", 0);
+    chainsView->addItem("Chain B only", 1);
+    chainsView->addItem("Chain C only", 2);
+
+    QPushButton *btnChains = new QPushButton("Filter chains");
+    btnChains->setCheckable(true);
+
+    QLabel *chainsStatus = new QLabel();
+    chainsStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    chainsRow->addWidget(new QLabel("Filters:"));
+    for (QLineEdit *edit : chainEdits) chainsRow->addWidget(edit, 1);
+    chainsRow->addWidget(chainsView);
+    chainsRow->addWidget(btnChains);
+    chainsRow->addWidget(chainsStatus);
+    mainLayout->addLayout(chainsRow);
+
+    // ------------------------------------------------------------------------
+    // Export Row (a clip of both players as one video file)
+    // ------------------------------------------------------------------------
+    // In and out are group times (player 1's position); "Set" takes the
+    // current one.
+    // ------------------------------------------------------------------------
+    QHBoxLayout *exportRow = new QHBoxLayout();
+
+    auto timeBox = []() {
+        QDoubleSpinBox *box = new QDoubleSpinBox();
+        box->setRange(0.0, 24 * 3600.0);
+        box->setDecimals(1);
+        box->setSuffix(" s");
+        return box;
+    };
+    QDoubleSpinBox *exportIn = timeBox();
+    QDoubleSpinBox *exportOut = timeBox();
+    QPushButton *btnSetIn = new QPushButton("Set");
+    QPushButton *btnSetOut = new QPushButton("Set");
+
+    QComboBox *exportLayout = new QComboBox();
+    exportLayout->addItem("Side by side", static_cast<int>(ClipExporter::SideBySide));
+    exportLayout->addItem("Picture in picture", static_cast<int>(ClipExporter::PictureInPicture));
+
+    QPushButton *btnExport = new QPushButton("Export clip...");
+
+    QLabel *exportStatus = new QLabel();
+    exportStatus->setStyleSheet("color: #0055aa;");
+    exportStatus->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Preferred);
+
+    exportRow->addWidget(new QLabel("In:"));
+    exportRow->addWidget(exportIn);
+    exportRow->addWidget(btnSetIn);
+    exportRow->addWidget(new QLabel("Out:"));
+    exportRow->addWidget(exportOut);
+    exportRow->addWidget(btnSetOut);
+    exportRow->addWidget(exportLayout);
+    exportRow->addWidget(btnExport);
+    exportRow->addWidget(exportStatus, 1);
+    mainLayout->addLayout(exportRow);
+
+    // ------------------------------------------------------------------------
+    // Scopes Row and Panel (hidden until "Scopes" is ticked)
+    // ------------------------------------------------------------------------
+    // Player 1's scope on the left, player 2's mirrored on the right; with
+    // "Overlay" ticked, both together in the middle (see scopeview.h).
+    // ------------------------------------------------------------------------
+    QHBoxLayout *scopeRow = new QHBoxLayout();
+
+    QCheckBox *scopesOn = new QCheckBox("Scopes");
+
+    QComboBox *scopeKind = new QComboBox();
+    scopeKind->addItem("Histogram", static_cast<int>(ScopeView::Histogram));
+    scopeKind->addItem("Waveform", static_cast<int>(ScopeView::Waveform));
+    scopeKind->addItem("Vectorscope", static_cast<int>(ScopeView::Vectorscope));
+
+    QSpinBox *scopeRate = new QSpinBox();
+    scopeRate->setRange(1, 30);
+    scopeRate->setValue(ScopeAnalyzer::DefaultRate);
+    scopeRate->setSuffix(" fps");
+
+    QCheckBox *scopeOverlay = new QCheckBox("Overlay");
+
+    QLabel *scopeStatus = new QLabel();
+    scopeStatus->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    scopeRow->addWidget(scopesOn);
+    scopeRow->addWidget(scopeKind);
+    scopeRow->addWidget(scopeRate);
+    scopeRow->addWidget(scopeOverlay);
+    scopeRow->addWidget(scopeStatus, 1);
+    mainLayout->addLayout(scopeRow);
+
+    QWidget *scopePanel = new QWidget();
+    QHBoxLayout *scopeLayout = new QHBoxLayout(scopePanel);
+    scopeLayout->setContentsMargins(0, 0, 0, 0);
+    ScopeView *scope1 = new ScopeView("P1");
+    ScopeView *scopeBoth = new ScopeView("P1 (magenta) vs P2 (green)");
+    ScopeView *scope2 = new ScopeView("P2");
+    scopeLayout->addWidget(scope1);
+    scopeLayout->addWidget(scopeBoth);
+    scopeLayout->addWidget(scope2);
+    scopeBoth->setVisible(false);
+    scopePanel->setVisible(false);
+    mainLayout->addWidget(scopePanel);
+
+    // ------------------------------------------------------------------------
+    // Watch Party Row (sync with other MPV-watchalong instances)
+    // ------------------------------------------------------------------------
+    // One instance hosts ("leader"), every other instance joins it
+    // ("follower") using the host's IP address and port. Followers then
+    // follow every play, pause and seek of the host automatically.
+    // ------------------------------------------------------------------------
+    QHBoxLayout *partyRow = new QHBoxLayout();
+
+    QComboBox *partyRole = new QComboBox();
+    partyRole->addItem("Host party", static_cast<int>(WatchPartySync::Leader));
+    partyRole->addItem("Join party", static_cast<int>(WatchPartySync::Follower));
+
+    QLineEdit *partyHost = new QLineEdit("127.0.0.1");
+    partyHost->setPlaceholderText("Host address");
+    partyHost->setEnabled(false);           // Only needed when joining
+
+    QSpinBox *partyPort = new QSpinBox();
+    partyPort->setRange(1024, 65535);
+    partyPort->setValue(WatchPartySync::DefaultPort);
+
+    QPushButton *btnParty = new QPushButton("Start");
+
+    QLabel *partyStatus = new QLabel("Not connected");
+    partyStatus->setStyleSheet("color: #0055aa;");
+    partyStatus->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Preferred);
+
+    partyRow->addWidget(new QLabel("Watch party:"));
+    partyRow->addWidget(partyRole);
+    partyRow->addWidget(partyHost);
+    partyRow->addWidget(partyPort);
+    partyRow->addWidget(btnParty);
+    partyRow->addWidget(partyStatus, 1);
+    mainLayout->addLayout(partyRow);
+
+    // ------------------------------------------------------------------------
+    // Player Group and Watch Party Sync
+    // ------------------------------------------------------------------------
+    // The group lets every "Global" control act on both players with one
+    // call. The sync object drives the same group when following a host.
+    // ------------------------------------------------------------------------
+    group = new PlayerGroup(this);
+    group->addPlayer(player1);
+    group->addPlayer(player2);
+
+    // Slot 0 is player 1, slot 1 is player 2 - the index every per-player
+    // feature below (analysis labels, pair memory, session) goes by.
+    QList<MpvWidget *> players = { player1, player2 };
+
+    partySync = new WatchPartySync(group, this);
+
+    // A stream stays out of the group until its prefill is done, then joins
+    // whatever the group is doing (see PlayerGroup::join)
+    for (MpvWidget *player : group->members()) {
+        connect(player, &MpvWidget::prefillFinished, this, [=]() {
+            group->join(player);
+            partySync->notifyLocalChange();
+        });
+    }
+
+    // If either player runs dry, hold both until each has data again
+    barrier = new BufferingBarrier(group, this);
+
+    connect(barrier, &BufferingBarrier::statusChanged, this, [=](const QString &text) {
+        barrierStatus->setText(text);
+        barrierStatus->setVisible(!text.isEmpty());
+    });
+
+    // A hosting instance broadcasts the hold as a pause, so the whole party
+    // waits for whoever is buffering
+    connect(barrier, &BufferingBarrier::holdChanged, this, [=](bool holding) {
+        if (ipcServer) ipcServer->setGroupHeld(holding);
+        partySync->notifyLocalChange();
+    });
+
+    // ------------------------------------------------------------------------
+    // Group Speed and Lockstep
+    // ------------------------------------------------------------------------
+    // The new speed reaches both players at the same moment (see
+    // PlayerGroup::applySpeed); the drift controller keeps the offsets they
+    // had, at whatever speed (see driftcontroller.h). The box also follows
+    // speed changes from the watch party and the IPC server.
+    // ------------------------------------------------------------------------
+    DriftController *drift = new DriftController(group, barrier, this);
+
+    connect(speedBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [=](double speed) {
+        group->setSpeed(speed);
+        if (compositePlayer && compositePlayer->isActive()) compositePlayer->player()->setSpeed(group->speed());
+        if (filterChains && filterChains->isActive()) filterChains->player()->setSpeed(group->speed());
+        partySync->notifyLocalChange();
+    });
+    connect(btnSpeedReset, &QPushButton::clicked, this, [=]() { speedBox->setValue(1.0); });
+
+    connect(group, &PlayerGroup::speedChanged, this, [=](double speed) {
+        speedBox->blockSignals(true);
+        speedBox->setValue(speed);
+        speedBox->blockSignals(false);
+    });
+
+    // "P2 +3 ms" - how far player 2 is from its locked offset
+    connect(drift, &DriftController::updated, this, [=]() {
+        if (!drift->isEnabled()) {
+            driftStatus->setText("-");
+            return;
+        }
+        double error = drift->error(1) * 1000.0;
+        driftStatus->setText(QString("P2 %1%2 ms").arg(error >= 0.0 ? "+" : "").arg(error, 0, 'f', 0));
+    });
+
+    connect(lockstep, &QCheckBox::toggled, drift, &DriftController::setEnabled);
+    drift->setEnabled(lockstep->isChecked());
+
+    // ------------------------------------------------------------------------
+    // Loudness Scans and Level Matching
+    // ------------------------------------------------------------------------
+    // Slot 0 is player 1, slot 1 is player 2. Only local files are scanned;
+    // a stream would have to be downloaded a second time.
+    // ------------------------------------------------------------------------
+    loudness = new LoudnessAnalyzer(this);
+
+    QList<QLabel *> loudnessLabels = { loudness1, loudness2 };
+
+    // "P1: -16.2 LUFS (-6.8 dB)" - the gain only when one is applied
+    auto showLoudness = [=](int slot) {
+        LoudnessInfo info = loudness->result(slot);
+        QString text = QString("P%1: ").arg(slot + 1);
+        if (!info.valid) {
+            loudnessLabels[slot]->setText(text + "-");
+            return;
+        }
+        text += QString("%1 LUFS").arg(info.integrated, 0, 'f', 1);
+        double gain = players[slot]->levelGain();
+        if (qAbs(gain) >= 0.05) text += QString(" (%1 dB)").arg(gain, 0, 'f', 1);
+        loudnessLabels[slot]->setText(text);
+        loudnessLabels[slot]->setToolTip(QString("Loudest 3 s: %1 LUFS").arg(info.maxShortTerm, 0, 'f', 1));
+    };
+
+    // Bring both players to the quieter file's loudness. Only ever turning
+    // down avoids clipping the quieter one.
+    auto matchLevels = [=]() {
+        LoudnessInfo a = loudness->result(0);
+        LoudnessInfo b = loudness->result(1);
+        if (!a.valid || !b.valid) return;
+
+        double target = qMin(a.integrated, b.integrated);
+        player1->setLevelGain(target - a.integrated);
+        player2->setLevelGain(target - b.integrated);
+        showLoudness(0);
+        showLoudness(1);
+    };
+
+    connect(loudness, &LoudnessAnalyzer::progress, this, [=](int slot, int percent) {
+        loudnessLabels[slot]->setText(QString("P%1: scanning %2%").arg(slot + 1).arg(percent));
+    });
+    connect(loudness, &LoudnessAnalyzer::failed, this, [=](int slot, const QString &reason) {
+        loudnessLabels[slot]->setText(QString("P%1: n/a").arg(slot + 1));
+        loudnessLabels[slot]->setToolTip(reason);
+    });
+    connect(loudness, &LoudnessAnalyzer::finished, this, [=](int slot) {
+        showLoudness(slot);
+        if (autoMatch->isChecked()) matchLevels();
+    });
+
+    connect(btnMatchLevels, &QPushButton::clicked, this, matchLevels);
+
+    // Unticking "Auto" leaves the current gains alone; ticking it matches now.
+    connect(autoMatch, &QCheckBox::toggled, this, [=](bool on) {
+        if (on) matchLevels();
+    });
+
+    if (!LoudnessAnalyzer::isAvailable()) {
+        btnMatchLevels->setEnabled(false);
+        autoMatch->setEnabled(false);
+        btnMatchLevels->setToolTip("Built without libav - loudness scanning is unavailable");
+    }
+
+    // ------------------------------------------------------------------------
+    // Audio Latency Compensation
+    // ------------------------------------------------------------------------
+    // Measured continuously while the players play (see audiolatency.h).
+    // "P1: 42 ms +45 | P2: 87 ms" - the +N is the delay being applied.
+    // ------------------------------------------------------------------------
+    AudioLatency *audioLatency = new AudioLatency(players, this);
+
+    connect(audioLatency, &AudioLatency::changed, this, [=]() {
+        QStringList parts;
+        for (int slot = 0; slot < players.size(); slot++) {
+            double latency = audioLatency->latency(slot);
+            QString text = QString("P%1: ").arg(slot + 1);
+            text += latency < 0.0 ? QString("-") : QString("%1 ms").arg(latency * 1000.0, 0, 'f', 0);
+            double delay = audioLatency->delay(slot);
+            if (delay >= 0.0005) text += QString(" +%1").arg(delay * 1000.0, 0, 'f', 0);
+            parts << text;
+        }
+        latencyStatus->setText(parts.join(" | "));
+    });
+
+    connect(latencyCompensate, &QCheckBox::toggled, audioLatency, &AudioLatency::setEnabled);
+    audioLatency->setEnabled(latencyCompensate->isChecked());
+
+    // ------------------------------------------------------------------------
+    // Commentary Ducking
+    // ------------------------------------------------------------------------
+    // The envelope runs on its own thread (see audioducker.h); the status
+    // shows player 2's level and player 1's current gain, e.g.
+    // "P2 -23 dBFS  P1 -11.8 dB".
+    // ------------------------------------------------------------------------
+    ducker = new AudioDucker(player2, player1, this);
+
+    connect(duckEnable, &QCheckBox::toggled, ducker, &AudioDucker::setEnabled);
+    connect(duckThreshold, QOverload<int>::of(&QSpinBox::valueChanged), ducker, &AudioDucker::setThreshold);
+    connect(duckDepth, QOverload<int>::of(&QSpinBox::valueChanged), ducker, &AudioDucker::setDepth);
+    connect(duckAttack, QOverload<int>::of(&QSpinBox::valueChanged), ducker, &AudioDucker::setAttack);
+    connect(duckRelease, QOverload<int>::of(&QSpinBox::valueChanged), ducker, &AudioDucker::setRelease);
+
+    connect(ducker, &AudioDucker::levelChanged, this, [=](double levelDb, double gainDb) {
+        if (!ducker->isEnabled()) {
+            duckStatus->setText("-");
+            return;
+        }
+        QString level = levelDb <= -100.0 ? QString("silent") : QString("%1 dBFS").arg(levelDb, 0, 'f', 0);
+        duckStatus->setText(QString("P2 %1  P1 %2 dB").arg(level).arg(gainDb, 0, 'f', 1));
+    });
+
+    // ------------------------------------------------------------------------
+    // Video Output Probe
+    // ------------------------------------------------------------------------
+    // Probing takes a few seconds (each candidate opens a small window of
+    // its own), so it runs in the background: on the first start on this
+    // machine, and whenever "Probe again" is clicked. MPV can switch the
+    // output of a running player, so the new choice applies right away.
+    // ------------------------------------------------------------------------
+    VoProber *voProber = new VoProber(this);
+
+    auto showVo = [=]() {
+        voStatus->setText(VoProbe::summary());
+        voStatus->setToolTip(VoProbe::table());
+    };
+    showVo();
+
+    auto startProbe = [=]() {
+        btnProbeVo->setEnabled(false);
+        voProber->start();
+    };
+    connect(btnProbeVo, &QPushButton::clicked, this, startProbe);
+
+    connect(voProber, &VoProber::progress, this, [=](int done, int total, const QString &vo) {
+        voStatus->setText(QString("Probing %1 (%2 of %3)...").arg(vo).arg(done + 1).arg(total));
+    });
+
+    connect(voProber, &VoProber::finished, this, [=]() {
+        QByteArray vo = VoProbe::selected().toUtf8();
+        if (!vo.isEmpty()) {
+            for (MpvWidget *player : players) {
+                player->setString("vo", vo.constData());
+            }
+        }
+        btnProbeVo->setEnabled(true);
+        showVo();
+    });
+
+    if (VoProbe::needsProbe()) startProbe();
+
+    // ------------------------------------------------------------------------
+    // Waveform Strips
+    // ------------------------------------------------------------------------
+    // Each local file gets a waveform pyramid built in the background (or
+    // loaded straight from the cache when it was built before). Slot 0 is
+    // player 1, slot 1 is player 2 - same as the loudness scanner.
+    // ------------------------------------------------------------------------
+    waveforms = new WaveformBuilder(this);
+
+    QList<WaveformView *> waveformViews = { waveform1, waveform2 };
+
+    connect(waveforms, &WaveformBuilder::progress, this, [=](int slot, int percent) {
+        waveformViews[slot]->setMessage(QString("Building waveform %1%").arg(percent));
+    });
+    connect(waveforms, &WaveformBuilder::finished, this, [=](int slot) {
+        waveformViews[slot]->setPyramid(waveforms->pyramid(slot));
+    });
+    connect(waveforms, &WaveformBuilder::failed, this, [=](int slot, const QString &reason) {
+        waveformViews[slot]->setMessage("No waveform: " + reason);
+    });
+
+    // ------------------------------------------------------------------------
+    // Difference Heatmap
+    // ------------------------------------------------------------------------
+    // "Compare files" scores every frame of player 1's file against player
+    // 2's at the CURRENT offset (see diffheatmap.h); a second click while
+    // it runs cancels. Clicking the heatmap brings both players to that
+    // frame with a barrier seek, at the offset that was compared.
+    // ------------------------------------------------------------------------
+    diffs = new DiffAnalyzer(this);
+
+    connect(btnDiff, &QPushButton::clicked, this, [=]() {
+        if (diffs->isRunning()) {
+            diffs->cancel();
+            btnDiff->setText("Compare files");
+            diffStatus->setText("cancelled");
+            return;
+        }
+        QString path1 = player1->currentPath();
+        QString path2 = player2->currentPath();
+        if (!player1->hasFile() || !player2->hasFile()
+            || !QFileInfo(path1).isFile() || !QFileInfo(path2).isFile()) {
+            diffStatus->setText("Load a local file in both players");
+            return;
+        }
+        diffStatus->clear();
+        btnDiff->setText("Cancel");
+        diffs->analyze(path1, path2, player2->position() - player1->position());
+    });
+
+    connect(diffs, &DiffAnalyzer::progress, this, [=](int, int percent) {
+        diffView->setMessage(QString("Comparing %1%").arg(percent));
+    });
+    connect(diffs, &DiffAnalyzer::finished, this, [=](int) {
+        QSharedPointer<DiffSeries> series = diffs->series();
+        btnDiff->setText("Compare files");
+        diffView->setSeries(series);
+        diffStatus->setText(QString("offset %1 s").arg(series->offset(), 0, 'f', 3));
+    });
+    connect(diffs, &DiffAnalyzer::failed, this, [=](int, const QString &reason) {
+        btnDiff->setText("Compare files");
+        diffView->setMessage("No comparison: " + reason);
+    });
+
+    connect(diffView, &DiffHeatmapView::seekRequested, this, [=](double time) {
+        QSharedPointer<DiffSeries> series = diffView->series();
+        if (!series || !player1->hasFile()) return;
+        barrier->seekTo(time, { 0.0, series->offset() });
+        partySync->notifyLocalChange();
+    });
+
+    // ------------------------------------------------------------------------
+    // Scene Index and Navigation
+    // ------------------------------------------------------------------------
+    // Every local file is indexed in the background. "Previous/Next scene"
+    // use the index of the first player that has one (normally player 1,
+    // which defines group time) and move the whole group by the same
+    // amount - so the other player keeps its offset - with one exact seek
+    // per player.
+    // ------------------------------------------------------------------------
+    scenes = new SceneDetector(this);
+
+    QList<QLabel *> sceneLabels = { scenes1, scenes2 };
+
+    connect(scenes, &SceneDetector::progress, this, [=](int slot, int percent) {
+        sceneLabels[slot]->setText(QString("P%1: indexing %2%").arg(slot + 1).arg(percent));
+    });
+    connect(scenes, &SceneDetector::failed, this, [=](int slot, const QString &reason) {
+        sceneLabels[slot]->setText(QString("P%1: n/a").arg(slot + 1));
+        sceneLabels[slot]->setToolTip(reason);
+    });
+    connect(scenes, &SceneDetector::finished, this, [=](int slot) {
+        sceneLabels[slot]->setText(QString("P%1: %2 cuts").arg(slot + 1).arg(scenes->cuts(slot).size()));
+    });
+
+    // direction > 0: the next cut after the current frame. direction < 0:
+    // the start of the current scene, or of the one before when we're
+    // within a second of that start (so pressing it twice keeps going back).
+    auto jumpScene = [=](int direction) {
+        for (int slot = 0; slot < players.size(); slot++) {
+            MpvWidget *player = players[slot];
+            QVector<double> cuts = scenes->cuts(slot);
+            if (cuts.isEmpty() || !player->hasFile() || player->isPrefilling()) continue;
+
+            double pos = player->position();
+            double target;
+            if (direction > 0) {
+                auto next = std::upper_bound(cuts.begin(), cuts.end(), pos + 0.01);
+                if (next == cuts.end()) return;
+                target = *next;
+            } else {
+                auto current = std::lower_bound(cuts.begin(), cuts.end(), pos - 1.0);
+                target = current == cuts.begin() ? 0.0 : *(current - 1);
+            }
+
+            barrier->seekTo(group->position() + (target - pos));
+            partySync->notifyLocalChange();
+            return;
+        }
+    };
+
+    connect(btnPrevScene, &QPushButton::clicked, this, [=]() { jumpScene(-1); });
+    connect(btnNextScene, &QPushButton::clicked, this, [=]() { jumpScene(1); });
+
+    if (!SceneDetector::isAvailable()) {
+        btnPrevScene->setEnabled(false);
+        btnNextScene->setEnabled(false);
+        btnPrevScene->setToolTip("Built without libav - scene indexing is unavailable");
+    }
+
+    // ------------------------------------------------------------------------
+    // Keyframe Index
+    // ------------------------------------------------------------------------
+    // Indexed like the scenes; the barrier uses the indexes to send each
+    // player's seek at the right moment (see bufferingbarrier.h). The label
+    // shows the average keyframe distance - the longer it is, the slower
+    // that player's exact seeks.
+    // ------------------------------------------------------------------------
+    keyframes = new KeyframeIndexer(this);
+    barrier->setKeyframeIndexer(keyframes);
+
+    QList<QLabel *> keyframeLabels = { keyframes1, keyframes2 };
+
+    connect(keyframes, &KeyframeIndexer::progress, this, [=](int slot, int percent) {
+        keyframeLabels[slot]->setText(QString("P%1: indexing %2%").arg(slot + 1).arg(percent));
+    });
+    connect(keyframes, &KeyframeIndexer::failed, this, [=](int slot, const QString &reason) {
+        keyframeLabels[slot]->setText(QString("P%1: n/a").arg(slot + 1));
+        keyframeLabels[slot]->setToolTip(reason);
+    });
+    connect(keyframes, &KeyframeIndexer::finished, this, [=](int slot) {
+        KeyframeIndex index = keyframes->index(slot);
+        keyframeLabels[slot]->setText(QString("P%1: %2 keyframes, every %3 s")
+                                          .arg(slot + 1).arg(index.times.size())
+                                          .arg(index.averageGop(), 0, 'f', 1));
+    });
+
+    // ------------------------------------------------------------------------
+    // Subtitle Search
+    // ------------------------------------------------------------------------
+    // Whenever a player's track list changes (file loaded, subtitle file
+    // added, file closed), its text subtitle tracks are (re)indexed in the
+    // background. Every keystroke then searches both players' indexes;
+    // choosing a hit brings the group there with a barrier seek, so both
+    // players resume together at that line.
+    // ------------------------------------------------------------------------
+    subtitles = new SubtitleIndexer(this);
+
+    QList<QLabel *> subtitleLabels = { subtitles1, subtitles2 };
+
+    for (int slot = 0; slot < players.size(); slot++) {
+        MpvWidget *player = players[slot];
+
+        player->observeProperty("track-list");
+        connect(player, &MpvWidget::propertyChanged, this, [=](const QString &name, const QVariant &value) {
+            if (name != "track-list") return;
+            QVector<SubtitleSource> sources = SubtitleIndexer::sourcesFromTrackList(value, player->currentPath());
+            subtitles->index(slot, sources);
+            if (sources.isEmpty()) {
+                subtitleLabels[slot]->setText(QString("P%1: -").arg(slot + 1));
+                subtitleLabels[slot]->setToolTip(QString());
+            }
+        });
+    }
+
+    auto runSearch = [=]() {
+        searchResults->clear();
+        const QString query = subtitleSearch->text();
+
+        for (int slot = 0; slot < players.size(); slot++) {
+            QSharedPointer<const SubtitleIndex> index = subtitles->result(slot);
+            if (!index) continue;
+            for (int cueId : index->search(query, 100)) {
+                const SubtitleIndex::Cue &cue = index->cue(cueId);
+                QString track = index->sources().size() > 1 ? index->sources()[cue.source].label : QString();
+                QString label = QString("P%1  %2  %3  %4").arg(QString::number(slot + 1),
+                                                                players[slot]->formatTime(cue.start),
+                                                                cue.text, track);
+                QListWidgetItem *item = new QListWidgetItem(label.trimmed(), searchResults);
+                item->setData(Qt::UserRole, slot);
+                item->setData(Qt::UserRole + 1, cue.start);
+            }
+        }
+        searchResults->setVisible(!query.trimmed().isEmpty());
+    };
+
+    connect(subtitleSearch, &QLineEdit::textChanged, this, runSearch);
+
+    connect(subtitles, &SubtitleIndexer::progress, this, [=](int slot, int percent) {
+        subtitleLabels[slot]->setText(QString("P%1: indexing %2%").arg(slot + 1).arg(percent));
+    });
+    connect(subtitles, &SubtitleIndexer::failed, this, [=](int slot, const QString &reason) {
+        subtitleLabels[slot]->setText(QString("P%1: n/a").arg(slot + 1));
+        subtitleLabels[slot]->setToolTip(reason);
+    });
+    connect(subtitles, &SubtitleIndexer::finished, this, [=](int slot) {
+        subtitleLabels[slot]->setText(QString("P%1: %2 lines").arg(slot + 1).arg(subtitles->result(slot)->cueCount()));
+        subtitleLabels[slot]->setToolTip(QString());
+        if (!subtitleSearch->text().isEmpty()) runSearch();
+    });
+
+    // Move the group so that the hit's player lands on the cue's first frame.
+    auto jumpToCue = [=](QListWidgetItem *item) {
+        int slot = item->data(Qt::UserRole).toInt();
+        double start = item->data(Qt::UserRole + 1).toDouble();
+        MpvWidget *player = players.value(slot);
+        if (!player || !player->hasFile() || player->isPrefilling()) return;
+
+        barrier->seekTo(group->position() + (start - player->position()));
+        partySync->notifyLocalChange();
+    };
+
+    connect(searchResults, &QListWidget::itemClicked, this, jumpToCue);
+    connect(subtitleSearch, &QLineEdit::returnPressed, this, [=]() {
+        if (searchResults->count() > 0) jumpToCue(searchResults->item(0));
+    });
+
+    if (!SubtitleIndexer::isAvailable()) {
+        subtitleSearch->setEnabled(false);
+        subtitleSearch->setPlaceholderText("Built without libav - subtitle search is unavailable");
+    }
+
+    // ------------------------------------------------------------------------
+    // Pair Memory
+    // ------------------------------------------------------------------------
+    // Every local file is fingerprinted in the background once loaded. When
+    // both players' files are known, the pair is looked up: a pair watched
+    // before gets its tracks, volumes and offset back right away - the offset
+    // with a barrier seek, so both players resume together. While the pair
+    // is open, a timer keeps its entry up to date (see PairMemory::observe).
+    // ------------------------------------------------------------------------
+    pairMemory = new PairMemory(this);
+
+    auto playerSettings = [](MpvWidget *player) {
+        PairState::PlayerSettings settings;
+        if (player->audioCombo->count() > 0) settings.audioTrack = player->audioCombo->currentData().toLongLong();
+        settings.subtitleTrack = player->subtitleCombo->currentData().toLongLong();
+        settings.volume = player->volumeSlider->value();
+        return settings;
+    };
+
+    // Goes through the widgets, so the dropdowns and slider show the
+    // restored choices and their handlers apply them.
+    auto applySettings = [](MpvWidget *player, const PairState::PlayerSettings &settings) {
+        int audio = player->audioCombo->findData(int(settings.audioTrack));
+        if (settings.audioTrack >= 0 && audio >= 0) player->audioCombo->setCurrentIndex(audio);
+        int sub = player->subtitleCombo->findData(int(settings.subtitleTrack));
+        if (settings.subtitleTrack >= 0 && sub >= 0) player->subtitleCombo->setCurrentIndex(sub);
+        if (settings.volume >= 0) player->volumeSlider->setValue(settings.volume);
+    };
+
+    connect(pairMemory, &PairMemory::identified, this, [=]() {
+        // A resumed session already has its exact positions and tracks
+        if (session && session->isResumedPair()) return;
+
+        PairState state;
+        if (!pairMemory->recall(state)) return;
+
+        for (int slot = 0; slot < players.size(); slot++) {
+            applySettings(players[slot], state.players[slot]);
+        }
+
+        if (!state.syncMap.isEmpty()) {
+            double offset = state.offsetAt(player1->position());
+            barrier->seekTo(group->position(), { 0.0, offset });
+            partySync->notifyLocalChange();
+        }
+    });
+
+    QTimer *pairTimer = new QTimer(this);
+    pairTimer->setInterval(2000);
+    connect(pairTimer, &QTimer::timeout, this, [=]() {
+        if (!pairMemory->hasPair() || barrier->isHolding()) return;
+        pairMemory->observe(group->position(), group->currentOffsets().value(1), !group->isPaused());
+        pairMemory->rememberSettings(playerSettings(player1), playerSettings(player2));
+    });
+    pairTimer->start();
+
+    // ------------------------------------------------------------------------
+    // File Loaded / Closed
+    // ------------------------------------------------------------------------
+    // Everything that follows a player's file, in one place. A new local
+    // file is scanned, drawn, indexed and fingerprinted in the background; a
+    // stream only gets its labels set (it would have to be downloaded a
+    // second time). Closing the file cancels that work and clears what it
+    // showed. The heatmap compares both files, so a new file in either
+    // player makes it stale.
+    // ------------------------------------------------------------------------
+    for (int slot = 0; slot < players.size(); slot++) {
+        MpvWidget *player = players[slot];
+
+        connect(player, &MpvWidget::fileLoaded, this, [=]() {
+            QString path = player->currentPath();
+
+            // The previous file's gain no longer applies
+            player->setLevelGain(0.0);
+            loudnessLabels[slot]->setToolTip(QString());
+            sceneLabels[slot]->setToolTip(QString());
+            keyframeLabels[slot]->setToolTip(QString());
+
+            if (QFileInfo(path).isFile()) {
+                loudness->analyze(slot, path);
+                waveformViews[slot]->setMessage("Building waveform...");
+                waveforms->build(slot, path);
+                scenes->analyze(slot, path);
+                keyframes->analyze(slot, path);
+                pairMemory->identify(slot, path);
+            } else {
+                QString stream = QString("P%1: n/a (stream)").arg(slot + 1);
+                loudness->cancel(slot);
+                loudnessLabels[slot]->setText(stream);
+                waveforms->cancel(slot);
+                waveformViews[slot]->setMessage("No waveform for streams");
+                scenes->cancel(slot);
+                sceneLabels[slot]->setText(stream);
+                keyframes->cancel(slot);
+                keyframeLabels[slot]->setText(stream);
+                pairMemory->forget(slot);
+            }
+
+            diffs->cancel();
+            btnDiff->setText("Compare files");
+            diffStatus->clear();
+            diffView->setMessage("Compare both files to see where they differ");
+        });
+
+        // Closed: forget the results
+        player->observeProperty("idle-active");
+        connect(player, &MpvWidget::propertyChanged, this, [=](const QString &name, const QVariant &value) {
+            if (name != "idle-active" || !value.toBool()) return;
+            QString none = QString("P%1: -").arg(slot + 1);
+
+            loudness->cancel(slot);
+            player->setLevelGain(0.0);
+            showLoudness(slot);
+            waveforms->cancel(slot);
+            waveformViews[slot]->clear();
+            scenes->cancel(slot);
+            sceneLabels[slot]->setText(none);
+            sceneLabels[slot]->setToolTip(QString());
+            keyframes->cancel(slot);
+            keyframeLabels[slot]->setText(none);
+            keyframeLabels[slot]->setToolTip(QString());
+            pairMemory->forget(slot);
+        });
+    }
+
+    // ------------------------------------------------------------------------
+    // Session Resume
+    // ------------------------------------------------------------------------
+    // The last session's files are opened once the window is up, both at
+    // once, each paused at its saved position (see sessionstore.h).
+    // ------------------------------------------------------------------------
+    session = new SessionStore(players, this);
+    QTimer::singleShot(0, this, [=]() { session->restore(); });
+
+    // ------------------------------------------------------------------------
+    // A-B Loop
+    // ------------------------------------------------------------------------
+    // The points are taken from the group time. The status shows which
+    // players already hold the whole range in their cache - from then on
+    // the wrap is seamless.
+    // ------------------------------------------------------------------------
+    GroupLoop *loop = new GroupLoop(group, barrier, this);
+
+    connect(btnLoopA, &QPushButton::clicked, this, [=]() { loop->setA(group->position()); });
+    connect(btnLoopB, &QPushButton::clicked, this, [=]() { loop->setB(group->position()); });
+    connect(btnLoopClear, &QPushButton::clicked, this, [=]() { loop->clear(); });
+
+    connect(loop, &GroupLoop::changed, this, [=]() {
+        if (loop->isActive()) {
+            QStringList cached;
+            for (int slot = 0; slot < players.size(); slot++) {
+                if (players[slot]->hasFile() && loop->isCached(slot)) cached << QString("P%1").arg(slot + 1);
+            }
+            loopStatus->setText(QString("Loop: %1 - %2, pass %3, cached: %4")
+                                    .arg(player1->formatTime(loop->a()), player1->formatTime(loop->b()))
+                                    .arg(loop->passes() + 1)
+                                    .arg(cached.isEmpty() ? QString("-") : cached.join(' ')));
+        } else if (loop->hasA()) {
+            loopStatus->setText(QString("Loop: A at %1, set B").arg(player1->formatTime(loop->a())));
+        } else if (loop->b() >= 0.0) {
+            loopStatus->setText(QString("Loop: B at %1, set A").arg(player1->formatTime(loop->b())));
+        } else {
+            loopStatus->setText("Loop: off");
+        }
+    });
+
+    // ------------------------------------------------------------------------
+    // Frame Capture
+    // ------------------------------------------------------------------------
+    // Images go to <Pictures>/mpv-watchalong. The capture pauses the group,
+    // so the watch party is told (a hosting instance pauses everyone).
+    // ------------------------------------------------------------------------
+    FrameCapture *capture = new FrameCapture(group, barrier, this);
+
+    connect(btnCapture, &QPushButton::clicked, this, [=]() {
+        if (capture->isBusy()) return;
+
+        FrameCapture::Options options;
+        options.frames = captureFrames->value();
+        options.format = captureFormat->currentData().toString();
+        options.sideBySide = captureSide->isChecked();
+        options.difference = captureDiff->isChecked();
+        options.directory = FrameCapture::defaultDirectory();
+
+        capture->capture(options);
+        partySync->notifyLocalChange();
+    });
+
+    connect(capture, &FrameCapture::progress, this, [=](int done, int total) {
+        btnCapture->setEnabled(false);
+        captureStatus->setText(QString("Capturing %1 / %2...").arg(done).arg(total));
+    });
+    connect(capture, &FrameCapture::finished, this, [=](int files, const QString &directory) {
+        btnCapture->setEnabled(true);
+        captureStatus->setText(QString("Saved %1 image(s) to %2").arg(files).arg(QDir::toNativeSeparators(directory)));
+    });
+    connect(capture, &FrameCapture::failed, this, [=](const QString &reason) {
+        btnCapture->setEnabled(true);
+        captureStatus->setText("Capture failed: " + reason);
+    });
+
+    // ------------------------------------------------------------------------
+    // Clip Export
+    // ------------------------------------------------------------------------
+    // The export runs in its own MPV instance; playback carries on. While it
+    // runs, the button cancels it.
+    // ------------------------------------------------------------------------
+    ClipExporter *exporter = new ClipExporter(this);
+
+    connect(btnSetIn, &QPushButton::clicked, this, [=]() { exportIn->setValue(group->position()); });
+    connect(btnSetOut, &QPushButton::clicked, this, [=]() { exportOut->setValue(group->position()); });
+
+    connect(btnExport, &QPushButton::clicked, this, [=]() {
+        if (exporter->isBusy()) {
+            exporter->cancel();
+            return;
+        }
+        if (!player1->hasFile() || player1->isPrefilling() || !player2->hasFile() || player2->isPrefilling()) {
+            exportStatus->setText("Load a file in both players first");
+            return;
+        }
+
+        QString suggested = ClipExporter::defaultDirectory() + "/"
+                          + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".mp4";
+        QString output = QFileDialog::getSaveFileName(this, "Export clip", suggested, "Video (*.mp4 *.mkv)");
+        if (output.isEmpty()) return;
+
+        ClipExporter::Job job;
+        job.firstPath = player1->currentPath();
+        job.secondPath = player2->currentPath();
+        job.offset = compositePlayer->isActive() ? compositePlayer->offsets().value(1)
+                                                 : group->currentOffsets().value(1);
+        job.inPoint = exportIn->value();
+        job.outPoint = exportOut->value();
+        job.layout = static_cast<ClipExporter::Layout>(exportLayout->currentData().toInt());
+        player1->getInt("aid", &job.firstAudio);
+        job.firstGain = ClipExporter::gainOf(player1);
+        job.secondGain = ClipExporter::gainOf(player2);
+        job.output = output;
+
+        if (!exporter->start(job)) {
+            exportStatus->setText(exporter->error());
+            return;
+        }
+        btnExport->setText("Cancel export");
+        exportStatus->setText("Exporting...");
+    });
+
+    connect(exporter, &ClipExporter::progress, this, [=](double fraction, double speed) {
+        exportStatus->setText(QString("Exporting %1% (%2x real time)")
+                                  .arg(qRound(fraction * 100)).arg(QString::number(speed, 'f', 1)));
+    });
+    connect(exporter, &ClipExporter::finished, this, [=](const QString &path) {
+        btnExport->setText("Export clip...");
+        exportStatus->setText("Saved " + QDir::toNativeSeparators(path));
+    });
+    connect(exporter, &ClipExporter::failed, this, [=](const QString &reason) {
+        btnExport->setText("Export clip...");
+        exportStatus->setText(reason);
+    });
+
+    // ------------------------------------------------------------------------
+    // Video Scopes
+    // ------------------------------------------------------------------------
+    // The analyzer only runs while the panel is shown. Each update redraws
+    // the views that show that player; the status shows how long a frame
+    // takes and how many ticks were skipped because one was still running.
+    // ------------------------------------------------------------------------
+    videoScopes = new ScopeAnalyzer(players, this);
+
+    auto refreshScopes = [=]() {
+        QSharedPointer<const ScopeFrame> first = videoScopes->frame(0);
+        QSharedPointer<const ScopeFrame> second = videoScopes->frame(1);
+        scope1->setFrames(first, QSharedPointer<const ScopeFrame>());
+        scope2->setFrames(second, QSharedPointer<const ScopeFrame>());
+        if (scopeOverlay->isChecked()) scopeBoth->setFrames(first, second);
+
+        QStringList parts;
+        for (int slot = 0; slot < players.size(); slot++) {
+            QSharedPointer<const ScopeFrame> frame = videoScopes->frame(slot);
+            if (!frame) continue;
+            parts << QString("P%1: %2 ms, %3 skipped").arg(slot + 1).arg(frame->computeMs).arg(videoScopes->skipped(slot));
+        }
+        scopeStatus->setText(parts.join("   "));
+    };
+
+    connect(videoScopes, &ScopeAnalyzer::updated, this, refreshScopes);
+
+    connect(scopesOn, &QCheckBox::toggled, this, [=](bool on) {
+        scopePanel->setVisible(on);
+        videoScopes->setEnabled(on);
+        if (!on) scopeStatus->clear();
+    });
+    connect(scopeRate, QOverload<int>::of(&QSpinBox::valueChanged), this, [=](int fps) {
+        videoScopes->setRate(fps);
+    });
+    connect(scopeKind, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=]() {
+        ScopeView::Kind kind = static_cast<ScopeView::Kind>(scopeKind->currentData().toInt());
+        scope1->setKind(kind);
+        scopeBoth->setKind(kind);
+        scope2->setKind(kind);
+    });
+    connect(scopeOverlay, &QCheckBox::toggled, this, [=](bool on) {
+        scopeBoth->setVisible(on);
+        if (!on) scopeBoth->setFrames(QSharedPointer<const ScopeFrame>(), QSharedPointer<const ScopeFrame>());
+        refreshScopes();
+    });
+
+    // ------------------------------------------------------------------------
+    // A/B Compare Window
+    // ------------------------------------------------------------------------
+    // A separate window, so the comparison can be as large as the screen.
+    // CompareView only grabs frames while the window is open.
+    // ------------------------------------------------------------------------
+    QWidget *compareWindow = new QWidget(this, Qt::Window);
+    compareWindow->setWindowTitle("A/B compare - mpv-watchalong");
+    QVBoxLayout *compareLayout = new QVBoxLayout(compareWindow);
+
+    QHBoxLayout *compareControls = new QHBoxLayout();
+    QComboBox *compareMode = new QComboBox();
+    compareMode->addItem("Wipe", static_cast<int>(CompareView::Wipe));
+    compareMode->addItem("Flicker (Space)", static_cast<int>(CompareView::Flicker));
+    compareMode->addItem("Blend", static_cast<int>(CompareView::Blend));
+    compareMode->addItem("Difference", static_cast<int>(CompareView::Difference));
+
+    QComboBox *compareGain = new QComboBox();
+    for (int shift = 0; shift <= 4; shift++) compareGain->addItem(QString("x%1").arg(1 << shift), shift);
+    compareGain->setCurrentIndex(2);
+    compareGain->setEnabled(false);          // Only used by Difference.
+
+    QCheckBox *compareAuto = new QCheckBox("Auto flicker");
+    compareAuto->setEnabled(false);          // Only used by Flicker.
+
+    QLabel *compareStats = new QLabel();
+    compareStats->setStyleSheet("color: #0055aa; font-family: monospace;");
+
+    compareControls->addWidget(compareMode);
+    compareControls->addWidget(compareGain);
+    compareControls->addWidget(compareAuto);
+    compareControls->addWidget(compareStats, 1);
+    compareLayout->addLayout(compareControls);
+
+    compareView = new CompareView(player1, player2);
+    compareLayout->addWidget(compareView, 1);
+
+    connect(btnCompare, &QPushButton::clicked, this, [=]() {
+        compareWindow->show();
+        compareWindow->raise();
+        compareWindow->activateWindow();
+    });
+    connect(compareMode, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=]() {
+        CompareView::Mode mode = static_cast<CompareView::Mode>(compareMode->currentData().toInt());
+        compareView->setMode(mode);
+        compareGain->setEnabled(mode == CompareView::Difference);
+        compareAuto->setEnabled(mode == CompareView::Flicker);
+        compareView->setFocus();
+    });
+    connect(compareGain, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=]() {
+        compareView->setDifferenceShift(compareGain->currentData().toInt());
+    });
+    connect(compareAuto, &QCheckBox::toggled, this, [=](bool on) {
+        compareView->setAutoFlicker(on ? 500 : 0);
+    });
+    connect(compareView, &CompareView::statsChanged, this, [=](int grabMs, int skipped) {
+        compareStats->setText(QString("grab %1 ms, %2 skipped").arg(grabMs).arg(skipped));
+    });
+
+    // ------------------------------------------------------------------------
+    // Composite Mode
+    // ------------------------------------------------------------------------
+    // Switching in hands the group's position, offset and pause state to the
+    // composite; switching back seeks both players - through the barrier -
+    // to where the composite was. While it is active the global transport
+    // controls drive the composite instead of the players.
+    // ------------------------------------------------------------------------
+    compositePlayer = new CompositePlayer(group, this);
+
+    auto resetViewMode = [=]() {
+        viewMode->blockSignals(true);
+        viewMode->setCurrentIndex(0);
+        viewMode->blockSignals(false);
+    };
+
+    connect(viewMode, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=]() {
+        int layout = viewMode->currentData().toInt();
+        if (layout < 0) {
+            if (!compositePlayer->isActive()) return;
+            double time = compositePlayer->leave();
+            barrier->seekTo(time, compositePlayer->offsets());
+            group->setPaused(compositePlayer->wasPaused());
+            partySync->notifyLocalChange();
+            return;
+        }
+        if (filterChains && filterChains->isActive()) {
+            viewStatus->setText("Switch the filter chains off first");
+            resetViewMode();
+            return;
+        }
+        if (!compositePlayer->enter(static_cast<CompositePlayer::Layout>(layout))) {
+            viewStatus->setText(compositePlayer->error());
+            resetViewMode();
+        }
+    });
+
+    connect(compositePlayer, &CompositePlayer::failed, this, [=](const QString &reason) {
+        viewStatus->setText(reason);
+        resetViewMode();
+    });
+
+    connect(compositePlayer, &CompositePlayer::costChanged, this, [=]() {
+        auto load = [&](CompositePlayer::Mode mode) {
+            double value = compositePlayer->cpuLoad(mode);
+            return value < 0.0 ? QString("-") : QString("%1%").arg(qRound(value));
+        };
+        viewStatus->setText(QString("CPU: composite %1, two players %2")
+                                .arg(load(CompositePlayer::Composite), load(CompositePlayer::Split)));
+    });
+
+    // ------------------------------------------------------------------------
+    // Filter Chains
+    // ------------------------------------------------------------------------
+    // Like composite mode, the chains take the group's position over and
+    // hand it back when switched off. Only one of the two can be active.
+    // ------------------------------------------------------------------------
+    filterChains = new FilterChains(group, this);
+
+    auto chainTexts = [=]() {
+        QStringList chains;
+        for (int i = 0; i < chainEdits.size(); i++) {
+            QString text = chainEdits[i]->text().trimmed();
+            if (i >= 2 && text.isEmpty()) break;     // C is optional.
+            chains << text;
+        }
+        return chains;
+    };
+    auto resetChainsButton = [=]() {
+        btnChains->blockSignals(true);
+        btnChains->setChecked(false);
+        btnChains->blockSignals(false);
+    };
+
+    connect(btnChains, &QPushButton::toggled, this, [=](bool on) {
+        if (!on) {
+            if (!filterChains->isActive()) return;
+            double time = filterChains->leave();
+            barrier->seekTo(time, filterChains->offsets());
+            group->setPaused(filterChains->wasPaused());
+            partySync->notifyLocalChange();
+            chainsStatus->clear();
+            return;
+        }
+        if (compositePlayer->isActive()) {
+            chainsStatus->setText("Switch the view to Split first");
+            resetChainsButton();
+            return;
+        }
+        filterChains->setView(chainsView->currentData().toInt());
+        if (!filterChains->enter(chainTexts())) {
+            chainsStatus->setText(filterChains->error());
+            resetChainsButton();
+        }
+    });
+
+    for (QLineEdit *edit : chainEdits) {
+        connect(edit, &QLineEdit::editingFinished, this, [=]() {
+            if (!filterChains->isActive()) return;
+            if (!filterChains->setChains(chainTexts())) chainsStatus->setText(filterChains->error());
+        });
+    }
+
+    connect(chainsView, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=]() {
+        filterChains->setView(chainsView->currentData().toInt());
+    });
+
+    connect(filterChains, &FilterChains::failed, this, [=](const QString &reason) {
+        chainsStatus->setText(reason);
+        if (!filterChains->isActive()) resetChainsButton();
+    });
+
+    connect(filterChains, &FilterChains::costChanged, this, [=]() {
+        QStringList parts;
+        const QStringList chains = filterChains->chains();
+        for (int i = 0; i < chains.size(); i++) {
+            double ms = filterChains->cost(i);
+            parts << QString("%1 %2").arg(QChar('A' + i))
+                         .arg(ms < 0.0 ? QString("-") : QString("%1 ms").arg(ms, 0, 'f', 1));
+        }
+        if (filterChains->isActive()) chainsStatus->setText(parts.join("  "));
+    });
+
+    // ------------------------------------------------------------------------
+    // Connect Global Controls
+    // ------------------------------------------------------------------------
+    // Global buttons affect BOTH players simultaneously. After each one we
+    // tell the watch party, so a hosting instance broadcasts the change
+    // right away (it does nothing when not hosting). The IPC server's group
+    // commands use the same functions - see seekGlobal() below.
+    // ------------------------------------------------------------------------
+
+    // Global seek - applies seek to both players (or the composite)
+    connect(gBack1m,  &QPushButton::clicked, this, [=]() { seekGlobal(-60); });
+    connect(gBack10s, &QPushButton::clicked, this, [=]() { seekGlobal(-10); });
+    connect(gFwd10s,  &QPushButton::clicked, this, [=]() { seekGlobal(10); });
+    connect(gFwd1m,   &QPushButton::clicked, this, [=]() { seekGlobal(60); });
+
+    // Global Pause / Play - sets pause on both players
+    connect(btnGlobalPause, &QPushButton::clicked, this, [=]() { setGlobalPaused(true); });
+    connect(btnGlobalPlay,  &QPushButton::clicked, this, [=]() { setGlobalPaused(false); });
+
+    // ------------------------------------------------------------------------
+    // Connect Watch Party Controls
+    // ------------------------------------------------------------------------
+
+    // The host address only matters when joining someone else's party
+    connect(partyRole, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=]() {
+        partyHost->setEnabled(partyRole->currentData().toInt() == WatchPartySync::Follower);
+    });
+
+    connect(btnParty, &QPushButton::clicked, this, [=]() {
+        // Already running - this click means "Stop"
+        if (partySync->role() != WatchPartySync::Off) {
+            partySync->stop();
+            return;
+        }
+
+        quint16 port = static_cast<quint16>(partyPort->value());
+
+        if (partyRole->currentData().toInt() == WatchPartySync::Leader) {
+            partySync->startLeader(port);
+            return;
+        }
+
+        // Accept either an IP address or a host name. Host names are looked
+        // up synchronously - fine here, it only happens once per click.
+        QHostAddress leader;
+        if (!leader.setAddress(partyHost->text().trimmed())) {
+            QHostInfo info = QHostInfo::fromName(partyHost->text().trimmed());
+            for (const QHostAddress &address : info.addresses()) {
+                if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+                    leader = address;
+                    break;
+                }
+            }
+        }
+        if (leader.isNull()) {
+            partyStatus->setText("Unknown host: " + partyHost->text());
+            return;
+        }
+        partySync->startFollower(leader, port);
+    });
+
+    // Keep the status label and the button text up to date. The role
+    // controls are locked while a party is running.
+    connect(partySync, &WatchPartySync::statusChanged, this, [=](const QString &text) {
+        bool running = partySync->role() != WatchPartySync::Off;
+        partyStatus->setText(text);
+        btnParty->setText(running ? "Stop" : "Start");
+        partyRole->setEnabled(!running);
+        partyPort->setEnabled(!running);
+        partyHost->setEnabled(!running && partyRole->currentData().toInt() == WatchPartySync::Follower);
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Destructor: MainWindow::~MainWindow
+// ----------------------------------------------------------------------------
+// Cleans up resources when the window is destroyed.
+// ----------------------------------------------------------------------------
+MainWindow::~MainWindow()
+{
+    // Leave any watch party first - it still uses the players
+    if (partySync) partySync->stop();
+
+    // Close the IPC server before the players: its client handles would
+    // otherwise keep the MPV cores alive
+    if (ipcServer) ipcServer->stop();
+
+    // The ducking thread talks to both players directly
+    if (ducker) ducker->setEnabled(false);
+
+    // Shut down both players (safe to call even if already shut down)
+    if (player1) player1->shutdown();
+    if (player2) player2->shutdown();
+
+    // Delete the UI object created in the constructor
+    delete ui;
+}
+
+// ----------------------------------------------------------------------------
+// Global Transport - the Global Buttons and the IPC Server
+// ----------------------------------------------------------------------------
+// While composite mode or the filter chains are showing, the two players
+// are paused and hidden, so the transport drives the instance on screen.
+// Otherwise it drives the group; absolute seeks go through the barrier,
+// which holds the group until both players have arrived.
+// ----------------------------------------------------------------------------
+void MainWindow::seekGlobal(double seconds) {
+    if (compositePlayer->isActive()) compositePlayer->player()->seek(seconds);
+    else if (filterChains->isActive()) filterChains->player()->seek(seconds);
+    else group->seekRelative(seconds);
+    partySync->notifyLocalChange();
+}
+
+void MainWindow::seekGlobalTo(double groupTime) {
+    if (compositePlayer->isActive()) {
+        // Group time is player 1's time - see compositeplayer.h.
+        double shift = qMax(0.0, -compositePlayer->offsets().value(1));
+        compositePlayer->player()->seekAbsolute(qMax(0.0, groupTime - shift));
+    } else if (filterChains->isActive()) {
+        filterChains->player()->seekAbsolute(groupTime);
+    } else if (group->hasMedia()) {
+        barrier->seekTo(groupTime);
+    }
+    partySync->notifyLocalChange();
+}
+
+void MainWindow::setGlobalPaused(bool paused) {
+    if (compositePlayer->isActive()) compositePlayer->player()->setPaused(paused);
+    else if (filterChains->isActive()) filterChains->player()->setPaused(paused);
+    else group->setPaused(paused);
+    partySync->notifyLocalChange();
+}
+
+// ----------------------------------------------------------------------------
+// startIpcServer() - Enable Remote Control Through a Local Socket
+// ----------------------------------------------------------------------------
+// The server thread only forwards group commands; they are applied here
+// exactly as if the Global buttons had been clicked. Speed changes go
+// through the group, which owns the nominal speed.
+// ----------------------------------------------------------------------------
+bool MainWindow::startIpcServer(const QString &name) {
+    if (!ipcServer) {
+        ipcServer = new IpcServer(this);
+        connect(ipcServer, &IpcServer::groupPauseRequested, this, &MainWindow::setGlobalPaused);
+        connect(ipcServer, &IpcServer::groupSeekRequested, this, [=](double seconds, bool relative) {
+            if (relative) seekGlobal(seconds);
+            else seekGlobalTo(seconds);
+        });
+        connect(ipcServer, &IpcServer::groupSpeedRequested, this, [=](double speed) {
+            group->setSpeed(speed);
+            partySync->notifyLocalChange();
+        });
+        ipcServer->setGroupHeld(group->isHeld());
+    }
+    return ipcServer->start(name, group->members());
+}
+
+// ----------------------------------------------------------------------------
+// closeEvent() - Handle Window Close
+// ----------------------------------------------------------------------------
+// This virtual function is called when the user tries to close the window
+// (clicking X, pressing Alt+F4, etc.). We override it to ensure clean
+// shutdown of MPV before the window is destroyed.
+//
+// Without this, the application could hang or crash because:
+//   1. Qt would destroy the window widgets
+//   2. MPV might still be rendering to those destroyed widgets
+//   3. Deadlock or crash!
+//
+// Parameter:
+//   event - Contains information about the close event. We can accept() it
+//           to allow the close, or ignore() it to prevent closing.
+// ----------------------------------------------------------------------------
+void MainWindow::closeEvent(QCloseEvent *event) {
+    // Step 0: Leave any watch party and close the IPC server, so nothing
+    // else drives the players while they shut down
+    if (partySync) partySync->stop();
+    if (ipcServer) ipcServer->stop();
+
+    // Last save of the session, while the players still have their files
+    if (session) session->stop();
+
+    // The scope and compare workers grab frames from the players - let
+    // them finish
+    if (videoScopes) videoScopes->stop();
+    if (compareView) compareView->stop();
+
+    // The ducking thread talks to both players directly
+    if (ducker) ducker->setEnabled(false);
 
-// ----------------------------------------------------------------------------
-// closeEvent() - Handle Window Close
-// ----------------------------------------------------------------------------
-// This virtual function is called when the user tries to close the window
-// (clicking X, pressing Alt+F4, etc.). We override it to ensure clean
-// shutdown of MPV before the window is destroyed.
-//
-// Without this, the application could hang or crash because:
-//   1. Qt would destroy the window widgets
-//   2. MPV might still be rendering to those destroyed widgets
-//   3. Deadlock or crash!
-//
-// Parameter:
-//   event - Contains information about the close event. We can accept() it
-//           to allow the close, or ignore() it to prevent closing.
-// ----------------------------------------------------------------------------
-void MainWindow::closeEvent(QCloseEvent *event) {
     // Step 1: Close any loaded videos (stop playback, release resources)
     if (player1) player1->closeVideo();
     if (player2) player2->closeVideo();
@@ -1114,6 +2059,8 @@ void MainWindow::closeEvent(QCloseEvent *event) {
     // Step 3: Fully shut down the MPV instances
     if (player1) player1->shutdown();
     if (player2) player2->shutdown();
+    if (compositePlayer) compositePlayer->shutdown();
+    if (filterChains) filterChains->shutdown();
 
     // Step 4: Accept the close event (allow the window to close)
     event->accept();
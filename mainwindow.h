@@ -1,5 +1,5 @@
 // ============================================================================
-// mainwindow.h - Header File for Main Window and MPV Widget Classes
+// mainwindow.h - Header File for the Main Window Class
 // ============================================================================
 // Header files in C++ declare the "interface" of classes - what methods and
 // data members they have - without providing the full implementation.
@@ -58,9 +58,13 @@
 #include <QComboBox>     // A dropdown selection widget.
 // We use it for audio and subtitle track selection.
 
-#include <mpv/client.h>  // The MPV library's C API header.
-// This gives us access to all MPV functions for video playback.
-// MPV is a powerful open-source media player/library.
+#include <QStringList>   // A list of QStrings (the observed property names).
+
+#include <QVariant>      // Holds a value of any type (observed property values).
+
+#include <QImage>        // An in-memory image (captured video frames).
+
+#include "mpvwidget.h"   // MpvWidget - one video player (see mpvwidget.h).
 
 // ----------------------------------------------------------------------------
 // Qt Namespace Declaration
@@ -76,136 +80,23 @@ QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
-// ============================================================================
-// MpvWidget Class Declaration
-// ============================================================================
-// This class wraps an MPV player instance and provides a clean interface
-// for controlling video playback. Each MpvWidget manages one video player.
-//
-// Inheritance: MpvWidget inherits from QWidget, making it a Qt widget that
-// can be placed in layouts, receive events, etc. (Though in our app, the
-// widget itself is hidden since videos play in separate MPV windows.)
-// ============================================================================
-class MpvWidget : public QWidget {
-    // The Q_OBJECT macro is REQUIRED for any class that:
-    //   - Uses signals and slots (Qt's event communication system)
-    //   - Uses Qt's meta-object features (like dynamic property access)
-    //
-    // It tells Qt's Meta-Object Compiler (moc) to generate extra code for
-    // this class. Without it, signals/slots won't work!
-    Q_OBJECT
-
-public:
-    // ------------------------------------------------------------------------
-    // Public Member Variables
-    // ------------------------------------------------------------------------
-    // Note: In production code, these would typically be private with accessor
-    // methods (getters/setters). They're public here for simplicity since the
-    // MainWindow needs direct access to update UI elements.
-    // ------------------------------------------------------------------------
-
-    mpv_handle *mpv;            // Pointer to the MPV player instance.
-    // This is MPV's main handle - all MPV API calls use this.
-    // nullptr means no player is initialized.
-
-    QLabel *statusLabel;         // Pointer to the label showing the current filename.
-    // We store this so we can update it when files load.
-
-    QLabel *timeLabel;           // Pointer to the label showing playback time.
-    // Displays "current / duration" format.
-
-    QTimer *pollTimer;           // Timer that fires periodically to update the time display.
-    // Qt timers emit a signal at set intervals.
-
-    QComboBox *subtitleCombo;    // Dropdown for selecting subtitle tracks.
-    // Populated when a video with subtitles is loaded.
-
-    QComboBox *audioCombo;       // Dropdown for selecting audio tracks.
-    // Populated when a video with multiple audio tracks is loaded.
-
-    // ------------------------------------------------------------------------
-    // Constructor and Destructor
-    // ------------------------------------------------------------------------
-
-    // Constructor: Creates and initializes the MPV player.
-    // The "explicit" keyword prevents implicit type conversions - a C++ best practice.
-    // The "parent = nullptr" is a default argument - if no parent is specified,
-    // the widget has no parent (it's a top-level widget or will be parented later).
-    explicit MpvWidget(QWidget *parent = nullptr);
-
-    // Destructor: Cleans up resources when the widget is destroyed.
-    // The ~ prefix indicates a destructor in C++.
-    // We use this to properly shut down MPV and free resources.
-    ~MpvWidget();
-
-    // ------------------------------------------------------------------------
-    // Public Methods - Video Control Interface
-    // ------------------------------------------------------------------------
-    // These methods provide a clean API for controlling the video player.
-    // They hide the complexity of MPV's C API behind simple function calls.
-    // ------------------------------------------------------------------------
-
-    void loadVideo(QString path);      // Load and start playing a video file.
-    // QString is Qt's string class - more powerful than std::string.
-
-    void closeVideo();                  // Stop playback and unload the current video.
-    // Resets the player to its initial state.
-
-    void setVolume(int value);          // Set the audio volume (0-100 scale).
-
-    void togglePause();                 // Toggle between playing and paused states.
-
-    void seek(double seconds);          // Seek forward or backward by the specified seconds.
-    // Positive = forward, negative = backward.
-
-    void shutdown();                    // Completely shut down the MPV instance.
-    // Called when closing the application.
-    // This is critical for clean app termination!
-
-    // ------------------------------------------------------------------------
-    // Subtitle Methods
-    // ------------------------------------------------------------------------
-
-    void refreshSubtitleTracks();       // Query MPV for available subtitle tracks and
-    // populate the subtitle dropdown.
-
-    void setSubtitleTrack(int index);   // Switch to the subtitle track at the given
-    // dropdown index.
-
-    void loadExternalSubtitles(QString path);  // Load a subtitle file from disk
-    // (e.g., .srt, .ass files).
-
-    // ------------------------------------------------------------------------
-    // Audio Methods
-    // ------------------------------------------------------------------------
-
-    void refreshAudioTracks();          // Query MPV for available audio tracks and
-    // populate the audio dropdown.
-
-    void setAudioTrack(int index);      // Switch to the audio track at the given
-    // dropdown index.
-
-    // ------------------------------------------------------------------------
-    // Utility Methods
-    // ------------------------------------------------------------------------
-
-    QString formatTime(double time);    // Convert seconds (e.g., 3661.5) to a
-    // human-readable string (e.g., "01:01:01").
-
-    // ------------------------------------------------------------------------
-    // Public Slots
-    // ------------------------------------------------------------------------
-    // Slots are special methods that can be connected to signals. When a signal
-    // is emitted, all connected slots are called automatically.
-    //
-    // This is Qt's implementation of the Observer pattern - it allows loose
-    // coupling between objects. The timer doesn't need to know about our widget;
-    // it just emits a signal, and Qt handles the connection.
-    // ------------------------------------------------------------------------
-public slots:
-    void onTimerTick();                 // Called every time pollTimer fires.
-    // Updates the time display with current position.
-};
+class PlayerGroup;       // Forward declarations - see playergroup.h,
+class WatchPartySync;    // watchpartysync.h, ipcserver.h and
+class IpcServer;         // bufferingbarrier.h. MainWindow only stores
+class BufferingBarrier;  // pointers.
+class LoudnessAnalyzer;  // loudnessanalyzer.h
+class AudioDucker;       // audioducker.h
+class SessionStore;      // sessionstore.h
+class WaveformBuilder;   // waveformpyramid.h
+class DiffAnalyzer;      // diffheatmap.h
+class SceneDetector;     // scenedetector.h
+class KeyframeIndexer;   // keyframeindex.h
+class SubtitleIndexer;   // subtitleindex.h
+class PairMemory;        // pairmemory.h
+class ScopeAnalyzer;     // videoscopes.h
+class CompareView;       // compareview.h
+class CompositePlayer;   // compositeplayer.h
+class FilterChains;      // filterchains.h
 
 // ============================================================================
 // MainWindow Class Declaration
@@ -229,6 +120,10 @@ public:
     // Destructor: Cleans up resources.
     ~MainWindow();
 
+    // Starts the JSON IPC control server on the given socket/pipe name
+    // (see ipcserver.h). Called from main() for --input-ipc-server.
+    bool startIpcServer(const QString &name);
+
 protected:
     // ------------------------------------------------------------------------
     // Protected Methods - Event Handlers
@@ -261,8 +156,63 @@ private:
     MpvWidget *player1;     // The first video player (left side in the UI).
     MpvWidget *player2;     // The second video player (right side in the UI).
 
+    PlayerGroup *group;         // Both players as one unit - used by all the
+    // "Global" controls.
+
+    WatchPartySync *partySync;  // Keeps this instance in step with other
+    // MPV-watchalong instances over the network.
+
+    IpcServer *ipcServer;       // Remote control for external tools, or
+    // nullptr when --input-ipc-server wasn't given.
+
+    BufferingBarrier *barrier;  // Pauses both players while either one is
+    // buffering, so they stay aligned.
+
+    LoudnessAnalyzer *loudness; // Measures each loaded file's loudness in the
+    // background, for level matching.
+
+    AudioDucker *ducker;        // Lowers player 1 while player 2's commentary
+    // is talking. Its thread uses both players, so it's stopped first.
+
+    WaveformBuilder *waveforms; // Builds the waveform strips in the background.
+
+    DiffAnalyzer *diffs;        // Frame-by-frame difference of the two files,
+    // for the heatmap under the players.
+
+    SceneDetector *scenes;      // Scene-cut index of each loaded file, for
+    // previous/next scene navigation.
+
+    KeyframeIndexer *keyframes; // Keyframe positions of each loaded file, for
+    // planning barrier seeks.
+
+    SubtitleIndexer *subtitles; // Searchable text of each player's subtitle
+    // tracks.
+
+    PairMemory *pairMemory;     // Offsets, tracks and volumes of every pair
+    // of files watched before, restored when the pair is loaded again.
+
+    SessionStore *session;      // The open files and their positions, saved
+    // continuously and resumed on the next launch.
+
+    ScopeAnalyzer *videoScopes; // Histogram/waveform/vectorscope of both
+    // players, computed while the scope panel is shown.
+
+    CompareView *compareView;   // A/B viewport in the compare window.
+
+    CompositePlayer *compositePlayer; // Both files in one MPV instance, for
+    // drift-free comparison (the "View" row).
+
+    FilterChains *filterChains; // One file, decoded once, through several
+    // filter chains side by side (the "Filters" row).
+
     bool isDarkMode;
     void applyTheme(bool dark);
+
+    // The Global transport, shared by the Global buttons and the IPC
+    // server. Each one tells the watch party afterwards.
+    void seekGlobal(double seconds);            // Relative.
+    void seekGlobalTo(double groupTime);        // Absolute, in group time.
+    void setGlobalPaused(bool paused);
 };
 
 #endif // MAINWINDOW_H  // End of include guard
@@ -0,0 +1,350 @@
+// ============================================================================
+// mediadecoder.cpp - Implementation of MediaDecoder
+// ============================================================================
+// Written against the FFmpeg 4.x - 7.x APIs. The only difference that
+// matters here is the channel layout API, which was replaced in FFmpeg 5.1
+// (and the old one removed in 7.0).
+// ============================================================================
+
+#include "mediadecoder.h"
+
+#ifdef HAVE_LIBAV
+extern "C" {                         // FFmpeg is a C library.
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
+#include <libswresample/swresample.h>
+}
+
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+#define WA_AV_CH_LAYOUT 1            // AVChannelLayout (FFmpeg 5.1+)
+#endif
+#endif
+
+// ----------------------------------------------------------------------------
+// Private Data
+// ----------------------------------------------------------------------------
+struct MediaDecoder::Private {
+    QString error;
+    int sampleRate = 0;
+    int channels = 0;
+    double duration = 0.0;
+
+#ifdef HAVE_LIBAV
+    AVFormatContext *format = nullptr;
+    AVCodecContext *codec = nullptr;
+    SwrContext *resampler = nullptr;     // Created at the first frame.
+    AVPacket *packet = nullptr;
+    AVFrame *frame = nullptr;
+    int stream = -1;
+    double startOffset = 0.0;            // Container start time, seconds.
+    bool draining = false;               // End of file - only buffered frames left.
+
+    // What the resampler was set up for; a change mid-file (it happens with
+    // some broadcast recordings) needs a new one.
+    int inFormat = -1;
+    int inRate = 0;
+    int inChannels = 0;
+
+    bool setupResampler(const AVFrame *f);
+    int convert(const AVFrame *f, QVector<float> &out, double &startTime);
+#endif
+};
+
+#ifdef HAVE_LIBAV
+static QString avError(int code) {
+    char text[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(code, text, sizeof(text));
+    return QString::fromUtf8(text);
+}
+
+static int frameChannels(const AVFrame *f) {
+#ifdef WA_AV_CH_LAYOUT
+    return f->ch_layout.nb_channels;
+#else
+    return f->channels;
+#endif
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+MediaDecoder::MediaDecoder() : d(new Private) {
+}
+
+MediaDecoder::~MediaDecoder() {
+    close();
+    delete d;
+}
+
+bool MediaDecoder::isAvailable() {
+#ifdef HAVE_LIBAV
+    return true;
+#else
+    return false;
+#endif
+}
+
+int MediaDecoder::channels() const      { return d->channels; }
+int MediaDecoder::sampleRate() const    { return d->sampleRate; }
+double MediaDecoder::duration() const   { return d->duration; }
+QString MediaDecoder::errorString() const { return d->error; }
+
+// ----------------------------------------------------------------------------
+// open()
+// ----------------------------------------------------------------------------
+// Every stream except the chosen audio one is set to AVDISCARD_ALL, so the
+// demuxer drops video and subtitle packets without handing them to us.
+// The codec runs single-threaded: analyzers already run one decoder per
+// core.
+// ----------------------------------------------------------------------------
+bool MediaDecoder::open(const QString &path, int sampleRate, int maxChannels) {
+    close();
+
+#ifndef HAVE_LIBAV
+    Q_UNUSED(path);
+    Q_UNUSED(sampleRate);
+    Q_UNUSED(maxChannels);
+    d->error = "Built without libav - audio analysis is unavailable";
+    return false;
+#else
+    QByteArray file = path.toUtf8();
+    int r = avformat_open_input(&d->format, file.constData(), nullptr, nullptr);
+    if (r < 0) {
+        d->error = "Can't open file: " + avError(r);
+        return false;
+    }
+    r = avformat_find_stream_info(d->format, nullptr);
+    if (r < 0) {
+        d->error = "Can't read stream info: " + avError(r);
+        close();
+        return false;
+    }
+
+    d->stream = av_find_best_stream(d->format, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (d->stream < 0) {
+        d->error = "No audio stream";
+        close();
+        return false;
+    }
+    for (unsigned i = 0; i < d->format->nb_streams; i++) {
+        if (static_cast<int>(i) != d->stream) d->format->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    AVStream *st = d->format->streams[d->stream];
+    const AVCodec *decoder = avcodec_find_decoder(st->codecpar->codec_id);
+    if (!decoder) {
+        d->error = "No decoder for the audio stream";
+        close();
+        return false;
+    }
+
+    d->codec = avcodec_alloc_context3(decoder);
+    avcodec_parameters_to_context(d->codec, st->codecpar);
+    d->codec->pkt_timebase = st->time_base;
+    d->codec->thread_count = 1;
+    r = avcodec_open2(d->codec, decoder, nullptr);
+    if (r < 0) {
+        d->error = "Can't open the audio decoder: " + avError(r);
+        close();
+        return false;
+    }
+
+#ifdef WA_AV_CH_LAYOUT
+    int sourceChannels = st->codecpar->ch_layout.nb_channels;
+#else
+    int sourceChannels = st->codecpar->channels;
+#endif
+    d->channels = (sourceChannels >= 2 && maxChannels >= 2) ? 2 : 1;
+    d->sampleRate = sampleRate;
+
+    if (d->format->start_time != AV_NOPTS_VALUE) {
+        d->startOffset = d->format->start_time / static_cast<double>(AV_TIME_BASE);
+    }
+    if (d->format->duration != AV_NOPTS_VALUE && d->format->duration > 0) {
+        d->duration = d->format->duration / static_cast<double>(AV_TIME_BASE);
+    } else if (st->duration != AV_NOPTS_VALUE && st->duration > 0) {
+        d->duration = st->duration * av_q2d(st->time_base);
+    }
+
+    d->packet = av_packet_alloc();
+    d->frame = av_frame_alloc();
+    d->error.clear();
+    return true;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// close()
+// ----------------------------------------------------------------------------
+void MediaDecoder::close() {
+#ifdef HAVE_LIBAV
+    swr_free(&d->resampler);
+    av_frame_free(&d->frame);
+    av_packet_free(&d->packet);
+    avcodec_free_context(&d->codec);
+    avformat_close_input(&d->format);
+    d->stream = -1;
+    d->startOffset = 0.0;
+    d->draining = false;
+    d->inFormat = -1;
+#endif
+    d->channels = 0;
+    d->duration = 0.0;
+}
+
+// ----------------------------------------------------------------------------
+// seek()
+// ----------------------------------------------------------------------------
+// Seeking in AV_TIME_BASE units (stream index -1) lets libavformat pick the
+// best stream to seek on. The resampler is thrown away along with the
+// decoder's buffers, so no audio from before the seek leaks through.
+// ----------------------------------------------------------------------------
+bool MediaDecoder::seek(double seconds) {
+#ifndef HAVE_LIBAV
+    Q_UNUSED(seconds);
+    return false;
+#else
+    if (!d->codec) return false;
+
+    int64_t target = static_cast<int64_t>((seconds + d->startOffset) * AV_TIME_BASE);
+    if (av_seek_frame(d->format, -1, target, AVSEEK_FLAG_BACKWARD) < 0) return false;
+
+    avcodec_flush_buffers(d->codec);
+    swr_free(&d->resampler);
+    d->inFormat = -1;
+    d->draining = false;
+    return true;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// decode() - Standard send_packet / receive_frame Loop
+// ----------------------------------------------------------------------------
+// A packet the decoder rejects is skipped, as a player would do; only
+// errors from the decoder's output end the stream.
+// ----------------------------------------------------------------------------
+int MediaDecoder::decode(QVector<float> &out, double &startTime) {
+    startTime = -1.0;
+
+#ifndef HAVE_LIBAV
+    Q_UNUSED(out);
+    return -1;
+#else
+    if (!d->codec) return -1;
+
+    for (;;) {
+        int r = avcodec_receive_frame(d->codec, d->frame);
+        if (r == 0) {
+            int frames = d->convert(d->frame, out, startTime);
+            av_frame_unref(d->frame);
+            if (frames != 0) return frames;
+            continue;                               // Resampler is still priming.
+        }
+        if (r == AVERROR_EOF) return 0;
+        if (r != AVERROR(EAGAIN)) {
+            d->error = "Decoding failed: " + avError(r);
+            return -1;
+        }
+        if (d->draining) return 0;
+
+        r = av_read_frame(d->format, d->packet);
+        if (r < 0) {
+            // End of file (a read error is treated the same way): flush
+            // the frames the decoder is still holding.
+            d->draining = true;
+            avcodec_send_packet(d->codec, nullptr);
+            continue;
+        }
+        if (d->packet->stream_index == d->stream) {
+            avcodec_send_packet(d->codec, d->packet);
+        }
+        av_packet_unref(d->packet);
+    }
+#endif
+}
+
+#ifdef HAVE_LIBAV
+// ----------------------------------------------------------------------------
+// Private::setupResampler()
+// ----------------------------------------------------------------------------
+// Frames without a real channel layout ("unspecified order") get the
+// default layout for their channel count, so the downmix still works.
+// ----------------------------------------------------------------------------
+bool MediaDecoder::Private::setupResampler(const AVFrame *f) {
+    swr_free(&resampler);
+
+#ifdef WA_AV_CH_LAYOUT
+    AVChannelLayout outLayout;
+    AVChannelLayout inLayout;
+    av_channel_layout_default(&outLayout, channels);
+    if (f->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
+        av_channel_layout_default(&inLayout, f->ch_layout.nb_channels);
+    } else {
+        av_channel_layout_copy(&inLayout, &f->ch_layout);
+    }
+    int r = swr_alloc_set_opts2(&resampler, &outLayout, AV_SAMPLE_FMT_FLT, sampleRate,
+                                &inLayout, static_cast<AVSampleFormat>(f->format), f->sample_rate,
+                                0, nullptr);
+    av_channel_layout_uninit(&inLayout);
+    av_channel_layout_uninit(&outLayout);
+    if (r < 0) return false;
+#else
+    int64_t inLayout = f->channel_layout ? static_cast<int64_t>(f->channel_layout)
+                                         : av_get_default_channel_layout(f->channels);
+    resampler = swr_alloc_set_opts(nullptr, av_get_default_channel_layout(channels), AV_SAMPLE_FMT_FLT, sampleRate,
+                                   inLayout, static_cast<AVSampleFormat>(f->format), f->sample_rate,
+                                   0, nullptr);
+    if (!resampler) return false;
+#endif
+
+    if (swr_init(resampler) < 0) {
+        swr_free(&resampler);
+        return false;
+    }
+    inFormat = f->format;
+    inRate = f->sample_rate;
+    inChannels = frameChannels(f);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Private::convert() - Resample One Frame and Append It
+// ----------------------------------------------------------------------------
+// The resampler holds back a few samples; its delay is subtracted so that
+// startTime belongs to the first sample actually returned.
+// ----------------------------------------------------------------------------
+int MediaDecoder::Private::convert(const AVFrame *f, QVector<float> &out, double &startTime) {
+    if (!resampler || f->format != inFormat || f->sample_rate != inRate || frameChannels(f) != inChannels) {
+        if (!setupResampler(f)) {
+            error = "Can't convert the audio format";
+            return -1;
+        }
+    }
+
+    int64_t delay = swr_get_delay(resampler, sampleRate);
+    int capacity = swr_get_out_samples(resampler, f->nb_samples);
+    if (capacity <= 0) return 0;
+
+    int old = out.size();
+    out.resize(old + capacity * channels);
+    uint8_t *dst = reinterpret_cast<uint8_t *>(out.data() + old);
+
+    int frames = swr_convert(resampler, &dst, capacity,
+                             const_cast<const uint8_t **>(f->extended_data), f->nb_samples);
+    if (frames < 0) {
+        out.resize(old);
+        error = "Resampling failed: " + avError(frames);
+        return -1;
+    }
+    out.resize(old + frames * channels);
+
+    if (frames > 0 && f->best_effort_timestamp != AV_NOPTS_VALUE) {
+        double pts = f->best_effort_timestamp * av_q2d(format->streams[stream]->time_base);
+        startTime = pts - startOffset - delay / static_cast<double>(sampleRate);
+        if (startTime < 0.0) startTime = 0.0;
+    }
+    return frames;
+}
+#endif
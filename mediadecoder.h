@@ -0,0 +1,64 @@
+// ============================================================================
+// mediadecoder.h - Decode a File's Audio to Float Samples (via libav*)
+// ============================================================================
+// MPV decodes audio for playback, but offers no way to get at the samples.
+// The background analyzers therefore decode the file a second time, directly
+// with FFmpeg's libraries (libavformat, libavcodec, libswresample) - the same
+// libraries MPV itself is built on.
+//
+// The decoder only touches the best audio stream; all other streams are
+// discarded by the demuxer, so a movie's video isn't decoded at all. Output
+// is interleaved float at a fixed sample rate, mono or stereo (anything
+// with more channels is downmixed to stereo).
+//
+// libav is optional: without it (HAVE_LIBAV not defined) open() always fails
+// and the analysis features report themselves as unavailable.
+//
+// A MediaDecoder is not thread-safe, but several decoders may work on the
+// same file in different threads - that's how analyzers split a long file
+// into segments.
+// ============================================================================
+
+#ifndef MEDIADECODER_H
+#define MEDIADECODER_H
+
+#include <QString>
+#include <QVector>
+
+class MediaDecoder {
+public:
+    MediaDecoder();
+    ~MediaDecoder();
+
+    static bool isAvailable();              // False when built without libav.
+
+    // Opens the file and sets up conversion to `sampleRate` Hz and at most
+    // `maxChannels` channels (1 or 2). Returns false on failure - see
+    // errorString().
+    bool open(const QString &path, int sampleRate, int maxChannels);
+    void close();
+
+    int channels() const;                   // Output channels (1 or 2).
+    int sampleRate() const;
+    double duration() const;                // Seconds, or 0 if unknown.
+    QString errorString() const;
+
+    // Jumps to the last point at or before `seconds` the demuxer can start
+    // from. The exact position comes back from the next decode().
+    bool seek(double seconds);
+
+    // Decodes the next chunk of audio and APPENDS it to `out` (interleaved).
+    // `startTime` receives the chunk's position in seconds, or a negative
+    // value if the file doesn't say. Returns the number of frames added,
+    // 0 at the end of the file, -1 on error.
+    int decode(QVector<float> &out, double &startTime);
+
+private:
+    MediaDecoder(const MediaDecoder &) = delete;
+    MediaDecoder &operator=(const MediaDecoder &) = delete;
+
+    struct Private;                         // libav types stay out of this header.
+    Private *d;
+};
+
+#endif // MEDIADECODER_H
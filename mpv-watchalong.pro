@@ -19,8 +19,9 @@
 #   - core: Core non-GUI classes (QString, QFile, etc.)
 #   - gui: Base GUI functionality (colors, fonts, images)
 #   - widgets: UI widgets (buttons, labels, layouts, etc.)
+#   - network: UDP/TCP and local sockets (watch party sync, IPC server)
 # ------------------------------------------------------------------------------
-QT       += core gui widgets
+QT       += core gui widgets network
 
 # ------------------------------------------------------------------------------
 # Build Configuration
@@ -49,7 +50,50 @@ TARGET = MPV-watchalong
 # ------------------------------------------------------------------------------
 SOURCES += \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    analysiscache.cpp \
+    audioducker.cpp \
+    audiolatency.cpp \
+    backgroundanalysis.cpp \
+    bufferingbarrier.cpp \
+    clipexporter.cpp \
+    compareview.cpp \
+    compositeplayer.cpp \
+    diffheatmap.cpp \
+    diffheatmapview.cpp \
+    driftcontroller.cpp \
+    fakebackend.cpp \
+    fileidentity.cpp \
+    filterchains.cpp \
+    framecapture.cpp \
+    framedecoder.cpp \
+    grouploop.cpp \
+    instrumentedbackend.cpp \
+    ipcserver.cpp \
+    keyframeindex.cpp \
+    loudnessanalyzer.cpp \
+    mediadecoder.cpp \
+    mpvbackend.cpp \
+    mpvhelpers.cpp \
+    mpvwidget.cpp \
+    openurldialog.cpp \
+    pairmemory.cpp \
+    playerbackend.cpp \
+    playergroup.cpp \
+    playerhost.cpp \
+    remotebackend.cpp \
+    scenedetector.cpp \
+    scopeview.cpp \
+    sessionstore.cpp \
+    sharedring.cpp \
+    simdkernels.cpp \
+    subtitledecoder.cpp \
+    subtitleindex.cpp \
+    videoscopes.cpp \
+    voprobe.cpp \
+    waveformpyramid.cpp \
+    waveformview.cpp \
+    watchpartysync.cpp
 
 # ------------------------------------------------------------------------------
 # Header Files
@@ -58,7 +102,50 @@ SOURCES += \
 # Qt's MOC (Meta-Object Compiler) processes headers with Q_OBJECT macro.
 # ------------------------------------------------------------------------------
 HEADERS += \
-    mainwindow.h
+    mainwindow.h \
+    analysiscache.h \
+    audioducker.h \
+    audiolatency.h \
+    backgroundanalysis.h \
+    bufferingbarrier.h \
+    clipexporter.h \
+    compareview.h \
+    compositeplayer.h \
+    diffheatmap.h \
+    diffheatmapview.h \
+    driftcontroller.h \
+    fakebackend.h \
+    fileidentity.h \
+    filterchains.h \
+    framecapture.h \
+    framedecoder.h \
+    grouploop.h \
+    instrumentedbackend.h \
+    ipcserver.h \
+    keyframeindex.h \
+    loudnessanalyzer.h \
+    mediadecoder.h \
+    mpvbackend.h \
+    mpvhelpers.h \
+    mpvwidget.h \
+    openurldialog.h \
+    pairmemory.h \
+    playerbackend.h \
+    playergroup.h \
+    playerhost.h \
+    remotebackend.h \
+    scenedetector.h \
+    scopeview.h \
+    sessionstore.h \
+    sharedring.h \
+    simdkernels.h \
+    subtitledecoder.h \
+    subtitleindex.h \
+    videoscopes.h \
+    voprobe.h \
+    waveformpyramid.h \
+    waveformview.h \
+    watchpartysync.h
 
 # ------------------------------------------------------------------------------
 # UI Form Files
@@ -184,6 +271,38 @@ unix:!macx {
     PKGCONFIG += mpv
 }
 
+# ------------------------------------------------------------------------------
+# FFmpeg Libraries (Optional - Background Media Analysis)
+# ------------------------------------------------------------------------------
+# The background analyzers (loudness, waveform, scene cuts) decode files
+# with FFmpeg's libraries directly. When they're found, HAVE_LIBAV is defined
+# and the analysis features switch on; otherwise the app builds without them.
+# On Windows, point FFMPEG_PATH at an FFmpeg "shared" dev build to enable
+# them.
+# ------------------------------------------------------------------------------
+macx {
+    exists(/opt/homebrew/include/libavformat/avformat.h) {
+        DEFINES += HAVE_LIBAV
+        LIBS += -lavformat -lavcodec -lavutil -lswresample
+    }
+}
+
+win32 {
+    FFMPEG_PATH = C:/ffmpeg-dev
+    exists($$FFMPEG_PATH/include/libavformat/avformat.h) {
+        DEFINES += HAVE_LIBAV
+        INCLUDEPATH += $$FFMPEG_PATH/include
+        LIBS += -L$$FFMPEG_PATH/lib -lavformat -lavcodec -lavutil -lswresample
+    }
+}
+
+unix:!macx {
+    packagesExist(libavformat libavcodec libavutil libswresample) {
+        DEFINES += HAVE_LIBAV
+        PKGCONFIG += libavformat libavcodec libavutil libswresample
+    }
+}
+
 # ==============================================================================
 # ICON FILE SETUP INSTRUCTIONS
 # ==============================================================================
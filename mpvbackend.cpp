@@ -0,0 +1,206 @@
+// ============================================================================
+// mpvbackend.cpp - Implementation of MpvBackend
+// ============================================================================
+
+#include "mpvbackend.h"
+#include "mpvhelpers.h"          // mpv_node <-> QVariant
+
+#include <mpv/client.h>
+
+MpvBackend::MpvBackend() : mpv(mpv_create()) {}
+
+MpvBackend::~MpvBackend() {
+    if (mpv) mpv_destroy(mpv);
+}
+
+bool MpvBackend::isValid() const {
+    return mpv != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// Setup
+// ----------------------------------------------------------------------------
+int MpvBackend::setOption(const char *name, const char *value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_set_option_string(mpv, name, value);
+}
+
+int MpvBackend::initialize() {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_initialize(mpv);
+}
+
+void MpvBackend::setWakeupCallback(void (*callback)(void *ctx), void *ctx) {
+    if (mpv) mpv_set_wakeup_callback(mpv, callback, ctx);
+}
+
+// ----------------------------------------------------------------------------
+// Commands
+// ----------------------------------------------------------------------------
+int MpvBackend::command(const char **args) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_command(mpv, args);
+}
+
+int MpvBackend::commandAsync(quint64 id, const char **args) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_command_async(mpv, id, args);
+}
+
+int MpvBackend::commandNode(const QVariant &args, QVariant *result) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+
+    MpvHelpers::NodeBuilder node(args);
+    mpv_node reply;
+    int error = mpv_command_node(mpv, node.node(), &reply);
+    if (error < 0) return error;
+    if (result) *result = MpvHelpers::nodeToVariant(&reply);
+    mpv_free_node_contents(&reply);
+    return error;
+}
+
+// ----------------------------------------------------------------------------
+// Properties
+// ----------------------------------------------------------------------------
+// mpv writes the output only on success, which is what the interface
+// promises - except for flags, which go through an int.
+// ----------------------------------------------------------------------------
+int MpvBackend::getDouble(const char *name, double *value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_get_property(mpv, name, MPV_FORMAT_DOUBLE, value);
+}
+
+int MpvBackend::getInt(const char *name, qint64 *value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    int64_t result = 0;
+    int error = mpv_get_property(mpv, name, MPV_FORMAT_INT64, &result);
+    if (error >= 0) *value = result;
+    return error;
+}
+
+int MpvBackend::getFlag(const char *name, bool *value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    int flag = 0;
+    int error = mpv_get_property(mpv, name, MPV_FORMAT_FLAG, &flag);
+    if (error >= 0) *value = flag != 0;
+    return error;
+}
+
+int MpvBackend::getString(const char *name, QString *value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    char *text = nullptr;
+    int error = mpv_get_property(mpv, name, MPV_FORMAT_STRING, &text);
+    if (error < 0) return error;
+    *value = QString::fromUtf8(text);
+    mpv_free(text);                           // Strings from MPV must be freed by MPV.
+    return error;
+}
+
+int MpvBackend::getNode(const char *name, QVariant *value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    mpv_node node;
+    int error = mpv_get_property(mpv, name, MPV_FORMAT_NODE, &node);
+    if (error < 0) return error;
+    *value = MpvHelpers::nodeToVariant(&node);
+    mpv_free_node_contents(&node);
+    return error;
+}
+
+int MpvBackend::setDouble(const char *name, double value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_set_property(mpv, name, MPV_FORMAT_DOUBLE, &value);
+}
+
+int MpvBackend::setInt(const char *name, qint64 value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    int64_t number = value;
+    return mpv_set_property(mpv, name, MPV_FORMAT_INT64, &number);
+}
+
+int MpvBackend::setFlag(const char *name, bool value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    int flag = value ? 1 : 0;
+    return mpv_set_property(mpv, name, MPV_FORMAT_FLAG, &flag);
+}
+
+int MpvBackend::setString(const char *name, const char *value) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_set_property_string(mpv, name, value);
+}
+
+int MpvBackend::observeProperty(quint64 id, const char *name) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_observe_property(mpv, id, name, MPV_FORMAT_NODE);
+}
+
+int MpvBackend::requestLogMessages(const char *minLevel) {
+    if (!mpv) return MPV_ERROR_UNINITIALIZED;
+    return mpv_request_log_messages(mpv, minLevel);
+}
+
+// ----------------------------------------------------------------------------
+// waitEvent() - Copy the Next mpv_event
+// ----------------------------------------------------------------------------
+PlayerEvent MpvBackend::waitEvent(double timeout) {
+    PlayerEvent result;
+    if (!mpv) return result;
+
+    mpv_event *event = mpv_wait_event(mpv, timeout);
+    result.id = event->reply_userdata;
+    result.error = event->error;
+
+    switch (event->event_id) {
+    case MPV_EVENT_NONE:
+        break;
+    case MPV_EVENT_PROPERTY_CHANGE: {
+        mpv_event_property *prop = static_cast<mpv_event_property *>(event->data);
+        result.type = PlayerEvent::PropertyChange;
+        result.name = QString::fromUtf8(prop->name);
+        if (prop->format == MPV_FORMAT_NODE) {
+            result.value = MpvHelpers::nodeToVariant(static_cast<mpv_node *>(prop->data));
+        }
+        break;
+    }
+    case MPV_EVENT_FILE_LOADED:
+        result.type = PlayerEvent::FileLoaded;
+        break;
+    case MPV_EVENT_PLAYBACK_RESTART:
+        result.type = PlayerEvent::PlaybackRestart;
+        break;
+    case MPV_EVENT_END_FILE: {
+        mpv_event_end_file *end = static_cast<mpv_event_end_file *>(event->data);
+        result.type = PlayerEvent::EndFile;
+        result.endReason = end->reason;
+        if (end->reason == MPV_END_FILE_REASON_ERROR) result.error = end->error;
+        break;
+    }
+    case MPV_EVENT_SHUTDOWN:
+        result.type = PlayerEvent::Shutdown;
+        break;
+    case MPV_EVENT_LOG_MESSAGE: {
+        mpv_event_log_message *msg = static_cast<mpv_event_log_message *>(event->data);
+        result.type = PlayerEvent::LogMessage;
+        result.name = QString::fromUtf8(msg->prefix);
+        result.value = QString::fromUtf8(msg->text).trimmed();
+        break;
+    }
+    default:
+        result.type = PlayerEvent::Other;
+        break;
+    }
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// terminate() / createClient()
+// ----------------------------------------------------------------------------
+bool MpvBackend::terminate() {
+    if (!mpv) return false;
+    mpv_terminate_destroy(mpv);
+    mpv = nullptr;
+    return true;
+}
+
+mpv_handle *MpvBackend::createClient(const char *name) {
+    return mpv ? mpv_create_client(mpv, name) : nullptr;
+}
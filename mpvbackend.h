@@ -0,0 +1,51 @@
+// ============================================================================
+// mpvbackend.h - PlayerBackend on Top of libmpv
+// ============================================================================
+// A direct translation: each function is one libmpv call, plus the
+// mpv_node <-> QVariant conversion (MpvHelpers) where structured values
+// are involved. Owns the mpv_handle.
+// ============================================================================
+
+#ifndef MPVBACKEND_H
+#define MPVBACKEND_H
+
+#include "playerbackend.h"
+
+class MpvBackend : public PlayerBackend {
+public:
+    MpvBackend();                             // mpv_create()
+    ~MpvBackend() override;                   // mpv_destroy()
+
+    bool isValid() const override;
+
+    int setOption(const char *name, const char *value) override;
+    int initialize() override;
+    void setWakeupCallback(void (*callback)(void *ctx), void *ctx) override;
+
+    int command(const char **args) override;
+    int commandAsync(quint64 id, const char **args) override;
+    int commandNode(const QVariant &args, QVariant *result = nullptr) override;
+
+    int getDouble(const char *name, double *value) override;
+    int getInt(const char *name, qint64 *value) override;
+    int getFlag(const char *name, bool *value) override;
+    int getString(const char *name, QString *value) override;
+    int getNode(const char *name, QVariant *value) override;
+
+    int setDouble(const char *name, double value) override;
+    int setInt(const char *name, qint64 value) override;
+    int setFlag(const char *name, bool value) override;
+    int setString(const char *name, const char *value) override;
+
+    int observeProperty(quint64 id, const char *name) override;
+    int requestLogMessages(const char *minLevel) override;
+
+    PlayerEvent waitEvent(double timeout) override;
+    bool terminate() override;
+    mpv_handle *createClient(const char *name) override;
+
+private:
+    mpv_handle *mpv;
+};
+
+#endif // MPVBACKEND_H
@@ -0,0 +1,171 @@
+// ============================================================================
+// mpvhelpers.cpp - Implementation of the mpv_node <-> QVariant Helpers
+// ============================================================================
+
+#include "mpvhelpers.h"
+
+#include <QStringList>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include <cstring>       // memcpy
+
+namespace MpvHelpers {
+
+// ----------------------------------------------------------------------------
+// nodeToVariant()
+// ----------------------------------------------------------------------------
+QVariant nodeToVariant(const mpv_node *node) {
+    if (!node) return QVariant();
+
+    switch (node->format) {
+    case MPV_FORMAT_STRING:
+        return QString::fromUtf8(node->u.string);
+    case MPV_FORMAT_FLAG:
+        return node->u.flag != 0;
+    case MPV_FORMAT_INT64:
+        return static_cast<qlonglong>(node->u.int64);
+    case MPV_FORMAT_DOUBLE:
+        return node->u.double_;
+    case MPV_FORMAT_NODE_ARRAY: {
+        QVariantList list;
+        for (int i = 0; i < node->u.list->num; i++) {
+            list.append(nodeToVariant(&node->u.list->values[i]));
+        }
+        return list;
+    }
+    case MPV_FORMAT_NODE_MAP: {
+        QVariantMap map;
+        for (int i = 0; i < node->u.list->num; i++) {
+            map.insert(QString::fromUtf8(node->u.list->keys[i]),
+                       nodeToVariant(&node->u.list->values[i]));
+        }
+        return map;
+    }
+    case MPV_FORMAT_BYTE_ARRAY:
+        return QByteArray(static_cast<const char *>(node->u.ba->data),
+                          static_cast<int>(node->u.ba->size));
+    default:
+        return QVariant();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// NodeBuilder
+// ----------------------------------------------------------------------------
+NodeBuilder::NodeBuilder(const QVariant &value) {
+    build(&root, value);
+}
+
+NodeBuilder::~NodeBuilder() {
+    release(&root);
+}
+
+mpv_node *NodeBuilder::node() {
+    return &root;
+}
+
+char *NodeBuilder::copyString(const QString &text) {
+    QByteArray bytes = text.toUtf8();
+    char *copy = new char[bytes.size() + 1];
+    memcpy(copy, bytes.constData(), bytes.size() + 1);   // +1 copies the '\0'
+    return copy;
+}
+
+// ----------------------------------------------------------------------------
+// build() - Recursively Convert One Value
+// ----------------------------------------------------------------------------
+// Numbers coming from JSON are always doubles. MPV converts them to integer
+// options itself (e.g. "sid": 2.0 selects track 2), so no guessing is done
+// here.
+// ----------------------------------------------------------------------------
+void NodeBuilder::build(mpv_node *dst, const QVariant &src) {
+    memset(dst, 0, sizeof(*dst));
+    dst->format = MPV_FORMAT_NONE;
+
+    if (!src.isValid() || src.userType() == QMetaType::Nullptr) return;
+
+    switch (src.userType()) {
+    case QMetaType::Bool:
+        dst->format = MPV_FORMAT_FLAG;
+        dst->u.flag = src.toBool() ? 1 : 0;
+        return;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        dst->format = MPV_FORMAT_INT64;
+        dst->u.int64 = src.toLongLong();
+        return;
+    case QMetaType::Float:
+    case QMetaType::Double:
+        dst->format = MPV_FORMAT_DOUBLE;
+        dst->u.double_ = src.toDouble();
+        return;
+    case QMetaType::QVariantList:
+    case QMetaType::QStringList: {
+        QVariantList items = src.toList();
+        mpv_node_list *list = new mpv_node_list;
+        list->num = items.size();
+        list->values = new mpv_node[items.size()];
+        list->keys = nullptr;
+        for (int i = 0; i < items.size(); i++) {
+            build(&list->values[i], items[i]);
+        }
+        dst->format = MPV_FORMAT_NODE_ARRAY;
+        dst->u.list = list;
+        return;
+    }
+    case QMetaType::QVariantMap:
+    case QMetaType::QVariantHash: {
+        QVariantMap items = src.toMap();
+        mpv_node_list *list = new mpv_node_list;
+        list->num = items.size();
+        list->values = new mpv_node[items.size()];
+        list->keys = new char *[items.size()];
+        int i = 0;
+        for (auto it = items.constBegin(); it != items.constEnd(); ++it, ++i) {
+            list->keys[i] = copyString(it.key());
+            build(&list->values[i], it.value());
+        }
+        dst->format = MPV_FORMAT_NODE_MAP;
+        dst->u.list = list;
+        return;
+    }
+    default:
+        // Strings, and anything else that can be printed (QUrl, QByteArray...)
+        if (src.canConvert<QString>()) {
+            dst->format = MPV_FORMAT_STRING;
+            dst->u.string = copyString(src.toString());
+        }
+        return;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// release() - Free Everything build() Allocated
+// ----------------------------------------------------------------------------
+void NodeBuilder::release(mpv_node *node) {
+    switch (node->format) {
+    case MPV_FORMAT_STRING:
+        delete[] node->u.string;
+        break;
+    case MPV_FORMAT_NODE_ARRAY:
+    case MPV_FORMAT_NODE_MAP: {
+        mpv_node_list *list = node->u.list;
+        for (int i = 0; i < list->num; i++) {
+            release(&list->values[i]);
+            if (list->keys) delete[] list->keys[i];
+        }
+        delete[] list->values;
+        delete[] list->keys;
+        delete list;
+        break;
+    }
+    default:
+        break;
+    }
+    node->format = MPV_FORMAT_NONE;
+}
+
+} // namespace MpvHelpers
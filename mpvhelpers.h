@@ -0,0 +1,67 @@
+// ============================================================================
+// mpvhelpers.h - Conversions Between mpv_node and QVariant
+// ============================================================================
+// MPV represents structured values (track lists, command arguments, command
+// results) as mpv_node trees. Qt represents the same kind of data as
+// QVariant / QVariantList / QVariantMap, which also convert directly to and
+// from JSON. These helpers translate between the two worlds so callers
+// don't have to walk mpv_node unions by hand.
+// ============================================================================
+
+#ifndef MPVHELPERS_H
+#define MPVHELPERS_H
+
+#include <QVariant>      // Qt's "can hold any type" value class.
+
+#include <mpv/client.h>  // mpv_node and MPV_FORMAT_* constants.
+
+namespace MpvHelpers {
+
+// ----------------------------------------------------------------------------
+// nodeToVariant() - mpv_node -> QVariant
+// ----------------------------------------------------------------------------
+// Makes a deep copy, so the node can be freed right afterwards.
+//
+//   MPV_FORMAT_STRING      -> QString
+//   MPV_FORMAT_FLAG        -> bool
+//   MPV_FORMAT_INT64       -> qlonglong
+//   MPV_FORMAT_DOUBLE      -> double
+//   MPV_FORMAT_NODE_ARRAY  -> QVariantList
+//   MPV_FORMAT_NODE_MAP    -> QVariantMap
+//   MPV_FORMAT_BYTE_ARRAY  -> QByteArray
+//   anything else          -> invalid QVariant (becomes JSON null)
+// ----------------------------------------------------------------------------
+QVariant nodeToVariant(const mpv_node *node);
+
+// ----------------------------------------------------------------------------
+// NodeBuilder - QVariant -> mpv_node
+// ----------------------------------------------------------------------------
+// Builds an mpv_node tree that stays valid for as long as the builder
+// exists. MPV copies whatever it needs during the API call, so the usual
+// pattern is a short-lived builder on the stack:
+//
+//     MpvHelpers::NodeBuilder args(QVariantList{"seek", 10, "relative"});
+//     mpv_command_node(mpv, args.node(), nullptr);
+// ----------------------------------------------------------------------------
+class NodeBuilder {
+public:
+    explicit NodeBuilder(const QVariant &value);
+    ~NodeBuilder();
+
+    mpv_node *node();
+
+    // The tree owns raw allocations, so copying would free them twice.
+    NodeBuilder(const NodeBuilder &) = delete;
+    NodeBuilder &operator=(const NodeBuilder &) = delete;
+
+private:
+    static void build(mpv_node *dst, const QVariant &src);
+    static void release(mpv_node *node);
+    static char *copyString(const QString &text);
+
+    mpv_node root;
+};
+
+} // namespace MpvHelpers
+
+#endif // MPVHELPERS_H
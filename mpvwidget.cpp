@@ -0,0 +1,1098 @@
+// ============================================================================
+// mpvwidget.cpp - Implementation of the MpvWidget Class
+// ============================================================================
+
+#include "mpvwidget.h"
+#include "voprobe.h"             // VoProbe - fastest video output on this machine
+
+#include <QFileInfo>             // File name of a path, for the status label.
+#include <QUrl>                  // Splits stream URLs, for a readable display name.
+#include <QTime>                 // Formats positions as "HH:MM:SS".
+#include <QDebug>
+
+#include <mpv/client.h>          // MPV_ERROR_UNINITIALIZED
+
+#include <locale.h>              // Needed for using standardized locale data
+
+// ============================================================================
+//
+//                          MpvWidget IMPLEMENTATION
+//
+// ============================================================================
+// MpvWidget wraps the MPV media player library, providing a clean C++/Qt
+// interface for video playback. Each instance manages one independent player.
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Constructor: MpvWidget::MpvWidget
+// ----------------------------------------------------------------------------
+// Initializes a new MPV player instance and sets up the timer for UI updates.
+//
+// The syntax "MpvWidget(QWidget *parent) : QWidget(parent), statusLabel(nullptr), ..."
+// is called a "member initializer list". It's the preferred way to initialize
+// member variables in C++ because:
+//   1. It's more efficient (initializes directly, no assignment after construction)
+//   2. It's required for const members and references
+//   3. It ensures proper initialization order
+// ----------------------------------------------------------------------------
+MpvWidget::MpvWidget(QWidget *parent, PlayerBackend *injected) : QWidget(parent), statusLabel(nullptr), timeLabel(nullptr), pollTimer(nullptr), subtitleCombo(nullptr), audioCombo(nullptr), cacheLabel(nullptr), volumeSlider(nullptr), backend(nullptr),
+    streaming(false), prefilling(false), streamLoaded(false), prefillTarget(0.0), cacheAhead(0.0), cacheIdle(false), cacheSpeed(0.0),
+    idle(true), levelGainDb(0.0) {
+
+    // Set the widget's background color to black using CSS-like syntax.
+    // Qt's stylesheets work similarly to CSS in web development.
+    // This widget is actually hidden in our app, but we set it anyway.
+    setStyleSheet("background-color: black;");
+
+    // ------------------------------------------------------------------------
+    // Create the MPV Player Instance
+    // ------------------------------------------------------------------------
+    // The backend calls mpv_create(), which allocates a new MPV player
+    // handle. The backend is used for ALL subsequent MPV API calls.
+    // isValid() is false if allocation failed (rare, usually out of memory).
+    // ------------------------------------------------------------------------
+    backend = injected ? injected : PlayerBackend::create();
+    if (!backend->isValid()) {
+        // qDebug() outputs to the debug console (visible in Qt Creator).
+        // The "<<" operator works like cout - you can chain multiple values.
+        qDebug() << "Failed to create MPV instance!";
+        delete backend;
+        backend = nullptr;
+        return;  // Early return - don't try to configure a null player
+    }
+
+    // ------------------------------------------------------------------------
+    // Configure MPV Options (BEFORE initialization)
+    // ------------------------------------------------------------------------
+    // IMPORTANT: setOption() (mpv_set_option_string) MUST be called BEFORE
+    // initialize(). After initialization, you must use the property setters.
+    //
+    // We intentionally do NOT set the "wid" (window ID) option. When wid is set,
+    // MPV embeds its video output into that window. By not setting it, MPV
+    // creates its own separate window for video playback. This allows users
+    // to freely position and resize the video windows independently.
+    // ------------------------------------------------------------------------
+
+    // "keep-open=yes" keeps the player window open after the video ends,
+    // showing the last frame. Without this, the window would close immediately.
+    backend->setOption("keep-open", "yes");
+
+    // Disable MPV's built-in keyboard shortcuts. We want our Qt UI to handle
+    // all user input, not MPV's default bindings (which could conflict).
+    backend->setOption("input-default-bindings", "no");
+
+    // Disable keyboard input to the video output window specifically.
+    // This prevents the video window from capturing keyboard events.
+    backend->setOption("input-vo-keyboard", "no");
+
+    // Disable terminal/console output from MPV.
+    // This prevents MPV from printing status messages to stdout/stderr,
+    // which could clutter logs or cause issues on some platforms.
+    backend->setOption("terminal", "no");
+
+    // Keep the pitch when playing faster or slower (scaletempo). This is
+    // MPV's default, but the group speed control relies on it.
+    backend->setOption("audio-pitch-correction", "yes");
+
+    // The video output measured fastest on this machine (see voprobe.h).
+    // Without a result - e.g. while the first probe is still running -
+    // Linux falls back to x11, which avoids driver conflicts between the
+    // two players; elsewhere MPV decides.
+    QByteArray vo = VoProbe::selected().toUtf8();
+    if (!vo.isEmpty()) {
+        backend->setOption("vo", vo.constData());
+    } else {
+    #if defined(Q_OS_LINUX)
+        // backend->setOption("hwdec", "no");
+        // Keep this option commented unless issues come up.
+
+        backend->setOption("vo", "x11");
+    #endif
+    }
+
+    // ------------------------------------------------------------------------
+    // Initialize MPV
+    // ------------------------------------------------------------------------
+    // initialize() (mpv_initialize) finalizes the player setup. After this call:
+    //   - Options can no longer be set (only properties)
+    //   - The player is ready to load and play files
+    // Returns 0 on success, negative error code on failure.
+    // ------------------------------------------------------------------------
+    backend->initialize();
+
+    // ------------------------------------------------------------------------
+    // Hook Up MPV's Event Queue
+    // ------------------------------------------------------------------------
+    // MPV queues events (file loaded, seek finished, observed property
+    // changed...) and calls the wakeup callback when the queue becomes
+    // non-empty. The callback runs on an MPV thread, so it only schedules
+    // onMpvEvents() to run in the GUI thread, where the queue is drained.
+    // ------------------------------------------------------------------------
+    backend->setWakeupCallback(&MpvWidget::onMpvWakeup, this);
+
+    // Cache state for network streams (prefill and the cacheLabel). For
+    // local files these change too, but are simply not displayed.
+    observeProperty("demuxer-cache-duration");
+    observeProperty("demuxer-cache-idle");
+    observeProperty("cache-speed");
+    connect(this, &MpvWidget::propertyChanged, this, &MpvWidget::onCacheProperty);
+
+    // Whether a file is loaded, for hasFile() - asked several times per
+    // group seek and on every timer tick, so it is followed, not read.
+    observeProperty("idle-active");
+    connect(this, &MpvWidget::propertyChanged, this, [this](const QString &name, const QVariant &value) {
+        if (name == "idle-active") idle = !value.isValid() || value.toBool();
+    });
+    connect(this, &MpvWidget::fileLoaded, this, [this]() {
+        streamLoaded = true;
+        onCacheProperty(QString(), QVariant());    // Re-check the prefill.
+    });
+
+    // ------------------------------------------------------------------------
+    // Setup the Polling Timer
+    // ------------------------------------------------------------------------
+    // We use a QTimer to periodically update the time display (current position
+    // and duration). This is a simple polling approach.
+    //
+    // Alternative: MPV supports an event-based approach using mpv_observe_property()
+    // which is more efficient but more complex to implement.
+    //
+    // IMPORTANT: We create the timer but do NOT start it yet!
+    // Starting it before a file is loaded would cause issues because we'd be
+    // polling for time-pos on an empty player, which can return errors or
+    // cause freezes during the sensitive initialization period.
+    // ------------------------------------------------------------------------
+    pollTimer = new QTimer(this);  // "this" makes MpvWidget the timer's parent.
+    // Qt's parent-child system automatically
+    // deletes children when parent is deleted.
+
+    pollTimer->setInterval(500);    // Fire every 500 milliseconds (twice per second).
+    // This gives smooth time updates without
+    // excessive CPU usage.
+
+    // Connect the timer's timeout signal to our onTimerTick slot.
+    // This is Qt's signal-slot mechanism:
+    //   - When pollTimer emits timeout(), Qt automatically calls onTimerTick()
+    //   - The & syntax takes the address of the member functions
+    //   - Qt handles all the plumbing automatically
+    connect(pollTimer, &QTimer::timeout, this, &MpvWidget::onTimerTick);
+}
+
+// ----------------------------------------------------------------------------
+// Destructor: MpvWidget::~MpvWidget
+// ----------------------------------------------------------------------------
+// Called when the MpvWidget is destroyed (deleted or goes out of scope).
+// We delegate to shutdown() to ensure clean MPV termination.
+// ----------------------------------------------------------------------------
+MpvWidget::~MpvWidget() {
+    shutdown();
+}
+
+// ----------------------------------------------------------------------------
+// shutdown() - Clean MPV Termination
+// ----------------------------------------------------------------------------
+// This function safely shuts down the MPV player. It's carefully designed to
+// avoid deadlocks and crashes that can occur if MPV isn't shut down properly.
+//
+// This was one of the trickiest parts of the application to get right!
+// Different approaches were tried, and this sequence was found to work
+// reliably across platforms (especially important on macOS).
+// ----------------------------------------------------------------------------
+void MpvWidget::shutdown() {
+    // Step 1: Stop the polling timer FIRST.
+    // If the timer fires while we're shutting down MPV, it would try to
+    // query properties from a partially-destroyed player = crash!
+    if (pollTimer) {
+        pollTimer->stop();           // Stop firing events
+        pollTimer->deleteLater();    // Schedule for deletion (safer than delete)
+        // deleteLater() waits for the event loop
+        // to be clear before actually deleting
+        pollTimer = nullptr;         // Mark as gone to prevent double-delete
+    }
+
+    if (backend) {
+        // Step 1b: Stop MPV from calling back into this (soon dead) widget.
+        backend->setWakeupCallback(nullptr, nullptr);
+
+        // Step 2: Pause playback immediately.
+        // This stops any ongoing decoding/rendering, making subsequent
+        // operations safer and faster.
+        backend->setFlag("pause", true);
+
+        // Step 3: Stop playback and unload the current file.
+        // The "stop" command clears the playlist and releases resources
+        // associated with the current video (decoders, video output, etc.).
+        const char *stopCmd[] = {"stop", NULL};  // MPV commands are NULL-terminated
+        // arrays of strings
+        backend->command(stopCmd);
+
+        // Step 4: Send the quit command ASYNCHRONOUSLY.
+        // The async version returns immediately without waiting for MPV to
+        // fully shut down. This is crucial to avoid deadlocks!
+        //
+        // The first argument (0) is a "reply userdata" that would be included
+        // in the reply event - we don't use it here.
+        const char *quitCmd[] = {"quit", NULL};
+        backend->commandAsync(0, quitCmd);
+
+        // Step 5: Release our handle to MPV by deleting the backend.
+        // IMPORTANT: That calls mpv_destroy(), NOT mpv_terminate_destroy()
+        // (which is what backend->terminate() would do)!
+        //
+        // mpv_terminate_destroy() waits for MPV to fully shut down, which can
+        // cause deadlocks on some platforms (especially macOS) when the video
+        // output is still attached to a window.
+        //
+        // mpv_destroy() just releases our handle immediately. MPV continues
+        // cleaning up in the background on its own threads.
+        delete backend;
+        backend = nullptr;  // Mark as gone to prevent use-after-free bugs
+    }
+}
+
+// ----------------------------------------------------------------------------
+// loadVideo() - Load and Play a Video File
+// ----------------------------------------------------------------------------
+// Loads a video file and starts playback. This function also updates the UI
+// and triggers refresh of audio/subtitle track lists.
+//
+// Parameter:
+//   path - Full path to the video file (QString is Qt's string class)
+// ----------------------------------------------------------------------------
+void MpvWidget::loadVideo(QString path, const QVariantMap &options) {
+    // Guard clause: do nothing if MPV isn't initialized
+    if (!backend) return;
+
+    // Enforce "C" locale right here.
+    // This protects us even if QProcessEvents or a Dialog reset it
+    // milliseconds earlier. This is crucial for MPV parsing.
+    setlocale(LC_NUMERIC, "C");
+
+    // Step 1: STOP the polling timer during loading.
+    // The load operation can take time (file probing, decoder init, etc.).
+    // Polling during this sensitive period can cause hangs or incorrect data.
+    pollTimer->stop();
+
+    // A local file plays straight away - leave stream mode if it was on.
+    streaming = false;
+    prefilling = false;
+    updateCacheLabel();
+
+    // Step 2: Convert QString to UTF-8 bytes for MPV's C API.
+    // MPV's API uses C strings (char*), but Qt uses QString.
+    // toUtf8() converts to a QByteArray containing UTF-8 encoded bytes.
+    // .data() returns a pointer to the raw bytes (char*).
+    QByteArray pathBytes = path.toUtf8();
+
+    // Step 3: Execute the "loadfile" command.
+    // MPV commands are arrays of C strings, terminated with NULL.
+    // "loadfile" takes the path as its argument.
+    const char *cmd[] = {"loadfile", pathBytes.data(), NULL};
+    if (options.isEmpty()) {
+        backend->command(cmd);  // This blocks until the file is probed and ready
+        // (or fails). For large files over network, this
+        // could take a moment.
+    } else {
+        // Per-file options need the named-argument form of the command.
+        // They are applied while the file opens, so e.g. a start position
+        // costs no separate seek afterwards.
+        QVariantMap args;
+        args["name"] = "loadfile";
+        args["url"] = path;
+        args["flags"] = "replace";
+        args["options"] = options;
+        backend->commandNode(args);
+    }
+
+    // Step 4: Update the filename display in the UI.
+    // QFileInfo extracts file information from a path.
+    // fileName() returns just the filename without the directory path.
+    if (statusLabel) {
+        QFileInfo fileInfo(path);
+        statusLabel->setText(fileInfo.fileName());
+    }
+
+    // Step 5: RESTART the polling timer now that loading is complete.
+    // It's now safe to query time-pos and duration.
+    pollTimer->start();
+
+    // Step 6: Refresh the audio and subtitle track dropdowns.
+    // We use QTimer::singleShot to delay this by 500ms because:
+    //   - MPV needs time to fully parse the file and enumerate tracks
+    //   - If we query immediately, we might get incomplete results
+    //
+    // singleShot() fires once after the specified delay, then stops.
+    // The syntax connects directly to our member functions.
+    QTimer::singleShot(500, this, &MpvWidget::refreshSubtitleTracks);
+    QTimer::singleShot(500, this, &MpvWidget::refreshAudioTracks);
+}
+
+// ----------------------------------------------------------------------------
+// loadStream() - Open a Network Stream With Prefill
+// ----------------------------------------------------------------------------
+// For a watchalong, a stall halfway through hurts far more than a few extra
+// seconds at the start. So a stream is opened PAUSED and only released once
+// prefillSecs are buffered ahead of the playback position.
+//
+// The cache settings are passed as per-file options of the loadfile
+// command, so MPV resets them automatically when the next file is loaded:
+//   cache=yes               - always use the demuxer cache, even for URLs MPV
+//                             doesn't recognize as network streams
+//   cache-secs              - how far ahead to read (the readahead)
+//   demuxer-max-bytes       - memory cap; raised so the readahead isn't cut
+//                             short on high bitrate streams
+//   cache-pause-wait        - after an underrun, wait for the prefill target
+//                             again before MPV resumes on its own
+//
+// The command is sent as a map with named arguments, which older and newer
+// MPV versions both accept (positional loadfile arguments changed in 0.38).
+//
+// Parameters:
+//   url           - http(s)://, hls (.m3u8) or anything else MPV can open
+//   readaheadSecs - seconds to buffer ahead of the playback position
+//   prefillSecs   - seconds that must be buffered before playback starts
+// ----------------------------------------------------------------------------
+void MpvWidget::loadStream(QString url, double readaheadSecs, double prefillSecs) {
+    if (!backend) return;
+
+    setlocale(LC_NUMERIC, "C");
+    pollTimer->stop();
+
+    if (prefillSecs > readaheadSecs) prefillSecs = readaheadSecs;
+
+    streaming = true;
+    prefilling = true;
+    streamLoaded = false;
+    prefillTarget = prefillSecs;
+    cacheAhead = 0.0;
+    cacheIdle = false;
+    cacheSpeed = 0.0;
+
+    // "pause" isn't reset by loadfile, so the stream opens paused.
+    setPaused(true);
+
+    // Assume up to ~3 MiB/s (about 25 Mbit/s) of stream, but never go below
+    // MPV's own 150 MiB default.
+    int maxMiB = qMax(150, static_cast<int>(readaheadSecs * 3.0));
+
+    // A map, like loadVideo()'s options: one value per option, so nothing
+    // has to be escaped, and every backend sees the same form.
+    QVariantMap options;
+    options["cache"] = "yes";
+    options["cache-secs"] = QString::number(readaheadSecs, 'f', 1);
+    options["demuxer-max-bytes"] = QString("%1MiB").arg(maxMiB);
+    options["cache-pause-wait"] = QString::number(prefillSecs, 'f', 1);
+
+    QVariantMap cmd;
+    cmd["name"] = "loadfile";
+    cmd["url"] = url;
+    cmd["flags"] = "replace";
+    cmd["options"] = options;
+
+    if (backend->commandNode(cmd) < 0) {
+        qDebug() << "Failed to open stream" << url;
+        streaming = false;
+        prefilling = false;
+    }
+
+    // Show the last path component, or the host for bare URLs.
+    if (statusLabel) {
+        QUrl parsed(url);
+        QString name = parsed.fileName();
+        if (name.isEmpty()) name = parsed.host();
+        if (name.isEmpty()) name = url;
+        statusLabel->setText(name);
+    }
+
+    updateCacheLabel();
+    pollTimer->start();
+
+    QTimer::singleShot(500, this, &MpvWidget::refreshSubtitleTracks);
+    QTimer::singleShot(500, this, &MpvWidget::refreshAudioTracks);
+}
+
+// ----------------------------------------------------------------------------
+// closeVideo() - Stop Playback and Reset UI
+// ----------------------------------------------------------------------------
+// Unloads the current video and resets all UI elements to their default state.
+// This doesn't destroy the MPV instance - it's ready to load another file.
+// ----------------------------------------------------------------------------
+void MpvWidget::closeVideo() {
+    if (!backend) return;
+
+    // Stop the timer - no need to poll when nothing is playing
+    pollTimer->stop();
+
+    // Execute the "stop" command to unload the file and clear the playlist
+    const char *cmd[] = {"stop", NULL};
+    backend->command(cmd);
+
+    // Reset the filename label
+    if (statusLabel) {
+        statusLabel->setText("No file loaded");
+    }
+
+    // Nothing to buffer any more
+    streaming = false;
+    prefilling = false;
+    updateCacheLabel();
+
+    // Reset the time display
+    if (timeLabel) {
+        timeLabel->setText("--:--:-- / --:--:--");
+    }
+
+    // Reset the subtitle dropdown to just "Off"
+    if (subtitleCombo) {
+        // blockSignals(true) temporarily prevents the combo box from emitting
+        // signals when we modify it. Without this, our modifications would
+        // trigger currentIndexChanged, which would call setSubtitleTrack(),
+        // which would be wasteful and could cause issues.
+        subtitleCombo->blockSignals(true);
+        subtitleCombo->clear();            // Remove all items
+        subtitleCombo->addItem("Off", 0);  // Add back just the "Off" option
+        subtitleCombo->blockSignals(false);// Re-enable signals
+    }
+
+    // Reset the audio dropdown (empty since no file is loaded)
+    if (audioCombo) {
+        audioCombo->blockSignals(true);
+        audioCombo->clear();
+        audioCombo->blockSignals(false);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// onTimerTick() - Timer Callback for Time Display Updates
+// ----------------------------------------------------------------------------
+// This slot is called every 500ms by pollTimer. It queries MPV for the
+// current playback position and duration, then updates the time label.
+// ----------------------------------------------------------------------------
+void MpvWidget::onTimerTick() {
+    if (!backend) return;
+
+    double timePos = 0;   // Current playback position in seconds
+    double duration = 0;  // Total video duration in seconds
+
+    // Query MPV properties with getDouble() (mpv_get_property() with
+    // MPV_FORMAT_DOUBLE). Parameters:
+    //   - property name: "time-pos" or "duration"
+    //   - pointer to variable to receive the value (floating-point seconds)
+    //
+    // These properties return the current playback time and total duration.
+    // If no file is loaded, they return an error (which we ignore) and the
+    // variables keep their 0.
+    backend->getDouble("time-pos", &timePos);
+    backend->getDouble("duration", &duration);
+
+    // Update the time label with formatted time strings
+    if (timeLabel) {
+        // QString's arg() method replaces %1, %2, etc. with the provided values.
+        // It's Qt's type-safe alternative to printf-style formatting.
+        QString text = QString("%1 / %2")
+                           .arg(formatTime(timePos))     // Current position
+                           .arg(formatTime(duration));   // Total duration
+        timeLabel->setText(text);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// formatTime() - Convert Seconds to HH:MM:SS String
+// ----------------------------------------------------------------------------
+// Utility function to convert a time in seconds (e.g., 3661.5) to a
+// human-readable string (e.g., "01:01:01").
+//
+// Parameter:
+//   totalSeconds - Time in seconds (can be fractional)
+//
+// Returns:
+//   QString in "HH:mm:ss" format
+// ----------------------------------------------------------------------------
+QString MpvWidget::formatTime(double totalSeconds) {
+    // Handle negative values (shouldn't happen, but defensive programming)
+    if (totalSeconds < 0) totalSeconds = 0;
+
+    // Start with a QTime of 00:00:00
+    QTime t(0, 0, 0);
+
+    // Add the seconds (truncated to integer).
+    // static_cast<int> safely converts double to int (C++ style cast).
+    t = t.addSecs(static_cast<int>(totalSeconds));
+
+    // Format as string using Qt's date/time formatting.
+    // "HH" = hours with leading zero, "mm" = minutes, "ss" = seconds
+    return t.toString("HH:mm:ss");
+}
+
+// ----------------------------------------------------------------------------
+// setVolume() - Set Playback Volume
+// ----------------------------------------------------------------------------
+// Sets the audio volume level.
+//
+// Parameter:
+//   value - Volume level from 0 (mute) to 100 (full)
+// ----------------------------------------------------------------------------
+void MpvWidget::setVolume(int value) {
+    if (!backend) return;
+
+    // MPV's volume property expects a double, so we convert.
+    // Note: MPV supports values > 100 for amplification, but we limit to 0-100.
+    double v = static_cast<double>(value);
+
+    // Set the "volume" property. Unlike options, properties can be changed
+    // at any time after initialization.
+    backend->setDouble("volume", v);
+}
+
+// ----------------------------------------------------------------------------
+// togglePause() - Toggle Play/Pause State
+// ----------------------------------------------------------------------------
+// Toggles between playing and paused states. If playing, pauses. If paused,
+// resumes playback.
+// ----------------------------------------------------------------------------
+void MpvWidget::togglePause() {
+    if (!backend) return;
+
+    // The "cycle" command toggles a property between its possible values.
+    // For "pause" (a boolean), it toggles between true and false.
+    // This is simpler than reading the current state and setting the opposite.
+    const char *cmd[] = {"cycle", "pause", NULL};
+    backend->command(cmd);
+}
+
+// ----------------------------------------------------------------------------
+// seek() - Seek Forward or Backward
+// ----------------------------------------------------------------------------
+// Seeks the playback position by the specified number of seconds.
+//
+// Parameter:
+//   seconds - Number of seconds to seek (positive = forward, negative = back)
+// ----------------------------------------------------------------------------
+void MpvWidget::seek(double seconds) {
+    if (!backend) return;
+
+    // Use QString::number to guarantee a DOT decimal separator regardless of locale.
+    // std::to_string() uses the global locale, which is risky if it ever drifts.
+    std::string timeStr = QString::number(seconds, 'f', 3).toStdString();
+
+    const char *cmd[] = {"seek", timeStr.c_str(), "relative+exact", NULL};
+    backend->command(cmd);
+
+    // Update the time display immediately for better UI responsiveness.
+    // Without this, there would be up to a 500ms delay before the display updates.
+    onTimerTick();
+}
+
+// ----------------------------------------------------------------------------
+// seekAbsolute() - Seek to an Exact Position
+// ----------------------------------------------------------------------------
+// Like seek(), but the target is a position in the file rather than a
+// distance from the current position. Group operations use this, because
+// each player's target is computed from the group time plus its offset.
+//
+// Parameter:
+//   seconds - Target position, in seconds from the start of the file
+// ----------------------------------------------------------------------------
+void MpvWidget::seekAbsolute(double seconds) {
+    if (!backend) return;
+
+    if (seconds < 0) seconds = 0;
+    std::string timeStr = QString::number(seconds, 'f', 3).toStdString();
+
+    const char *cmd[] = {"seek", timeStr.c_str(), "absolute+exact", NULL};
+    backend->command(cmd);
+
+    onTimerTick();
+}
+
+// ----------------------------------------------------------------------------
+// setPaused() - Pause or Resume Explicitly
+// ----------------------------------------------------------------------------
+// Unlike togglePause(), the result doesn't depend on the current state, which
+// is what group controls need (a "Global Pause" must never resume a player
+// that happened to be paused already).
+// ----------------------------------------------------------------------------
+void MpvWidget::setPaused(bool paused) {
+    if (!backend) return;
+
+    backend->setFlag("pause", paused);
+}
+
+// ----------------------------------------------------------------------------
+// setSpeed() - Set Playback Speed
+// ----------------------------------------------------------------------------
+// MPV keeps the audio pitch unchanged at other speeds (audio-pitch-correction,
+// set in the constructor), so small corrections are inaudible.
+//
+// Sent asynchronously: the call returns at once instead of waiting for the
+// player's core, so PlayerGroup can change all players at the same moment.
+// ----------------------------------------------------------------------------
+void MpvWidget::setSpeed(double speed) {
+    if (!backend) return;
+
+    QByteArray value = QByteArray::number(speed, 'f', 6);
+    const char *cmd[] = {"set", "speed", value.constData(), NULL};
+    backend->commandAsync(0, cmd);
+}
+
+// ----------------------------------------------------------------------------
+// setLevelGain() - Loudness Matching Gain
+// ----------------------------------------------------------------------------
+// MPV's "volume" property follows a cubic curve, which makes it awkward for
+// exact dB corrections and would fight with the volume slider. Instead, a
+// labelled libavfilter "volume" filter is inserted into the audio chain.
+// It is removed first, so setting it again never stacks two of them.
+//
+// Audio filters belong to the player, not to the file, so the gain stays
+// in place when another file is loaded until it's set again.
+// ----------------------------------------------------------------------------
+void MpvWidget::setLevelGain(double dB) {
+    if (!backend) return;
+
+    levelGainDb = dB;
+
+    const char *removeCmd[] = {"af", "remove", "@wa-level", NULL};
+    backend->command(removeCmd);      // Fails harmlessly if there is none.
+
+    if (qAbs(dB) < 0.05) return;      // Inaudible - leave the chain untouched.
+
+    QByteArray filter = QString("@wa-level:lavfi-volume=volume=%1dB")
+                            .arg(QString::number(dB, 'f', 2)).toUtf8();
+    const char *addCmd[] = {"af", "add", filter.constData(), NULL};
+    backend->command(addCmd);
+}
+
+double MpvWidget::levelGain() const {
+    return levelGainDb;
+}
+
+// ----------------------------------------------------------------------------
+// hasFile() / position() / isPaused() - State Queries
+// ----------------------------------------------------------------------------
+// "idle-active" is true while MPV has nothing loaded. Note that with
+// keep-open=yes, a file that reached its end still counts as loaded.
+// hasFile() answers from the observed value, so it follows a loadfile or
+// stop once MPV's property change has been processed.
+// ----------------------------------------------------------------------------
+bool MpvWidget::hasFile() {
+    return backend && !idle;
+}
+
+double MpvWidget::position() {
+    if (!backend) return 0.0;
+
+    double pos = 0.0;
+    backend->getDouble("time-pos", &pos);
+    return pos;
+}
+
+bool MpvWidget::isPaused() {
+    if (!backend) return true;
+
+    bool paused = true;
+    backend->getFlag("pause", &paused);
+    return paused;
+}
+
+bool MpvWidget::isPrefilling() const {
+    return prefilling;
+}
+
+QString MpvWidget::currentPath() {
+    if (!backend) return QString();
+
+    QString path;
+    backend->getString("path", &path);
+    return path;
+}
+
+// Prefers the rate measured from the decoded frames over the one the
+// container claims - variable frame rate files often claim nonsense.
+double MpvWidget::frameRate() {
+    if (!backend) return 0.0;
+
+    double fps = 0.0;
+    if (backend->getDouble("estimated-vf-fps", &fps) >= 0 && fps > 0.0) return fps;
+    if (backend->getDouble("container-fps", &fps) >= 0 && fps > 0.0) return fps;
+    return 0.0;
+}
+
+// ----------------------------------------------------------------------------
+// grabFrame() - Copy the Current Video Frame
+// ----------------------------------------------------------------------------
+// "screenshot-raw video" returns the decoded frame at its own resolution as
+// a map {w, h, stride, format, data}. The default format "bgr0" has the
+// same byte order as QImage::Format_RGB32 on little-endian machines (every
+// platform we build for).
+// ----------------------------------------------------------------------------
+QImage MpvWidget::grabFrame() {
+    if (!backend) return QImage();
+
+    QVariant result;
+    if (backend->commandNode(QVariantList{ "screenshot-raw", "video" }, &result) < 0) return QImage();
+    QVariantMap frame = result.toMap();
+
+    QString format = frame.value("format").toString();
+    QImage::Format qtFormat;
+    if (format == "bgr0") qtFormat = QImage::Format_RGB32;
+    else if (format == "bgra") qtFormat = QImage::Format_ARGB32_Premultiplied;
+    else return QImage();
+
+    QByteArray data = frame.value("data").toByteArray();
+    int w = frame.value("w").toInt();
+    int h = frame.value("h").toInt();
+    int stride = frame.value("stride").toInt();
+    if (w <= 0 || h <= 0 || stride < w * 4 || data.size() < qint64(stride) * h) return QImage();
+
+    // The QImage only wraps `data`, which goes out of scope - copy() detaches.
+    return QImage(reinterpret_cast<const uchar *>(data.constData()), w, h, stride, qtFormat).copy();
+}
+
+// ----------------------------------------------------------------------------
+// observeProperty() - Get Notified When a Property Changes
+// ----------------------------------------------------------------------------
+// The property's position in observedProperties is passed to MPV as the
+// "reply_userdata", which comes back with every change event. MPV reports
+// the current value once right away, then again on every change.
+// ----------------------------------------------------------------------------
+void MpvWidget::observeProperty(const QString &name) {
+    if (!backend || observedProperties.contains(name)) return;
+
+    observedProperties.append(name);
+    QByteArray nameBytes = name.toUtf8();
+    backend->observeProperty(observedProperties.size() - 1, nameBytes.constData());
+}
+
+// ----------------------------------------------------------------------------
+// onMpvWakeup() / onMpvEvents() - Process MPV's Event Queue
+// ----------------------------------------------------------------------------
+// MPV forbids calling its API from inside the wakeup callback, and Qt
+// widgets may only be touched from the GUI thread, so the callback just
+// posts a queued call. onMpvEvents() then reads events with a timeout of 0
+// (don't wait) until the queue is empty.
+// ----------------------------------------------------------------------------
+void MpvWidget::onMpvWakeup(void *ctx) {
+    MpvWidget *self = static_cast<MpvWidget *>(ctx);
+    QMetaObject::invokeMethod(self, &MpvWidget::onMpvEvents, Qt::QueuedConnection);
+}
+
+void MpvWidget::onMpvEvents() {
+    while (backend) {
+        PlayerEvent event = backend->waitEvent(0);
+        if (event.type == PlayerEvent::None) break;
+
+        switch (event.type) {
+        case PlayerEvent::PropertyChange:
+            emit propertyChanged(event.name, event.value);
+            break;
+        case PlayerEvent::FileLoaded:
+            emit fileLoaded();
+            break;
+        case PlayerEvent::PlaybackRestart:
+            emit playbackRestarted();
+            break;
+        case PlayerEvent::LogMessage:
+            emit logMessage(event.name, event.value.toString());
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// onCacheProperty() - Follow the Stream Cache
+// ----------------------------------------------------------------------------
+// Prefill is done when the target is buffered, or when the cache stopped
+// reading because it has everything it may read (demuxer-cache-idle) -
+// e.g. a clip shorter than the prefill target. Values only count once the
+// stream itself was opened, so leftovers from the previous file can't end
+// the prefill early.
+// ----------------------------------------------------------------------------
+void MpvWidget::onCacheProperty(const QString &name, const QVariant &value) {
+    if (name == "demuxer-cache-duration")  cacheAhead = value.toDouble();
+    else if (name == "demuxer-cache-idle") cacheIdle = value.toBool();
+    else if (name == "cache-speed")        cacheSpeed = value.toDouble();
+    else if (!name.isEmpty()) return;
+
+    if (!streaming) return;
+
+    if (prefilling && streamLoaded && (cacheAhead >= prefillTarget || cacheIdle)) {
+        prefilling = false;
+        emit prefillFinished();
+    }
+    updateCacheLabel();
+}
+
+// ----------------------------------------------------------------------------
+// updateCacheLabel() - "Prefill 3.2 / 10.0 s | 1.8 MiB/s"
+// ----------------------------------------------------------------------------
+void MpvWidget::updateCacheLabel() {
+    if (!cacheLabel) return;
+
+    cacheLabel->setVisible(streaming);
+    if (!streaming) return;
+
+    QString rate = cacheSpeed >= 1024.0 * 1024.0
+                       ? QString("%1 MiB/s").arg(cacheSpeed / (1024.0 * 1024.0), 0, 'f', 1)
+                       : QString("%1 KiB/s").arg(cacheSpeed / 1024.0, 0, 'f', 0);
+
+    if (prefilling) {
+        cacheLabel->setText(QString("Prefill %1 / %2 s | %3")
+                                .arg(cacheAhead, 0, 'f', 1)
+                                .arg(prefillTarget, 0, 'f', 1)
+                                .arg(rate));
+    } else {
+        cacheLabel->setText(QString("Buffered %1 s ahead | %2")
+                                .arg(cacheAhead, 0, 'f', 1)
+                                .arg(rate));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// refreshSubtitleTracks() - Populate Subtitle Track Dropdown
+// ----------------------------------------------------------------------------
+// Queries MPV for all available subtitle tracks and populates the subtitle
+// dropdown with them. This includes embedded subtitles and any external
+// subtitle files that have been loaded.
+// ----------------------------------------------------------------------------
+void MpvWidget::refreshSubtitleTracks() {
+    if (!backend || !subtitleCombo) return;
+
+    // Block signals while modifying the combo box (see closeVideo for explanation)
+    subtitleCombo->blockSignals(true);
+    subtitleCombo->clear();
+
+    // Add "Off" option first. The second parameter (0) is the "user data" -
+    // we store the subtitle ID (sid) there. sid=0 means no subtitles.
+    subtitleCombo->addItem("Off", 0);
+
+    // ------------------------------------------------------------------------
+    // Query MPV's Track List
+    // ------------------------------------------------------------------------
+    // "track-list" is a complex property that returns information about all
+    // tracks (video, audio, subtitle) in the current file. MPV returns it as
+    // an mpv_node, which is MPV's way of representing complex data structures
+    // (similar to JSON); the backend hands it over as a QVariant - a list of
+    // maps, one per track.
+    // ------------------------------------------------------------------------
+    QVariant trackList;
+    if (backend->getNode("track-list", &trackList) >= 0) {
+        // Iterate through each track
+        for (const QVariant &entry : trackList.toList()) {
+            // Each track is a map (dictionary) of properties
+            QVariantMap track = entry.toMap();
+
+            // Read the track properties we need. Missing keys just give an
+            // empty/zero value.
+            QString type = track.value("type").toString();        // "video", "audio", or "sub"
+            int id = track.value("id").toInt();                   // Track ID (used to select it)
+            QString title = track.value("title").toString();      // Track title (if any)
+            QString lang = track.value("lang").toString();        // Language code (e.g., "eng", "jpn")
+            bool isExternal = track.value("external").toBool();   // Whether it's from an external file
+
+            // Only process subtitle tracks (skip video and audio)
+            if (type == "sub") {
+                // Build a descriptive label for the dropdown
+                QString label = QString("#%1").arg(id);
+                if (!lang.isEmpty()) label += " [" + lang + "]";
+                if (!title.isEmpty()) label += " " + title;
+                if (isExternal) label += " (external)";
+
+                // Add to dropdown with track ID as user data
+                subtitleCombo->addItem(label, id);
+            }
+        }
+    }
+
+    // Select the currently active subtitle track in the dropdown
+    qint64 currentSid = 0;           // Stays 0 while subtitles are off ("no").
+    backend->getInt("sid", &currentSid);
+    for (int i = 0; i < subtitleCombo->count(); i++) {
+        if (subtitleCombo->itemData(i).toInt() == currentSid) {
+            subtitleCombo->setCurrentIndex(i);
+            break;
+        }
+    }
+
+    subtitleCombo->blockSignals(false);  // Re-enable signals
+}
+
+// ----------------------------------------------------------------------------
+// setSubtitleTrack() - Switch Subtitle Track
+// ----------------------------------------------------------------------------
+// Changes the active subtitle track based on dropdown selection.
+//
+// Parameter:
+//   index - Index of the selected item in the subtitle dropdown
+// ----------------------------------------------------------------------------
+void MpvWidget::setSubtitleTrack(int index) {
+    if (!backend || !subtitleCombo) return;
+
+    // Get the subtitle ID (sid) stored as user data for this item
+    int sid = subtitleCombo->itemData(index).toInt();
+
+    // Set MPV's "sid" (subtitle ID) property to switch tracks.
+    // sid=0 means no subtitles (Off).
+    backend->setInt("sid", sid);
+}
+
+// ----------------------------------------------------------------------------
+// loadExternalSubtitles() - Load Subtitle File from Disk
+// ----------------------------------------------------------------------------
+// Loads an external subtitle file (e.g., .srt, .ass) and adds it to the
+// available subtitle tracks.
+//
+// Parameter:
+//   path - Full path to the subtitle file
+// ----------------------------------------------------------------------------
+void MpvWidget::loadExternalSubtitles(QString path) {
+    if (!backend) return;
+
+    setlocale(LC_NUMERIC, "C");
+
+    // Convert QString to UTF-8 for MPV's C API
+    QByteArray pathBytes = path.toUtf8();
+
+    // "sub-add" command adds an external subtitle file.
+    // "auto" means MPV should auto-select it if it's the first subtitle.
+    const char *cmd[] = {"sub-add", pathBytes.data(), "auto", NULL};
+    backend->command(cmd);
+
+    // Refresh the track list to show the newly added subtitle
+    refreshSubtitleTracks();
+
+    // Select the newly added track (it should be the last one in the list)
+    if (subtitleCombo && subtitleCombo->count() > 0) {
+        subtitleCombo->setCurrentIndex(subtitleCombo->count() - 1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// refreshAudioTracks() - Populate Audio Track Dropdown
+// ----------------------------------------------------------------------------
+// Similar to refreshSubtitleTracks(), but for audio tracks.
+// Queries MPV for all available audio tracks and populates the dropdown.
+// ----------------------------------------------------------------------------
+void MpvWidget::refreshAudioTracks() {
+    if (!backend || !audioCombo) return;
+
+    audioCombo->blockSignals(true);
+    audioCombo->clear();
+
+    // Query the track list (same as for subtitles)
+    QVariant trackList;
+    if (backend->getNode("track-list", &trackList) >= 0) {
+        for (const QVariant &entry : trackList.toList()) {
+            QVariantMap track = entry.toMap();
+
+            QString type = track.value("type").toString();
+            int id = track.value("id").toInt();
+            QString title = track.value("title").toString();
+            QString lang = track.value("lang").toString();
+            int channels = track.value("demux-channel-count").toInt();  // Number of audio channels
+
+            // Only process audio tracks
+            if (type == "audio") {
+                // Build descriptive label
+                QString label = QString("#%1").arg(id);
+                if (!lang.isEmpty()) label += " [" + lang + "]";
+                if (!title.isEmpty()) label += " " + title;
+
+                // Add human-readable channel configuration
+                if (channels > 0) {
+                    if (channels == 1) label += " (Mono)";
+                    else if (channels == 2) label += " (Stereo)";
+                    else if (channels == 6) label += " (5.1)";    // 5.1 surround
+                    else if (channels == 8) label += " (7.1)";    // 7.1 surround
+                    else label += QString(" (%1ch)").arg(channels);
+                }
+
+                audioCombo->addItem(label, id);
+            }
+        }
+    }
+
+    // Select current audio track
+    qint64 currentAid = 0;
+    backend->getInt("aid", &currentAid);
+    for (int i = 0; i < audioCombo->count(); i++) {
+        if (audioCombo->itemData(i).toInt() == currentAid) {
+            audioCombo->setCurrentIndex(i);
+            break;
+        }
+    }
+
+    audioCombo->blockSignals(false);
+}
+
+// ----------------------------------------------------------------------------
+// setAudioTrack() - Switch Audio Track
+// ----------------------------------------------------------------------------
+// Changes the active audio track based on dropdown selection.
+//
+// Parameter:
+//   index - Index of the selected item in the audio dropdown
+// ----------------------------------------------------------------------------
+void MpvWidget::setAudioTrack(int index) {
+    if (!backend || !audioCombo) return;
+
+    int aid = audioCombo->itemData(index).toInt();
+
+    // Set MPV's "aid" (audio ID) property to switch tracks
+    backend->setInt("aid", aid);
+}
+
+// ----------------------------------------------------------------------------
+// Raw Player Access
+// ----------------------------------------------------------------------------
+// Plain forwarding to the backend, with the null check every caller would
+// otherwise have to remember.
+// ----------------------------------------------------------------------------
+bool MpvWidget::isReady() const {
+    return backend != nullptr;
+}
+
+int MpvWidget::command(const char **args) {
+    return backend ? backend->command(args) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::commandNode(const QVariant &args, QVariant *result) {
+    return backend ? backend->commandNode(args, result) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::getDouble(const char *name, double *value) {
+    return backend ? backend->getDouble(name, value) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::getInt(const char *name, qint64 *value) {
+    return backend ? backend->getInt(name, value) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::getString(const char *name, QString *value) {
+    return backend ? backend->getString(name, value) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::getNode(const char *name, QVariant *value) {
+    return backend ? backend->getNode(name, value) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::setDouble(const char *name, double value) {
+    return backend ? backend->setDouble(name, value) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::setInt(const char *name, qint64 value) {
+    return backend ? backend->setInt(name, value) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::setString(const char *name, const char *value) {
+    return backend ? backend->setString(name, value) : MPV_ERROR_UNINITIALIZED;
+}
+
+int MpvWidget::requestLogMessages(const char *minLevel) {
+    return backend ? backend->requestLogMessages(minLevel) : MPV_ERROR_UNINITIALIZED;
+}
+
+mpv_handle *MpvWidget::createClient(const char *name) {
+    return backend ? backend->createClient(name) : nullptr;
+}
@@ -0,0 +1,302 @@
+// ============================================================================
+// mpvwidget.h - One Video Player
+// ============================================================================
+// MpvWidget owns one player (a PlayerBackend, see playerbackend.h) and is the
+// only class that talks to it: everything else - MainWindow, PlayerGroup and
+// the feature classes - goes through the methods below. That keeps the
+// number of MPV calls per user action visible in one file, and lets tests
+// run the whole control layer on a FakeBackend.
+// ============================================================================
+
+#ifndef MPVWIDGET_H
+#define MPVWIDGET_H
+
+#include <QWidget>       // Base class for ALL visual UI elements in Qt.
+#include <QSlider>       // The volume slider.
+#include <QLabel>        // Filename, time and cache labels.
+#include <QTimer>        // The time display's polling timer.
+#include <QComboBox>     // Audio and subtitle track selection.
+#include <QStringList>   // The observed property names.
+#include <QVariant>      // Holds a value of any type (observed property values).
+#include <QImage>        // An in-memory image (captured video frames).
+
+#include "playerbackend.h" // The player behind an MpvWidget: libmpv, or a fake
+// for tests and benchmarks. All MPV calls go through it (see playerbackend.h).
+
+// ============================================================================
+// MpvWidget Class Declaration
+// ============================================================================
+// This class wraps an MPV player instance and provides a clean interface
+// for controlling video playback. Each MpvWidget manages one video player.
+//
+// Inheritance: MpvWidget inherits from QWidget, making it a Qt widget that
+// can be placed in layouts, receive events, etc. (Though in our app, the
+// widget itself is hidden since videos play in separate MPV windows.)
+// ============================================================================
+class MpvWidget : public QWidget {
+    // The Q_OBJECT macro is REQUIRED for any class that:
+    //   - Uses signals and slots (Qt's event communication system)
+    //   - Uses Qt's meta-object features (like dynamic property access)
+    //
+    // It tells Qt's Meta-Object Compiler (moc) to generate extra code for
+    // this class. Without it, signals/slots won't work!
+    Q_OBJECT
+
+public:
+    // ------------------------------------------------------------------------
+    // Public Member Variables
+    // ------------------------------------------------------------------------
+    // Note: In production code, these would typically be private with accessor
+    // methods (getters/setters). They're public here for simplicity since the
+    // MainWindow needs direct access to update UI elements.
+    // ------------------------------------------------------------------------
+
+    QLabel *statusLabel;         // Pointer to the label showing the current filename.
+    // We store this so we can update it when files load.
+
+    QLabel *timeLabel;           // Pointer to the label showing playback time.
+    // Displays "current / duration" format.
+
+    QTimer *pollTimer;           // Timer that fires periodically to update the time display.
+    // Qt timers emit a signal at set intervals.
+
+    QComboBox *subtitleCombo;    // Dropdown for selecting subtitle tracks.
+    // Populated when a video with subtitles is loaded.
+
+    QComboBox *audioCombo;       // Dropdown for selecting audio tracks.
+    // Populated when a video with multiple audio tracks is loaded.
+
+    QLabel *cacheLabel;          // Pointer to the label showing network throughput
+    // and how much is buffered ahead. Only visible while a stream is loaded.
+
+    QSlider *volumeSlider;       // The player's volume slider. Setting its value
+    // changes the volume, like dragging it would.
+
+    // ------------------------------------------------------------------------
+    // Constructor and Destructor
+    // ------------------------------------------------------------------------
+
+    // Constructor: Creates and initializes the MPV player.
+    // The "explicit" keyword prevents implicit type conversions - a C++ best practice.
+    // The "parent = nullptr" is a default argument - if no parent is specified,
+    // the widget has no parent (it's a top-level widget or will be parented later).
+    // The widget takes ownership of `backend`; by default it gets the backend
+    // chosen at startup (PlayerBackend::create()).
+    explicit MpvWidget(QWidget *parent = nullptr, PlayerBackend *backend = nullptr);
+
+    // Destructor: Cleans up resources when the widget is destroyed.
+    // The ~ prefix indicates a destructor in C++.
+    // We use this to properly shut down MPV and free resources.
+    ~MpvWidget();
+
+    // ------------------------------------------------------------------------
+    // Public Methods - Video Control Interface
+    // ------------------------------------------------------------------------
+    // These methods provide a clean API for controlling the video player.
+    // They hide the complexity of MPV's C API behind simple function calls.
+    // ------------------------------------------------------------------------
+
+    void loadVideo(QString path,       // Load and start playing a video file.
+                   const QVariantMap &options = QVariantMap());
+    // QString is Qt's string class - more powerful than std::string.
+    // `options` are per-file MPV options applied as the file opens, e.g.
+    // {"start": "83.5", "pause": "yes"} to open it paused at 83.5 s.
+
+    void loadStream(QString url, double readaheadSecs, double prefillSecs);
+    // Open a network stream (HTTP, HLS...). MPV reads up to readaheadSecs
+    // ahead of the playback position; playback is held back until
+    // prefillSecs are buffered, then prefillFinished() is emitted.
+
+    void closeVideo();                  // Stop playback and unload the current video.
+    // Resets the player to its initial state.
+
+    void setVolume(int value);          // Set the audio volume (0-100 scale).
+
+    void togglePause();                 // Toggle between playing and paused states.
+
+    void seek(double seconds);          // Seek forward or backward by the specified seconds.
+    // Positive = forward, negative = backward.
+
+    void seekAbsolute(double seconds);  // Seek to an exact position (in seconds from
+    // the start of the file).
+
+    void setPaused(bool paused);        // Explicitly pause (true) or resume (false).
+
+    void setSpeed(double speed);        // Set the playback speed (1.0 = normal).
+
+    void setLevelGain(double dB);       // Extra gain (in dB) on top of the volume
+    // slider, used for loudness matching. 0 removes it.
+
+    double levelGain() const;           // The gain last set by setLevelGain().
+
+    // ------------------------------------------------------------------------
+    // State Queries
+    // ------------------------------------------------------------------------
+    // Small read-only helpers so other classes (PlayerGroup, WatchPartySync)
+    // don't have to call the MPV C API themselves.
+    // ------------------------------------------------------------------------
+
+    bool hasFile();                     // True if a file is currently loaded.
+
+    double position();                  // Current playback position in seconds.
+
+    bool isPaused();                    // True if playback is paused.
+
+    bool isPrefilling() const;          // True while a stream is loaded but still
+    // buffering its prefill target.
+
+    QString currentPath();              // Path or URL of the loaded file, or empty.
+
+    double frameRate();                 // Frames per second of the video, or 0.
+
+    QImage grabFrame();                 // Copy of the video frame on screen, without
+    // subtitles or OSD (MPV's "screenshot-raw"). Null if there is none.
+    // Only uses the (thread-safe) MPV API, so
+    // worker threads may call it too.
+
+    // ------------------------------------------------------------------------
+    // Property Observation and Events
+    // ------------------------------------------------------------------------
+    // Instead of polling, other classes can ask MPV to report changes of a
+    // property. Every change then arrives as a propertyChanged() signal in
+    // the GUI thread. Observing the same property twice is harmless.
+    // ------------------------------------------------------------------------
+
+    void observeProperty(const QString &name);
+
+    void shutdown();                    // Completely shut down the MPV instance.
+    // Called when closing the application.
+    // This is critical for clean app termination!
+
+    // ------------------------------------------------------------------------
+    // Raw Player Access
+    // ------------------------------------------------------------------------
+    // For the features that need MPV properties or commands the methods
+    // above don't cover (filters, track ids, cache tuning...). They mirror
+    // PlayerBackend (playerbackend.h) and return its mpv error codes, but
+    // are safe without a player: they then fail with MPV_ERROR_UNINITIALIZED
+    // and leave the output untouched. Like the backend, they may be called
+    // from worker threads.
+    // ------------------------------------------------------------------------
+
+    bool isReady() const;               // False if the player couldn't be created
+    // (or was shut down) - every call below then fails.
+
+    int command(const char **args);     // NULL-terminated, as for mpv_command().
+    int commandNode(const QVariant &args, QVariant *result = nullptr);
+
+    int getDouble(const char *name, double *value);
+    int getInt(const char *name, qint64 *value);
+    int getString(const char *name, QString *value);
+    int getNode(const char *name, QVariant *value);
+
+    int setDouble(const char *name, double value);
+    int setInt(const char *name, qint64 value);
+    int setString(const char *name, const char *value);
+
+    int requestLogMessages(const char *minLevel);  // See logMessage().
+
+    mpv_handle *createClient(const char *name);    // For the IPC server.
+
+    // ------------------------------------------------------------------------
+    // Subtitle Methods
+    // ------------------------------------------------------------------------
+
+    void refreshSubtitleTracks();       // Query MPV for available subtitle tracks and
+    // populate the subtitle dropdown.
+
+    void setSubtitleTrack(int index);   // Switch to the subtitle track at the given
+    // dropdown index.
+
+    void loadExternalSubtitles(QString path);  // Load a subtitle file from disk
+    // (e.g., .srt, .ass files).
+
+    // ------------------------------------------------------------------------
+    // Audio Methods
+    // ------------------------------------------------------------------------
+
+    void refreshAudioTracks();          // Query MPV for available audio tracks and
+    // populate the audio dropdown.
+
+    void setAudioTrack(int index);      // Switch to the audio track at the given
+    // dropdown index.
+
+    // ------------------------------------------------------------------------
+    // Utility Methods
+    // ------------------------------------------------------------------------
+
+    QString formatTime(double time);    // Convert seconds (e.g., 3661.5) to a
+    // human-readable string (e.g., "01:01:01").
+
+    // ------------------------------------------------------------------------
+    // Public Slots
+    // ------------------------------------------------------------------------
+    // Slots are special methods that can be connected to signals. When a signal
+    // is emitted, all connected slots are called automatically.
+    //
+    // This is Qt's implementation of the Observer pattern - it allows loose
+    // coupling between objects. The timer doesn't need to know about our widget;
+    // it just emits a signal, and Qt handles the connection.
+    // ------------------------------------------------------------------------
+public slots:
+    void onTimerTick();                 // Called every time pollTimer fires.
+    // Updates the time display with current position.
+
+    // ------------------------------------------------------------------------
+    // Signals
+    // ------------------------------------------------------------------------
+    // Signals are the other half of signals/slots: the widget "emits" them and
+    // every connected slot or lambda runs. All of these are emitted from the
+    // GUI thread, while draining MPV's event queue.
+    // ------------------------------------------------------------------------
+signals:
+    void propertyChanged(const QString &name, const QVariant &value);
+    // An observed property changed. The value is
+    // invalid if the property is unavailable
+    // (e.g. no file loaded).
+
+    void fileLoaded();                  // A new file was opened and is about to play.
+
+    void playbackRestarted();           // Playback resumed after loading or seeking -
+    // the new position is now valid.
+
+    void prefillFinished();             // A stream has buffered its prefill target
+    // and is ready to play (still paused).
+
+    void logMessage(const QString &prefix, const QString &text);
+    // One line of MPV's log, once requested
+    // with requestLogMessages().
+
+private slots:
+    void onMpvEvents();                 // Drains MPV's event queue.
+
+    void onCacheProperty(const QString &name, const QVariant &value);
+    // Tracks the stream cache for the prefill
+    // and the cacheLabel.
+
+private:
+    PlayerBackend *backend;             // The MPV player instance (or a stand-in).
+    // Every MPV call goes through this - it mirrors MPV's C API.
+    // nullptr means no player is initialized.
+
+    static void onMpvWakeup(void *ctx); // Called by MPV, from one of ITS threads,
+    // whenever new events are waiting.
+
+    QStringList observedProperties;     // Index in this list = reply_userdata.
+
+    void updateCacheLabel();            // Re-render cacheLabel from the values below.
+
+    bool streaming;                     // Current file came from loadStream().
+    bool prefilling;                    // Waiting for prefillTarget to be buffered.
+    bool streamLoaded;                  // MPV has opened the stream (file-loaded).
+    double prefillTarget;               // Seconds to buffer before playing.
+    double cacheAhead;                  // demuxer-cache-duration, seconds.
+    bool cacheIdle;                     // demuxer-cache-idle (readahead limit hit).
+    double cacheSpeed;                  // cache-speed, bytes per second.
+
+    bool idle;                          // idle-active, as last reported; see hasFile().
+
+    double levelGainDb;                 // See setLevelGain().
+};
+
+#endif // MPVWIDGET_H
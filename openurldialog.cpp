@@ -0,0 +1,87 @@
+// ============================================================================
+// openurldialog.cpp - Implementation of OpenUrlDialog
+// ============================================================================
+
+#include "openurldialog.h"
+
+#include <QFormLayout>       // Label / field pairs, one per row.
+#include <QLineEdit>
+#include <QDoubleSpinBox>
+#include <QDialogButtonBox>  // Platform-ordered OK / Cancel buttons.
+#include <QSettings>         // Remembers the last URL and cache settings.
+
+// ----------------------------------------------------------------------------
+// Defaults
+// ----------------------------------------------------------------------------
+// A minute of readahead rides out most hiccups of a home connection; ten
+// seconds of prefill keeps the start reasonably quick.
+// ----------------------------------------------------------------------------
+static const double DefaultReadahead = 60.0;
+static const double DefaultPrefill   = 10.0;
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+OpenUrlDialog::OpenUrlDialog(QWidget *parent) : QDialog(parent) {
+    setWindowTitle("Open URL");
+
+    QSettings settings("MPV-watchalong", "MPV-watchalong");
+
+    urlEdit = new QLineEdit(settings.value("stream/url").toString());
+    urlEdit->setPlaceholderText("https://example.com/vod/playlist.m3u8");
+    urlEdit->setMinimumWidth(360);
+    urlEdit->selectAll();
+
+    readaheadSpin = new QDoubleSpinBox();
+    readaheadSpin->setRange(5.0, 3600.0);
+    readaheadSpin->setDecimals(0);
+    readaheadSpin->setSuffix(" s");
+    readaheadSpin->setValue(settings.value("stream/readahead", DefaultReadahead).toDouble());
+
+    prefillSpin = new QDoubleSpinBox();
+    prefillSpin->setRange(0.0, 600.0);
+    prefillSpin->setDecimals(0);
+    prefillSpin->setSuffix(" s");
+    prefillSpin->setValue(settings.value("stream/prefill", DefaultPrefill).toDouble());
+
+    // More prefill than readahead could never be reached
+    prefillSpin->setMaximum(readaheadSpin->value());
+    connect(readaheadSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+            [=](double value) { prefillSpin->setMaximum(value); });
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, this, &OpenUrlDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &OpenUrlDialog::reject);
+
+    QFormLayout *form = new QFormLayout(this);
+    form->addRow("URL:", urlEdit);
+    form->addRow("Readahead:", readaheadSpin);
+    form->addRow("Prefill before start:", prefillSpin);
+    form->addRow(buttons);
+}
+
+QString OpenUrlDialog::url() const {
+    return urlEdit->text().trimmed();
+}
+
+double OpenUrlDialog::readaheadSeconds() const {
+    return readaheadSpin->value();
+}
+
+double OpenUrlDialog::prefillSeconds() const {
+    return prefillSpin->value();
+}
+
+// ----------------------------------------------------------------------------
+// accept() - Remember the Settings
+// ----------------------------------------------------------------------------
+void OpenUrlDialog::accept() {
+    if (url().isEmpty()) return;     // Nothing to open - keep the dialog up.
+
+    QSettings settings("MPV-watchalong", "MPV-watchalong");
+    settings.setValue("stream/url", url());
+    settings.setValue("stream/readahead", readaheadSeconds());
+    settings.setValue("stream/prefill", prefillSeconds());
+
+    QDialog::accept();
+}
@@ -0,0 +1,43 @@
+// ============================================================================
+// openurldialog.h - "Open URL" Dialog for Network Streams
+// ============================================================================
+// Asks for a stream URL (HTTP, HLS...) together with the two cache settings
+// MpvWidget::loadStream() needs:
+//
+//   Readahead - how many seconds MPV keeps buffered ahead of the playback
+//               position while playing.
+//   Prefill   - how many seconds must be buffered before the stream starts
+//               (or joins the other player).
+//
+// The values are remembered between runs, so they only have to be tuned
+// once for a given connection.
+// ============================================================================
+
+#ifndef OPENURLDIALOG_H
+#define OPENURLDIALOG_H
+
+#include <QDialog>       // Base class for modal dialog windows.
+
+class QLineEdit;
+class QDoubleSpinBox;
+
+class OpenUrlDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit OpenUrlDialog(QWidget *parent = nullptr);
+
+    QString url() const;
+    double readaheadSeconds() const;
+    double prefillSeconds() const;
+
+public slots:
+    void accept() override;      // Saves the settings before closing.
+
+private:
+    QLineEdit *urlEdit;
+    QDoubleSpinBox *readaheadSpin;
+    QDoubleSpinBox *prefillSpin;
+};
+
+#endif // OPENURLDIALOG_H
@@ -0,0 +1,333 @@
+// ============================================================================
+// pairmemory.cpp - Implementation of the Per-Pair Database
+// ============================================================================
+// On disk, the database is one JSON object keyed by "<fingerprint 1>|
+// <fingerprint 2>":
+//
+//   {
+//     "3f2a...|9c01...": {
+//       "names":    ["movie.mkv", "vod.mp4"],      // Only for humans reading it.
+//       "lastUsed": 1718000000000,                  // ms since epoch.
+//       "syncMap":  [[0, 152.3], [3120.5, 31.8]],  // [position, offset] anchors.
+//       "players":  [{"aid": 1, "sid": 0, "volume": 80}, {...}]
+//     }
+//   }
+//
+// It is small (a few hundred bytes per pair) and written only when
+// something actually changes, so it's simply rewritten whole every time.
+// ============================================================================
+
+#include "pairmemory.h"
+#include "fileidentity.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRunnable>
+#include <QSaveFile>            // Write to a temp file, rename when complete.
+#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+
+namespace {
+
+QString databaseFile() {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!QDir().mkpath(dir)) return QString();
+    return dir + "/pairs.json";
+}
+
+QJsonObject settingsToJson(const PairState::PlayerSettings &settings) {
+    QJsonObject o;
+    o["aid"] = double(settings.audioTrack);
+    o["sid"] = double(settings.subtitleTrack);
+    o["volume"] = settings.volume;
+    return o;
+}
+
+PairState::PlayerSettings settingsFromJson(const QJsonObject &o) {
+    PairState::PlayerSettings settings;
+    settings.audioTrack = qint64(o.value("aid").toDouble(-1));
+    settings.subtitleTrack = qint64(o.value("sid").toDouble(-1));
+    settings.volume = o.value("volume").toInt(-1);
+    return settings;
+}
+
+void sortByPosition(QVector<PairState::Anchor> &map) {
+    std::sort(map.begin(), map.end(), [](const PairState::Anchor &a, const PairState::Anchor &b) {
+        return a.position < b.position;
+    });
+}
+
+QVector<PairState::Anchor> syncMapFromJson(const QJsonArray &array) {
+    QVector<PairState::Anchor> map;
+    for (const QJsonValue &v : array) {
+        QJsonArray pair = v.toArray();
+        if (pair.size() != 2) continue;
+        map.append({pair.at(0).toDouble(), pair.at(1).toDouble()});
+    }
+    sortByPosition(map);
+    return map;
+}
+
+QJsonArray syncMapToJson(const QVector<PairState::Anchor> &map) {
+    QJsonArray array;
+    for (const PairState::Anchor &a : map) array.append(QJsonArray{a.position, a.offset});
+    return array;
+}
+
+// ----------------------------------------------------------------------------
+// swapped() - The Same Entry Seen from the Other Player
+// ----------------------------------------------------------------------------
+// With the players swapped, player 2's position becomes the reference: an
+// anchor (p, o) turns into (p + o, -o), and the settings trade places.
+// ----------------------------------------------------------------------------
+QJsonObject swapped(const QJsonObject &entry) {
+    QJsonObject out = entry;
+
+    QJsonArray names = entry.value("names").toArray();
+    if (names.size() == 2) out["names"] = QJsonArray{names.at(1), names.at(0)};
+
+    QJsonArray players = entry.value("players").toArray();
+    if (players.size() == 2) out["players"] = QJsonArray{players.at(1), players.at(0)};
+
+    QVector<PairState::Anchor> map = syncMapFromJson(entry.value("syncMap").toArray());
+    for (PairState::Anchor &a : map) {
+        a.position += a.offset;
+        a.offset = -a.offset;
+    }
+    sortByPosition(map);
+    out["syncMap"] = syncMapToJson(map);
+    return out;
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// PairState::offsetAt()
+// ----------------------------------------------------------------------------
+double PairState::offsetAt(double position) const {
+    if (syncMap.isEmpty()) return 0.0;
+    double offset = syncMap.first().offset;
+    for (const Anchor &a : syncMap) {
+        if (a.position > position) break;
+        offset = a.offset;
+    }
+    return offset;
+}
+
+// ----------------------------------------------------------------------------
+// FingerprintTask - Hash One File Off the GUI Thread
+// ----------------------------------------------------------------------------
+class PairMemory::FingerprintTask : public QRunnable {
+public:
+    FingerprintTask(PairMemory *owner, int slot, int generation, const QString &path)
+        : owner(owner), slot(slot), generation(generation), path(path) {}
+
+    void run() override {
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+        QString fingerprint = FileIdentity::fingerprint(path);
+
+        PairMemory *owner = this->owner;
+        int slot = this->slot;
+        int generation = this->generation;
+        QMetaObject::invokeMethod(owner, [owner, slot, generation, fingerprint]() {
+            owner->finishIdentify(slot, generation, fingerprint);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    PairMemory *owner;
+    int slot;
+    int generation;
+    QString path;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+PairMemory::PairMemory(QObject *parent) : QObject(parent), haveCandidate(false),
+    candidatePosition(0.0), candidateOffset(0.0), candidateSeconds(0.0) {
+    generations[0] = generations[1] = 0;
+
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(2);       // One per player.
+
+    load();
+}
+
+PairMemory::~PairMemory() {
+    pool->waitForDone();
+}
+
+// ----------------------------------------------------------------------------
+// identify() / forget() / finishIdentify()
+// ----------------------------------------------------------------------------
+void PairMemory::identify(int slot, const QString &path) {
+    forget(slot);
+    names[slot] = QFileInfo(path).fileName();
+    pool->start(new FingerprintTask(this, slot, generations[slot], path));
+}
+
+void PairMemory::forget(int slot) {
+    generations[slot]++;
+    fingerprints[slot].clear();
+    names[slot].clear();
+    haveCandidate = false;
+}
+
+void PairMemory::finishIdentify(int slot, int generation, const QString &fingerprint) {
+    if (generation != generations[slot] || fingerprint.isEmpty()) return;
+    fingerprints[slot] = fingerprint;
+    emit identified(slot);
+}
+
+QString PairMemory::fingerprint(int slot) const {
+    return fingerprints[slot];
+}
+
+bool PairMemory::hasPair() const {
+    return !fingerprints[0].isEmpty() && !fingerprints[1].isEmpty();
+}
+
+QString PairMemory::pairKey() const {
+    return fingerprints[0] + "|" + fingerprints[1];
+}
+
+// ----------------------------------------------------------------------------
+// recall()
+// ----------------------------------------------------------------------------
+// A pair last seen in swapped players is re-stored the way round it is now,
+// so everything after this only ever deals with one orientation.
+// ----------------------------------------------------------------------------
+bool PairMemory::recall(PairState &state) {
+    if (!hasPair()) return false;
+
+    QString key = pairKey();
+    QString reversed = fingerprints[1] + "|" + fingerprints[0];
+    if (!pairs.contains(key)) {
+        if (!pairs.contains(reversed)) return false;
+        QJsonObject entry = swapped(pairs.value(reversed).toObject());
+        pairs.remove(reversed);
+        pairs.insert(key, entry);
+    }
+
+    QJsonObject e = entry();
+    state.syncMap = syncMapFromJson(e.value("syncMap").toArray());
+    QJsonArray players = e.value("players").toArray();
+    for (int i = 0; i < 2; i++) state.players[i] = settingsFromJson(players.at(i).toObject());
+
+    storeEntry(e);                    // Refresh names and lastUsed.
+    save();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// observe() - Time the Live Offset, Keep It Once It Has Stuck
+// ----------------------------------------------------------------------------
+// Any change of offset (beyond Tolerance) restarts the clock. Only time
+// spent playing counts, so leaving the pair paused mid-alignment doesn't
+// store anything. The anchor goes at the earliest position the offset was
+// seen at, so seeking back after aligning still lands on it.
+// ----------------------------------------------------------------------------
+void PairMemory::observe(double position, double offset, bool playing) {
+    if (!hasPair()) return;
+
+    if (!haveCandidate || qAbs(offset - candidateOffset) > Tolerance) {
+        haveCandidate = true;
+        candidatePosition = position;
+        candidateOffset = offset;
+        candidateSeconds = 0.0;
+        candidateClock.start();
+        return;
+    }
+
+    double elapsed = candidateClock.restart() / 1000.0;
+    candidatePosition = qMin(candidatePosition, position);
+    if (!playing || candidateSeconds >= StableSeconds) return;
+
+    candidateSeconds += elapsed;
+    if (candidateSeconds < StableSeconds) return;
+
+    QJsonObject e = entry();
+    PairState state;
+    state.syncMap = syncMapFromJson(e.value("syncMap").toArray());
+    if (!state.syncMap.isEmpty() && qAbs(state.offsetAt(candidatePosition) - candidateOffset) <= Tolerance) return;
+
+    QVector<PairState::Anchor> map;
+    for (const PairState::Anchor &a : state.syncMap) {
+        if (qAbs(a.position - candidatePosition) >= MergeSeconds) map.append(a);
+    }
+    map.append({candidatePosition, candidateOffset});
+    sortByPosition(map);
+
+    e["syncMap"] = syncMapToJson(map);
+    storeEntry(e);
+    save();
+}
+
+// ----------------------------------------------------------------------------
+// rememberSettings()
+// ----------------------------------------------------------------------------
+void PairMemory::rememberSettings(const PairState::PlayerSettings &first,
+                                  const PairState::PlayerSettings &second) {
+    if (!hasPair()) return;
+
+    QJsonObject e = entry();
+    QJsonArray players{settingsToJson(first), settingsToJson(second)};
+    if (e.value("players").toArray() == players) return;
+
+    e["players"] = players;
+    storeEntry(e);
+    save();
+}
+
+// ----------------------------------------------------------------------------
+// entry() / storeEntry()
+// ----------------------------------------------------------------------------
+QJsonObject PairMemory::entry() const {
+    return pairs.value(pairKey()).toObject();
+}
+
+void PairMemory::storeEntry(const QJsonObject &entry) {
+    QJsonObject e = entry;
+    e["names"] = QJsonArray{names[0], names[1]};
+    e["lastUsed"] = double(QDateTime::currentMSecsSinceEpoch());
+    pairs.insert(pairKey(), e);
+}
+
+// ----------------------------------------------------------------------------
+// load() / save()
+// ----------------------------------------------------------------------------
+// A missing or corrupt file just means starting with an empty memory.
+// ----------------------------------------------------------------------------
+void PairMemory::load() {
+    QFile file(databaseFile());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    pairs = QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void PairMemory::save() {
+    // Drop the least recently used pairs beyond MaxPairs.
+    if (pairs.size() > MaxPairs) {
+        QVector<QPair<double, QString>> byAge;
+        for (auto it = pairs.constBegin(); it != pairs.constEnd(); ++it) {
+            byAge.append(qMakePair(it.value().toObject().value("lastUsed").toDouble(), it.key()));
+        }
+        std::sort(byAge.begin(), byAge.end());
+        for (int i = 0; i < byAge.size() - MaxPairs; i++) pairs.remove(byAge[i].second);
+    }
+
+    QString path = databaseFile();
+    if (path.isEmpty()) return;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return;
+    file.write(QJsonDocument(pairs).toJson(QJsonDocument::Indented));
+    file.commit();
+}
@@ -0,0 +1,116 @@
+// ============================================================================
+// pairmemory.h - Remember How a Pair of Files Was Watched
+// ============================================================================
+// Lining up a VOD with a movie takes a while, and it has to be done again
+// every time the same two files are opened. PairMemory keeps a small local
+// database (a JSON file in the app data folder) with, for every PAIR of
+// files ever played together:
+//
+//   - the SYNC MAP: the offsets the pair was watched with, as a list of
+//     (player 1 position, player 2 offset) anchors. One anchor is enough for
+//     most pairs; a VOD that cut out an ad break needs one per break.
+//   - the selected audio and subtitle track of each player
+//   - the volume of each player
+//
+// Files are keyed by their content fingerprint (see fileidentity.h), not
+// their path, so a pair is recognized even after the files were renamed,
+// moved, or opened in swapped players.
+//
+// An offset only becomes an anchor once the pair has PLAYED with it for a
+// while (StableSeconds) - the offsets seen while the user is still lining
+// things up are never stored.
+// ============================================================================
+
+#ifndef PAIRMEMORY_H
+#define PAIRMEMORY_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+class QThreadPool;
+
+// ----------------------------------------------------------------------------
+// PairState - Everything Remembered About One Pair
+// ----------------------------------------------------------------------------
+struct PairState {
+    struct Anchor {
+        double position;      // Player 1 position the offset applies from.
+        double offset;        // Player 2 position - player 1 position.
+    };
+
+    struct PlayerSettings {
+        qint64 audioTrack = -1;     // MPV "aid"; -1 = unknown.
+        qint64 subtitleTrack = -1;  // MPV "sid"; 0 = off, -1 = unknown.
+        int volume = -1;            // 0-100; -1 = unknown.
+    };
+
+    QVector<Anchor> syncMap;        // Sorted by position.
+    PlayerSettings players[2];
+
+    // Offset for player 1 position `position`: that of the last anchor at or
+    // before it, or the first anchor's for earlier positions. 0 without anchors.
+    double offsetAt(double position) const;
+};
+
+class PairMemory : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PairMemory(QObject *parent = nullptr);
+    ~PairMemory();
+
+    static constexpr double StableSeconds = 60.0;   // Playback before an offset is kept.
+    static constexpr double Tolerance = 0.1;        // Offsets closer than this are "the same".
+    static constexpr double MergeSeconds = 30.0;    // New anchor replaces those this close.
+    static const int MaxPairs = 500;                // Least recently used pairs are dropped.
+
+    // Fingerprint the file playing in `slot` (0 = player 1, 1 = player 2) in
+    // the background; identified(slot) fires when done. forget() clears the
+    // slot, e.g. when its file is closed.
+    void identify(int slot, const QString &path);
+    void forget(int slot);
+    QString fingerprint(int slot) const;
+    bool hasPair() const;             // Both slots identified.
+
+    // Look up the current pair. Returns false if it was never seen before.
+    bool recall(PairState &state);
+
+    // Called periodically with the live alignment; records an anchor once
+    // an offset has been played with for StableSeconds.
+    void observe(double position, double offset, bool playing);
+
+    // Store track and volume choices for the current pair (if they changed).
+    void rememberSettings(const PairState::PlayerSettings &first,
+                          const PairState::PlayerSettings &second);
+
+signals:
+    void identified(int slot);
+
+private:
+    class FingerprintTask;
+
+    void finishIdentify(int slot, int generation, const QString &fingerprint);
+    QString pairKey() const;
+    QJsonObject entry() const;
+    void storeEntry(const QJsonObject &entry);
+    void load();
+    void save();
+
+    QThreadPool *pool;
+    QString fingerprints[2];
+    QString names[2];
+    int generations[2];               // Bumped by identify()/forget(); stale results are dropped.
+    QJsonObject pairs;                // pairKey() -> entry, as stored on disk.
+
+    // The offset observe() is currently timing.
+    bool haveCandidate;
+    double candidatePosition;
+    double candidateOffset;
+    double candidateSeconds;
+    QElapsedTimer candidateClock;
+};
+
+#endif // PAIRMEMORY_H
@@ -0,0 +1,71 @@
+// ============================================================================
+// playerbackend.cpp - Backend Selection
+// ============================================================================
+
+#include "playerbackend.h"
+#include "fakebackend.h"
+#include "instrumentedbackend.h"
+#include "mpvbackend.h"
+#include "playerhost.h"              // PlayerChannel::processCpuSeconds()
+#include "remotebackend.h"
+
+#include <mpv/client.h>          // mpv_error_string()
+
+#include <atomic>
+
+namespace {
+
+// Set once from main() before any player exists; atomics only so the odd
+// backend created on a worker thread reads a defined value.
+std::atomic<int> chosenKind(PlayerBackend::Mpv);
+std::atomic<bool> instrumented(false);
+std::atomic<bool> outOfProcess(false);
+
+} // namespace
+
+PlayerBackend::~PlayerBackend() {}
+
+PlayerBackend *PlayerBackend::create() {
+    return create(defaultKind());
+}
+
+PlayerBackend *PlayerBackend::create(Kind kind) {
+    PlayerBackend *backend = nullptr;
+    if (kind == Fake)        backend = new FakeBackend();
+    else if (outOfProcess)   backend = new RemoteBackend();
+    else                     backend = new MpvBackend();
+    if (instrumented) backend = new InstrumentedBackend(backend);
+    return backend;
+}
+
+void PlayerBackend::setDefaultKind(Kind kind) {
+    chosenKind = kind;
+}
+
+PlayerBackend::Kind PlayerBackend::defaultKind() {
+    return static_cast<Kind>(chosenKind.load());
+}
+
+void PlayerBackend::setInstrumentationEnabled(bool enabled) {
+    instrumented = enabled;
+}
+
+bool PlayerBackend::isInstrumentationEnabled() {
+    return instrumented;
+}
+
+void PlayerBackend::setOutOfProcessEnabled(bool enabled) {
+    outOfProcess = enabled;
+}
+
+bool PlayerBackend::isOutOfProcessEnabled() {
+    return outOfProcess;
+}
+
+double PlayerBackend::cpuSeconds() {
+    return PlayerChannel::processCpuSeconds() + RemoteBackend::helperCpuSeconds();
+}
+
+QString PlayerBackend::errorString(int error) {
+    return QString::fromUtf8(mpv_error_string(error));
+}
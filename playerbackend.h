@@ -0,0 +1,167 @@
+// ============================================================================
+// playerbackend.h - The One Way Into a Player
+// ============================================================================
+// Everything the app does to a player - options, commands, properties,
+// events - goes through this small interface instead of calling libmpv
+// directly. There are four implementations:
+//
+//   MpvBackend           (mpvbackend.h)          The real thing: every call
+//                                                is exactly one libmpv call.
+//   RemoteBackend        (remotebackend.h)       The real thing in a helper
+//                                                process, restarted if it
+//                                                crashes (--out-of-process).
+//   FakeBackend          (fakebackend.h)         A scripted player in the
+//                                                same process: a clock, a
+//                                                property table and an
+//                                                event queue. No video, no
+//                                                windows, no libmpv work.
+//   InstrumentedBackend  (instrumentedbackend.h) Wraps either of them and
+//                                                counts every call and its
+//                                                latency.
+//
+// The shape follows libmpv closely, so code reads the same as before: the
+// functions return mpv error codes (>= 0 is success), scalar properties
+// are typed, and structured values (track lists, command arguments and
+// results) are QVariants, converted the way MpvHelpers does.
+//
+// Which backend a new player gets is chosen once at startup (--backend,
+// --out-of-process, --instrument, see main.cpp). When instrumentation is
+// off, no wrapper exists, so it costs nothing.
+//
+// The one exception is the IPC server: it speaks mpv's own protocol on
+// separate client handles (createClient()), which only the in-process
+// real backend can provide.
+// ============================================================================
+
+#ifndef PLAYERBACKEND_H
+#define PLAYERBACKEND_H
+
+#include <QString>
+#include <QVariant>
+
+struct mpv_handle;
+
+// ----------------------------------------------------------------------------
+// PlayerEvent - One Entry of a Player's Event Queue
+// ----------------------------------------------------------------------------
+// A plain copy of the few mpv events the app reacts to, so it can outlive
+// the next waitEvent() call (mpv's own event struct doesn't).
+// ----------------------------------------------------------------------------
+struct PlayerEvent {
+    enum Type { None, PropertyChange, FileLoaded, PlaybackRestart, EndFile, Shutdown, LogMessage, Other };
+
+    Type type = None;
+    quint64 id = 0;          // reply_userdata (the observer id for property changes).
+    int error = 0;           // mpv error code (EndFile: why the file ended badly).
+    QString name;            // PropertyChange: the property. LogMessage: the prefix.
+    QVariant value;          // PropertyChange: new value, invalid if unavailable.
+                             // LogMessage: the line, without its newline.
+    int endReason = 0;       // EndFile: MPV_END_FILE_REASON_*.
+};
+
+class PlayerBackend {
+public:
+    enum Kind { Mpv, Fake };
+
+    virtual ~PlayerBackend();
+
+    // ------------------------------------------------------------------------
+    // Choosing a Backend
+    // ------------------------------------------------------------------------
+    // create() makes a backend of the kind chosen at startup, wrapped in an
+    // InstrumentedBackend if instrumentation is on. Set both before the
+    // first player is created.
+    // ------------------------------------------------------------------------
+    static PlayerBackend *create();
+    static PlayerBackend *create(Kind kind);
+    static void setDefaultKind(Kind kind);
+    static Kind defaultKind();
+    static void setInstrumentationEnabled(bool enabled);
+    static bool isInstrumentationEnabled();
+
+    // Mpv players run in helper processes (RemoteBackend). Fake ones stay
+    // in process.
+    static void setOutOfProcessEnabled(bool enabled);
+    static bool isOutOfProcessEnabled();
+
+    // CPU seconds used so far by this process and the helpers it started,
+    // so a player's decoding counts wherever it runs.
+    static double cpuSeconds();
+
+    // mpv_error_string() for the codes these functions return.
+    static QString errorString(int error);
+
+    // False if the player couldn't be created at all (mpv_create failed).
+    virtual bool isValid() const = 0;
+
+    // ------------------------------------------------------------------------
+    // Setup - Options Only Work Before initialize()
+    // ------------------------------------------------------------------------
+    virtual int setOption(const char *name, const char *value) = 0;
+    virtual int initialize() = 0;
+
+    // Called from any thread when the event queue becomes non-empty. Like
+    // libmpv's, the callback must not call back into the backend.
+    virtual void setWakeupCallback(void (*callback)(void *ctx), void *ctx) = 0;
+
+    // ------------------------------------------------------------------------
+    // Commands
+    // ------------------------------------------------------------------------
+    // `args` is a NULL-terminated array of strings, as for mpv_command().
+    // commandNode() takes a list or a map with named arguments and returns
+    // the command's result, if it has one.
+    // ------------------------------------------------------------------------
+    virtual int command(const char **args) = 0;
+    virtual int commandAsync(quint64 id, const char **args) = 0;
+    virtual int commandNode(const QVariant &args, QVariant *result = nullptr) = 0;
+
+    // ------------------------------------------------------------------------
+    // Properties
+    // ------------------------------------------------------------------------
+    // On failure the output is left untouched, so callers can preset a
+    // default. setString() uses mpv's string parser ("yes", "64MiB"...).
+    // ------------------------------------------------------------------------
+    virtual int getDouble(const char *name, double *value) = 0;
+    virtual int getInt(const char *name, qint64 *value) = 0;
+    virtual int getFlag(const char *name, bool *value) = 0;
+    virtual int getString(const char *name, QString *value) = 0;
+    virtual int getNode(const char *name, QVariant *value) = 0;
+
+    virtual int setDouble(const char *name, double value) = 0;
+    virtual int setInt(const char *name, qint64 value) = 0;
+    virtual int setFlag(const char *name, bool value) = 0;
+    virtual int setString(const char *name, const char *value) = 0;
+
+    // Change events arrive with `id` and the value as a QVariant.
+    virtual int observeProperty(quint64 id, const char *name) = 0;
+
+    // Deliver the player's own log lines of `minLevel` and above ("warn",
+    // "info", "v"...) as LogMessage events; "no" stops them again.
+    virtual int requestLogMessages(const char *minLevel) = 0;
+
+    // ------------------------------------------------------------------------
+    // Events and Teardown
+    // ------------------------------------------------------------------------
+    // waitEvent() returns a None event once the queue is empty (timeout 0
+    // never blocks). Deleting a backend releases the player without waiting
+    // for it (mpv_destroy); terminate() waits until it is completely shut
+    // down - and e.g. an encoder has written its file - first. It returns
+    // false if the player didn't get that far: a helper process that died
+    // or had to be killed on the way leaves an encoder's file unfinished.
+    // ------------------------------------------------------------------------
+    virtual PlayerEvent waitEvent(double timeout) = 0;
+    virtual bool terminate() = 0;
+
+    // A separate libmpv client handle on the same player, for the IPC
+    // server. nullptr for backends without libmpv behind them.
+    virtual mpv_handle *createClient(const char *name) = 0;
+
+protected:
+    PlayerBackend() {}
+
+private:
+    PlayerBackend(const PlayerBackend &) = delete;
+    PlayerBackend &operator=(const PlayerBackend &) = delete;
+};
+
+#endif // PLAYERBACKEND_H
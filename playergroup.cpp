@@ -0,0 +1,244 @@
+// ============================================================================
+// playergroup.cpp - Implementation of PlayerGroup
+// ============================================================================
+// See playergroup.h for the idea of "group time" and per-player offsets.
+// ============================================================================
+
+#include "playergroup.h"
+#include "mpvwidget.h"           // For the full MpvWidget class definition.
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+PlayerGroup::PlayerGroup(QObject *parent)
+    : QObject(parent), nominalSpeed(1.0), rateCorrection(1.0), held(false), requestedPause(true) {
+}
+
+// ----------------------------------------------------------------------------
+// addPlayer() / members()
+// ----------------------------------------------------------------------------
+void PlayerGroup::addPlayer(MpvWidget *player) {
+    if (player && !players.contains(player)) {
+        players.append(player);
+        memberCorrections.append(1.0);
+    }
+}
+
+const QList<MpvWidget *> &PlayerGroup::members() const {
+    return players;
+}
+
+// ----------------------------------------------------------------------------
+// isActive() - Does a Player Take Part in Group Control?
+// ----------------------------------------------------------------------------
+// A stream that is still prefilling has a file loaded, but its position is
+// meaningless until it starts playing, so it is left out like an empty one.
+// ----------------------------------------------------------------------------
+bool PlayerGroup::isActive(MpvWidget *player) {
+    return player->hasFile() && !player->isPrefilling();
+}
+
+// ----------------------------------------------------------------------------
+// reference() - The Player That Defines Group Time
+// ----------------------------------------------------------------------------
+// Normally this is player 1 (the movie). If player 1 is empty but player 2
+// has a file, player 2 becomes the reference so the group still has a
+// meaningful timeline.
+// ----------------------------------------------------------------------------
+MpvWidget *PlayerGroup::reference() const {
+    for (MpvWidget *p : players) {
+        if (isActive(p)) return p;
+    }
+    return nullptr;
+}
+
+bool PlayerGroup::hasMedia() const {
+    return reference() != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// join() - Let a Prefilled Stream Take Part
+// ----------------------------------------------------------------------------
+// The new player keeps its position: where a stream starts relative to the
+// others is up to the user, exactly as with a local file. It only takes
+// over the group's speed and transport state. If nobody else is playing or
+// paused (the stream is the only file), joining simply starts it. During a
+// hold it stays paused and is resumed with the others on release.
+// ----------------------------------------------------------------------------
+void PlayerGroup::join(MpvWidget *player) {
+    if (!players.contains(player) || !isActive(player)) return;
+
+    bool othersActive = false;
+    bool othersPaused = true;
+    for (MpvWidget *p : players) {
+        if (p == player || !isActive(p)) continue;
+        othersActive = true;
+        if (!p->isPaused()) othersPaused = false;
+    }
+
+    player->setSpeed(nominalSpeed * rateCorrection * memberCorrections.value(players.indexOf(player), 1.0));
+
+    if (held) {
+        player->setPaused(true);
+        if (!othersActive) requestedPause = false;
+        return;
+    }
+    player->setPaused(othersActive && othersPaused);
+}
+
+// ----------------------------------------------------------------------------
+// position() - Current Group Time
+// ----------------------------------------------------------------------------
+double PlayerGroup::position() const {
+    MpvWidget *ref = reference();
+    return ref ? ref->position() : 0.0;
+}
+
+// ----------------------------------------------------------------------------
+// currentOffsets() - Sample Every Player's Offset From the Reference
+// ----------------------------------------------------------------------------
+// All positions are read first and only then turned into offsets, so the
+// samples are as close together in time as possible.
+// ----------------------------------------------------------------------------
+QVector<double> PlayerGroup::currentOffsets() const {
+    QVector<double> offsets(players.size(), 0.0);
+
+    MpvWidget *ref = reference();
+    if (!ref) return offsets;
+
+    QVector<double> positions(players.size(), 0.0);
+    for (int i = 0; i < players.size(); i++) {
+        if (isActive(players[i])) positions[i] = players[i]->position();
+    }
+
+    double refPos = positions[players.indexOf(ref)];
+    for (int i = 0; i < players.size(); i++) {
+        if (isActive(players[i])) offsets[i] = positions[i] - refPos;
+    }
+    return offsets;
+}
+
+// ----------------------------------------------------------------------------
+// isPaused() / setPaused()
+// ----------------------------------------------------------------------------
+// isPaused() reports what the players are actually doing, so during a hold
+// it is true even if the user pressed play.
+// ----------------------------------------------------------------------------
+bool PlayerGroup::isPaused() const {
+    for (MpvWidget *p : players) {
+        if (isActive(p) && !p->isPaused()) return false;
+    }
+    return true;
+}
+
+void PlayerGroup::setPaused(bool paused) {
+    requestedPause = paused;
+    if (held) return;              // Applied by setHeld(false) instead.
+
+    // Issue the calls back-to-back with nothing in between, so both players
+    // change state within a few microseconds of each other. A prefilling
+    // stream stays paused until join().
+    for (MpvWidget *p : players) {
+        if (!p->isPrefilling()) p->setPaused(paused);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// setHeld() / isHeld() / pauseRequested()
+// ----------------------------------------------------------------------------
+void PlayerGroup::setHeld(bool hold) {
+    if (hold == held) return;
+
+    if (hold) {
+        // Remember what the players were doing, so releasing the hold
+        // restores it - unless setPaused() is called in the meantime.
+        requestedPause = isPaused();
+        for (MpvWidget *p : players) {
+            p->setPaused(true);
+        }
+        held = true;
+    } else {
+        held = false;
+        setPaused(requestedPause);
+    }
+}
+
+bool PlayerGroup::isHeld() const {
+    return held;
+}
+
+bool PlayerGroup::pauseRequested() const {
+    return held ? requestedPause : isPaused();
+}
+
+// ----------------------------------------------------------------------------
+// seekRelative() / seekTo()
+// ----------------------------------------------------------------------------
+void PlayerGroup::seekRelative(double seconds) {
+    for (MpvWidget *p : players) {
+        if (!p->isPrefilling()) p->seek(seconds);
+    }
+}
+
+void PlayerGroup::seekTo(double groupTime) {
+    // Capture the offsets BEFORE seeking anything. Once the reference player
+    // has moved, the live offsets of the other players would be wrong.
+    seekTo(groupTime, currentOffsets());
+}
+
+void PlayerGroup::seekTo(double groupTime, const QVector<double> &offsets) {
+    for (int i = 0; i < players.size(); i++) {
+        if (!isActive(players[i])) continue;
+        players[i]->seekAbsolute(groupTime + offsets.value(i));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// speed() / setSpeed() / setRateCorrection() / setMemberCorrection()
+// ----------------------------------------------------------------------------
+// The speed each player actually runs at is the nominal group speed times
+// two correction factors: one for the whole group (the watch party keeping
+// this instance in step with the leader) and one per member (the drift
+// controller keeping the players in step with each other). The user only
+// ever changes the nominal speed; drift controllers only ever change the
+// corrections. Keeping them apart means a correction can never "stick" and
+// become the new nominal speed.
+// ----------------------------------------------------------------------------
+double PlayerGroup::speed() const {
+    return nominalSpeed;
+}
+
+void PlayerGroup::setSpeed(double speed) {
+    speed = qBound(MinSpeed, speed, MaxSpeed);
+    if (speed == nominalSpeed) return;
+    nominalSpeed = speed;
+    applySpeed();
+    emit speedChanged(nominalSpeed);
+}
+
+void PlayerGroup::setRateCorrection(double factor) {
+    // Skip redundant property writes - drift controllers call this often.
+    if (factor == rateCorrection) return;
+    rateCorrection = factor;
+    applySpeed();
+}
+
+void PlayerGroup::setMemberCorrection(int index, double factor) {
+    if (index < 0 || index >= players.size() || factor == memberCorrections[index]) return;
+    memberCorrections[index] = factor;
+    players[index]->setSpeed(nominalSpeed * rateCorrection * factor);
+}
+
+double PlayerGroup::memberCorrection(int index) const {
+    return memberCorrections.value(index, 1.0);
+}
+
+// MpvWidget::setSpeed() doesn't wait for the player, so every member gets
+// its new speed within microseconds of the others - no member runs ahead at
+// the new speed while the next one is still being told.
+void PlayerGroup::applySpeed() {
+    double effective = nominalSpeed * rateCorrection;
+    for (int i = 0; i < players.size(); i++) {
+        players[i]->setSpeed(effective * memberCorrections[i]);
+    }
+}
@@ -0,0 +1,126 @@
+// ============================================================================
+// playergroup.h - Group Control for Several MpvWidgets
+// ============================================================================
+// A PlayerGroup bundles every local player (player1, player2, ...) so that
+// "global" actions can be expressed once instead of being repeated for each
+// player in MainWindow's lambdas.
+//
+// The group has its own timeline, the "group time". Group time is simply the
+// playback position of the reference player (the first player that has a
+// file loaded). Every other player is described by its OFFSET from that
+// reference:
+//
+//     offset(player) = position(player) - position(reference)
+//
+// So if the movie (player 1) is at 00:10:00 and the VOD (player 2) is at
+// 00:12:30, player 2's offset is +150 seconds. Seeking the group to group
+// time T then means seeking each player to T + offset(player).
+// ============================================================================
+
+#ifndef PLAYERGROUP_H
+#define PLAYERGROUP_H
+
+#include <QObject>       // Base class - gives us signals/slots and parenting.
+#include <QList>         // Qt's dynamic array, used for the member list.
+#include <QVector>       // Used to return one offset per member.
+
+class MpvWidget;         // Forward declaration - full definition in mpvwidget.h.
+// Only pointers are used here, so the header
+// doesn't need to pull in all of libmpv.
+
+class PlayerGroup : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PlayerGroup(QObject *parent = nullptr);
+
+    // ------------------------------------------------------------------------
+    // Membership
+    // ------------------------------------------------------------------------
+
+    void addPlayer(MpvWidget *player);          // Add a player to the group.
+    const QList<MpvWidget *> &members() const;  // All players, in the order added.
+
+    MpvWidget *reference() const;               // The player that defines group time,
+    // or nullptr if no player has a file.
+
+    bool hasMedia() const;                      // True if at least one player has a file.
+
+    // ------------------------------------------------------------------------
+    // Joining Late
+    // ------------------------------------------------------------------------
+    // A player that is still prefilling a network stream (see
+    // MpvWidget::loadStream) sits outside the group: group controls leave it
+    // alone and it doesn't count for group time. join() brings it in once
+    // prefill is done, matching the group's speed and pause state.
+    // ------------------------------------------------------------------------
+
+    void join(MpvWidget *player);
+
+    // ------------------------------------------------------------------------
+    // Group Timeline
+    // ------------------------------------------------------------------------
+
+    double position() const;                    // Current group time in seconds.
+
+    QVector<double> currentOffsets() const;     // Offset of every member (same order as
+    // members()), sampled right now. Players
+    // without a file (or still prefilling)
+    // get an offset of 0.
+
+    // ------------------------------------------------------------------------
+    // Group Transport Controls
+    // ------------------------------------------------------------------------
+
+    bool isPaused() const;                      // True if every loaded player is paused.
+    void setPaused(bool paused);                // Pause or resume all players.
+
+    // ------------------------------------------------------------------------
+    // Hold
+    // ------------------------------------------------------------------------
+    // A hold keeps every player paused regardless of what the user asks for,
+    // e.g. while one of them is buffering. Pause/resume requests made during
+    // the hold are remembered and applied, to all players at once, when the
+    // hold is released.
+    // ------------------------------------------------------------------------
+
+    void setHeld(bool held);
+    bool isHeld() const;
+    bool pauseRequested() const;                // The state setPaused() last asked for.
+
+    void seekRelative(double seconds);          // Move every player by the same amount.
+    void seekTo(double groupTime);              // Move every player to groupTime + offset.
+    void seekTo(double groupTime,               // Same, with explicit offsets (one per
+                const QVector<double> &offsets);// member) - used to restore an alignment.
+
+    static constexpr double MinSpeed = 0.25;
+    static constexpr double MaxSpeed = 4.0;
+
+    double speed() const;                       // Nominal playback speed of the group.
+    void setSpeed(double speed);                // Apply the same speed to all players
+    // (clamped to MinSpeed..MaxSpeed).
+
+    void setRateCorrection(double factor);      // Small multiplier on top of the nominal
+    // speed, used by drift controllers to
+    // catch up or fall back (e.g. 1.02).
+
+    void setMemberCorrection(int index,         // Same, for one member only - keeps
+                             double factor);    // the players in step with each other.
+    double memberCorrection(int index) const;
+
+signals:
+    void speedChanged(double speed);            // The nominal speed changed.
+
+private:
+    static bool isActive(MpvWidget *player);    // Has a file and isn't prefilling.
+    void applySpeed();                          // Push nominalSpeed * rateCorrection.
+
+    QList<MpvWidget *> players;                 // Not owned - MainWindow owns the widgets.
+    double nominalSpeed;                        // Last speed set through setSpeed().
+    double rateCorrection;                      // Last factor set through setRateCorrection().
+    QVector<double> memberCorrections;          // Per member, same order as players.
+    bool held;                                  // True while setHeld(true) is in effect.
+    bool requestedPause;                        // Applied when the hold is released.
+};
+
+#endif // PLAYERGROUP_H
@@ -0,0 +1,377 @@
+// ============================================================================
+// playerhost.cpp - Implementation of PlayerChannel and PlayerHost
+// ============================================================================
+
+#include "playerhost.h"
+#include "mpvbackend.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QThread>
+
+#include <mpv/client.h>          // MPV_ERROR_*
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+    #include <windows.h>
+#else
+    #include <errno.h>
+    #include <signal.h>
+    #include <sys/resource.h>    // getrusage()
+#endif
+
+static const double EventSliceSeconds = 0.25;        // Heartbeat period of the event thread.
+
+// ============================================================================
+// PlayerChannel
+// ============================================================================
+void PlayerChannel::reset(qint64 gui) {
+    magic = Magic;
+    version = Version;
+    guiPid = gui;
+    hostPid = 0;
+    ready = 0;
+    heartbeat = 0;
+    cpuMicros = 0;
+    positionBits = 0;
+    hasPosition = 0;
+    paused = 0;
+    SharedRing::reset(&requestRing, RequestBytes);
+    SharedRing::reset(&replyRing, ReplyBytes);
+    SharedRing::reset(&eventRing, EventBytes);
+}
+
+QByteArray PlayerChannel::encodeEvent(const PlayerEvent &event) {
+    QByteArray message;
+    QDataStream out(&message, QIODevice::WriteOnly);
+    out << qint32(event.type) << event.id << qint32(event.error) << event.name << event.value
+        << qint32(event.endReason);
+    return message;
+}
+
+bool PlayerChannel::decodeEvent(const QByteArray &message, PlayerEvent &event) {
+    QDataStream in(message);
+    qint32 type = 0, error = 0, endReason = 0;
+    in >> type >> event.id >> error >> event.name >> event.value >> endReason;
+    if (in.status() != QDataStream::Ok) return false;
+    event.type = static_cast<PlayerEvent::Type>(type);
+    event.error = error;
+    event.endReason = endReason;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// processAlive() / killProcess() / processCpuSeconds()
+// ----------------------------------------------------------------------------
+bool PlayerChannel::processAlive(qint64 pid) {
+    if (pid <= 0) return false;
+#if defined(Q_OS_WIN)
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+    if (!process) return false;
+    bool running = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return running;
+#else
+    return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+void PlayerChannel::killProcess(qint64 pid) {
+    if (pid <= 0) return;
+#if defined(Q_OS_WIN)
+    HANDLE process = OpenProcess(PROCESS_TERMINATE, FALSE, static_cast<DWORD>(pid));
+    if (!process) return;
+    TerminateProcess(process, 1);
+    CloseHandle(process);
+#else
+    kill(static_cast<pid_t>(pid), SIGKILL);
+#endif
+}
+
+double PlayerChannel::processCpuSeconds() {
+#if defined(Q_OS_WIN)
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    auto seconds = [](const FILETIME &t) {
+        return double((quint64(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 1e7;   // 100 ns units
+    };
+    return seconds(kernel) + seconds(user);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+         + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+// ============================================================================
+// PlayerHost
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// run() - The Helper's main()
+// ----------------------------------------------------------------------------
+// Qt's event loop keeps the main thread; the request thread ends it once
+// the player is gone.
+// ----------------------------------------------------------------------------
+int PlayerHost::run(const QString &key) {
+    PlayerHost host(key);
+    if (!host.attach()) return 1;
+
+    QThread *requests = QThread::create([&host]() { host.serveRequests(); });
+    requests->start();
+    int code = QCoreApplication::exec();
+    requests->wait();
+    delete requests;
+    return code;
+}
+
+PlayerHost::PlayerHost(const QString &key)
+    : memory(key), channel(nullptr), backend(nullptr), eventThread(nullptr), stopping(false),
+      exitArmed(false) {}
+
+PlayerHost::~PlayerHost() {
+    stopEvents();
+    delete backend;
+}
+
+// ----------------------------------------------------------------------------
+// attach() - Map the Channel, Create the Player, Report Ready
+// ----------------------------------------------------------------------------
+bool PlayerHost::attach() {
+    if (!memory.attach()) {
+        qWarning() << "Player host: can't attach to" << memory.key() << memory.errorString();
+        return false;
+    }
+    if (memory.size() < static_cast<qsizetype>(sizeof(PlayerChannel))) return false;
+
+    channel = static_cast<PlayerChannel *>(memory.data());
+    if (channel->magic != PlayerChannel::Magic || channel->version != PlayerChannel::Version) {
+        qWarning() << "Player host: channel version mismatch";
+        return false;
+    }
+
+    backend = new MpvBackend();
+    eventThread = QThread::create([this]() { forwardEvents(); });
+    eventThread->start();
+
+    channel->hostPid = QCoreApplication::applicationPid();
+    channel->ready = 1;
+    SharedRing::wake(&channel->ready);
+    return true;
+}
+
+bool PlayerHost::guiAlive() const {
+    return PlayerChannel::processAlive(channel->guiPid);
+}
+
+void PlayerHost::stopEvents() {
+    stopping = true;
+    if (!eventThread) return;
+    eventThread->wait();
+    delete eventThread;
+    eventThread = nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// serveRequests() - Request Thread
+// ----------------------------------------------------------------------------
+// Runs until Terminate/Destroy, or until the GUI process is gone. Whatever
+// ends it, mpv_destroy() gets ExitGraceMs before the process exits anyway
+// - a hung teardown is exactly what the helper is there to absorb.
+// ----------------------------------------------------------------------------
+void PlayerHost::serveRequests() {
+    SharedRing requests = channel->requests();
+    SharedRing replies = channel->replies();
+    auto alive = [this]() { return guiAlive(); };
+
+    bool exitAfter = false;
+    while (!exitAfter) {
+        QByteArray request;
+        if (requests.read(request, -1, alive) != SharedRing::Ok) break;
+        QByteArray reply = execute(request, &exitAfter);
+        if (!reply.isEmpty() && !replies.write(reply, alive)) break;
+    }
+
+    armExitWatchdog();
+    stopEvents();
+    delete backend;                          // mpv_destroy(); a no-op after Terminate.
+    backend = nullptr;
+    QMetaObject::invokeMethod(QCoreApplication::instance(), []() { QCoreApplication::quit(); },
+                              Qt::QueuedConnection);
+}
+
+// ----------------------------------------------------------------------------
+// armExitWatchdog() - Exit After ExitGraceMs, Whatever mpv Does
+// ----------------------------------------------------------------------------
+// Armed BEFORE the teardown call that might hang: mpv_terminate_destroy()
+// for Terminate, mpv_destroy() otherwise.
+// ----------------------------------------------------------------------------
+void PlayerHost::armExitWatchdog() {
+    if (exitArmed) return;
+    exitArmed = true;
+
+    // Never deleted: the process ends before it, one way or the other.
+    QThread *watchdog = QThread::create([]() {
+        QThread::msleep(ExitGraceMs);
+        std::_Exit(0);
+    });
+    watchdog->start();
+}
+
+// ----------------------------------------------------------------------------
+// execute() - One Request, One Reply
+// ----------------------------------------------------------------------------
+QByteArray PlayerHost::execute(const QByteArray &request, bool *exitAfter) {
+    QDataStream in(request);
+    quint8 op = 0;
+    quint64 sequence = 0;
+    QVariantList args;
+    in >> op >> sequence >> args;
+
+    auto text = [&args](int i) { return args.value(i).toByteArray(); };
+
+    int error = MPV_ERROR_INVALID_PARAMETER;
+    QVariant value;
+
+    if (in.status() == QDataStream::Ok) {
+        switch (op) {
+        case PlayerChannel::SetOption:
+            error = backend->setOption(text(0).constData(), text(1).constData());
+            break;
+        case PlayerChannel::Initialize:
+            error = backend->initialize();
+            if (error >= 0) {
+                backend->observeProperty(PositionId, "time-pos");
+                backend->observeProperty(PauseId, "pause");
+            }
+            break;
+        case PlayerChannel::Command:
+        case PlayerChannel::CommandAsync: {
+            // Arguments after the reply id (CommandAsync) are the strings.
+            int first = op == PlayerChannel::CommandAsync ? 1 : 0;
+            QList<QByteArray> strings;
+            for (int i = first; i < args.size(); i++) strings.append(args[i].toByteArray());
+            QVector<const char *> argv;
+            for (const QByteArray &s : strings) argv.append(s.constData());
+            argv.append(nullptr);
+            error = op == PlayerChannel::Command
+                  ? backend->command(argv.data())
+                  : backend->commandAsync(args.value(0).toULongLong(), argv.data());
+            break;
+        }
+        case PlayerChannel::CommandNode:
+            error = backend->commandNode(args.value(0), args.value(1).toBool() ? &value : nullptr);
+            break;
+        case PlayerChannel::GetDouble: {
+            double result = 0.0;
+            error = backend->getDouble(text(0).constData(), &result);
+            value = result;
+            break;
+        }
+        case PlayerChannel::GetInt: {
+            qint64 result = 0;
+            error = backend->getInt(text(0).constData(), &result);
+            value = result;
+            break;
+        }
+        case PlayerChannel::GetFlag: {
+            bool result = false;
+            error = backend->getFlag(text(0).constData(), &result);
+            value = result;
+            break;
+        }
+        case PlayerChannel::GetString: {
+            QString result;
+            error = backend->getString(text(0).constData(), &result);
+            value = result;
+            break;
+        }
+        case PlayerChannel::GetNode:
+            error = backend->getNode(text(0).constData(), &value);
+            break;
+        case PlayerChannel::SetDouble:
+            error = backend->setDouble(text(0).constData(), args.value(1).toDouble());
+            break;
+        case PlayerChannel::SetInt:
+            error = backend->setInt(text(0).constData(), args.value(1).toLongLong());
+            break;
+        case PlayerChannel::SetFlag:
+            error = backend->setFlag(text(0).constData(), args.value(1).toBool());
+            break;
+        case PlayerChannel::SetString:
+            error = backend->setString(text(0).constData(), text(1).constData());
+            break;
+        case PlayerChannel::Observe:
+            error = backend->observeProperty(args.value(0).toULongLong(), text(1).constData());
+            break;
+        case PlayerChannel::LogMessages:
+            error = backend->requestLogMessages(text(0).constData());
+            break;
+        case PlayerChannel::Terminate:
+            armExitWatchdog();
+            stopEvents();
+            backend->terminate();
+            error = 0;
+            *exitAfter = true;
+            break;
+        case PlayerChannel::Destroy:
+            *exitAfter = true;
+            return QByteArray();
+        default:
+            error = MPV_ERROR_NOT_IMPLEMENTED;
+            break;
+        }
+    }
+
+    QByteArray reply;
+    QDataStream out(&reply, QIODevice::WriteOnly);
+    out << sequence << qint32(error) << value;
+    return reply;
+}
+
+// ----------------------------------------------------------------------------
+// forwardEvents() - Event Thread
+// ----------------------------------------------------------------------------
+// Waits on MPV's queue in short slices so the heartbeat keeps ticking
+// while nothing happens; the host's CPU time goes out with each beat, for
+// PlayerBackend::cpuSeconds() on the GUI side. The status properties are
+// swallowed here; a repeated Shutdown (MPV keeps reporting it until
+// destroyed) is forwarded only once.
+// ----------------------------------------------------------------------------
+void PlayerHost::forwardEvents() {
+    SharedRing events = channel->events();
+    auto alive = [this]() { return !stopping && guiAlive(); };
+    bool shutDown = false;
+
+    while (!stopping) {
+        PlayerEvent event = backend->waitEvent(EventSliceSeconds);
+        channel->heartbeat.fetch_add(1);
+        channel->cpuMicros = static_cast<quint64>(PlayerChannel::processCpuSeconds() * 1e6);
+
+        if (event.type == PlayerEvent::None || (shutDown && event.type == PlayerEvent::Shutdown)) {
+            if (!backend->isValid() || shutDown) QThread::msleep(static_cast<unsigned long>(EventSliceSeconds * 1000));
+            continue;
+        }
+        if (event.type == PlayerEvent::PropertyChange && event.id == PositionId) {
+            if (event.value.isValid()) {
+                double position = event.value.toDouble();
+                quint64 bits = 0;
+                std::memcpy(&bits, &position, sizeof bits);
+                channel->positionBits = bits;
+                channel->hasPosition = 1;
+            }
+            continue;
+        }
+        if (event.type == PlayerEvent::PropertyChange && event.id == PauseId) {
+            channel->paused = event.value.toBool() ? 1 : 0;
+            continue;
+        }
+        if (event.type == PlayerEvent::Shutdown) shutDown = true;
+
+        if (!events.write(PlayerChannel::encodeEvent(event), alive)) break;
+    }
+}
@@ -0,0 +1,140 @@
+// ============================================================================
+// playerhost.h - A Player in Its Own Process
+// ============================================================================
+// With --out-of-process each player's libmpv core runs in a helper process
+// - the app's own executable started with --player-host=<key> - instead
+// of inside the GUI. A decoder crash or an mpv_destroy() that never
+// returns then only takes the helper down; RemoteBackend (remotebackend.h)
+// notices and starts a new one at the same position.
+//
+// The two processes share one block of memory, the PlayerChannel:
+//
+//   requests  GUI -> host   one message per PlayerBackend call
+//   replies   host -> GUI   the result of each call, in order
+//   events    host -> GUI   what waitEvent() returns
+//   status                  the last position and pause state, kept up to
+//                           date by the host so a restart can resume there
+//
+// Each direction is a SharedRing (sharedring.h): lock-free, with a futex
+// wakeup, so a property read costs two ring messages and usually no
+// syscall at all while the player is busy - microseconds, not the
+// milliseconds of a pipe or socket round trip.
+//
+// Messages are QDataStream-encoded: a request is (op, sequence, arguments),
+// a reply is (sequence, error, value), an event is a PlayerEvent.
+//
+// In the helper, PlayerHost runs two threads next to Qt's event loop (which
+// MPV's own windows need on some systems): one executes requests on an
+// MpvBackend, the other forwards its events. The helper quits on its own
+// when the GUI process is gone.
+// ============================================================================
+
+#ifndef PLAYERHOST_H
+#define PLAYERHOST_H
+
+#include "sharedring.h"
+
+#include <QByteArray>
+#include <QSharedMemory>
+#include <QString>
+#include <QVariant>
+
+#include <atomic>
+
+struct PlayerEvent;
+class MpvBackend;
+class QThread;
+
+// ----------------------------------------------------------------------------
+// PlayerChannel - The Shared Block
+// ----------------------------------------------------------------------------
+struct PlayerChannel {
+    enum Op : quint8 {
+        SetOption, Initialize,
+        Command, CommandAsync, CommandNode,
+        GetDouble, GetInt, GetFlag, GetString, GetNode,
+        SetDouble, SetInt, SetFlag, SetString,
+        Observe, LogMessages,
+        Terminate,                           // mpv_terminate_destroy(), then exit.
+        Destroy                              // mpv_destroy(), then exit. No reply.
+    };
+
+    static const quint32 Magic = 0x57414843;             // "WAHC"
+    static const quint32 Version = 2;
+    static const quint32 RequestBytes = 64 * 1024;
+    static const quint32 ReplyBytes = 1024 * 1024;       // Room for a track list.
+    static const quint32 EventBytes = 256 * 1024;
+
+    quint32 magic;
+    quint32 version;
+    std::atomic<qint64> guiPid;
+    std::atomic<qint64> hostPid;
+    std::atomic<quint32> ready;              // Non-zero once the host serves requests.
+    std::atomic<quint32> heartbeat;          // Bumped by the host a few times a second.
+    std::atomic<quint64> cpuMicros;          // The host's CPU time, updated with the heartbeat.
+
+    std::atomic<quint64> positionBits;       // time-pos as a double's bits.
+    std::atomic<quint32> hasPosition;
+    std::atomic<quint32> paused;
+
+    SharedRing::Header requestRing;
+    SharedRing::Header replyRing;
+    SharedRing::Header eventRing;
+    char requestData[RequestBytes];
+    char replyData[ReplyBytes];
+    char eventData[EventBytes];
+
+    // GUI side, before a (new) host is started.
+    void reset(qint64 gui);
+
+    SharedRing requests() { return SharedRing(&requestRing, requestData); }
+    SharedRing replies() { return SharedRing(&replyRing, replyData); }
+    SharedRing events() { return SharedRing(&eventRing, eventData); }
+
+    static QByteArray encodeEvent(const PlayerEvent &event);
+    static bool decodeEvent(const QByteArray &message, PlayerEvent &event);
+
+    // A process we didn't start as a child - the helper is detached.
+    static bool processAlive(qint64 pid);
+    static void killProcess(qint64 pid);
+
+    // CPU time used by this process so far (all threads, user + system).
+    static double processCpuSeconds();
+};
+
+// ----------------------------------------------------------------------------
+// PlayerHost - The Helper Process's Side
+// ----------------------------------------------------------------------------
+class PlayerHost {
+public:
+    // Serves the channel named `key` until the GUI lets go of it. Call with
+    // the QApplication already created; returns the exit code.
+    static int run(const QString &key);
+
+private:
+    // Observer ids of the host's own status properties; the GUI's ids are
+    // small, so these never collide and are never forwarded.
+    static const quint64 PositionId = 0xffffffffffff0001ull;
+    static const quint64 PauseId = 0xffffffffffff0002ull;
+    static const int ExitGraceMs = 3000;     // Then exit even if mpv hangs.
+
+    explicit PlayerHost(const QString &key);
+    ~PlayerHost();
+
+    bool attach();
+    void serveRequests();                    // Request thread.
+    void forwardEvents();                    // Event thread.
+    QByteArray execute(const QByteArray &request, bool *exitAfter);
+    void stopEvents();
+    void armExitWatchdog();                  // Request thread; once is enough.
+    bool guiAlive() const;
+
+    QSharedMemory memory;
+    PlayerChannel *channel;
+    MpvBackend *backend;
+    QThread *eventThread;
+    std::atomic<bool> stopping;
+    bool exitArmed;
+};
+
+#endif // PLAYERHOST_H
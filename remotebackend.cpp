@@ -0,0 +1,608 @@
+// ============================================================================
+// remotebackend.cpp - Implementation of RemoteBackend
+// ============================================================================
+
+#include "remotebackend.h"
+#include "playerhost.h"              // PlayerChannel
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QThread>
+
+#include <mpv/client.h>              // MPV_ERROR_*, MPV_END_FILE_REASON_ERROR
+
+#include <cstring>
+#include <new>
+
+namespace {
+
+std::atomic<int> instances(0);
+
+// For helperCpuSeconds(): the players with a channel, and the CPU time of
+// helpers that have exited or been replaced.
+QMutex cpuMutex;
+QList<const PlayerChannel *> cpuChannels;
+quint64 retiredCpuMicros = 0;
+
+QVariantList stringList(const char **args) {
+    QVariantList list;
+    for (; args && *args; args++) list.append(QByteArray(*args));
+    return list;
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+// The key is unique per process and player, so two instances of the app
+// (or a helper left over from a crashed one) never share a channel.
+// ----------------------------------------------------------------------------
+RemoteBackend::RemoteBackend()
+    : channel(nullptr), hostPid(0), sequence(0), dead(false),
+      wakeupCallback(nullptr), wakeupContext(nullptr),
+      watcher(nullptr), closing(false), terminating(false), generation(0), lostGeneration(~0u),
+      initialized(false), encoding(false), restarts(0) {
+    clock.start();
+    memory.setKey(QString("mpv-watchalong-%1-%2").arg(QCoreApplication::applicationPid()).arg(++instances));
+
+    bool mapped = memory.create(sizeof(PlayerChannel))
+               || (memory.error() == QSharedMemory::AlreadyExists && memory.attach()
+                   && memory.size() >= static_cast<qsizetype>(sizeof(PlayerChannel)));
+    if (!mapped) {
+        qWarning() << "Player channel:" << memory.errorString();
+        dead = true;
+        return;
+    }
+    channel = new (memory.data()) PlayerChannel;
+    channel->cpuMicros = 0;
+    {
+        QMutexLocker cpuLock(&cpuMutex);
+        cpuChannels.append(channel);
+    }
+
+    QMutexLocker lock(&mutex);
+    if (!launch()) {
+        qWarning() << "Can't start a player process";
+        dead = true;
+        return;
+    }
+    watcher = QThread::create([this]() { watch(); });
+    watcher->start();
+}
+
+RemoteBackend::~RemoteBackend() {
+    closing = true;
+    if (watcher) {
+        watcher->wait();
+        delete watcher;
+    }
+
+    QMutexLocker lock(&mutex);
+    if (channel) {
+        retireCpu();
+        QMutexLocker cpuLock(&cpuMutex);
+        cpuChannels.removeOne(channel);
+    }
+    if (dead || !hostAlive()) return;
+
+    QByteArray request;
+    QDataStream out(&request, QIODevice::WriteOnly);
+    out << quint8(PlayerChannel::Destroy) << ++sequence << QVariantList();
+    channel->requests().write(request, [this]() { return hostAlive(); });
+}
+
+int RemoteBackend::restartCount() const {
+    QMutexLocker lock(&mutex);
+    return restarts;
+}
+
+bool RemoteBackend::isValid() const {
+    return !dead;
+}
+
+// ----------------------------------------------------------------------------
+// helperCpuSeconds() - For the Cost Meter
+// ----------------------------------------------------------------------------
+// Each helper reports its own CPU time with the heartbeat. A helper that
+// is replaced or let go is counted with its last report; whatever it
+// spends after that (mpv_destroy(), mostly) is lost, which is little.
+// ----------------------------------------------------------------------------
+double RemoteBackend::helperCpuSeconds() {
+    QMutexLocker lock(&cpuMutex);
+    quint64 micros = retiredCpuMicros;
+    for (const PlayerChannel *running : cpuChannels) micros += running->cpuMicros.load();
+    return micros / 1e6;
+}
+
+void RemoteBackend::retireCpu() {
+    QMutexLocker lock(&cpuMutex);
+    retiredCpuMicros += channel->cpuMicros.exchange(0);
+}
+
+// ----------------------------------------------------------------------------
+// Helper State
+// ----------------------------------------------------------------------------
+bool RemoteBackend::isLost() const {
+    return lostGeneration.load() == generation.load();
+}
+
+void RemoteBackend::markLost() {
+    lostGeneration = generation.load();
+}
+
+bool RemoteBackend::hostAlive() const {
+    return !isLost() && PlayerChannel::processAlive(hostPid);
+}
+
+void RemoteBackend::notify() {
+    QMutexLocker lock(&callbackMutex);
+    if (wakeupCallback) wakeupCallback(wakeupContext);
+}
+
+// ----------------------------------------------------------------------------
+// launch() - Start a Helper on a Fresh Channel
+// ----------------------------------------------------------------------------
+bool RemoteBackend::launch() {
+    retireCpu();
+    channel->reset(QCoreApplication::applicationPid());
+
+    qint64 pid = 0;
+    QStringList arguments{ "--player-host", memory.key() };
+    if (!QProcess::startDetached(QCoreApplication::applicationFilePath(), arguments, QString(), &pid)) {
+        return false;
+    }
+    hostPid = pid;
+    generation.fetch_add(1);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!channel->ready.load()) {
+        if (timer.elapsed() > StartTimeoutMs || !PlayerChannel::processAlive(pid)) {
+            PlayerChannel::killProcess(pid);
+            markLost();
+            return false;
+        }
+        SharedRing::wait(&channel->ready, 0, SharedRing::WaitSliceMs);
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// call() / send() - One Request, One Reply
+// ----------------------------------------------------------------------------
+int RemoteBackend::call(quint8 op, const QVariantList &args, QVariant *result) {
+    if (isLost()) recover();
+    if (dead) return MPV_ERROR_UNINITIALIZED;
+
+    int error = 0;
+    if (send(op, args, result, &error)) return error;
+
+    markLost();
+    recover();
+    return MPV_ERROR_GENERIC;
+}
+
+bool RemoteBackend::send(quint8 op, const QVariantList &args, QVariant *result, int *error, int timeoutMs) {
+    const quint64 number = ++sequence;
+    QByteArray request;
+    QDataStream out(&request, QIODevice::WriteOnly);
+    out << op << number << args;
+
+    QElapsedTimer timer;
+    timer.start();
+    auto alive = [this, &timer, timeoutMs]() {
+        return hostAlive() && (timeoutMs < 0 || timer.elapsed() < timeoutMs);
+    };
+    SharedRing requests = channel->requests();
+    SharedRing replies = channel->replies();
+    if (!requests.write(request, alive)) return false;
+
+    for (;;) {
+        QByteArray reply;
+        if (replies.read(reply, -1, alive) != SharedRing::Ok) return false;
+
+        QDataStream in(reply);
+        quint64 answered = 0;
+        qint32 code = 0;
+        QVariant value;
+        in >> answered >> code >> value;
+        if (answered != number) continue;    // Left over from an abandoned call.
+
+        *error = code;
+        if (result && code >= 0) *result = value;
+        return true;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// recover() - Replace a Crashed or Hung Helper
+// ----------------------------------------------------------------------------
+// The position and pause state are read before the channel is reset. The
+// event ring is reset too, so nobody may be reading it meanwhile. Not once
+// shutdown has begun: a helper dying then is no reason to start another.
+// ----------------------------------------------------------------------------
+bool RemoteBackend::recover() {
+    if (dead || terminating || closing) return false;
+
+    const bool hasPosition = channel->hasPosition.load() != 0;
+    const bool paused = channel->paused.load() != 0;
+    quint64 bits = channel->positionBits.load();
+    double position = 0.0;
+    std::memcpy(&position, &bits, sizeof position);
+
+    PlayerChannel::killProcess(hostPid);
+    restarts++;
+
+    const qint64 now = clock.elapsed();
+    restartTimes.append(now);
+    while (!restartTimes.isEmpty() && now - restartTimes.first() > RestartWindowMs) restartTimes.removeFirst();
+
+    if (encoding) {
+        giveUp("the encoder's player process died");
+        return false;
+    }
+    if (restartTimes.size() > MaxRestarts) {
+        giveUp(QString("its player process died %1 times within a minute").arg(restartTimes.size()));
+        return false;
+    }
+
+    qWarning().noquote() << QString("Player process %1 lost - restarting at %2 s")
+                                .arg(hostPid.load()).arg(position, 0, 'f', 3);
+    bool started;
+    {
+        QMutexLocker events(&eventMutex);
+        started = launch();
+    }
+    if (!started) {
+        giveUp("a new player process didn't start");
+        return false;
+    }
+    replay(position, hasPosition, paused);
+    notify();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// replay() - Tell the New Helper Everything Again
+// ----------------------------------------------------------------------------
+// In the original order: options, initialize(), observers, properties,
+// filters, then the file - opened where the old helper was, so it costs
+// no separate seek. A crash during the replay is picked up by the next call.
+// ----------------------------------------------------------------------------
+void RemoteBackend::replay(double position, bool hasPosition, bool paused) {
+    int error = 0;
+    auto run = [&](quint8 op, const QVariantList &args) {
+        return !isLost() && (send(op, args, nullptr, &error) || (markLost(), false));
+    };
+
+    for (const auto &option : options) run(PlayerChannel::SetOption, { option.first, option.second });
+    if (initialized) run(PlayerChannel::Initialize, {});
+    if (!logLevel.isEmpty()) run(PlayerChannel::LogMessages, { logLevel });
+    for (const auto &observer : observed) run(PlayerChannel::Observe, { observer.first, observer.second });
+    for (auto it = properties.cbegin(); it != properties.cend(); ++it) {
+        run(it.value().first, { it.key(), it.value().second });
+    }
+    for (const QVariantList &filter : filterCommands) run(PlayerChannel::Command, filter);
+    if (hasPosition) run(PlayerChannel::SetFlag, { QByteArray("pause"), paused });
+
+    if (loaded.isEmpty()) return;
+    QVariantMap load = loaded;
+    if (hasPosition) {
+        QVariantMap fileOptions = load.value("options").toMap();
+        fileOptions["start"] = QString::number(position, 'f', 3);
+        load["options"] = fileOptions;
+    }
+    run(PlayerChannel::CommandNode, { load, false });
+}
+
+// ----------------------------------------------------------------------------
+// giveUp() - No More Restarts
+// ----------------------------------------------------------------------------
+// The app learns it the way it learns of any broken file: an EndFile event
+// with an error.
+// ----------------------------------------------------------------------------
+void RemoteBackend::giveUp(const QString &reason) {
+    qWarning().noquote() << "Player stopped:" << reason;
+    dead = true;
+    PlayerChannel::killProcess(hostPid);
+
+    PlayerEvent event;
+    event.type = PlayerEvent::EndFile;
+    event.endReason = MPV_END_FILE_REASON_ERROR;
+    event.error = MPV_ERROR_GENERIC;
+    {
+        QMutexLocker events(&eventMutex);
+        localEvents.enqueue(event);
+    }
+    notify();
+}
+
+// ----------------------------------------------------------------------------
+// remember() - Journal the Current File, Property Sets and the Filters
+// ----------------------------------------------------------------------------
+// Appending to the playlist doesn't change what plays; everything else
+// that loads a file replaces it. A "set" command is the string form of
+// setString() and is journaled like it. Filter commands are kept in order,
+// minus what a later one undoes: "set"/"clr" start the chain over, and
+// removing a labelled filter drops the command that added it.
+// ----------------------------------------------------------------------------
+void RemoteBackend::remember(const QVariantList &command) {
+    const QString name = command.value(0).toString();
+    if (name == "set") {
+        properties[command.value(1).toByteArray()] =
+            qMakePair(quint8(PlayerChannel::SetString), QVariant(command.value(2).toByteArray()));
+        return;
+    }
+    if (name == "vf" || name == "af") {
+        const QString action = command.value(1).toString();
+        const QString target = command.value(2).toString();
+        if (action == "set" || action == "clr") {
+            for (int i = filterCommands.size() - 1; i >= 0; i--) {
+                if (filterCommands[i].value(0).toString() == name) filterCommands.removeAt(i);
+            }
+        } else if (action == "remove" && target.startsWith('@')) {
+            bool undone = false;
+            for (int i = filterCommands.size() - 1; i >= 0; i--) {
+                const QVariantList &earlier = filterCommands[i];
+                if (earlier.value(0).toString() == name && earlier.value(1).toString() == "add"
+                    && earlier.value(2).toString().startsWith(target + ':')) {
+                    filterCommands.removeAt(i);
+                    undone = true;
+                }
+            }
+            if (undone) return;
+        }
+        filterCommands.append(command);
+        return;
+    }
+    if (name == "stop") {
+        loaded.clear();
+        return;
+    }
+    if (name != "loadfile") return;
+
+    QString flags = command.value(2).toString();
+    if (flags.startsWith("append")) return;
+    loaded.clear();
+    loaded["name"] = name;
+    loaded["url"] = command.value(1).toString();
+    loaded["flags"] = "replace";
+}
+
+// ----------------------------------------------------------------------------
+// Setup
+// ----------------------------------------------------------------------------
+int RemoteBackend::setOption(const char *name, const char *value) {
+    QMutexLocker lock(&mutex);
+    QByteArray key(name);
+    QByteArray text(value);
+    bool replaced = false;
+    for (auto &option : options) {
+        if (option.first == key) {
+            option.second = text;
+            replaced = true;
+        }
+    }
+    if (!replaced) options.append(qMakePair(key, text));
+    if (key == "o") encoding = !text.isEmpty();
+    return call(PlayerChannel::SetOption, { key, text });
+}
+
+int RemoteBackend::initialize() {
+    QMutexLocker lock(&mutex);
+    int error = call(PlayerChannel::Initialize, {});
+    initialized = error >= 0;
+    return error;
+}
+
+// Events may already be waiting - libmpv would have called back for them.
+void RemoteBackend::setWakeupCallback(void (*callback)(void *ctx), void *ctx) {
+    {
+        QMutexLocker lock(&callbackMutex);
+        wakeupCallback = callback;
+        wakeupContext = ctx;
+    }
+    if (channel && !channel->events().isEmpty()) notify();
+}
+
+// ----------------------------------------------------------------------------
+// Commands
+// ----------------------------------------------------------------------------
+int RemoteBackend::command(const char **args) {
+    QMutexLocker lock(&mutex);
+    QVariantList list = stringList(args);
+    remember(list);
+    return call(PlayerChannel::Command, list);
+}
+
+int RemoteBackend::commandAsync(quint64 id, const char **args) {
+    QMutexLocker lock(&mutex);
+    QVariantList list = stringList(args);
+    remember(list);
+    list.prepend(id);
+    return call(PlayerChannel::CommandAsync, list);
+}
+
+int RemoteBackend::commandNode(const QVariant &args, QVariant *result) {
+    QMutexLocker lock(&mutex);
+    if (args.userType() == QMetaType::QVariantMap) {
+        QVariantMap map = args.toMap();
+        const QString name = map.value("name").toString();
+        if (name == "stop") {
+            loaded.clear();
+        } else if (name == "loadfile" && !map.value("flags").toString().startsWith("append")) {
+            loaded = map;
+        }
+    } else {
+        remember(args.toList());
+    }
+    return call(PlayerChannel::CommandNode, { args, result != nullptr }, result);
+}
+
+// ----------------------------------------------------------------------------
+// Properties
+// ----------------------------------------------------------------------------
+int RemoteBackend::getDouble(const char *name, double *value) {
+    QMutexLocker lock(&mutex);
+    QVariant result;
+    int error = call(PlayerChannel::GetDouble, { QByteArray(name) }, &result);
+    if (error >= 0) *value = result.toDouble();
+    return error;
+}
+
+int RemoteBackend::getInt(const char *name, qint64 *value) {
+    QMutexLocker lock(&mutex);
+    QVariant result;
+    int error = call(PlayerChannel::GetInt, { QByteArray(name) }, &result);
+    if (error >= 0) *value = result.toLongLong();
+    return error;
+}
+
+int RemoteBackend::getFlag(const char *name, bool *value) {
+    QMutexLocker lock(&mutex);
+    QVariant result;
+    int error = call(PlayerChannel::GetFlag, { QByteArray(name) }, &result);
+    if (error >= 0) *value = result.toBool();
+    return error;
+}
+
+int RemoteBackend::getString(const char *name, QString *value) {
+    QMutexLocker lock(&mutex);
+    QVariant result;
+    int error = call(PlayerChannel::GetString, { QByteArray(name) }, &result);
+    if (error >= 0) *value = result.toString();
+    return error;
+}
+
+int RemoteBackend::getNode(const char *name, QVariant *value) {
+    QMutexLocker lock(&mutex);
+    return call(PlayerChannel::GetNode, { QByteArray(name) }, value);
+}
+
+int RemoteBackend::setProperty(quint8 op, const char *name, const QVariant &value) {
+    QByteArray key(name);
+    properties[key] = qMakePair(op, value);
+    return call(op, { key, value });
+}
+
+int RemoteBackend::setDouble(const char *name, double value) {
+    QMutexLocker lock(&mutex);
+    return setProperty(PlayerChannel::SetDouble, name, value);
+}
+
+int RemoteBackend::setInt(const char *name, qint64 value) {
+    QMutexLocker lock(&mutex);
+    return setProperty(PlayerChannel::SetInt, name, value);
+}
+
+int RemoteBackend::setFlag(const char *name, bool value) {
+    QMutexLocker lock(&mutex);
+    return setProperty(PlayerChannel::SetFlag, name, value);
+}
+
+int RemoteBackend::setString(const char *name, const char *value) {
+    QMutexLocker lock(&mutex);
+    return setProperty(PlayerChannel::SetString, name, QByteArray(value));
+}
+
+int RemoteBackend::observeProperty(quint64 id, const char *name) {
+    QMutexLocker lock(&mutex);
+    observed.append(qMakePair(id, QByteArray(name)));
+    return call(PlayerChannel::Observe, { id, QByteArray(name) });
+}
+
+int RemoteBackend::requestLogMessages(const char *minLevel) {
+    QMutexLocker lock(&mutex);
+    logLevel = QByteArray(minLevel);
+    return call(PlayerChannel::LogMessages, { logLevel });
+}
+
+// ----------------------------------------------------------------------------
+// waitEvent()
+// ----------------------------------------------------------------------------
+// A lost helper is replaced first (that takes `mutex`, and must not happen
+// while holding `eventMutex`).
+// ----------------------------------------------------------------------------
+PlayerEvent RemoteBackend::waitEvent(double timeout) {
+    if (isLost() && !dead) {
+        QMutexLocker lock(&mutex);
+        if (isLost()) recover();
+    }
+
+    QMutexLocker lock(&eventMutex);
+    if (!localEvents.isEmpty()) return localEvents.dequeue();
+
+    PlayerEvent event;
+    if (dead || !channel) return event;
+
+    int timeoutMs = timeout < 0.0 ? -1 : static_cast<int>(timeout * 1000.0);
+    QByteArray message;
+    if (channel->events().read(message, timeoutMs, [this]() { return hostAlive(); }) == SharedRing::Ok) {
+        PlayerChannel::decodeEvent(message, event);
+    }
+    return event;
+}
+
+// ----------------------------------------------------------------------------
+// terminate() / createClient()
+// ----------------------------------------------------------------------------
+// terminate() waits for the helper's mpv_terminate_destroy(), as the
+// in-process backend would - but only while the process lives, and no
+// longer than TerminateTimeoutMs. The watcher's hang detection is off
+// meanwhile, so the time limit is this wait's own.
+// ----------------------------------------------------------------------------
+bool RemoteBackend::terminate() {
+    QMutexLocker lock(&mutex);
+    if (dead || !channel) return false;
+    terminating = true;
+    int error = 0;
+    bool finished = !isLost() && send(PlayerChannel::Terminate, {}, nullptr, &error, TerminateTimeoutMs);
+    if (!finished) PlayerChannel::killProcess(hostPid);
+    dead = true;
+    return finished;
+}
+
+mpv_handle *RemoteBackend::createClient(const char *) {
+    return nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// watch() - Watcher Thread
+// ----------------------------------------------------------------------------
+// Calls back for new events, and flags the helper lost when its process is
+// gone or its heartbeat has been silent for HangTimeoutMs.
+// ----------------------------------------------------------------------------
+void RemoteBackend::watch() {
+    quint32 seen = channel->events().written();
+    quint32 watched = generation;
+    quint32 beat = channel->heartbeat;
+    QElapsedTimer quiet;
+    quiet.start();
+
+    while (!closing && !dead) {
+        SharedRing events = channel->events();
+        if (events.waitWritten(seen, SharedRing::WaitSliceMs)) {
+            seen = events.written();
+            notify();
+        }
+
+        const quint32 current = generation;
+        if (current != watched || channel->heartbeat != beat) {
+            watched = current;
+            beat = channel->heartbeat;
+            quiet.restart();
+        }
+        if (isLost()) continue;
+
+        bool gone = !PlayerChannel::processAlive(hostPid);
+        bool hung = !terminating && quiet.elapsed() > HangTimeoutMs;
+        if ((gone || hung) && generation == current) {
+            lostGeneration = current;
+            notify();
+        }
+    }
+}
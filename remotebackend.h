@@ -0,0 +1,158 @@
+// ============================================================================
+// remotebackend.h - PlayerBackend in a Helper Process
+// ============================================================================
+// The GUI side of --out-of-process (see playerhost.h for the helper and the
+// shared channel). Each call becomes a request message; the caller spins
+// briefly for the reply and then sleeps on a futex, so a call costs
+// microseconds more than the in-process MpvBackend.
+//
+// A thread watches the event ring and the helper:
+//
+//   - new events          -> the wakeup callback, as libmpv would call it
+//   - helper gone or hung -> flagged; the next call (or waitEvent()) starts
+//                            a new helper and replays what this player was
+//                            told so far
+//
+// "What it was told" is a small journal: the options, initialize(), the
+// observed properties, the log level, the last value of every property
+// set through setDouble()/setInt()/... or a "set" command (speed changes
+// are sent asynchronously), the vf/af filter commands and the file that
+// was loaded. The
+// file is loaded again at the position and pause state the old helper
+// last reported, so to the rest of the app a crash looks like the file
+// being re-opened where it was. After MaxRestarts crashes within
+// RestartWindowMs, or while encoding (the "o" option - restarting would
+// overwrite the output), the player is given up with an EndFile error.
+//
+// The call that ran into the crash fails with MPV_ERROR_GENERIC, but its
+// effect is in the journal and part of the replay. Once terminate() or the
+// destructor has begun, a lost helper stays lost.
+//
+// No second client handle on the player (createClient() returns nullptr),
+// so the IPC server doesn't reach hosted players.
+// ============================================================================
+
+#ifndef REMOTEBACKEND_H
+#define REMOTEBACKEND_H
+
+#include "playerbackend.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QSharedMemory>
+#include <QVariantList>
+
+#include <atomic>
+
+struct PlayerChannel;
+class QThread;
+
+class RemoteBackend : public PlayerBackend {
+public:
+    static const int StartTimeoutMs = 10000;     // For a new helper to report ready.
+    static const int HangTimeoutMs = 5000;       // Heartbeat silence that counts as a hang.
+    static const int MaxRestarts = 3;
+    static const int RestartWindowMs = 60000;
+    static const int TerminateTimeoutMs = 5000;  // The helper exits 3 s after Terminate
+    // by itself (PlayerHost::ExitGraceMs); past this it is killed.
+
+    RemoteBackend();                          // Starts the helper.
+    ~RemoteBackend() override;                // Tells it to mpv_destroy(); doesn't wait.
+
+    int restartCount() const;
+
+    // CPU seconds used by every helper this process has started: the
+    // running ones as of their last heartbeat, plus those that are gone.
+    static double helperCpuSeconds();
+
+    bool isValid() const override;
+
+    int setOption(const char *name, const char *value) override;
+    int initialize() override;
+    void setWakeupCallback(void (*callback)(void *ctx), void *ctx) override;
+
+    int command(const char **args) override;
+    int commandAsync(quint64 id, const char **args) override;
+    int commandNode(const QVariant &args, QVariant *result = nullptr) override;
+
+    int getDouble(const char *name, double *value) override;
+    int getInt(const char *name, qint64 *value) override;
+    int getFlag(const char *name, bool *value) override;
+    int getString(const char *name, QString *value) override;
+    int getNode(const char *name, QVariant *value) override;
+
+    int setDouble(const char *name, double value) override;
+    int setInt(const char *name, qint64 value) override;
+    int setFlag(const char *name, bool value) override;
+    int setString(const char *name, const char *value) override;
+
+    int observeProperty(quint64 id, const char *name) override;
+    int requestLogMessages(const char *minLevel) override;
+
+    PlayerEvent waitEvent(double timeout) override;
+    bool terminate() override;
+    mpv_handle *createClient(const char *name) override;
+
+private:
+    // All of these expect `mutex` to be held. send() is false when the
+    // helper went away before replying (or took longer than timeoutMs);
+    // call() then recovers, unless the player is shutting down.
+    int call(quint8 op, const QVariantList &args, QVariant *result = nullptr);
+    bool send(quint8 op, const QVariantList &args, QVariant *result, int *error, int timeoutMs = -1);
+    bool launch();
+    bool recover();
+    void replay(double position, bool hasPosition, bool paused);
+    void giveUp(const QString &reason);
+    void remember(const QVariantList &command);  // Journal loadfile, stop, set, vf, af.
+    int setProperty(quint8 op, const char *name, const QVariant &value);
+
+    bool hostAlive() const;
+    bool isLost() const;
+    void markLost();
+    void notify();                           // Call the wakeup callback.
+
+    void watch();                            // Watcher thread.
+    void retireCpu();                        // Add the current helper to the gone ones.
+
+    QSharedMemory memory;
+    PlayerChannel *channel;
+    std::atomic<qint64> hostPid;
+    quint64 sequence;
+    std::atomic<bool> dead;                  // Given up, or terminated.
+
+    mutable QMutex mutex;                    // One call at a time.
+    QMutex eventMutex;                       // One waitEvent() at a time.
+    QMutex callbackMutex;
+    void (*wakeupCallback)(void *ctx);
+    void *wakeupContext;
+    QQueue<PlayerEvent> localEvents;         // Made up here (giving up).
+
+    // A helper is "lost" once lostGeneration catches up with generation,
+    // which launch() bumps - so a late report about the old helper can't
+    // mark its replacement lost.
+    QThread *watcher;
+    std::atomic<bool> closing;
+    std::atomic<bool> terminating;           // No heartbeat during terminate().
+    std::atomic<quint32> generation;
+    std::atomic<quint32> lostGeneration;
+
+    // The journal.
+    QList<QPair<QByteArray, QByteArray>> options;
+    bool initialized;
+    QList<QPair<quint64, QByteArray>> observed;
+    QByteArray logLevel;
+    QMap<QByteArray, QPair<quint8, QVariant>> properties;    // name -> (op, value)
+    QList<QVariantList> filterCommands;      // vf/af, in order.
+    QVariantMap loaded;                      // loadfile as a named-argument command.
+    bool encoding;
+
+    QList<qint64> restartTimes;              // ms on `clock`
+    QElapsedTimer clock;
+    int restarts;
+};
+
+#endif // REMOTEBACKEND_H
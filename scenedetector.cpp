@@ -0,0 +1,260 @@
+// ============================================================================
+// scenedetector.cpp - Implementation of SceneDetector
+// ============================================================================
+
+#include "scenedetector.h"
+#include "framedecoder.h"
+#include "simdkernels.h"
+#include "analysiscache.h"
+
+#include <QDataStream>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Constants
+// ----------------------------------------------------------------------------
+static const double PrerollSeconds = 1.0;            // Decode from a keyframe before this.
+static const double MinSegmentSeconds = 120.0;       // Shorter segments aren't worth a seek.
+
+static const double MinCutScore = 12.0;              // Mean |difference|, 0-255 luma.
+static const double CutRatio = 3.0;                  // ...and this many times the neighbours'.
+static const int NeighbourFrames = 12;               // On each side of the candidate.
+static const double MinSceneSeconds = 0.4;           // Closer cuts: keep the stronger one.
+
+static const quint32 CacheMagic = 0x57415343;        // "WASC"
+static const quint32 CacheVersion = 1;
+
+namespace {
+struct FrameScore {
+    double time;                                     // Seconds.
+    float score;                                     // Mean |difference| to the previous frame.
+};
+}
+
+// ----------------------------------------------------------------------------
+// Job - Shared State of One Scan
+// ----------------------------------------------------------------------------
+// Progress is counted in milliseconds of video covered.
+// ----------------------------------------------------------------------------
+struct SceneDetector::Job : BackgroundAnalysis::Job {
+    // One entry per segment. Every task writes only its own entry.
+    struct Segment {
+        double start = 0.0;
+        double end = -1.0;                   // -1 = until the end of the file.
+        QVector<FrameScore> frames;
+    };
+    QVector<Segment> segments;
+};
+
+// ----------------------------------------------------------------------------
+// SegmentTask - Decode One Segment and Score Its Frames
+// ----------------------------------------------------------------------------
+class SceneDetector::SegmentTask : public Task {
+public:
+    SegmentTask(QSharedPointer<Job> job, int index) : Task(job), job(job), index(index) {}
+
+private:
+    void work() override {
+        Job::Segment &segment = job->segments[index];
+
+        FrameDecoder decoder;
+        if (!decoder.open(job->path)) {
+            job->fail(decoder.errorString());
+            return;
+        }
+        if (segment.start > 0.0) {
+            decoder.seek(qMax(0.0, segment.start - PrerollSeconds));
+        }
+
+        const size_t pixels = FrameDecoder::ThumbWidth * FrameDecoder::ThumbHeight;
+        QVector<quint8> previous;
+        QVector<quint8> current;
+        double reached = segment.start;      // For the progress counter.
+
+        while (!job->cancelled) {
+            double time = 0.0;
+            int r = decoder.decode(current, time);
+            if (r < 0) {
+                if (segment.frames.isEmpty()) job->fail(decoder.errorString());
+                return;
+            }
+            if (r == 0) return;
+            if (time < 0.0) continue;        // No timestamp - can't place it.
+            if (segment.end >= 0.0 && time >= segment.end) return;
+
+            if (!previous.isEmpty() && time >= segment.start) {
+                quint64 sad = SimdKernels::sumAbsDiff(previous.constData(), current.constData(), pixels);
+                segment.frames.append({ time, static_cast<float>(double(sad) / pixels) });
+            }
+            previous.swap(current);
+
+            if (time > reached) {
+                job->done += static_cast<qint64>((time - reached) * 1000.0);
+                reached = time;
+            }
+        }
+    }
+
+    QSharedPointer<Job> job;
+    int index;
+};
+
+// ----------------------------------------------------------------------------
+// PlanTask - Split the File Into Segments
+// ----------------------------------------------------------------------------
+class SceneDetector::PlanTask : public Task {
+public:
+    explicit PlanTask(QSharedPointer<Job> job) : Task(job), job(job) {}
+
+private:
+    void work() override {
+        FrameDecoder probe;
+        double duration = 0.0;
+        if (probe.open(job->path)) duration = probe.duration();
+        probe.close();
+
+        int count = segmentCount(*job, duration, MinSegmentSeconds);
+
+        job->segments.resize(count);
+        for (int i = 0; i < count; i++) {
+            job->segments[i].start = duration * i / count;
+            job->segments[i].end = (i == count - 1) ? -1.0 : duration * (i + 1) / count;
+        }
+        job->total = static_cast<qint64>(duration * 1000.0);
+
+        for (int i = 0; i < count; i++) {
+            spawn(job, new SegmentTask(job, i));
+        }
+    }
+
+    QSharedPointer<Job> job;
+};
+
+// ----------------------------------------------------------------------------
+// Cache Format
+// ----------------------------------------------------------------------------
+static QByteArray serialize(const QVector<double> &cuts) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << CacheMagic << CacheVersion << cuts;
+    return data;
+}
+
+static bool deserialize(const QByteArray &data, QVector<double> &cuts) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != CacheMagic || version != CacheVersion) return false;
+    in >> cuts;
+    return in.status() == QDataStream::Ok;
+}
+
+// ----------------------------------------------------------------------------
+// findCuts() - Pick the Cuts Out of the Frame Scores
+// ----------------------------------------------------------------------------
+// The neighbourhood average is a running sum over NeighbourFrames frames on
+// each side, minus the candidate itself, so the whole pass is O(frames).
+// ----------------------------------------------------------------------------
+static QVector<double> findCuts(const QVector<FrameScore> &frames) {
+    QVector<double> cuts;
+    QVector<float> strength;                 // Score of each entry in cuts.
+    const int n = frames.size();
+
+    double window = 0.0;
+    int lo = 0, hi = 0;                      // Window is frames [lo, hi).
+    for (int i = 0; i < n; i++) {
+        while (hi < n && hi <= i + NeighbourFrames) window += frames[hi++].score;
+        while (lo < i - NeighbourFrames) window -= frames[lo++].score;
+
+        const double score = frames[i].score;
+        const int neighbours = hi - lo - 1;
+        const double average = neighbours > 0 ? (window - score) / neighbours : 0.0;
+        if (score < MinCutScore || score < CutRatio * average) continue;
+
+        if (!cuts.isEmpty() && frames[i].time - cuts.last() < MinSceneSeconds) {
+            if (score > strength.last()) {
+                cuts.last() = frames[i].time;
+                strength.last() = static_cast<float>(score);
+            }
+            continue;
+        }
+        cuts.append(frames[i].time);
+        strength.append(static_cast<float>(score));
+    }
+    return cuts;
+}
+
+// ----------------------------------------------------------------------------
+// Constructor - One Thread per Core
+// ----------------------------------------------------------------------------
+SceneDetector::SceneDetector(QObject *parent)
+    : BackgroundAnalysis(QThread::idealThreadCount(), parent) {}
+
+bool SceneDetector::isAvailable() {
+    return FrameDecoder::isAvailable();
+}
+
+// ----------------------------------------------------------------------------
+// analyze() / forget() / cuts()
+// ----------------------------------------------------------------------------
+void SceneDetector::analyze(int slot, const QString &path) {
+    cancel(slot);
+
+    if (!isAvailable()) {
+        emit failed(slot, "Built without libav");
+        return;
+    }
+
+    QByteArray cached;
+    QVector<double> index;
+    if (AnalysisCache::load(path, "scenes", cached) && deserialize(cached, index)) {
+        results[slot] = index;
+        emit finished(slot);
+        return;
+    }
+
+    QSharedPointer<Job> job(new Job);
+    job->path = path;
+    start(slot, job, new PlanTask(job));
+}
+
+void SceneDetector::forget(int slot) {
+    results.remove(slot);
+}
+
+QVector<double> SceneDetector::cuts(int slot) const {
+    return results.value(slot);
+}
+
+// ----------------------------------------------------------------------------
+// finishJob() - Combine the Segments and Find the Cuts (GUI Thread)
+// ----------------------------------------------------------------------------
+// Segments cover disjoint time ranges and are stored in order, so joining
+// them keeps the frames sorted except where a file's timestamps jump
+// backwards; one sort fixes that too.
+// ----------------------------------------------------------------------------
+void SceneDetector::finishJob(QSharedPointer<BackgroundAnalysis::Job> done) {
+    QSharedPointer<Job> job = done.staticCast<Job>();
+
+    QVector<FrameScore> frames;
+    for (const Job::Segment &segment : job->segments) frames += segment.frames;
+
+    if (frames.isEmpty()) {
+        emit failed(job->slot, job->errorOr("No video decoded"));
+        return;
+    }
+
+    std::stable_sort(frames.begin(), frames.end(), [](const FrameScore &a, const FrameScore &b) {
+        return a.time < b.time;
+    });
+
+    QVector<double> index = findCuts(frames);
+    results[job->slot] = index;
+    AnalysisCache::save(job->path, "scenes", serialize(index));
+    emit finished(job->slot);
+}
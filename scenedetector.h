@@ -0,0 +1,57 @@
+// ============================================================================
+// scenedetector.h - Background Scene-Cut Index
+// ============================================================================
+// Finds the hard cuts in each loaded file, so both players can jump to the
+// previous / next scene instead of stepping by fixed amounts.
+//
+// How it works: like the loudness scan, the file is split into segments
+// that are decoded in parallel on a low-priority thread pool (see
+// backgroundanalysis.h), here with one FrameDecoder each. For every frame
+// the decoder delivers a 64x36 luma thumbnail, and the segment records the
+// mean absolute difference to the previous thumbnail (SimdKernels::
+// sumAbsDiff). Each segment starts decoding a keyframe early, so its first
+// frame has a predecessor too.
+//
+// Once all segments are done, a frame is a cut when its difference is both
+// large in absolute terms and several times the average of the frames
+// around it. The second test keeps fast pans and flickering lights from
+// looking like cuts; fades are deliberately not cuts.
+//
+// The result is a sorted list of cut times (the first frame of each new
+// scene), cached per file like the loudness results.
+// ============================================================================
+
+#ifndef SCENEDETECTOR_H
+#define SCENEDETECTOR_H
+
+#include "backgroundanalysis.h"
+
+#include <QHash>
+#include <QVector>
+
+class SceneDetector : public BackgroundAnalysis {
+    Q_OBJECT
+
+public:
+    explicit SceneDetector(QObject *parent = nullptr);
+
+    static bool isAvailable();               // False when built without libav.
+
+    // Index `path` for the player in `slot` (0 = player 1...). Works like
+    // LoudnessAnalyzer::analyze(): a cached index finishes immediately.
+    void analyze(int slot, const QString &path);
+
+    QVector<double> cuts(int slot) const;    // Seconds, ascending. Empty until finished().
+
+private:
+    struct Job;                              // One scan - see the .cpp file.
+    class PlanTask;
+    class SegmentTask;
+
+    void finishJob(QSharedPointer<BackgroundAnalysis::Job> done) override;
+    void forget(int slot) override;
+
+    QHash<int, QVector<double>> results;     // Finished indexes, by slot.
+};
+
+#endif // SCENEDETECTOR_H
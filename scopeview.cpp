@@ -0,0 +1,171 @@
+// ============================================================================
+// scopeview.cpp - Implementation of ScopeView
+// ============================================================================
+
+#include "scopeview.h"
+#include "videoscopes.h"
+
+#include <QPainter>
+
+#include <cmath>
+
+namespace {
+
+const int Levels = ScopeFrame::Levels;
+
+// Counts -> 0-255 brightness on a log scale, relative to the largest count.
+QVector<quint8> logPlane(const QVector<quint32> &counts) {
+    QVector<quint8> plane(counts.size(), 0);
+    quint32 peak = 0;
+    for (quint32 c : counts) peak = qMax(peak, c);
+    if (peak == 0) return plane;
+
+    const double scale = 255.0 / std::log1p(double(peak));
+    for (int i = 0; i < counts.size(); i++) {
+        if (counts[i]) plane[i] = quint8(qMax(48.0, std::log1p(double(counts[i])) * scale));
+    }
+    return plane;
+}
+
+// One histogram channel as filled bars, Levels x Levels, linear height.
+QVector<quint8> barPlane(const QVector<quint32> &counts) {
+    QVector<quint8> plane(Levels * Levels, 0);
+    quint32 peak = 0;
+    for (quint32 c : counts) peak = qMax(peak, c);
+    if (peak == 0) return plane;
+
+    for (int level = 0; level < Levels; level++) {
+        int height = int(qint64(counts[level]) * (Levels - 1) / peak);
+        for (int row = Levels - 1 - height; row < Levels; row++) plane[row * Levels + level] = 255;
+    }
+    return plane;
+}
+
+// Waveform and vectorscope counts are stored bottom-up; images are top-down.
+QVector<quint8> flipped(const QVector<quint8> &plane) {
+    QVector<quint8> out(plane.size());
+    for (int row = 0; row < Levels; row++) {
+        std::copy(plane.constBegin() + row * Levels, plane.constBegin() + (row + 1) * Levels,
+                  out.begin() + (Levels - 1 - row) * Levels);
+    }
+    return out;
+}
+
+QVector<quint8> scopePlane(const ScopeFrame &frame, ScopeView::Kind kind) {
+    switch (kind) {
+    case ScopeView::Waveform:    return flipped(logPlane(frame.waveform));
+    case ScopeView::Vectorscope: return flipped(logPlane(frame.vectorscope));
+    default:                     return barPlane(frame.histogram[ScopeFrame::Luma]);
+    }
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+ScopeView::ScopeView(const QString &title, QWidget *parent)
+    : QWidget(parent), title(title), kind(Histogram) {
+    setMinimumSize(120, 120);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+}
+
+QSize ScopeView::sizeHint() const {
+    return QSize(200, 200);
+}
+
+void ScopeView::setKind(Kind newKind) {
+    kind = newKind;
+    render();
+}
+
+void ScopeView::setFrames(QSharedPointer<const ScopeFrame> a, QSharedPointer<const ScopeFrame> b) {
+    first = a;
+    second = b;
+    render();
+}
+
+// ----------------------------------------------------------------------------
+// render()
+// ----------------------------------------------------------------------------
+// Single player: the histogram shows R, G and B bars added together (white
+// where they agree); the other scopes are grey. Overlay: player 1 goes to
+// red + blue, player 2 to green.
+// ----------------------------------------------------------------------------
+void ScopeView::render() {
+    if (!first && !second) {
+        image = QImage();
+        update();
+        return;
+    }
+
+    image = QImage(Levels, Levels, QImage::Format_RGB32);
+
+    if (first && second) {
+        QVector<quint8> a = scopePlane(*first, kind);
+        QVector<quint8> b = scopePlane(*second, kind);
+        for (int row = 0; row < Levels; row++) {
+            QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(row));
+            for (int x = 0; x < Levels; x++) {
+                int i = row * Levels + x;
+                line[x] = qRgb(a[i], b[i], a[i]);
+            }
+        }
+    } else {
+        const ScopeFrame &frame = first ? *first : *second;
+        if (kind == Histogram) {
+            QVector<quint8> r = barPlane(frame.histogram[ScopeFrame::Red]);
+            QVector<quint8> g = barPlane(frame.histogram[ScopeFrame::Green]);
+            QVector<quint8> b = barPlane(frame.histogram[ScopeFrame::Blue]);
+            for (int row = 0; row < Levels; row++) {
+                QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(row));
+                for (int x = 0; x < Levels; x++) {
+                    int i = row * Levels + x;
+                    line[x] = qRgb(r[i] * 3 / 4, g[i] * 3 / 4, b[i] * 3 / 4);
+                }
+            }
+        } else {
+            QVector<quint8> v = scopePlane(frame, kind);
+            for (int row = 0; row < Levels; row++) {
+                QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(row));
+                for (int x = 0; x < Levels; x++) line[x] = qRgb(v[row * Levels + x], v[row * Levels + x], v[row * Levels + x]);
+            }
+        }
+    }
+    update();
+}
+
+// ----------------------------------------------------------------------------
+// paintEvent()
+// ----------------------------------------------------------------------------
+// The scope fills the largest square that fits, with a graticule on top:
+// broadcast-range lines (16 and 235) on the waveform, the neutral point and
+// the 75% saturation circle on the vectorscope.
+// ----------------------------------------------------------------------------
+void ScopeView::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    int side = qMin(width(), height());
+    QRect square((width() - side) / 2, (height() - side) / 2, side, side);
+
+    if (!image.isNull()) painter.drawImage(square, image);
+
+    auto levelY = [&](int level) { return square.bottom() - level * square.height() / Levels; };
+
+    painter.setPen(QColor(90, 90, 90));
+    if (kind == Waveform) {
+        painter.drawLine(square.left(), levelY(16), square.right(), levelY(16));
+        painter.drawLine(square.left(), levelY(235), square.right(), levelY(235));
+    } else if (kind == Vectorscope) {
+        QPoint center = square.center();
+        painter.drawLine(center.x() - 6, center.y(), center.x() + 6, center.y());
+        painter.drawLine(center.x(), center.y() - 6, center.x(), center.y() + 6);
+        int radius = int(square.width() * 0.75 / 2);
+        painter.drawEllipse(center, radius, radius);
+    }
+
+    painter.setPen(Qt::lightGray);
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignLeft | Qt::AlignTop, title);
+    if (image.isNull()) painter.drawText(rect(), Qt::AlignCenter, "No video");
+}
@@ -0,0 +1,54 @@
+// ============================================================================
+// scopeview.h - Draws One Video Scope
+// ============================================================================
+// Shows one scope (see videoscopes.h) of one player, or - in OVERLAY mode -
+// of both players at once in complementary colors:
+//
+//   magenta - only player 1 has pixels there
+//   green   - only player 2 has pixels there
+//   white   - both do, equally
+//
+// so wherever the two sources differ in level or color, the overlay shows
+// fringes of color. Counts are drawn on a log scale; a few pixels are as
+// visible as a million.
+// ============================================================================
+
+#ifndef SCOPEVIEW_H
+#define SCOPEVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QSharedPointer>
+#include <QString>
+
+struct ScopeFrame;
+
+class ScopeView : public QWidget {
+    Q_OBJECT
+
+public:
+    enum Kind { Histogram, Waveform, Vectorscope };
+
+    explicit ScopeView(const QString &title, QWidget *parent = nullptr);
+
+    void setKind(Kind kind);
+
+    // `second` is only used in overlay views; pass null otherwise.
+    void setFrames(QSharedPointer<const ScopeFrame> first, QSharedPointer<const ScopeFrame> second);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    void render();                           // Rebuild `image` from the frames.
+
+    QString title;
+    Kind kind;
+    QSharedPointer<const ScopeFrame> first;
+    QSharedPointer<const ScopeFrame> second;
+    QImage image;                            // Levels x Levels, drawn scaled.
+};
+
+#endif // SCOPEVIEW_H
@@ -0,0 +1,188 @@
+// ============================================================================
+// sessionstore.cpp - Implementation of SessionStore
+// ============================================================================
+
+#include "sessionstore.h"
+#include "mpvwidget.h"           // MpvWidget
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>             // Write to a temp file, rename when complete.
+#include <QStandardPaths>
+#include <QTimer>
+#include <QVariantMap>
+
+static const quint32 SessionMagic = 0x57415353;  // "WASS"
+static const quint32 SessionVersion = 1;
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+SessionStore::SessionStore(const QList<MpvWidget *> &players, QObject *parent)
+    : QObject(parent), players(players), pending(0), stopped(false) {
+
+    for (int i = 0; i < players.size(); i++) resumedPaths << QString();
+
+    for (MpvWidget *player : players) {
+        connect(player, &MpvWidget::fileLoaded, this, [this, player]() {
+            int index = this->players.indexOf(player);
+            if (pending > 0 && player->currentPath() == resumedPaths.value(index)) pending--;
+            save();
+        });
+    }
+
+    timer = new QTimer(this);
+    timer->setInterval(SaveIntervalMs);
+    connect(timer, &QTimer::timeout, this, &SessionStore::save);
+    timer->start();
+}
+
+// ----------------------------------------------------------------------------
+// sessionFile() / serialize() / deserialize()
+// ----------------------------------------------------------------------------
+// A few dozen bytes plus the paths - cheap enough to compare and rewrite
+// every couple of seconds.
+// ----------------------------------------------------------------------------
+QString SessionStore::sessionFile() {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!QDir().mkpath(dir)) return QString();
+    return dir + "/session.bin";
+}
+
+QByteArray SessionStore::serialize(const SessionState &state) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);   // Same bytes from Qt 5 and Qt 6 builds.
+    out << SessionMagic << SessionVersion << quint8(state.players.size());
+    for (const SessionState::Player &player : state.players) {
+        out << player.path << player.position << qint32(player.audioTrack)
+            << qint32(player.subtitleTrack) << qint8(player.volume);
+    }
+    return data;
+}
+
+bool SessionStore::deserialize(const QByteArray &data, SessionState &state) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0, version = 0;
+    quint8 count = 0;
+    in >> magic >> version >> count;
+    if (magic != SessionMagic || version != SessionVersion) return false;
+
+    state.players.clear();
+    for (int i = 0; i < count; i++) {
+        SessionState::Player player;
+        qint32 audio = -1, subtitle = -1;
+        qint8 volume = -1;
+        in >> player.path >> player.position >> audio >> subtitle >> volume;
+        player.audioTrack = audio;
+        player.subtitleTrack = subtitle;
+        player.volume = volume;
+        state.players.append(player);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+// ----------------------------------------------------------------------------
+// capture() - The Players' State Right Now
+// ----------------------------------------------------------------------------
+// aid/sid are "no" when switched off and "auto" before MPV picked one.
+// ----------------------------------------------------------------------------
+SessionState SessionStore::capture() const {
+    auto trackId = [](MpvWidget *player, const char *name) -> qint64 {
+        QString value;
+        if (player->getString(name, &value) < 0) return -1;
+        if (value == "no") return 0;
+        bool ok = false;
+        qint64 id = value.toLongLong(&ok);
+        return ok ? id : -1;
+    };
+
+    SessionState state;
+    for (MpvWidget *player : players) {
+        SessionState::Player entry;
+        QString path = player->hasFile() ? player->currentPath() : QString();
+        if (QFileInfo(path).isFile()) {
+            entry.path = QFileInfo(path).absoluteFilePath();
+            entry.position = player->position();
+            entry.audioTrack = trackId(player, "aid");
+            entry.subtitleTrack = trackId(player, "sid");
+            if (player->volumeSlider) entry.volume = player->volumeSlider->value();
+        }
+        state.players.append(entry);
+    }
+    return state;
+}
+
+// ----------------------------------------------------------------------------
+// save() / stop()
+// ----------------------------------------------------------------------------
+// Nothing is saved while a restore is still loading: the players would
+// look empty and overwrite the session being resumed.
+// ----------------------------------------------------------------------------
+void SessionStore::save() {
+    if (stopped || pending > 0) return;
+
+    QByteArray data = serialize(capture());
+    if (data == saved) return;
+
+    QString path = sessionFile();
+    if (path.isEmpty()) return;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return;
+    file.write(data);
+    if (file.commit()) saved = data;
+}
+
+void SessionStore::stop() {
+    save();
+    stopped = true;
+    timer->stop();
+}
+
+// ----------------------------------------------------------------------------
+// restore() - Open Every Saved File, Paused at Its Position
+// ----------------------------------------------------------------------------
+bool SessionStore::restore() {
+    QFile file(sessionFile());
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QByteArray data = file.readAll();
+
+    SessionState state;
+    if (!deserialize(data, state)) return false;
+    saved = data;
+
+    bool any = false;
+    for (int i = 0; i < players.size() && i < state.players.size(); i++) {
+        const SessionState::Player &entry = state.players[i];
+        MpvWidget *player = players[i];
+        if (entry.path.isEmpty() || !QFileInfo(entry.path).isFile() || !player->isReady()) continue;
+
+        QVariantMap options;
+        options["start"] = QString::number(entry.position, 'f', 3);
+        options["pause"] = "yes";
+        if (entry.audioTrack >= 0) options["aid"] = entry.audioTrack == 0 ? QString("no") : QString::number(entry.audioTrack);
+        if (entry.subtitleTrack >= 0) options["sid"] = entry.subtitleTrack == 0 ? QString("no") : QString::number(entry.subtitleTrack);
+
+        if (entry.volume >= 0 && player->volumeSlider) player->volumeSlider->setValue(entry.volume);
+
+        resumedPaths[i] = entry.path;
+        pending++;
+        player->loadVideo(entry.path, options);
+        any = true;
+    }
+
+    // A file that fails to open never reports fileLoaded.
+    if (pending > 0) QTimer::singleShot(RestoreTimeoutMs, this, [this]() { pending = 0; });
+    return any;
+}
+
+bool SessionStore::isResumedPair() const {
+    for (int i = 0; i < players.size(); i++) {
+        if (resumedPaths[i].isEmpty() || players[i]->currentPath() != resumedPaths[i]) return false;
+    }
+    return true;
+}
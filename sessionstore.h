@@ -0,0 +1,90 @@
+// ============================================================================
+// sessionstore.h - Save the Session Continuously, Resume It on Launch
+// ============================================================================
+// Closing the app (or a crash) used to lose everything: which files were
+// open, where each one was, the tracks and volumes. The SessionStore keeps
+// that state in a small binary file in the app data folder:
+//
+//   per player: file path, position, audio track, subtitle track, volume
+//
+// The offset between the players needs no entry of its own - it is the
+// difference of the two positions (see playergroup.h).
+//
+// Saving: every SaveIntervalMs, when a file is loaded, and on close. The
+// file is only rewritten when the state actually changed, and always
+// atomically (QSaveFile), so a crash mid-write keeps the previous session.
+//
+// Resuming: every player's file is opened with the per-file options
+// start=<position>, pause=yes and its aid/sid, so opening, seeking and
+// selecting tracks are ONE step inside MPV and the player ends up paused on
+// the exact decoded frame. The loadfile commands of all players are sent
+// back to back and each MPV core opens its file on its own thread, so the
+// players load in parallel - resuming takes about as long as opening the
+// slowest file once.
+//
+// Network streams aren't saved; they need the prefill dialog to reopen.
+// ============================================================================
+
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class MpvWidget;
+class QTimer;
+
+// ----------------------------------------------------------------------------
+// SessionState - What Is Saved
+// ----------------------------------------------------------------------------
+struct SessionState {
+    struct Player {
+        QString path;               // Empty = no file in this player.
+        double position = 0.0;
+        qint64 audioTrack = -1;     // MPV "aid"; 0 = off, -1 = unknown.
+        qint64 subtitleTrack = -1;  // MPV "sid"; 0 = off, -1 = unknown.
+        int volume = -1;            // 0-100; -1 = unknown.
+    };
+
+    QVector<Player> players;        // Same order as the constructor's list.
+};
+
+class SessionStore : public QObject {
+    Q_OBJECT
+
+public:
+    static const int SaveIntervalMs = 2000;
+    static const int RestoreTimeoutMs = 15000;   // Give up waiting for a file.
+
+    explicit SessionStore(const QList<MpvWidget *> &players, QObject *parent = nullptr);
+
+    // Open the saved session in the players. Returns false if there is
+    // nothing to resume (no session, or none of its files exist anymore).
+    bool restore();
+
+    // True while the players show exactly the files restore() opened -
+    // e.g. so PairMemory doesn't move the restored positions again.
+    bool isResumedPair() const;
+
+    void save();                    // Write now, if anything changed.
+    void stop();                    // Final save; no more saving afterwards.
+
+private:
+    SessionState capture() const;
+    static QByteArray serialize(const SessionState &state);
+    static bool deserialize(const QByteArray &data, SessionState &state);
+    static QString sessionFile();
+
+    QList<MpvWidget *> players;     // Not owned.
+    QTimer *timer;
+    QByteArray saved;               // Last written contents.
+    QStringList resumedPaths;       // Per player, as opened by restore().
+    int pending;                    // Restored players not loaded yet.
+    bool stopped;
+};
+
+#endif // SESSIONSTORE_H
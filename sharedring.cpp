@@ -0,0 +1,194 @@
+// ============================================================================
+// sharedring.cpp - Implementation of SharedRing
+// ============================================================================
+
+#include "sharedring.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#if defined(Q_OS_LINUX)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+// The words are shared between processes and handed to the kernel as
+// plain 32-bit integers.
+static_assert(sizeof(std::atomic<quint32>) == sizeof(quint32), "atomic<quint32> must be a plain word");
+static_assert(std::atomic<quint32>::is_always_lock_free, "atomic<quint32> must be lock-free");
+
+static const quint32 MaxMessageBytes = 256u * 1024 * 1024;   // Anything larger is corruption.
+
+// ----------------------------------------------------------------------------
+// wait() / wake() - Futex on Linux, Polling Elsewhere
+// ----------------------------------------------------------------------------
+// Not FUTEX_PRIVATE: the word is mapped into two processes.
+// ----------------------------------------------------------------------------
+void SharedRing::wait(std::atomic<quint32> *word, quint32 value, int timeoutMs) {
+#if defined(Q_OS_LINUX)
+    timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<quint32 *>(word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+#else
+    Q_UNUSED(timeoutMs);
+    if (word->load(std::memory_order_acquire) == value) QThread::msleep(1);
+#endif
+}
+
+void SharedRing::wake(std::atomic<quint32> *word) {
+#if defined(Q_OS_LINUX)
+    syscall(SYS_futex, reinterpret_cast<quint32 *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    Q_UNUSED(word);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// waitChange() - Spin, Then Sleep in Slices
+// ----------------------------------------------------------------------------
+// The sleeper counts itself in `sleepers` BEFORE its last look at the
+// word, and the other side changes the word BEFORE looking at `sleepers`
+// (all sequentially consistent), so at least one of them sees the other:
+// either the sleeper finds the new value, or the other side wakes it.
+// ----------------------------------------------------------------------------
+static SharedRing::Result waitChange(std::atomic<quint32> *word, std::atomic<quint32> *sleepers,
+                                     quint32 value, int timeoutMs, const SharedRing::AliveCheck &alive) {
+    if (word->load(std::memory_order_acquire) != value) return SharedRing::Ok;
+    if (timeoutMs == 0) return SharedRing::Empty;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.nsecsElapsed() < SharedRing::SpinMicroseconds * 1000LL) {
+        if (word->load(std::memory_order_acquire) != value) return SharedRing::Ok;
+        std::this_thread::yield();
+    }
+
+    for (;;) {
+        int slice = SharedRing::WaitSliceMs;
+        if (timeoutMs > 0) {
+            qint64 left = timeoutMs - timer.elapsed();
+            if (left <= 0) return SharedRing::Empty;
+            slice = static_cast<int>(qMin<qint64>(slice, left));
+        }
+
+        sleepers->fetch_add(1);
+        if (word->load() == value) SharedRing::wait(word, value, slice);
+        sleepers->fetch_sub(1);
+
+        if (word->load(std::memory_order_acquire) != value) return SharedRing::Ok;
+        if (alive && !alive()) return SharedRing::Failed;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Constructor / reset()
+// ----------------------------------------------------------------------------
+SharedRing::SharedRing(Header *header, char *data) : header(header), data(data) {}
+
+void SharedRing::reset(Header *header, quint32 capacity) {
+    Q_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    header->head = 0;
+    header->tail = 0;
+    header->headSleepers = 0;
+    header->tailSleepers = 0;
+    header->capacity = capacity;
+}
+
+bool SharedRing::isEmpty() const {
+    return header->head.load(std::memory_order_acquire) == header->tail.load(std::memory_order_acquire);
+}
+
+quint32 SharedRing::written() const {
+    return header->head.load(std::memory_order_acquire);
+}
+
+bool SharedRing::waitWritten(quint32 seen, int timeoutMs) {
+    return waitChange(&header->head, &header->headSleepers, seen, timeoutMs, AliveCheck()) == Ok;
+}
+
+// ----------------------------------------------------------------------------
+// Producer
+// ----------------------------------------------------------------------------
+bool SharedRing::write(const QByteArray &message, const AliveCheck &alive) {
+    const quint32 length = static_cast<quint32>(message.size());
+    char prefix[4];
+    std::memcpy(prefix, &length, sizeof prefix);
+    return writeBytes(prefix, sizeof prefix, alive) && writeBytes(message.constData(), length, alive);
+}
+
+bool SharedRing::writeBytes(const char *bytes, quint32 size, const AliveCheck &alive) {
+    const quint32 capacity = header->capacity;
+    while (size > 0) {
+        const quint32 head = header->head.load(std::memory_order_relaxed);
+        const quint32 tail = header->tail.load(std::memory_order_acquire);
+        const quint32 space = capacity - (head - tail);
+        if (space == 0) {
+            if (waitChange(&header->tail, &header->tailSleepers, tail, -1, alive) != Ok) return false;
+            continue;
+        }
+
+        const quint32 count = qMin(size, space);
+        const quint32 at = head & (capacity - 1);
+        const quint32 first = qMin(count, capacity - at);
+        std::memcpy(data + at, bytes, first);
+        std::memcpy(data, bytes + first, count - first);
+
+        header->head.store(head + count);
+        if (header->headSleepers.load() > 0) wake(&header->head);
+
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Consumer
+// ----------------------------------------------------------------------------
+SharedRing::Result SharedRing::read(QByteArray &message, int timeoutMs, const AliveCheck &alive) {
+    const quint32 tail = header->tail.load(std::memory_order_relaxed);
+    Result started = waitChange(&header->head, &header->headSleepers, tail, timeoutMs, alive);
+    if (started != Ok) return started;
+
+    quint32 length = 0;
+    char prefix[4];
+    if (!readBytes(prefix, sizeof prefix, alive)) return Failed;
+    std::memcpy(&length, prefix, sizeof prefix);
+    if (length > MaxMessageBytes) return Failed;
+
+    message.resize(static_cast<int>(length));
+    return readBytes(message.data(), length, alive) ? Ok : Failed;
+}
+
+bool SharedRing::readBytes(char *bytes, quint32 size, const AliveCheck &alive) {
+    const quint32 capacity = header->capacity;
+    while (size > 0) {
+        const quint32 tail = header->tail.load(std::memory_order_relaxed);
+        const quint32 head = header->head.load(std::memory_order_acquire);
+        const quint32 available = head - tail;
+        if (available == 0) {
+            if (waitChange(&header->head, &header->headSleepers, head, -1, alive) != Ok) return false;
+            continue;
+        }
+
+        const quint32 count = qMin(size, available);
+        const quint32 at = tail & (capacity - 1);
+        const quint32 first = qMin(count, capacity - at);
+        std::memcpy(bytes, data + at, first);
+        std::memcpy(bytes + first, data, count - first);
+
+        header->tail.store(tail + count);
+        if (header->tailSleepers.load() > 0) wake(&header->tail);
+
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+// ============================================================================
+// sharedring.h - Lock-Free Message Ring Between Two Processes
+// ============================================================================
+// A single-producer, single-consumer byte ring that lives in shared memory
+// (see playerhost.h for the block it sits in). The producer only ever
+// advances `head`, the consumer only `tail`; both are free-running 32-bit
+// counters, so
+//
+//     bytes waiting = head - tail          (modulo 2^32)
+//
+// and no lock is needed - each side publishes with a release store and
+// reads the other side's counter with an acquire load.
+//
+// Messages are a 4-byte length followed by the payload. They are STREAMED
+// through the ring: a message larger than the ring (a screenshot-raw frame)
+// simply makes the producer wait for the consumer to catch up, so the ring
+// size is a matter of speed, not of limits.
+//
+// Waiting: a side that finds nothing to do spins for a few microseconds -
+// most replies arrive within that - and then sleeps on the counter it
+// waits for. On Linux that is a futex on the shared word itself, so a wake
+// costs one syscall and only when someone is actually asleep (`sleepers`).
+// Elsewhere there is no cross-process wait on an address, and a sleeping
+// side polls in short steps instead.
+//
+// Every wait is sliced: after each slice the caller's `alive` check runs,
+// so a side blocked on a peer that has died (or hung) gives up instead of
+// waiting forever.
+// ============================================================================
+
+#ifndef SHAREDRING_H
+#define SHAREDRING_H
+
+#include <QByteArray>
+
+#include <atomic>
+#include <functional>
+
+class SharedRing {
+public:
+    // Lives in shared memory - only atomics and plain values.
+    struct Header {
+        std::atomic<quint32> head;           // Bytes ever written.
+        std::atomic<quint32> tail;           // Bytes ever read.
+        std::atomic<quint32> headSleepers;   // Consumers asleep on `head`.
+        std::atomic<quint32> tailSleepers;   // Producers asleep on `tail`.
+        quint32 capacity;                    // A power of two.
+    };
+
+    enum Result { Ok, Empty, Failed };
+    using AliveCheck = std::function<bool()>;
+
+    static const int SpinMicroseconds = 50;  // Busy-wait before sleeping.
+    static const int WaitSliceMs = 100;      // Sleep between `alive` checks.
+
+    SharedRing(Header *header, char *data);
+
+    // Empties the ring. Only while neither side is using it.
+    static void reset(Header *header, quint32 capacity);
+
+    // Producer. False if `alive` said no while waiting for space.
+    bool write(const QByteArray &message, const AliveCheck &alive);
+
+    // Consumer. Waits up to `timeoutMs` for a message to START (0 = don't
+    // wait, < 0 = forever); once one has started, waits for the rest.
+    Result read(QByteArray &message, int timeoutMs, const AliveCheck &alive);
+
+    bool isEmpty() const;
+
+    // For a watcher that isn't the consumer: the write counter, and a wait
+    // until it differs from `seen` (false on timeout).
+    quint32 written() const;
+    bool waitWritten(quint32 seen, int timeoutMs);
+
+    // ------------------------------------------------------------------------
+    // Waiting on a Shared Word
+    // ------------------------------------------------------------------------
+    // wait() returns once *word != value, or after about timeoutMs (check
+    // again). wake() wakes every waiter; call it after changing the word.
+    // ------------------------------------------------------------------------
+    static void wait(std::atomic<quint32> *word, quint32 value, int timeoutMs);
+    static void wake(std::atomic<quint32> *word);
+
+private:
+    bool writeBytes(const char *bytes, quint32 size, const AliveCheck &alive);
+    bool readBytes(char *bytes, quint32 size, const AliveCheck &alive);
+
+    Header *header;
+    char *data;
+};
+
+#endif // SHAREDRING_H
@@ -0,0 +1,474 @@
+// ============================================================================
+// simdkernels.cpp - SSE2 / NEON / Scalar Implementations
+// ============================================================================
+
+#include "simdkernels.h"
+
+// ----------------------------------------------------------------------------
+// Instruction Set Selection
+// ----------------------------------------------------------------------------
+// MSVC doesn't define __SSE2__, but always has SSE2 on x64 (and reports it
+// through _M_IX86_FP on 32-bit x86).
+// ----------------------------------------------------------------------------
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WA_SIMD_SSE2 1
+#include <emmintrin.h>   // SSE2 intrinsics
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define WA_SIMD_NEON 1
+#include <arm_neon.h>    // AArch64 NEON intrinsics
+#endif
+
+namespace SimdKernels {
+
+// ----------------------------------------------------------------------------
+// biquad()
+// ----------------------------------------------------------------------------
+// An IIR filter can't be vectorized along time (every output depends on the
+// previous one), but the channels are independent. For stereo - the common
+// case, and what MediaDecoder delivers for anything with two or more
+// channels - both channels run side by side in one 2 x double register.
+// ----------------------------------------------------------------------------
+static void biquadScalar(const float *in, float *out, size_t frames, int channels,
+                         const Biquad &c, BiquadState *state) {
+    for (int ch = 0; ch < channels; ch++) {
+        double z1 = state[ch].z1;
+        double z2 = state[ch].z2;
+        for (size_t i = 0; i < frames; i++) {
+            double x = in[i * channels + ch];
+            double y = c.b0 * x + z1;
+            z1 = c.b1 * x - c.a1 * y + z2;
+            z2 = c.b2 * x - c.a2 * y;
+            out[i * channels + ch] = static_cast<float>(y);
+        }
+        state[ch].z1 = z1;
+        state[ch].z2 = z2;
+    }
+}
+
+#if defined(WA_SIMD_SSE2)
+static void biquadStereo(const float *in, float *out, size_t frames,
+                         const Biquad &c, BiquadState *state) {
+    const __m128d b0 = _mm_set1_pd(c.b0), b1 = _mm_set1_pd(c.b1), b2 = _mm_set1_pd(c.b2);
+    const __m128d a1 = _mm_set1_pd(c.a1), a2 = _mm_set1_pd(c.a2);
+
+    // Lane 0 = left, lane 1 = right (_mm_set_pd takes the high lane first).
+    __m128d z1 = _mm_set_pd(state[1].z1, state[0].z1);
+    __m128d z2 = _mm_set_pd(state[1].z2, state[0].z2);
+
+    for (size_t i = 0; i < frames; i++) {
+        // Load one L/R pair (64 bits) and widen it to two doubles.
+        __m128 pair = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + 2 * i)));
+        __m128d x = _mm_cvtps_pd(pair);
+
+        __m128d y = _mm_add_pd(_mm_mul_pd(b0, x), z1);
+        z1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, x), _mm_mul_pd(a1, y)), z2);
+        z2 = _mm_sub_pd(_mm_mul_pd(b2, x), _mm_mul_pd(a2, y));
+
+        _mm_storel_pi(reinterpret_cast<__m64 *>(out + 2 * i), _mm_cvtpd_ps(y));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, z1);
+    state[0].z1 = lanes[0];
+    state[1].z1 = lanes[1];
+    _mm_storeu_pd(lanes, z2);
+    state[0].z2 = lanes[0];
+    state[1].z2 = lanes[1];
+}
+#elif defined(WA_SIMD_NEON)
+static void biquadStereo(const float *in, float *out, size_t frames,
+                         const Biquad &c, BiquadState *state) {
+    const float64x2_t b0 = vdupq_n_f64(c.b0), b1 = vdupq_n_f64(c.b1), b2 = vdupq_n_f64(c.b2);
+    const float64x2_t a1 = vdupq_n_f64(c.a1), a2 = vdupq_n_f64(c.a2);
+
+    double init1[2] = { state[0].z1, state[1].z1 };
+    double init2[2] = { state[0].z2, state[1].z2 };
+    float64x2_t z1 = vld1q_f64(init1);
+    float64x2_t z2 = vld1q_f64(init2);
+
+    for (size_t i = 0; i < frames; i++) {
+        float64x2_t x = vcvt_f64_f32(vld1_f32(in + 2 * i));
+
+        float64x2_t y = vfmaq_f64(z1, b0, x);
+        z1 = vfmsq_f64(vfmaq_f64(z2, b1, x), a1, y);
+        z2 = vfmsq_f64(vmulq_f64(b2, x), a2, y);
+
+        vst1_f32(out + 2 * i, vcvt_f32_f64(y));
+    }
+
+    vst1q_f64(init1, z1);
+    vst1q_f64(init2, z2);
+    state[0].z1 = init1[0];
+    state[1].z1 = init1[1];
+    state[0].z2 = init2[0];
+    state[1].z2 = init2[1];
+}
+#endif
+
+void biquad(const float *in, float *out, size_t frames, int channels,
+            const Biquad &coeffs, BiquadState *state) {
+#if defined(WA_SIMD_SSE2) || defined(WA_SIMD_NEON)
+    if (channels == 2) {
+        biquadStereo(in, out, frames, coeffs, state);
+        return;
+    }
+#endif
+    biquadScalar(in, out, frames, channels, coeffs, state);
+}
+
+// ----------------------------------------------------------------------------
+// sumOfSquares()
+// ----------------------------------------------------------------------------
+// Four floats per step, widened to doubles before squaring so that long
+// blocks of quiet audio don't lose their low bits.
+// ----------------------------------------------------------------------------
+double sumOfSquares(const float *x, size_t n) {
+    size_t i = 0;
+    double sum = 0.0;
+
+#if defined(WA_SIMD_SSE2)
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(x + i);
+        __m128d lo = _mm_cvtps_pd(v);
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(lo, lo));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(hi, hi));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    sum = lanes[0] + lanes[1];
+#elif defined(WA_SIMD_NEON)
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(x + i);
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(v));
+        float64x2_t hi = vcvt_high_f64_f32(v);
+        acc0 = vfmaq_f64(acc0, lo, lo);
+        acc1 = vfmaq_f64(acc1, hi, hi);
+    }
+    sum = vaddvq_f64(vaddq_f64(acc0, acc1));
+#endif
+
+    for (; i < n; i++) {
+        double v = x[i];
+        sum += v * v;
+    }
+    return sum;
+}
+
+// ----------------------------------------------------------------------------
+// minMaxSumSquares()
+// ----------------------------------------------------------------------------
+void minMaxSumSquares(const float *x, size_t n, float &min, float &max, double &sumSquares) {
+    size_t i = 0;
+    float lo = min;
+    float hi = max;
+    double sum = 0.0;
+
+#if defined(WA_SIMD_SSE2)
+    if (n >= 4) {
+        __m128 vmin = _mm_set1_ps(lo);
+        __m128 vmax = _mm_set1_ps(hi);
+        __m128d acc0 = _mm_setzero_pd();
+        __m128d acc1 = _mm_setzero_pd();
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(x + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+            __m128d dlo = _mm_cvtps_pd(v);
+            __m128d dhi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(dlo, dlo));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(dhi, dhi));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, vmin);
+        for (float v : lanes) lo = v < lo ? v : lo;
+        _mm_storeu_ps(lanes, vmax);
+        for (float v : lanes) hi = v > hi ? v : hi;
+        double sums[2];
+        _mm_storeu_pd(sums, _mm_add_pd(acc0, acc1));
+        sum = sums[0] + sums[1];
+    }
+#elif defined(WA_SIMD_NEON)
+    if (n >= 4) {
+        float32x4_t vmin = vdupq_n_f32(lo);
+        float32x4_t vmax = vdupq_n_f32(hi);
+        float64x2_t acc0 = vdupq_n_f64(0.0);
+        float64x2_t acc1 = vdupq_n_f64(0.0);
+        for (; i + 4 <= n; i += 4) {
+            float32x4_t v = vld1q_f32(x + i);
+            vmin = vminq_f32(vmin, v);
+            vmax = vmaxq_f32(vmax, v);
+            float64x2_t dlo = vcvt_f64_f32(vget_low_f32(v));
+            float64x2_t dhi = vcvt_high_f64_f32(v);
+            acc0 = vfmaq_f64(acc0, dlo, dlo);
+            acc1 = vfmaq_f64(acc1, dhi, dhi);
+        }
+        lo = vminvq_f32(vmin);
+        hi = vmaxvq_f32(vmax);
+        sum = vaddvq_f64(vaddq_f64(acc0, acc1));
+    }
+#endif
+
+    for (; i < n; i++) {
+        float v = x[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+        sum += double(v) * v;
+    }
+
+    min = lo;
+    max = hi;
+    sumSquares += sum;
+}
+
+// ----------------------------------------------------------------------------
+// accumulateRow()
+// ----------------------------------------------------------------------------
+// 16 pixels per step, zero-extended to 16 and then 32 bits.
+// ----------------------------------------------------------------------------
+void accumulateRow(const uint8_t *row, size_t n, uint32_t *sums) {
+    size_t i = 0;
+
+#if defined(WA_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        __m128i *s = reinterpret_cast<__m128i *>(sums + i);
+        _mm_storeu_si128(s + 0, _mm_add_epi32(_mm_loadu_si128(s + 0), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+#elif defined(WA_SIMD_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(row + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_high_u8(v);
+        uint32_t *s = sums + i;
+        vst1q_u32(s + 0,  vaddw_u16(vld1q_u32(s + 0),  vget_low_u16(lo)));
+        vst1q_u32(s + 4,  vaddw_high_u16(vld1q_u32(s + 4),  lo));
+        vst1q_u32(s + 8,  vaddw_u16(vld1q_u32(s + 8),  vget_low_u16(hi)));
+        vst1q_u32(s + 12, vaddw_high_u16(vld1q_u32(s + 12), hi));
+    }
+#endif
+
+    for (; i < n; i++) sums[i] += row[i];
+}
+
+// ----------------------------------------------------------------------------
+// sumAbsDiff()
+// ----------------------------------------------------------------------------
+// SSE2 has a dedicated instruction for this (PSADBW); on NEON the absolute
+// differences are pairwise-accumulated into 16-bit lanes, which is safe for
+// up to 128 steps before they're widened.
+// ----------------------------------------------------------------------------
+uint64_t sumAbsDiff(const uint8_t *a, const uint8_t *b, size_t n) {
+    size_t i = 0;
+    uint64_t sum = 0;
+
+#if defined(WA_SIMD_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    sum = lanes[0] + lanes[1];
+#elif defined(WA_SIMD_NEON)
+    while (i + 16 <= n) {
+        uint16x8_t acc = vdupq_n_u16(0);
+        for (int step = 0; step < 128 && i + 16 <= n; step++, i += 16) {
+            acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+        }
+        sum += vaddlvq_u16(acc);
+    }
+#endif
+
+    for (; i < n; i++) sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    return sum;
+}
+
+// ----------------------------------------------------------------------------
+// absDiff()
+// ----------------------------------------------------------------------------
+// |a - b| on unsigned bytes is (a -sat b) | (b -sat a): one of the two
+// saturating differences is always zero. The shift is a saturating add of
+// the result to itself, repeated.
+// ----------------------------------------------------------------------------
+void absDiff(const uint8_t *a, const uint8_t *b, uint8_t *out, size_t n, int shift) {
+    size_t i = 0;
+
+#if defined(WA_SIMD_SSE2)
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        for (int s = 0; s < shift; s++) d = _mm_adds_epu8(d, d);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), d);
+    }
+#elif defined(WA_SIMD_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        for (int s = 0; s < shift; s++) d = vqaddq_u8(d, d);
+        vst1q_u8(out + i, d);
+    }
+#endif
+
+    for (; i < n; i++) {
+        unsigned d = unsigned(a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]) << shift;
+        out[i] = uint8_t(d > 255 ? 255 : d);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// blend()
+// ----------------------------------------------------------------------------
+// 8.8 fixed point in 16-bit lanes: 255 * 256 + 128 still fits unsigned 16
+// bits, so a single multiply-add per byte suffices.
+// ----------------------------------------------------------------------------
+void blend(const uint8_t *a, const uint8_t *b, uint8_t *out, size_t n, int weight) {
+    size_t i = 0;
+    const uint16_t wb = uint16_t(weight < 0 ? 0 : weight > 256 ? 256 : weight);
+    const uint16_t wa = uint16_t(256 - wb);
+
+#if defined(WA_SIMD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va16 = _mm_set1_epi16(short(wa)), vb16 = _mm_set1_epi16(short(wb));
+    const __m128i round = _mm_set1_epi16(128);
+    auto mix = [&](__m128i x, __m128i y) {
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(x, va16), _mm_mullo_epi16(y, vb16));
+        return _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+    };
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        __m128i lo = mix(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(y, zero));
+        __m128i hi = mix(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(y, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(WA_SIMD_NEON)
+    const uint16x8_t va16 = vdupq_n_u16(wa), vb16 = vdupq_n_u16(wb);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t x = vld1q_u8(a + i);
+        uint8x16_t y = vld1q_u8(b + i);
+        uint16x8_t lo = vmlaq_u16(vmulq_u16(vmovl_u8(vget_low_u8(x)), va16), vmovl_u8(vget_low_u8(y)), vb16);
+        uint16x8_t hi = vmlaq_u16(vmulq_u16(vmovl_u8(vget_high_u8(x)), va16), vmovl_u8(vget_high_u8(y)), vb16);
+        vst1q_u8(out + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+    }
+#endif
+
+    for (; i < n; i++) out[i] = uint8_t((a[i] * wa + b[i] * wb + 128) >> 8);
+}
+
+// ----------------------------------------------------------------------------
+// bgrxToYCbCr()
+// ----------------------------------------------------------------------------
+// Fixed point with 14 fractional bits, so every coefficient fits a signed
+// 16-bit lane:
+//
+//   Y  =  0.2126 R + 0.7152 G + 0.0722 B
+//   Cb = -0.1146 R - 0.3854 G + 0.5000 B + 128
+//   Cr =  0.5000 R - 0.4542 G - 0.0458 B + 128
+//
+// SSE2 widens the pixels to 16 bits and uses PMADDWD (two products summed
+// per 32-bit lane: B*cB + G*cG and R*cR + X*0), then adds the lane pairs.
+// NEON deinterleaves the channels on load and multiply-accumulates.
+// ----------------------------------------------------------------------------
+namespace {
+const int YCbCrShift = 14;
+const int16_t CoeffY[3]  = {  1183, 11718,  3483 };    // B, G, R
+const int16_t CoeffCb[3] = {  8192, -6314, -1878 };
+const int16_t CoeffCr[3] = {  -750, -7442,  8192 };
+const int32_t BiasY = 1 << (YCbCrShift - 1);                        // Rounding.
+const int32_t BiasC = (128 << YCbCrShift) + (1 << (YCbCrShift - 1));
+
+inline uint8_t clampByte(int32_t v) {
+    return uint8_t(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+} // namespace
+
+void bgrxToYCbCr(const uint8_t *bgrx, size_t n, uint8_t *y, uint8_t *cb, uint8_t *cr) {
+    size_t i = 0;
+
+#if defined(WA_SIMD_SSE2)
+    auto coeffs = [](const int16_t c[3]) { return _mm_setr_epi16(c[0], c[1], c[2], 0, c[0], c[1], c[2], 0); };
+    const __m128i cy = coeffs(CoeffY), ccb = coeffs(CoeffCb), ccr = coeffs(CoeffCr);
+    const __m128i zero = _mm_setzero_si128();
+
+    // Four pixels (as two 16-bit vectors of two pixels each) -> four sums.
+    auto dot = [](__m128i lo, __m128i hi, __m128i c, int32_t bias) {
+        __m128 a = _mm_castsi128_ps(_mm_madd_epi16(lo, c));
+        __m128 b = _mm_castsi128_ps(_mm_madd_epi16(hi, c));
+        __m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128i sum = _mm_add_epi32(_mm_add_epi32(even, odd), _mm_set1_epi32(bias));
+        return _mm_srai_epi32(sum, YCbCrShift);
+    };
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgrx + i * 4));
+        __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgrx + i * 4 + 16));
+        __m128i a = _mm_unpacklo_epi8(p0, zero), b = _mm_unpackhi_epi8(p0, zero);
+        __m128i c = _mm_unpacklo_epi8(p1, zero), d = _mm_unpackhi_epi8(p1, zero);
+
+        auto store = [&](__m128i c16, int32_t bias, uint8_t *out) {
+            __m128i words = _mm_packs_epi32(dot(a, b, c16, bias), dot(c, d, c16, bias));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(words, words));
+        };
+        store(cy, BiasY, y);
+        store(ccb, BiasC, cb);
+        store(ccr, BiasC, cr);
+    }
+#elif defined(WA_SIMD_NEON)
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t px = vld4_u8(bgrx + i * 4);
+        int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(px.val[0]));
+        int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(px.val[1]));
+        int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(px.val[2]));
+
+        auto channel = [&](const int16_t c[3], int32_t bias) {
+            int32x4_t lo = vdupq_n_s32(bias), hi = vdupq_n_s32(bias);
+            lo = vmlal_n_s16(lo, vget_low_s16(b), c[0]);
+            hi = vmlal_n_s16(hi, vget_high_s16(b), c[0]);
+            lo = vmlal_n_s16(lo, vget_low_s16(g), c[1]);
+            hi = vmlal_n_s16(hi, vget_high_s16(g), c[1]);
+            lo = vmlal_n_s16(lo, vget_low_s16(r), c[2]);
+            hi = vmlal_n_s16(hi, vget_high_s16(r), c[2]);
+            return vqmovun_s16(vcombine_s16(vshrn_n_s32(lo, YCbCrShift), vshrn_n_s32(hi, YCbCrShift)));
+        };
+        vst1_u8(y + i, channel(CoeffY, BiasY));
+        vst1_u8(cb + i, channel(CoeffCb, BiasC));
+        vst1_u8(cr + i, channel(CoeffCr, BiasC));
+    }
+#endif
+
+    for (; i < n; i++) {
+        const uint8_t *p = bgrx + i * 4;
+        auto dot = [p](const int16_t c[3], int32_t bias) {
+            return (c[0] * p[0] + c[1] * p[1] + c[2] * p[2] + bias) >> YCbCrShift;
+        };
+        y[i] = clampByte(dot(CoeffY, BiasY));
+        cb[i] = clampByte(dot(CoeffCb, BiasC));
+        cr[i] = clampByte(dot(CoeffCr, BiasC));
+    }
+}
+
+const char *instructionSet() {
+#if defined(WA_SIMD_SSE2)
+    return "SSE2";
+#elif defined(WA_SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace SimdKernels
@@ -0,0 +1,95 @@
+// ============================================================================
+// simdkernels.h - Vectorized Inner Loops for the Media Analyzers
+// ============================================================================
+// The background analyzers (loudness, waveform...) spend nearly all their
+// time in a few tight loops over decoded samples. Those loops live here, with
+// one implementation per instruction set:
+//
+//   SSE2   - every x86-64 CPU (and 32-bit x86 builds with SSE2 enabled)
+//   NEON   - every 64-bit ARM CPU (Apple Silicon, Raspberry Pi 4/5...)
+//   scalar - plain C++ for anything else
+//
+// The choice is made at compile time; no runtime CPU detection is needed
+// because both SSE2 and AArch64 NEON are part of their architecture's
+// baseline.
+//
+// The audio functions take interleaved float samples, as delivered by
+// MediaDecoder; the video ones take rows of 8-bit luma, as delivered by
+// FrameDecoder, or whole 8-bit images (screenshots).
+// ============================================================================
+
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include <cstddef>       // size_t
+#include <cstdint>       // uint8_t, uint32_t, uint64_t
+
+namespace SimdKernels {
+
+// ----------------------------------------------------------------------------
+// Biquad Filter
+// ----------------------------------------------------------------------------
+// A second-order IIR section in transposed direct form II. Coefficients are
+// normalized so that a0 == 1. The state is kept in double precision: low
+// frequency filters (like the 38 Hz high-pass of the K-weighting) lose
+// accuracy quickly in float.
+// ----------------------------------------------------------------------------
+struct Biquad {
+    double b0, b1, b2;
+    double a1, a2;
+};
+
+struct BiquadState {
+    double z1 = 0.0;
+    double z2 = 0.0;
+};
+
+// Filters `frames` interleaved frames of `channels` channels. `state` must
+// point to one BiquadState per channel. `in` and `out` may be the same
+// buffer. Stereo uses both lanes of a 128-bit register (one per channel).
+void biquad(const float *in, float *out, size_t frames, int channels,
+            const Biquad &coeffs, BiquadState *state);
+
+// Sum of x[i]^2 over n samples, accumulated in double precision.
+double sumOfSquares(const float *x, size_t n);
+
+// Smallest and largest sample and the sum of squares, in one pass. The
+// results are MERGED into min/max/sumSquares, so a range split across
+// several calls gives the same answer as one call.
+void minMaxSumSquares(const float *x, size_t n, float &min, float &max, double &sumSquares);
+
+// ----------------------------------------------------------------------------
+// 8-Bit Luma
+// ----------------------------------------------------------------------------
+
+// sums[i] += row[i] for n pixels. Used to box-filter video frames down to
+// thumbnails one source row at a time.
+void accumulateRow(const uint8_t *row, size_t n, uint32_t *sums);
+
+// Sum of |a[i] - b[i]| over n pixels - the frame-difference measure of the
+// scene detector.
+uint64_t sumAbsDiff(const uint8_t *a, const uint8_t *b, size_t n);
+
+// ----------------------------------------------------------------------------
+// 8-Bit Pixels
+// ----------------------------------------------------------------------------
+
+// out[i] = |a[i] - b[i]| << shift, saturated at 255, for n bytes of any
+// 8-bit-per-channel image. A shift of 2 makes faint compression differences
+// visible in difference images.
+void absDiff(const uint8_t *a, const uint8_t *b, uint8_t *out, size_t n, int shift);
+
+// out[i] = (a[i] * (256 - weight) + b[i] * weight) / 256, rounded, for n
+// bytes; weight is 0-256 (0 = all a, 256 = all b).
+void blend(const uint8_t *a, const uint8_t *b, uint8_t *out, size_t n, int weight);
+
+// Splits n pixels of 32-bit BGRX (QImage::Format_RGB32) into full-range
+// BT.709 luma and chroma planes - the input of the video scopes.
+void bgrxToYCbCr(const uint8_t *bgrx, size_t n, uint8_t *y, uint8_t *cb, uint8_t *cr);
+
+// Name of the compiled-in implementation ("SSE2", "NEON" or "scalar").
+const char *instructionSet();
+
+} // namespace SimdKernels
+
+#endif // SIMDKERNELS_H
@@ -0,0 +1,265 @@
+// ============================================================================
+// subtitledecoder.cpp - Implementation of SubtitleDecoder
+// ============================================================================
+// Every text subtitle decoder in FFmpeg (SubRip, ASS, WebVTT, mov_text...)
+// hands its cues out in the same form: an ASS "Dialogue" line without the
+// "Dialogue:" prefix,
+//
+//     ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text
+//
+// so one routine (plainText) handles all of them.
+// ============================================================================
+
+#include "subtitledecoder.h"
+
+#include <QHash>
+#include <QStringList>
+
+#ifdef HAVE_LIBAV
+extern "C" {                         // FFmpeg is a C library.
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+#endif
+
+static const double DefaultCueSeconds = 3.0;         // When a cue has no end time.
+
+// ----------------------------------------------------------------------------
+// Private Data
+// ----------------------------------------------------------------------------
+struct SubtitleDecoder::Private {
+    QString error;
+    QVector<int> streams;
+
+#ifdef HAVE_LIBAV
+    AVFormatContext *format = nullptr;
+    QHash<int, AVCodecContext *> codecs; // By stream index.
+    AVPacket *packet = nullptr;
+    double startOffset = 0.0;            // Subtracted from every time, seconds.
+    qint64 fileSize = 0;
+#endif
+};
+
+#ifdef HAVE_LIBAV
+static QString avError(int code) {
+    char text[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(code, text, sizeof(text));
+    return QString::fromUtf8(text);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// plainText() - The Spoken Text of One ASS Dialogue Line
+// ----------------------------------------------------------------------------
+// Skips the eight leading fields, drops {override} blocks and turns ASS
+// line breaks (\N, \n) and hard spaces (\h) into plain spaces.
+// ----------------------------------------------------------------------------
+static QString plainText(const QString &ass) {
+    int pos = 0;
+    for (int field = 0; field < 8 && pos >= 0; field++) {
+        pos = ass.indexOf(',', pos);
+        if (pos >= 0) pos++;
+    }
+    if (pos < 0) return QString();
+
+    QString text;
+    text.reserve(ass.size() - pos);
+    int depth = 0;
+    for (int i = pos; i < ass.size(); i++) {
+        QChar c = ass[i];
+        if (c == '{') { depth++; continue; }
+        if (c == '}') { if (depth > 0) depth--; continue; }
+        if (depth > 0) continue;
+        if (c == '\\' && i + 1 < ass.size()) {
+            QChar n = ass[i + 1];
+            if (n == 'N' || n == 'n' || n == 'h') {
+                text += ' ';
+                i++;
+                continue;
+            }
+        }
+        text += c;
+    }
+    return text.simplified();
+}
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+SubtitleDecoder::SubtitleDecoder() : d(new Private) {
+}
+
+SubtitleDecoder::~SubtitleDecoder() {
+    close();
+    delete d;
+}
+
+bool SubtitleDecoder::isAvailable() {
+#ifdef HAVE_LIBAV
+    return true;
+#else
+    return false;
+#endif
+}
+
+QVector<int> SubtitleDecoder::streams() const { return d->streams; }
+QString SubtitleDecoder::errorString() const  { return d->error; }
+
+// ----------------------------------------------------------------------------
+// open()
+// ----------------------------------------------------------------------------
+bool SubtitleDecoder::open(const QString &path, const QVector<int> &streams, bool rebase) {
+    close();
+
+#ifndef HAVE_LIBAV
+    Q_UNUSED(path);
+    Q_UNUSED(streams);
+    Q_UNUSED(rebase);
+    d->error = "Built without libav - subtitle search is unavailable";
+    return false;
+#else
+    QByteArray file = path.toUtf8();
+    int r = avformat_open_input(&d->format, file.constData(), nullptr, nullptr);
+    if (r < 0) {
+        d->error = "Can't open file: " + avError(r);
+        return false;
+    }
+    r = avformat_find_stream_info(d->format, nullptr);
+    if (r < 0) {
+        d->error = "Can't read stream info: " + avError(r);
+        close();
+        return false;
+    }
+
+    for (int index : streams) {
+        if (index < 0 || index >= static_cast<int>(d->format->nb_streams) || d->codecs.contains(index)) continue;
+        AVStream *st = d->format->streams[index];
+        if (st->codecpar->codec_type != AVMEDIA_TYPE_SUBTITLE) continue;
+
+        const AVCodecDescriptor *desc = avcodec_descriptor_get(st->codecpar->codec_id);
+        if (desc && (desc->props & AV_CODEC_PROP_BITMAP_SUB)) continue;
+
+        const AVCodec *decoder = avcodec_find_decoder(st->codecpar->codec_id);
+        if (!decoder) continue;
+        AVCodecContext *codec = avcodec_alloc_context3(decoder);
+        avcodec_parameters_to_context(codec, st->codecpar);
+        codec->pkt_timebase = st->time_base;
+        if (avcodec_open2(codec, decoder, nullptr) < 0) {
+            avcodec_free_context(&codec);
+            continue;
+        }
+        d->codecs.insert(index, codec);
+        d->streams.append(index);
+    }
+
+    if (d->streams.isEmpty()) {
+        d->error = "No text subtitles";
+        close();
+        return false;
+    }
+
+    // Everything else is dropped by the demuxer.
+    for (unsigned i = 0; i < d->format->nb_streams; i++) {
+        if (!d->codecs.contains(static_cast<int>(i))) d->format->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    if (rebase && d->format->start_time != AV_NOPTS_VALUE) {
+        d->startOffset = d->format->start_time / static_cast<double>(AV_TIME_BASE);
+    }
+    if (d->format->pb) d->fileSize = avio_size(d->format->pb);
+
+    d->packet = av_packet_alloc();
+    d->error.clear();
+    return true;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// close()
+// ----------------------------------------------------------------------------
+void SubtitleDecoder::close() {
+#ifdef HAVE_LIBAV
+    for (AVCodecContext *codec : d->codecs) avcodec_free_context(&codec);
+    d->codecs.clear();
+    av_packet_free(&d->packet);
+    avformat_close_input(&d->format);
+    d->startOffset = 0.0;
+    d->fileSize = 0;
+#endif
+    d->streams.clear();
+}
+
+double SubtitleDecoder::progress() const {
+#ifdef HAVE_LIBAV
+    if (!d->format || !d->format->pb || d->fileSize <= 0) return 0.0;
+    return qBound(0.0, avio_tell(d->format->pb) / double(d->fileSize), 1.0);
+#else
+    return 0.0;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// next()
+// ----------------------------------------------------------------------------
+// Subtitle decoders work packet in, cue out, so there's no frame queue to
+// drain. A packet that doesn't decode is skipped; a cue whose text is
+// empty after stripping (pure positioning or drawing commands) too.
+// ----------------------------------------------------------------------------
+int SubtitleDecoder::next(int &stream, Cue &cue) {
+#ifndef HAVE_LIBAV
+    Q_UNUSED(stream);
+    Q_UNUSED(cue);
+    return -1;
+#else
+    if (!d->format) return -1;
+
+    for (;;) {
+        int r = av_read_frame(d->format, d->packet);
+        if (r == AVERROR_EOF) return 0;
+        if (r < 0) {
+            d->error = "Reading failed: " + avError(r);
+            return -1;
+        }
+
+        AVCodecContext *codec = d->codecs.value(d->packet->stream_index);
+        if (!codec) {
+            av_packet_unref(d->packet);
+            continue;
+        }
+
+        AVSubtitle sub;
+        int got = 0;
+        r = avcodec_decode_subtitle2(codec, &sub, &got, d->packet);
+        const AVRational timeBase = d->format->streams[d->packet->stream_index]->time_base;
+        const double packetStart = d->packet->pts != AV_NOPTS_VALUE ? d->packet->pts * av_q2d(timeBase) : -1.0;
+        const double packetLength = d->packet->duration > 0 ? d->packet->duration * av_q2d(timeBase) : 0.0;
+        stream = d->packet->stream_index;
+        av_packet_unref(d->packet);
+        if (r < 0 || !got) continue;
+
+        QStringList lines;
+        for (unsigned i = 0; i < sub.num_rects; i++) {
+            const AVSubtitleRect *rect = sub.rects[i];
+            QString text;
+            if (rect->type == SUBTITLE_ASS && rect->ass) text = plainText(QString::fromUtf8(rect->ass));
+            else if (rect->type == SUBTITLE_TEXT && rect->text) text = QString::fromUtf8(rect->text).simplified();
+            if (!text.isEmpty()) lines.append(text);
+        }
+
+        double start = sub.pts != AV_NOPTS_VALUE ? sub.pts / static_cast<double>(AV_TIME_BASE) : packetStart;
+        start += sub.start_display_time / 1000.0;
+        double length = packetLength;
+        if (sub.end_display_time > sub.start_display_time && sub.end_display_time != UINT32_MAX) {
+            length = (sub.end_display_time - sub.start_display_time) / 1000.0;
+        }
+        avsubtitle_free(&sub);
+
+        if (lines.isEmpty() || start < 0.0) continue;
+
+        cue.start = qMax(0.0, start - d->startOffset);
+        cue.end = cue.start + (length > 0.0 ? length : DefaultCueSeconds);
+        cue.text = lines.join(' ');
+        return 1;
+    }
+#endif
+}
@@ -0,0 +1,59 @@
+// ============================================================================
+// subtitledecoder.h - Read the Text Cues of Subtitle Streams (via libav*)
+// ============================================================================
+// The subtitle search needs every line of dialogue with its timing, long
+// before MPV would display it. SubtitleDecoder reads the chosen subtitle
+// streams of one file - a movie's embedded tracks or an external .srt /
+// .ass file - in a single pass and returns their cues as plain text, with
+// styling tags and line breaks removed.
+//
+// Only text subtitles can be read. Picture-based formats (Blu-ray PGS,
+// DVD VobSub) would need OCR and are skipped by open().
+//
+// libav is optional: without it (HAVE_LIBAV not defined) open() always
+// fails.
+// ============================================================================
+
+#ifndef SUBTITLEDECODER_H
+#define SUBTITLEDECODER_H
+
+#include <QString>
+#include <QVector>
+
+class SubtitleDecoder {
+public:
+    struct Cue {
+        double start = 0.0;                 // Seconds, on the player's timeline.
+        double end = 0.0;
+        QString text;
+    };
+
+    SubtitleDecoder();
+    ~SubtitleDecoder();
+
+    static bool isAvailable();              // False when built without libav.
+
+    // Opens `path` and sets up the given streams (FFmpeg stream indexes, as
+    // in MPV's "ff-index" track property). Picture-based streams are left
+    // out - see streams(). `rebase` subtracts the container's start time,
+    // like MPV does for the main file (but not for external subtitles).
+    bool open(const QString &path, const QVector<int> &streams, bool rebase);
+    void close();
+
+    QVector<int> streams() const;           // The streams actually being read.
+    QString errorString() const;
+    double progress() const;                // Fraction of the file read, 0..1.
+
+    // Reads the next cue of any open stream; `stream` says which. Returns 1
+    // for a cue, 0 at the end of the file, -1 on error.
+    int next(int &stream, Cue &cue);
+
+private:
+    SubtitleDecoder(const SubtitleDecoder &) = delete;
+    SubtitleDecoder &operator=(const SubtitleDecoder &) = delete;
+
+    struct Private;                         // libav types stay out of this header.
+    Private *d;
+};
+
+#endif // SUBTITLEDECODER_H
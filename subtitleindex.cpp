@@ -0,0 +1,379 @@
+// ============================================================================
+// subtitleindex.cpp - Implementation of SubtitleIndex and SubtitleIndexer
+// ============================================================================
+
+#include "subtitleindex.h"
+#include "subtitledecoder.h"
+#include "analysiscache.h"
+
+#include <QDataStream>
+#include <QFileInfo>
+
+#include <algorithm>
+
+static const quint32 CacheMagic = 0x57415354;        // "WAST"
+static const quint32 CacheVersion = 1;
+
+namespace {
+struct TermRange {
+    int first;                                       // Term ids [first, last).
+    int last;
+    int weight;                                      // Postings in the range.
+};
+}
+
+// ============================================================================
+// SubtitleIndex
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// tokenize()
+// ----------------------------------------------------------------------------
+// Compatibility decomposition splits "é" into "e" plus a combining accent
+// (and "ﬁ" into "fi"); the accents are then dropped along with everything
+// that isn't a letter or digit.
+// ----------------------------------------------------------------------------
+QStringList SubtitleIndex::tokenize(const QString &text) {
+    const QString folded = text.normalized(QString::NormalizationForm_KD).toCaseFolded();
+
+    QStringList words;
+    QString word;
+    for (QChar c : folded) {
+        if (c.isLetterOrNumber()) {
+            word += c;
+        } else if (c.isMark() || c == QChar('\'') || c == QChar(0x2019)) {
+            continue;                        // Accent or apostrophe: same word.
+        } else if (!word.isEmpty()) {
+            words.append(word);
+            word.clear();
+        }
+    }
+    if (!word.isEmpty()) words.append(word);
+    return words;
+}
+
+// ----------------------------------------------------------------------------
+// Constructor - Build the Index
+// ----------------------------------------------------------------------------
+// Postings are collected per word while walking the cues in time order, so
+// every list comes out ascending. The per-cue lists are then filled by
+// walking the SORTED terms, which makes them ascending too.
+// ----------------------------------------------------------------------------
+SubtitleIndex::SubtitleIndex(const QVector<SubtitleSource> &sources, QVector<Cue> cueList)
+    : sourceList(sources), cues(std::move(cueList)) {
+
+    std::stable_sort(cues.begin(), cues.end(), [](const Cue &a, const Cue &b) { return a.start < b.start; });
+
+    QHash<QString, QVector<int>> byWord;
+    for (int i = 0; i < cues.size(); i++) {
+        for (const QString &word : tokenize(cues[i].text)) {
+            QVector<int> &list = byWord[word];
+            if (list.isEmpty() || list.last() != i) list.append(i);
+        }
+    }
+
+    terms.reserve(byWord.size());
+    for (auto it = byWord.constBegin(); it != byWord.constEnd(); ++it) terms.append(it.key());
+    std::sort(terms.begin(), terms.end());
+
+    QVector<int> termsPerCue(cues.size(), 0);
+    postingStart.reserve(terms.size() + 1);
+    postingStart.append(0);
+    for (const QString &term : terms) {
+        const QVector<int> &list = byWord[term];
+        postings += list;
+        postingStart.append(postings.size());
+        for (int cueId : list) termsPerCue[cueId]++;
+    }
+
+    cueTermStart.resize(cues.size() + 1);
+    cueTermStart[0] = 0;
+    for (int i = 0; i < cues.size(); i++) cueTermStart[i + 1] = cueTermStart[i] + termsPerCue[i];
+
+    cueTerms.resize(postings.size());
+    QVector<int> fill = cueTermStart;
+    for (int t = 0; t < terms.size(); t++) {
+        for (int p = postingStart[t]; p < postingStart[t + 1]; p++) {
+            cueTerms[fill[postings[p]]++] = t;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// search()
+// ----------------------------------------------------------------------------
+QVector<int> SubtitleIndex::search(const QString &query, int limit) const {
+    QVector<int> hits;
+    const QStringList words = tokenize(query);
+    if (words.isEmpty() || limit <= 0) return hits;
+
+    // Each word becomes the range of term ids it is a prefix of, weighted by
+    // how many postings the range holds.
+    QVector<TermRange> ranges;
+    for (const QString &word : words) {
+        auto first = std::lower_bound(terms.constBegin(), terms.constEnd(), word);
+        auto last = std::partition_point(first, terms.constEnd(),
+                                         [&word](const QString &term) { return term.startsWith(word); });
+        TermRange r;
+        r.first = static_cast<int>(first - terms.constBegin());
+        r.last = static_cast<int>(last - terms.constBegin());
+        r.weight = postingStart[r.last] - postingStart[r.first];
+        if (r.weight == 0) return hits;      // A word nothing matches.
+        ranges.append(r);
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const TermRange &a, const TermRange &b) { return a.weight < b.weight; });
+
+    // Candidates: the rarest word's cues. A single term's postings are
+    // already in order; a range of terms is merged through a bitmap.
+    QVector<int> candidates;
+    const TermRange &rarest = ranges[0];
+    if (rarest.last - rarest.first == 1) {
+        candidates = postings.mid(postingStart[rarest.first], rarest.weight);
+    } else {
+        QVector<bool> seen(cues.size(), false);
+        for (int p = postingStart[rarest.first]; p < postingStart[rarest.last]; p++) seen[postings[p]] = true;
+        for (int i = 0; i < cues.size(); i++) {
+            if (seen[i]) candidates.append(i);
+        }
+    }
+
+    for (int cueId : candidates) {
+        const int *begin = cueTerms.constData() + cueTermStart[cueId];
+        const int *end = cueTerms.constData() + cueTermStart[cueId + 1];
+
+        bool all = true;
+        for (int k = 1; k < ranges.size() && all; k++) {
+            const int *t = std::lower_bound(begin, end, ranges[k].first);
+            all = t != end && *t < ranges[k].last;
+        }
+        if (!all) continue;
+
+        hits.append(cueId);
+        if (hits.size() >= limit) break;
+    }
+    return hits;
+}
+
+// ============================================================================
+// SubtitleIndexer
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Job - Shared State of One Indexing Run
+// ----------------------------------------------------------------------------
+// Progress is counted in permille of the files to read.
+// ----------------------------------------------------------------------------
+struct SubtitleIndexer::Job : BackgroundAnalysis::Job {
+    QVector<SubtitleSource> sources;
+
+    // Written by the task, read by finishJob() after it's done.
+    QSharedPointer<const SubtitleIndex> index;
+};
+
+// ----------------------------------------------------------------------------
+// Cache Format - One Entry per Subtitle Stream
+// ----------------------------------------------------------------------------
+static QString cacheKind(int stream) {
+    return QString("subtitles-%1").arg(stream);
+}
+
+static QByteArray serialize(const QVector<SubtitleDecoder::Cue> &cues) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << CacheMagic << CacheVersion << qint32(cues.size());
+    for (const SubtitleDecoder::Cue &cue : cues) out << cue.start << cue.end << cue.text;
+    return data;
+}
+
+static bool deserialize(const QByteArray &data, QVector<SubtitleDecoder::Cue> &cues) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0, version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != CacheMagic || version != CacheVersion || count < 0) return false;
+    cues.clear();
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        SubtitleDecoder::Cue cue;
+        in >> cue.start >> cue.end >> cue.text;
+        cues.append(cue);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+// ----------------------------------------------------------------------------
+// BuildTask - Read Every Source and Build the Index
+// ----------------------------------------------------------------------------
+// The sources are grouped by file, so all the uncached tracks of a movie
+// come out of ONE pass over it - reading a large file is what takes time.
+// ----------------------------------------------------------------------------
+class SubtitleIndexer::BuildTask : public Task {
+public:
+    explicit BuildTask(QSharedPointer<Job> job) : Task(job), job(job) {}
+
+private:
+    void work() override {
+        const QVector<SubtitleSource> &sources = job->sources;
+
+        QStringList files;
+        for (const SubtitleSource &source : sources) {
+            if (!files.contains(source.path)) files.append(source.path);
+        }
+
+        QVector<SubtitleIndex::Cue> cues;
+        QStringList errors;
+
+        for (int f = 0; f < files.size() && !job->cancelled; f++) {
+            const QString &path = files[f];
+
+            // Source number -> stream; cached streams are added right away.
+            QHash<int, int> wanted;
+            bool external = false;
+            for (int s = 0; s < sources.size(); s++) {
+                if (sources[s].path != path) continue;
+                external = sources[s].external;
+
+                QByteArray cached;
+                QVector<SubtitleDecoder::Cue> list;
+                if (AnalysisCache::load(path, cacheKind(sources[s].stream), cached) && deserialize(cached, list)) {
+                    append(cues, list, s);
+                } else {
+                    wanted.insert(sources[s].stream, s);
+                }
+            }
+            if (wanted.isEmpty()) continue;
+
+            QVector<int> streams;
+            for (auto it = wanted.constBegin(); it != wanted.constEnd(); ++it) streams.append(it.key());
+
+            SubtitleDecoder decoder;
+            if (!decoder.open(path, streams, !external)) {
+                errors.append(QFileInfo(path).fileName() + ": " + decoder.errorString());
+                continue;
+            }
+
+            QHash<int, QVector<SubtitleDecoder::Cue>> perStream;
+            int stream = -1;
+            SubtitleDecoder::Cue cue;
+            int r = 0;
+            while (!job->cancelled && (r = decoder.next(stream, cue)) > 0) {
+                perStream[stream].append(cue);
+                job->done = static_cast<qint64>((f + decoder.progress()) * 1000.0 / files.size());
+            }
+            if (job->cancelled) return;
+            if (r < 0) errors.append(QFileInfo(path).fileName() + ": " + decoder.errorString());
+
+            // A stream that was read to the end is cached even when it turned
+            // out empty, so it isn't read again next time.
+            for (int s : decoder.streams()) {
+                const QVector<SubtitleDecoder::Cue> &list = perStream[s];
+                if (r == 0) AnalysisCache::save(path, cacheKind(s), serialize(list));
+                append(cues, list, wanted.value(s));
+            }
+        }
+        if (job->cancelled) return;
+
+        if (cues.isEmpty()) {
+            job->fail(errors.isEmpty() ? QString("No text subtitles") : errors.join("; "));
+            return;
+        }
+        job->index = QSharedPointer<const SubtitleIndex>(new SubtitleIndex(sources, cues));
+    }
+
+    static void append(QVector<SubtitleIndex::Cue> &cues, const QVector<SubtitleDecoder::Cue> &list, int source) {
+        for (const SubtitleDecoder::Cue &c : list) {
+            SubtitleIndex::Cue cue;
+            cue.start = c.start;
+            cue.end = c.end;
+            cue.source = source;
+            cue.text = c.text;
+            cues.append(cue);
+        }
+    }
+
+    QSharedPointer<Job> job;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+// Indexing is I/O-bound (one pass over each file), so two threads are
+// enough - one per player.
+// ----------------------------------------------------------------------------
+SubtitleIndexer::SubtitleIndexer(QObject *parent) : BackgroundAnalysis(2, parent) {}
+
+bool SubtitleIndexer::isAvailable() {
+    return SubtitleDecoder::isAvailable();
+}
+
+// ----------------------------------------------------------------------------
+// sourcesFromTrackList()
+// ----------------------------------------------------------------------------
+QVector<SubtitleSource> SubtitleIndexer::sourcesFromTrackList(const QVariant &trackList, const QString &mediaPath) {
+    QVector<SubtitleSource> sources;
+    const bool localMedia = QFileInfo(mediaPath).isFile();
+
+    for (const QVariant &entry : trackList.toList()) {
+        QVariantMap track = entry.toMap();
+        if (track.value("type").toString() != "sub" || !track.contains("ff-index")) continue;
+
+        SubtitleSource source;
+        source.external = track.value("external").toBool();
+        source.path = source.external ? track.value("external-filename").toString() : mediaPath;
+        source.stream = track.value("ff-index").toInt();
+        if (source.external ? !QFileInfo(source.path).isFile() : !localMedia) continue;
+
+        source.label = QString("#%1").arg(track.value("id").toInt());
+        QString lang = track.value("lang").toString();
+        QString title = track.value("title").toString();
+        if (!lang.isEmpty()) source.label += " [" + lang + "]";
+        if (!title.isEmpty()) source.label += " " + title;
+        sources.append(source);
+    }
+    return sources;
+}
+
+// ----------------------------------------------------------------------------
+// index() / forget() / result()
+// ----------------------------------------------------------------------------
+void SubtitleIndexer::index(int slot, const QVector<SubtitleSource> &sources) {
+    QSharedPointer<Job> running = runningJob(slot).staticCast<Job>();
+    if (running && running->sources == sources) return;
+    QSharedPointer<const SubtitleIndex> done = results.value(slot);
+    if (!running && done && done->sources() == sources) return;
+
+    cancel(slot);
+    if (sources.isEmpty()) return;
+
+    if (!isAvailable()) {
+        emit failed(slot, "Built without libav");
+        return;
+    }
+
+    QSharedPointer<Job> job(new Job);
+    job->sources = sources;
+    job->total = 1000;
+    start(slot, job, new BuildTask(job));
+}
+
+void SubtitleIndexer::forget(int slot) {
+    results.remove(slot);
+}
+
+QSharedPointer<const SubtitleIndex> SubtitleIndexer::result(int slot) const {
+    return results.value(slot);
+}
+
+// ----------------------------------------------------------------------------
+// finishJob() (GUI Thread)
+// ----------------------------------------------------------------------------
+void SubtitleIndexer::finishJob(QSharedPointer<BackgroundAnalysis::Job> done) {
+    QSharedPointer<Job> job = done.staticCast<Job>();
+    if (!job->index) {
+        emit failed(job->slot, job->errorOr("No text subtitles"));
+        return;
+    }
+    results[job->slot] = job->index;
+    emit finished(job->slot);
+}
@@ -0,0 +1,124 @@
+// ============================================================================
+// subtitleindex.h - Full-Text Search Over a Player's Subtitles
+// ============================================================================
+// "Find the line where X says Y" - type a few words and jump both players
+// to that cue. Every text subtitle track of a player (embedded ones as well
+// as those added with loadExternalSubtitles) is read in the background by
+// SubtitleIndexer and turned into an INVERTED INDEX:
+//
+//   terms     - every distinct word, case- and accent-folded, sorted
+//   postings  - for every term, the cues that contain it (ascending)
+//   cue terms - for every cue, the terms it contains (ascending)
+//
+// A query is split into words the same way; every word matches the terms
+// it is a PREFIX of (so results appear while typing), and a cue is a hit
+// when it matches every word. Because the terms are sorted, a prefix is a
+// contiguous range of term ids. The search starts from the rarest word's
+// postings and checks the other words against each candidate's term list
+// with a binary search - which keeps queries far below a millisecond even
+// with tens of thousands of cues.
+//
+// Extracted cues are cached per subtitle stream (see analysiscache.h), so
+// re-opening a movie or adding another external file only reads what's new.
+// ============================================================================
+
+#ifndef SUBTITLEINDEX_H
+#define SUBTITLEINDEX_H
+
+#include "backgroundanalysis.h"
+
+#include <QHash>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+// ----------------------------------------------------------------------------
+// SubtitleSource - One Subtitle Track, as Listed in MPV's track-list
+// ----------------------------------------------------------------------------
+struct SubtitleSource {
+    QString path;            // The media file, or the external subtitle file.
+    int stream = -1;         // FFmpeg stream index in that file ("ff-index").
+    bool external = false;
+    QString label;           // For display, e.g. "#3 [eng] SDH".
+
+    bool operator==(const SubtitleSource &other) const {
+        return path == other.path && stream == other.stream && external == other.external;
+    }
+    bool operator!=(const SubtitleSource &other) const { return !(*this == other); }
+};
+
+// ----------------------------------------------------------------------------
+// SubtitleIndex - The Searchable Cues of One Player (Immutable)
+// ----------------------------------------------------------------------------
+class SubtitleIndex {
+public:
+    struct Cue {
+        double start = 0.0;  // Seconds, on the player's timeline.
+        double end = 0.0;
+        int source = 0;      // Index into sources().
+        QString text;
+    };
+
+    // Sorts the cues by time and builds the index. Meant for a worker thread.
+    SubtitleIndex(const QVector<SubtitleSource> &sources, QVector<Cue> cues);
+
+    const QVector<SubtitleSource> &sources() const { return sourceList; }
+    int cueCount() const { return cues.size(); }
+    const Cue &cue(int index) const { return cues[index]; }
+    int termCount() const { return terms.size(); }
+
+    // Cues containing every word of `query` (as prefixes), in time order.
+    // At most `limit` results.
+    QVector<int> search(const QString &query, int limit) const;
+
+    // Splits text into lower-case words without accents; apostrophes are
+    // dropped, so "don't" and "dont" both become "dont".
+    static QStringList tokenize(const QString &text);
+
+private:
+    QVector<SubtitleSource> sourceList;
+    QVector<Cue> cues;
+
+    QVector<QString> terms;              // Sorted; a term's id is its position.
+    QVector<int> postingStart;           // terms.size() + 1 entries into postings.
+    QVector<int> postings;               // Cue ids, ascending per term.
+    QVector<int> cueTermStart;           // cues.size() + 1 entries into cueTerms.
+    QVector<int> cueTerms;               // Term ids, ascending per cue.
+};
+
+// ----------------------------------------------------------------------------
+// SubtitleIndexer - Builds Indexes in the Background
+// ----------------------------------------------------------------------------
+// Slots work like LoudnessAnalyzer's: 0 = player 1, 1 = player 2. The
+// indexing runs on a background pool (see backgroundanalysis.h).
+// ----------------------------------------------------------------------------
+class SubtitleIndexer : public BackgroundAnalysis {
+    Q_OBJECT
+
+public:
+    explicit SubtitleIndexer(QObject *parent = nullptr);
+
+    static bool isAvailable();               // False when built without libav.
+
+    // The text-searchable sources in an MPV "track-list" value. Embedded
+    // tracks belong to `mediaPath`; both must be local files.
+    static QVector<SubtitleSource> sourcesFromTrackList(const QVariant &trackList, const QString &mediaPath);
+
+    // (Re)index a slot from `sources`. Does nothing if the slot is already
+    // indexed, or being indexed, from the same sources; an empty list
+    // clears the slot.
+    void index(int slot, const QVector<SubtitleSource> &sources);
+
+    QSharedPointer<const SubtitleIndex> result(int slot) const;   // Null until finished().
+
+private:
+    struct Job;
+    class BuildTask;
+
+    void finishJob(QSharedPointer<BackgroundAnalysis::Job> done) override;
+    void forget(int slot) override;
+
+    QHash<int, QSharedPointer<const SubtitleIndex>> results;
+};
+
+#endif // SUBTITLEINDEX_H
@@ -1,13 +1,99 @@
-QT       += core gui widgets
+QT       += core gui widgets network
 
 CONFIG += c++17
 
 SOURCES += \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    analysiscache.cpp \
+    audioducker.cpp \
+    audiolatency.cpp \
+    backgroundanalysis.cpp \
+    bufferingbarrier.cpp \
+    clipexporter.cpp \
+    compareview.cpp \
+    compositeplayer.cpp \
+    diffheatmap.cpp \
+    diffheatmapview.cpp \
+    driftcontroller.cpp \
+    fakebackend.cpp \
+    fileidentity.cpp \
+    filterchains.cpp \
+    framecapture.cpp \
+    framedecoder.cpp \
+    grouploop.cpp \
+    instrumentedbackend.cpp \
+    ipcserver.cpp \
+    keyframeindex.cpp \
+    loudnessanalyzer.cpp \
+    mediadecoder.cpp \
+    mpvbackend.cpp \
+    mpvhelpers.cpp \
+    mpvwidget.cpp \
+    openurldialog.cpp \
+    pairmemory.cpp \
+    playerbackend.cpp \
+    playergroup.cpp \
+    playerhost.cpp \
+    remotebackend.cpp \
+    scenedetector.cpp \
+    scopeview.cpp \
+    sessionstore.cpp \
+    sharedring.cpp \
+    simdkernels.cpp \
+    subtitledecoder.cpp \
+    subtitleindex.cpp \
+    videoscopes.cpp \
+    voprobe.cpp \
+    waveformpyramid.cpp \
+    waveformview.cpp \
+    watchpartysync.cpp
 
 HEADERS += \
-    mainwindow.h
+    mainwindow.h \
+    analysiscache.h \
+    audioducker.h \
+    audiolatency.h \
+    backgroundanalysis.h \
+    bufferingbarrier.h \
+    clipexporter.h \
+    compareview.h \
+    compositeplayer.h \
+    diffheatmap.h \
+    diffheatmapview.h \
+    driftcontroller.h \
+    fakebackend.h \
+    fileidentity.h \
+    filterchains.h \
+    framecapture.h \
+    framedecoder.h \
+    grouploop.h \
+    instrumentedbackend.h \
+    ipcserver.h \
+    keyframeindex.h \
+    loudnessanalyzer.h \
+    mediadecoder.h \
+    mpvbackend.h \
+    mpvhelpers.h \
+    mpvwidget.h \
+    openurldialog.h \
+    pairmemory.h \
+    playerbackend.h \
+    playergroup.h \
+    playerhost.h \
+    remotebackend.h \
+    scenedetector.h \
+    scopeview.h \
+    sessionstore.h \
+    sharedring.h \
+    simdkernels.h \
+    subtitledecoder.h \
+    subtitleindex.h \
+    videoscopes.h \
+    voprobe.h \
+    waveformpyramid.h \
+    waveformview.h \
+    watchpartysync.h
 
 FORMS += \
     mainwindow.ui
@@ -40,3 +126,11 @@ unix:!macx {
     PKGCONFIG += mpv
     CONFIG += release
 }
+
+# Optional FFmpeg libraries for the background media analysis
+unix:!macx {
+    packagesExist(libavformat libavcodec libavutil libswresample) {
+        DEFINES += HAVE_LIBAV
+        PKGCONFIG += libavformat libavcodec libavutil libswresample
+    }
+}
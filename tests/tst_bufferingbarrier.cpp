@@ -0,0 +1,279 @@
+// ============================================================================
+// tst_bufferingbarrier.cpp - Holding the Group for a Slow Source
+// ============================================================================
+// Two MpvWidgets on FakeBackends in a PlayerGroup, watched by a
+// BufferingBarrier. Player 2 plays the slow source: the tests script its
+// cache properties with FakeBackend::inject(), exactly as MPV would report
+// a network share running dry, and check when the barrier holds and
+// releases the group.
+//
+// The fake seeks instantly and keeps its cache full unless told otherwise,
+// so player 1 is always ready and only player 2 decides.
+//
+// One test replaces the script with the real thing: player 2 is an MPV
+// player on an HTTP stream from a ThrottledStream below, which stops
+// sending a few seconds in. MPV runs dry and pauses for the cache by
+// itself, and the barrier has to notice from MPV's own properties.
+// ============================================================================
+
+#include "bufferingbarrier.h"
+#include "fakebackend.h"
+#include "mpvwidget.h"
+#include "playerbackend.h"
+#include "playergroup.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QtTest>
+
+#include <cmath>
+#include <memory>
+
+// ----------------------------------------------------------------------------
+// ThrottledStream - A Video Over HTTP That Stalls on Demand
+// ----------------------------------------------------------------------------
+// An uncompressed YUV4MPEG2 video (no encoder needed, and a byte count that
+// maps straight to seconds) served from 127.0.0.1. Every connection gets
+// the file from the start, but only up to limit() bytes; raising the limit
+// is the network coming back. Range requests are ignored, which MPV takes
+// as a stream it can't seek in - fine for playing straight through.
+// ----------------------------------------------------------------------------
+class ThrottledStream : public QObject {
+public:
+    static const int Width = 160;
+    static const int Height = 120;
+    static const int Fps = 25;
+    static const int Seconds = 60;
+
+    ThrottledStream() : limitBytes(0) {
+        header = QByteArray("YUV4MPEG2 W") + QByteArray::number(Width) + " H" + QByteArray::number(Height)
+               + " F" + QByteArray::number(Fps) + ":1 Ip A1:1 C420jpeg\n";
+        frame = QByteArray("FRAME\n") + QByteArray(Width * Height * 3 / 2, char(0x80));
+
+        connect(&server, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = server.nextPendingConnection()) clients.append({ socket, QByteArray(), false, 0 });
+        });
+        connect(&pump, &QTimer::timeout, this, [this]() { send(); });
+        pump.start(10);
+    }
+
+    bool listen() { return server.listen(QHostAddress::LocalHost); }
+    QString url() const { return QString("http://127.0.0.1:%1/stall.y4m").arg(server.serverPort()); }
+
+    qint64 size() const { return header.size() + qint64(frame.size()) * Fps * Seconds; }
+    qint64 bytesFor(double seconds) const { return header.size() + qint64(frame.size() * Fps * seconds); }
+    void setLimit(qint64 bytes) { limitBytes = qMin(bytes, size()); }
+
+private:
+    struct Client {
+        QTcpSocket *socket;
+        QByteArray request;                  // Until its blank line.
+        bool answered;                       // Response header sent.
+        qint64 sent;                         // Body bytes.
+    };
+
+    void send() {
+        for (Client &client : clients) {
+            if (client.socket->state() != QAbstractSocket::ConnectedState) continue;
+            if (!client.answered) {
+                client.request += client.socket->readAll();
+                if (client.request.indexOf(QByteArray("\r\n\r\n")) < 0) continue;
+                client.socket->write("HTTP/1.1 200 OK\r\nContent-Type: video/x-yuv4mpeg\r\nContent-Length: "
+                                     + QByteArray::number(size()) + "\r\nConnection: close\r\n\r\n");
+                client.answered = true;
+            }
+            while (client.sent < limitBytes && client.socket->bytesToWrite() < 256 * 1024) {
+                QByteArray chunk = body(client.sent, qMin<qint64>(64 * 1024, limitBytes - client.sent));
+                client.socket->write(chunk);
+                client.sent += chunk.size();
+            }
+        }
+    }
+
+    QByteArray body(qint64 offset, qint64 length) const {
+        QByteArray chunk;
+        while (chunk.size() < length) {
+            qint64 at = offset + chunk.size();
+            if (at < header.size()) {
+                chunk += header.mid(int(at), int(qMin<qint64>(header.size() - at, length - chunk.size())));
+            } else {
+                qint64 inFrame = (at - header.size()) % frame.size();
+                chunk += frame.mid(int(inFrame), int(qMin<qint64>(frame.size() - inFrame, length - chunk.size())));
+            }
+        }
+        return chunk;
+    }
+
+    QTcpServer server;
+    QTimer pump;
+    QList<Client> clients;                   // Sockets owned by the server.
+    QByteArray header;
+    QByteArray frame;
+    qint64 limitBytes;
+};
+
+class BufferingBarrierTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void slowSourceHoldsBothPlayers();
+    void staleEofDoesNotEndSeekHold();
+    void throttledStreamHoldsBothPlayers();
+
+private:
+    void starve();                           // Player 2 has 0.2 s cached.
+    void refill();                           // ...and now 3 s.
+
+    FakeBackend *fakes[2] = {};              // Owned by the players.
+    MpvWidget *players[2] = {};
+    PlayerGroup *group = nullptr;
+    BufferingBarrier *barrier = nullptr;
+};
+
+// ----------------------------------------------------------------------------
+// init() / cleanup() - Two Playing Players Under a Barrier
+// ----------------------------------------------------------------------------
+void BufferingBarrierTest::init() {
+    group = new PlayerGroup();
+    for (int i = 0; i < 2; i++) {
+        fakes[i] = new FakeBackend();
+        players[i] = new MpvWidget(nullptr, fakes[i]);
+        players[i]->loadVideo("fake://600");
+        group->addPlayer(players[i]);
+    }
+    barrier = new BufferingBarrier(group);
+    barrier->setResumeAhead(2.0);
+
+    group->setPaused(false);
+    QTest::qWait(50);                        // Let the initial values arrive.
+    QVERIFY(!barrier->isHolding());
+}
+
+void BufferingBarrierTest::cleanup() {
+    delete barrier;
+    delete group;
+    for (MpvWidget *&player : players) {
+        delete player;
+        player = nullptr;
+    }
+}
+
+void BufferingBarrierTest::starve() {
+    fakes[1]->inject("demuxer-cache-idle", false);
+    fakes[1]->inject("demuxer-cache-duration", 0.2);
+}
+
+void BufferingBarrierTest::refill() {
+    fakes[1]->inject("demuxer-cache-duration", 3.0);
+}
+
+// ----------------------------------------------------------------------------
+// A Stall While Playing
+// ----------------------------------------------------------------------------
+// Player 2 runs out of data. After the grace period both players are held;
+// player 2 catching its breath is not enough, only a cache of resumeAhead
+// seconds releases the group - and then both play again together.
+// ----------------------------------------------------------------------------
+void BufferingBarrierTest::slowSourceHoldsBothPlayers() {
+    starve();
+    fakes[1]->inject("paused-for-cache", true);
+
+    QTRY_VERIFY(barrier->isHolding());
+    QVERIFY(players[0]->isPaused());
+    QVERIFY(players[1]->isPaused());
+
+    fakes[1]->inject("paused-for-cache", false);
+    QTest::qWait(300);
+    QVERIFY(barrier->isHolding());
+
+    refill();
+    QTRY_VERIFY(!barrier->isHolding());
+    QVERIFY(!players[0]->isPaused());
+    QVERIFY(!players[1]->isPaused());
+}
+
+// ----------------------------------------------------------------------------
+// A Barrier Seek Away From the End
+// ----------------------------------------------------------------------------
+// Player 2 sits at the end of its file when the group seeks back. Its old
+// eof-reached must not make it "ready": the hold has to wait for its cache
+// at the new position.
+// ----------------------------------------------------------------------------
+void BufferingBarrierTest::staleEofDoesNotEndSeekHold() {
+    players[1]->seekAbsolute(600.0);
+    fakes[1]->inject("eof-reached", true);   // Re-announces the (true) value.
+    QTest::qWait(50);
+
+    starve();
+    barrier->seekTo(30.0, { 0.0, 0.0 });
+    QVERIFY(barrier->isHolding());
+
+    QTest::qWait(300);
+    QVERIFY(barrier->isHolding());
+
+    refill();
+    QTRY_VERIFY(!barrier->isHolding());
+    QVERIFY(!group->isPaused());
+}
+
+// ----------------------------------------------------------------------------
+// A Real Stall - MPV on a Stream That Stops Arriving
+// ----------------------------------------------------------------------------
+// A group of its own: player 1 a fake, player 2 MPV on the throttled
+// stream with 3 s of it available. Once MPV has played those, it pauses
+// for the cache; the barrier must hold player 1 too, keep holding while
+// nothing arrives, and release both once the data flows again.
+// ----------------------------------------------------------------------------
+void BufferingBarrierTest::throttledStreamHoldsBothPlayers() {
+    PlayerBackend *mpv = PlayerBackend::create(PlayerBackend::Mpv);
+    if (!mpv->isValid()) {
+        delete mpv;
+        QSKIP("No MPV player available");
+    }
+    mpv->setOption("ytdl", "no");            // Don't hand http:// URLs to youtube-dl.
+    mpv->setOption("load-scripts", "no");
+
+    ThrottledStream stream;
+    QVERIFY(stream.listen());
+    stream.setLimit(stream.bytesFor(3.0));
+
+    std::unique_ptr<MpvWidget> fake(new MpvWidget(nullptr, new FakeBackend()));
+    std::unique_ptr<MpvWidget> real(new MpvWidget(nullptr, mpv));
+    mpv->setString("vo", "null");            // After MpvWidget has chosen its own.
+    mpv->setString("ao", "null");
+
+    PlayerGroup streamGroup;                 // Declared after the players, so gone first.
+    streamGroup.addPlayer(fake.get());
+    streamGroup.addPlayer(real.get());
+    BufferingBarrier streamBarrier(&streamGroup);
+    streamBarrier.setResumeAhead(2.0);
+    streamGroup.setPaused(true);
+
+    fake->loadVideo("fake://600");
+    real->loadVideo(stream.url(), { { "cache", "yes" }, { "cache-pause-wait", "1" } });
+    QTRY_VERIFY_WITH_TIMEOUT(real->hasFile(), 10000);
+    streamGroup.setPaused(false);
+
+    QTRY_VERIFY_WITH_TIMEOUT(streamBarrier.isHolding(), 15000);
+    QVERIFY(fake->isPaused());
+    QVERIFY(real->isPaused());
+
+    double heldAt = fake->position();
+    QTest::qWait(1000);                      // Nothing new arrives...
+    QVERIFY(streamBarrier.isHolding());      // ...so the group stays held.
+    QVERIFY(std::abs(fake->position() - heldAt) < 0.05);
+    QVERIFY(real->position() < 3.5);
+
+    stream.setLimit(stream.size());
+    QTRY_VERIFY_WITH_TIMEOUT(!streamBarrier.isHolding(), 15000);
+    QVERIFY(!fake->isPaused());
+    QVERIFY(!real->isPaused());
+    QTRY_VERIFY_WITH_TIMEOUT(real->position() > 4.0, 5000);
+}
+
+QTEST_MAIN(BufferingBarrierTest)
+#include "tst_bufferingbarrier.moc"
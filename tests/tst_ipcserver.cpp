@@ -0,0 +1,207 @@
+// ============================================================================
+// tst_ipcserver.cpp - Group Commands Over the IPC Socket
+// ============================================================================
+// A real IpcServer on a local socket, in front of two MpvWidgets on
+// FakeBackends in a PlayerGroup. The fake players have no client handle,
+// which doesn't matter here: group commands never touch the handles, they
+// go through the GUI thread (this test's main thread), where the group
+// applies them as MainWindow does.
+//
+// A group command's reply waits for the GUI thread, so the client can't
+// live there: each test runs its client on a thread of its own while the
+// main thread runs an event loop, as the app's would. The client checks
+// the players straight from its thread - FakeBackend is thread-safe, like
+// libmpv - so "paused" is verified at the moment the reply arrives.
+// ============================================================================
+
+#include "fakebackend.h"
+#include "ipcserver.h"
+#include "mpvwidget.h"
+#include "playergroup.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QSignalSpy>
+#include <QThread>
+#include <QtTest>
+
+#include <algorithm>
+#include <functional>
+
+class IpcServerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void pauseAndPlayAreAppliedBeforeReply();
+    void seeksAreForwarded();
+    void invalidSeekIsRejected();
+    void roundTripUnderOneMillisecond();
+
+private:
+    // Runs `client` on a new thread with a connected socket, and the event
+    // loop here until it returns.
+    void runClient(const std::function<void(QLocalSocket &socket)> &client);
+
+    // Sends one JSON line and waits for its reply line (client thread).
+    static QJsonObject request(QLocalSocket &socket, const QByteArray &line);
+
+    bool bothPaused(bool paused) const;      // As the players report it.
+
+    QString name;
+    FakeBackend *fakes[2] = {};              // Owned by the players.
+    MpvWidget *players[2] = {};
+    PlayerGroup *group = nullptr;
+    IpcServer *server = nullptr;
+};
+
+// ----------------------------------------------------------------------------
+// initTestCase() / cleanupTestCase() - Server and Group
+// ----------------------------------------------------------------------------
+void IpcServerTest::initTestCase() {
+    group = new PlayerGroup();
+    for (int i = 0; i < 2; i++) {
+        fakes[i] = new FakeBackend();
+        players[i] = new MpvWidget(nullptr, fakes[i]);
+        players[i]->loadVideo("fake://600");
+        group->addPlayer(players[i]);
+    }
+
+    server = new IpcServer();
+    connect(server, &IpcServer::groupPauseRequested, group, &PlayerGroup::setPaused);
+
+    name = QString("watchalong-test-%1").arg(QCoreApplication::applicationPid());
+    QVERIFY(server->start(name, group->members()));
+}
+
+void IpcServerTest::cleanupTestCase() {
+    delete server;                           // Before the players, see IpcServer::stop().
+    delete group;
+    for (MpvWidget *player : players) delete player;
+}
+
+void IpcServerTest::runClient(const std::function<void(QLocalSocket &socket)> &client) {
+    const QString server = name;
+    QThread *thread = QThread::create([server, client]() {
+        QLocalSocket socket;
+        socket.connectToServer(server);
+        if (socket.waitForConnected(1000)) client(socket);
+    });
+
+    QEventLoop loop;
+    connect(thread, &QThread::finished, &loop, &QEventLoop::quit);
+    thread->start();
+    loop.exec();
+    delete thread;
+}
+
+QJsonObject IpcServerTest::request(QLocalSocket &socket, const QByteArray &line) {
+    socket.write(line + '\n');
+    socket.flush();
+    while (!socket.canReadLine()) {
+        if (!socket.waitForReadyRead(1000)) return QJsonObject();
+    }
+    return QJsonDocument::fromJson(socket.readLine()).object();
+}
+
+bool IpcServerTest::bothPaused(bool paused) const {
+    for (FakeBackend *fake : fakes) {
+        bool value = !paused;
+        if (fake->getFlag("pause", &value) < 0 || value != paused) return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Applied, Then Answered
+// ----------------------------------------------------------------------------
+void IpcServerTest::pauseAndPlayAreAppliedBeforeReply() {
+    QString pauseError, playError;
+    bool pausedAtReply = false, playingAtReply = false;
+
+    runClient([&](QLocalSocket &socket) {
+        pauseError = request(socket, R"({"command": ["group-pause"]})").value("error").toString();
+        pausedAtReply = bothPaused(true);
+        playError = request(socket, R"({"command": ["group-play"]})").value("error").toString();
+        playingAtReply = bothPaused(false);
+    });
+
+    QCOMPARE(pauseError, QString("success"));
+    QVERIFY(pausedAtReply);
+    QCOMPARE(playError, QString("success"));
+    QVERIFY(playingAtReply);
+}
+
+void IpcServerTest::seeksAreForwarded() {
+    QSignalSpy seeks(server, &IpcServer::groupSeekRequested);
+
+    runClient([](QLocalSocket &socket) {
+        request(socket, R"({"command": ["group-seek", 42.5, "absolute"]})");
+        request(socket, R"({"command": ["group-seek", -10]})");
+    });
+
+    QCOMPARE(seeks.count(), 2);                      // Before the replies.
+    QCOMPARE(seeks[0][0].toDouble(), 42.5);
+    QCOMPARE(seeks[0][1].toBool(), false);
+    QCOMPARE(seeks[1][0].toDouble(), -10.0);
+    QCOMPARE(seeks[1][1].toBool(), true);            // Relative is the default.
+}
+
+void IpcServerTest::invalidSeekIsRejected() {
+    QSignalSpy seeks(server, &IpcServer::groupSeekRequested);
+
+    QJsonObject reply;
+    runClient([&](QLocalSocket &socket) {
+        reply = request(socket, R"({"command": ["group-seek", 5, "sideways"], "request_id": 3})");
+    });
+
+    QCOMPARE(reply.value("error").toString(), QString("invalid parameter"));
+    QCOMPARE(reply.value("request_id").toInt(), 3);
+    QCOMPARE(seeks.count(), 0);
+}
+
+// ----------------------------------------------------------------------------
+// Latency - Request to Both Players Paused in Under a Millisecond
+// ----------------------------------------------------------------------------
+// Alternating pause and play; each round trip ends with the reply, which
+// only comes once both players report the new state - checked right then.
+// The median of many round trips, so one unlucky scheduling delay on a
+// busy machine doesn't fail the test.
+// ----------------------------------------------------------------------------
+void IpcServerTest::roundTripUnderOneMillisecond() {
+    const int warmup = 20;
+    const int samples = 200;
+
+    QVector<qint64> nanoseconds;
+    int wrong = 0;
+
+    runClient([&](QLocalSocket &socket) {
+        for (int i = 0; i < warmup + samples; i++) {
+            bool pause = (i % 2) == 0;
+            QByteArray line = pause ? R"({"command": ["group-pause"]})" : R"({"command": ["group-play"]})";
+
+            QElapsedTimer timer;
+            timer.start();
+            QJsonObject reply = request(socket, line);
+            qint64 elapsed = timer.nsecsElapsed();
+
+            if (reply.value("error").toString() != "success" || !bothPaused(pause)) wrong++;
+            if (i >= warmup) nanoseconds.append(elapsed);
+        }
+    });
+
+    QCOMPARE(wrong, 0);
+    QCOMPARE(nanoseconds.size(), samples);
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    qint64 median = nanoseconds[samples / 2];
+    QVERIFY2(median < 1000000, qPrintable(QString("median round trip %1 us").arg(median / 1000)));
+}
+
+QTEST_MAIN(IpcServerTest)
+#include "tst_ipcserver.moc"
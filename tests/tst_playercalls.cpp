@@ -0,0 +1,152 @@
+// ============================================================================
+// tst_playercalls.cpp - Player Calls per Group Action
+// ============================================================================
+// Two MpvWidgets on FakeBackends, each wrapped in an InstrumentedBackend and
+// put in a PlayerGroup - the app's arrangement, minus libmpv. Every test
+// loads a file into both, clears the counters, runs ONE group action and
+// then compares the complete table of calls each player received.
+//
+// The expected tables are the cost of an action. A change that adds a
+// property read to a global seek fails here, and the table shows where.
+// ============================================================================
+
+#include "fakebackend.h"
+#include "instrumentedbackend.h"
+#include "mpvwidget.h"
+#include "playergroup.h"
+
+#include <QtTest>
+
+using CallTable = QMap<QString, qint64>;
+
+class PlayerCallsTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void groupSeek();
+    void groupSeekRelative();
+    void groupPause();
+    void groupPlay();
+    void groupSpeed();
+    void instrumentationOffAddsNoWrapper();
+
+private:
+    CallTable calls(int player) const;       // "get time-pos" -> 2, ...
+
+    MpvWidget *players[2] = {};
+    InstrumentedBackend *counters[2] = {};
+    PlayerGroup *group = nullptr;
+};
+
+// ----------------------------------------------------------------------------
+// init() / cleanup() - Two Loaded Players, Counters at Zero
+// ----------------------------------------------------------------------------
+void PlayerCallsTest::init() {
+    group = new PlayerGroup();
+    for (int i = 0; i < 2; i++) {
+        counters[i] = new InstrumentedBackend(new FakeBackend());
+        players[i] = new MpvWidget(nullptr, counters[i]);     // Takes ownership.
+        players[i]->loadVideo("fake://600");
+        group->addPlayer(players[i]);
+    }
+    QTRY_VERIFY(group->hasMedia());          // Once idle-active has come in.
+
+    counters[0]->reset();
+    counters[1]->reset();
+}
+
+void PlayerCallsTest::cleanup() {
+    delete group;
+    for (MpvWidget *&player : players) {
+        delete player;
+        player = nullptr;
+    }
+}
+
+CallTable PlayerCallsTest::calls(int player) const {
+    CallTable table;
+    const QMap<QString, InstrumentedBackend::CallStats> stats = counters[player]->stats();
+    for (auto it = stats.begin(); it != stats.end(); ++it) table[it.key()] = it.value().calls;
+    return table;
+}
+
+// ----------------------------------------------------------------------------
+// Seeking
+// ----------------------------------------------------------------------------
+// seekTo() reads every player's position once for the offsets; whether a
+// player has a file comes from the observed idle-active, not from a call.
+// Each seek refreshes the time display: time-pos and duration.
+// ----------------------------------------------------------------------------
+void PlayerCallsTest::groupSeek() {
+    group->seekTo(120.0);
+
+    const CallTable expected{ { "get time-pos", 2 }, { "get duration", 1 }, { "command seek", 1 } };
+    QCOMPARE(calls(0), expected);
+    QCOMPARE(calls(1), expected);
+}
+
+void PlayerCallsTest::groupSeekRelative() {
+    group->seekRelative(-10.0);
+
+    const CallTable expected{ { "command seek", 1 }, { "get time-pos", 1 }, { "get duration", 1 } };
+    QCOMPARE(calls(0), expected);
+    QCOMPARE(calls(1), expected);
+}
+
+// ----------------------------------------------------------------------------
+// Transport and Speed - One Write per Player, Nothing Read
+// ----------------------------------------------------------------------------
+// Anything read in between would delay the second player's change.
+// ----------------------------------------------------------------------------
+void PlayerCallsTest::groupPause() {
+    group->setPaused(true);
+
+    QCOMPARE(calls(0), (CallTable{ { "set pause", 1 } }));
+    QCOMPARE(calls(1), (CallTable{ { "set pause", 1 } }));
+    QVERIFY(group->isPaused());
+}
+
+void PlayerCallsTest::groupPlay() {
+    group->setPaused(true);
+    counters[0]->reset();
+    counters[1]->reset();
+
+    group->setPaused(false);
+
+    QCOMPARE(calls(0), (CallTable{ { "set pause", 1 } }));
+    QCOMPARE(calls(1), (CallTable{ { "set pause", 1 } }));
+    QVERIFY(!group->isPaused());
+}
+
+void PlayerCallsTest::groupSpeed() {
+    group->setSpeed(1.5);
+
+    QCOMPARE(calls(0), (CallTable{ { "command-async set", 1 } }));
+    QCOMPARE(calls(1), (CallTable{ { "command-async set", 1 } }));
+}
+
+// ----------------------------------------------------------------------------
+// Zero Cost When Off
+// ----------------------------------------------------------------------------
+// Without --instrument there is no wrapper at all - not a disabled one.
+// ----------------------------------------------------------------------------
+void PlayerCallsTest::instrumentationOffAddsNoWrapper() {
+    PlayerBackend *plain = PlayerBackend::create(PlayerBackend::Fake);
+    QVERIFY(dynamic_cast<FakeBackend *>(plain));
+    delete plain;
+
+    PlayerBackend::setInstrumentationEnabled(true);
+    PlayerBackend *wrapped = PlayerBackend::create(PlayerBackend::Fake);
+    PlayerBackend::setInstrumentationEnabled(false);
+
+    InstrumentedBackend *instrumented = dynamic_cast<InstrumentedBackend *>(wrapped);
+    QVERIFY(instrumented);
+    QVERIFY(dynamic_cast<FakeBackend *>(instrumented->inner()));
+    delete wrapped;
+}
+
+QTEST_MAIN(PlayerCallsTest)
+#include "tst_playercalls.moc"
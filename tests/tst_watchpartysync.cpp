@@ -0,0 +1,220 @@
+// ============================================================================
+// tst_watchpartysync.cpp - Follower Drift Under Jitter and Packet Loss
+// ============================================================================
+// A leader and a follower WatchPartySync in one process, each driving a
+// PlayerGroup of one MpvWidget on a FakeBackend. Nothing here waits for
+// real time: the test owns the clock that both syncs and both players
+// read, moves it in 5 ms steps and calls the control loops every TickMs
+// itself, so a run is the same on a busy machine as on an idle one.
+//
+// The players report time-pos a frame at a time, as MPV does, so the
+// follower has to see through the stair-steps (PositionTracker) to hold a
+// bound tighter than one frame would allow. The follower's clock also
+// starts 7 s after the leader's, for the clock estimate to find.
+//
+// The packets go over 127.0.0.1 through a LossyLink, which holds each one
+// back by a random 0-40 ms of the test's clock and drops one in ten, in
+// both directions - seeded, so every run loses the same packets.
+//
+// The follower starts a minute behind and paused, so it has to take the
+// whole path: clock estimation, a hard seek, learning its seek lead and
+// then speed corrections. Once it has had time to settle, the two players'
+// true positions (between frame steps) are compared at the same instant,
+// and every sample has to be within 50 ms.
+// ============================================================================
+
+#include "fakebackend.h"
+#include "mpvwidget.h"
+#include "playergroup.h"
+#include "watchpartysync.h"
+
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QUdpSocket>
+#include <QtTest>
+
+#include <cmath>
+
+namespace {
+
+const qint64 Millisecond = 1000000LL;        // In nanoseconds.
+const qint64 StepNs = 5 * Millisecond;
+const qint64 FollowerClockOffsetNs = 7000 * Millisecond;
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// LossyLink - A Bad Network on the Test's Clock
+// ----------------------------------------------------------------------------
+// Sits between the follower and the leader: the follower joins the link's
+// port, the link forwards to the leader's and back. A packet is dropped or
+// held until the clock reaches its due time; release() sends the ones due.
+// ----------------------------------------------------------------------------
+class LossyLink : public QObject {
+public:
+    LossyLink(quint16 leaderPort, const qint64 &nowNs, int jitterMs, int lossPercent)
+        : leaderPort(leaderPort), nowNs(nowNs), jitterMs(jitterMs), lossPercent(lossPercent),
+          random(20240611), followerPort(0) {
+        connect(&socket, &QUdpSocket::readyRead, this, [this]() { receive(); });
+    }
+
+    bool listen() { return socket.bind(QHostAddress::LocalHost, 0); }
+    quint16 port() const { return socket.localPort(); }
+
+    void release() {
+        for (int i = 0; i < held.size();) {
+            if (held[i].dueNs > nowNs) {
+                i++;
+                continue;
+            }
+            socket.writeDatagram(held[i].data, QHostAddress::LocalHost, held[i].port);
+            held.removeAt(i);
+        }
+    }
+
+private:
+    struct Packet {
+        qint64 dueNs;
+        QByteArray data;
+        quint16 port;
+    };
+
+    void receive() {
+        while (socket.hasPendingDatagrams()) {
+            QNetworkDatagram datagram = socket.receiveDatagram();
+            quint16 from = static_cast<quint16>(datagram.senderPort());
+            if (from != leaderPort) followerPort = from;
+            quint16 to = from == leaderPort ? followerPort : leaderPort;
+
+            if (to == 0 || int(random.bounded(100)) < lossPercent) continue;
+            qint64 delay = qint64(random.bounded(jitterMs + 1)) * Millisecond;
+            held.append({ nowNs + delay, datagram.data(), to });
+        }
+    }
+
+    QUdpSocket socket;
+    quint16 leaderPort;
+    const qint64 &nowNs;
+    int jitterMs;
+    int lossPercent;
+    QRandomGenerator random;
+    quint16 followerPort;                    // Learned from its first packet.
+    QList<Packet> held;
+};
+
+class WatchPartySyncTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void driftStaysUnder50msWithJitterAndLoss();
+
+private:
+    void advance(qint64 ns);                 // Move the clock, a step at a time.
+    static void deliver();                   // Let sent packets arrive.
+
+    qint64 nowNs = 0;
+    FakeBackend *fakes[2] = {};              // Owned by the players.
+    MpvWidget *players[2] = {};              // Leader's, follower's.
+    PlayerGroup *groups[2] = {};
+    WatchPartySync *syncs[2] = {};
+    LossyLink *link = nullptr;
+};
+
+// ----------------------------------------------------------------------------
+// initTestCase() / cleanupTestCase()
+// ----------------------------------------------------------------------------
+// The link replaces WatchPartySync's own simulation, which runs on real
+// time - make sure it is off before the syncs read it.
+// ----------------------------------------------------------------------------
+void WatchPartySyncTest::initTestCase() {
+    qunsetenv("WATCHALONG_SYNC_SIMULATE");
+
+    for (int i = 0; i < 2; i++) {
+        fakes[i] = new FakeBackend();
+        fakes[i]->setClock([this]() { return nowNs; });
+        fakes[i]->setFrameSteps(true);
+
+        groups[i] = new PlayerGroup();
+        players[i] = new MpvWidget(nullptr, fakes[i]);
+        players[i]->loadVideo("fake://600");
+        groups[i]->addPlayer(players[i]);
+        QTRY_VERIFY(groups[i]->hasMedia());
+        syncs[i] = new WatchPartySync(groups[i]);
+    }
+    syncs[0]->setClock([this]() { return nowNs; });
+    syncs[1]->setClock([this]() { return nowNs + FollowerClockOffsetNs; });
+}
+
+void WatchPartySyncTest::cleanupTestCase() {
+    for (int i = 0; i < 2; i++) {
+        delete syncs[i];
+        delete groups[i];
+        delete players[i];
+    }
+    delete link;
+}
+
+// ----------------------------------------------------------------------------
+// advance() / deliver()
+// ----------------------------------------------------------------------------
+// On loopback a datagram is readable as soon as it was written, so a few
+// rounds of event processing carry it through the link and into the
+// receiving sync within the same step.
+// ----------------------------------------------------------------------------
+void WatchPartySyncTest::advance(qint64 ns) {
+    const qint64 tickNs = WatchPartySync::TickMs * Millisecond;
+
+    for (const qint64 end = nowNs + ns; nowNs < end;) {
+        nowNs += StepNs;
+        link->release();
+        deliver();
+        if (nowNs % tickNs == 0) {
+            for (WatchPartySync *sync : syncs) sync->onTick();
+            deliver();
+        }
+    }
+}
+
+void WatchPartySyncTest::deliver() {
+    for (int i = 0; i < 3; i++) QCoreApplication::processEvents();
+}
+
+// ----------------------------------------------------------------------------
+// The Drift Bound
+// ----------------------------------------------------------------------------
+void WatchPartySyncTest::driftStaysUnder50msWithJitterAndLoss() {
+    const qint64 settleNs = 12000 * Millisecond;     // Seek, seek-lead check, speed-up.
+    const qint64 measureNs = 5000 * Millisecond;
+    const qint64 sampleNs = 50 * Millisecond;
+    const double bound = 0.050;
+
+    groups[0]->seekTo(60.0);
+    groups[0]->setPaused(false);
+    groups[1]->setPaused(true);
+
+    quint16 port = WatchPartySync::DefaultPort + 1 + QCoreApplication::applicationPid() % 1000;
+    QVERIFY(syncs[0]->startLeader(port));
+    link = new LossyLink(port, nowNs, 40, 10);
+    QVERIFY(link->listen());
+    QVERIFY(syncs[1]->startFollower(QHostAddress::LocalHost, link->port()));
+
+    advance(settleNs);
+    QVERIFY(!groups[1]->isPaused());
+
+    double worst = 0.0;
+    for (qint64 measured = 0; measured < measureNs; measured += sampleNs) {
+        advance(sampleNs);
+        double drift = fakes[1]->truePosition() - fakes[0]->truePosition();
+        worst = qMax(worst, std::abs(drift));
+    }
+
+    QVERIFY2(worst < bound, qPrintable(QString("worst drift %1 ms").arg(worst * 1000.0, 0, 'f', 1)));
+}
+
+QTEST_MAIN(WatchPartySyncTest)
+#include "tst_watchpartysync.moc"
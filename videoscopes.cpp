@@ -0,0 +1,203 @@
+// ============================================================================
+// videoscopes.cpp - Implementation of ScopeFrame and ScopeAnalyzer
+// ============================================================================
+
+#include "videoscopes.h"
+#include "mpvwidget.h"           // MpvWidget
+#include "simdkernels.h"         // bgrxToYCbCr()
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <atomic>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// ScopeFrame::compute()
+// ----------------------------------------------------------------------------
+// One pass per sampled row: convert to Y/Cb/Cr with the SIMD kernel, then
+// scatter into the counters. The scatter can't be vectorized (any pixel can
+// hit any bin), but it is one increment per counter per pixel.
+// ----------------------------------------------------------------------------
+QSharedPointer<ScopeFrame> ScopeFrame::compute(const QImage &source, int maxLines) {
+    QSharedPointer<ScopeFrame> frame(new ScopeFrame);
+    for (QVector<quint32> &h : frame->histogram) h.fill(0, Levels);
+    frame->waveform.fill(0, Levels * Levels);
+    frame->vectorscope.fill(0, Levels * Levels);
+
+    // Both formats grabFrame() returns are B, G, R, X/A bytes in memory.
+    QImage image = source;
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32_Premultiplied) {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    }
+
+    const int w = image.width();
+    const int h = image.height();
+    if (w <= 0 || h <= 0) return frame;
+
+    std::vector<uint8_t> y(w), cb(w), cr(w);
+    std::vector<int> column(w);
+    for (int x = 0; x < w; x++) column[x] = x * Levels / w;
+
+    quint32 *luma = frame->histogram[Luma].data();
+    quint32 *red = frame->histogram[Red].data();
+    quint32 *green = frame->histogram[Green].data();
+    quint32 *blue = frame->histogram[Blue].data();
+    quint32 *wave = frame->waveform.data();
+    quint32 *vector = frame->vectorscope.data();
+
+    const int step = qMax(1, (h + maxLines - 1) / maxLines);
+    for (int row = 0; row < h; row += step) {
+        const uint8_t *px = image.constScanLine(row);
+        SimdKernels::bgrxToYCbCr(px, size_t(w), y.data(), cb.data(), cr.data());
+
+        for (int x = 0; x < w; x++) {
+            luma[y[x]]++;
+            blue[px[x * 4]]++;
+            green[px[x * 4 + 1]]++;
+            red[px[x * 4 + 2]]++;
+            wave[y[x] * Levels + column[x]]++;
+            vector[cr[x] * Levels + cb[x]]++;
+        }
+        frame->pixels += quint32(w);
+    }
+    return frame;
+}
+
+// ----------------------------------------------------------------------------
+// Slot - Per-Player State Shared with the Worker
+// ----------------------------------------------------------------------------
+struct ScopeAnalyzer::Slot {
+    std::atomic<bool> busy{false};
+    std::atomic<int> skipped{0};
+    double lastPosition = -1.0;        // GUI thread only.
+};
+
+// ----------------------------------------------------------------------------
+// ScopeTask - Grab and Measure One Frame
+// ----------------------------------------------------------------------------
+// MPV's API is thread-safe, so the frame is grabbed here rather than on the
+// GUI thread; with hardware decoding the copy back from the GPU is the
+// slowest part.
+// ----------------------------------------------------------------------------
+class ScopeAnalyzer::ScopeTask : public QRunnable {
+public:
+    ScopeTask(ScopeAnalyzer *owner, int slot, MpvWidget *player, QSharedPointer<Slot> state)
+        : owner(owner), slot(slot), player(player), state(state) {}
+
+    void run() override {
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+
+        QElapsedTimer clock;
+        clock.start();
+
+        QSharedPointer<ScopeFrame> frame;
+        QImage image = player->grabFrame();
+        if (!image.isNull()) {
+            frame = ScopeFrame::compute(image, MaxLines);
+            frame->computeMs = int(clock.elapsed());
+        }
+
+        QSharedPointer<const ScopeFrame> result = frame;
+        ScopeAnalyzer *owner = this->owner;
+        int slot = this->slot;
+        QMetaObject::invokeMethod(owner, [owner, slot, result]() { owner->publish(slot, result); }, Qt::QueuedConnection);
+        state->busy = false;
+    }
+
+private:
+    ScopeAnalyzer *owner;
+    int slot;
+    MpvWidget *player;
+    QSharedPointer<Slot> state;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+ScopeAnalyzer::ScopeAnalyzer(const QList<MpvWidget *> &players, QObject *parent)
+    : QObject(parent), players(players) {
+    for (int i = 0; i < players.size(); i++) states.append(QSharedPointer<Slot>(new Slot));
+    frames.resize(players.size());
+
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(qMax(1, qMin(int(players.size()), QThread::idealThreadCount())));
+
+    timer = new QTimer(this);
+    timer->setInterval(1000 / DefaultRate);
+    connect(timer, &QTimer::timeout, this, &ScopeAnalyzer::tick);
+}
+
+ScopeAnalyzer::~ScopeAnalyzer() {
+    stop();
+}
+
+// ----------------------------------------------------------------------------
+// setEnabled() / setRate() / stop()
+// ----------------------------------------------------------------------------
+void ScopeAnalyzer::setEnabled(bool enabled) {
+    if (!enabled) {
+        timer->stop();
+        return;
+    }
+    for (const QSharedPointer<Slot> &state : states) state->lastPosition = -1.0;
+    timer->start();
+    tick();
+}
+
+void ScopeAnalyzer::setRate(int framesPerSecond) {
+    timer->setInterval(1000 / qBound(1, framesPerSecond, 60));
+}
+
+void ScopeAnalyzer::stop() {
+    timer->stop();
+    pool->waitForDone();
+}
+
+QSharedPointer<const ScopeFrame> ScopeAnalyzer::frame(int slot) const {
+    return frames.value(slot);
+}
+
+int ScopeAnalyzer::skipped(int slot) const {
+    return slot >= 0 && slot < states.size() ? int(states[slot]->skipped) : 0;
+}
+
+// ----------------------------------------------------------------------------
+// tick() - Start a Measurement for Every Player That Is Free
+// ----------------------------------------------------------------------------
+// A paused player keeps showing the same frame, so it is only measured
+// again once its position changes.
+// ----------------------------------------------------------------------------
+void ScopeAnalyzer::tick() {
+    for (int i = 0; i < players.size(); i++) {
+        MpvWidget *player = players[i];
+        Slot &state = *states[i];
+
+        if (!player->hasFile() || player->isPrefilling()) {
+            if (frames[i]) publish(i, QSharedPointer<const ScopeFrame>());
+            state.lastPosition = -1.0;
+            continue;
+        }
+
+        double position = player->position();
+        if (position == state.lastPosition && frames[i]) continue;
+
+        if (state.busy) {
+            state.skipped++;
+            continue;
+        }
+
+        state.busy = true;
+        state.lastPosition = position;
+        pool->start(new ScopeTask(this, i, player, states[i]));
+    }
+}
+
+void ScopeAnalyzer::publish(int slot, QSharedPointer<const ScopeFrame> frame) {
+    frames[slot] = frame;
+    emit updated(slot);
+}
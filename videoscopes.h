@@ -0,0 +1,90 @@
+// ============================================================================
+// videoscopes.h - Histogram, Waveform and Vectorscope of Both Players
+// ============================================================================
+// Comparing the color of two sources (a grade, an encoder's color handling)
+// by eye is unreliable; scopes make it measurable:
+//
+//   HISTOGRAM   - how many pixels have each luma / R / G / B level
+//   WAVEFORM    - luma level (up) against horizontal picture position
+//   VECTORSCOPE - chroma: Cb (right = blue) against Cr (up = red)
+//
+// ScopeAnalyzer samples each player's current frame (MpvWidget::grabFrame)
+// at a configurable rate and computes all three on a worker thread, using
+// SimdKernels::bgrxToYCbCr for the color conversion. Tall frames are
+// subsampled to MaxLines rows, which is plenty for a 256-level scope.
+//
+// Scopes never slow the video down: if a player's previous frame is still
+// being computed when the timer fires, that player simply skips the tick
+// (counted in skipped()). Frames are grabbed on the worker too, so the
+// GUI thread does nothing but draw. ScopeView (scopeview.h) draws results.
+// ============================================================================
+
+#ifndef VIDEOSCOPES_H
+#define VIDEOSCOPES_H
+
+#include <QObject>
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+
+class MpvWidget;
+class QImage;
+class QThreadPool;
+class QTimer;
+
+// ----------------------------------------------------------------------------
+// ScopeFrame - All Three Scopes of One Video Frame
+// ----------------------------------------------------------------------------
+struct ScopeFrame {
+    static const int Levels = 256;
+
+    enum Channel { Luma, Red, Green, Blue, ChannelCount };
+
+    QVector<quint32> histogram[ChannelCount];   // Levels counts each.
+    QVector<quint32> waveform;       // [level * Levels + column]; column =
+                                     // horizontal position scaled to 0-255.
+    QVector<quint32> vectorscope;    // [cr * Levels + cb].
+    quint32 pixels = 0;              // Pixels sampled.
+    int computeMs = 0;               // Grab + computation time.
+
+    static QSharedPointer<ScopeFrame> compute(const QImage &image, int maxLines);
+};
+
+class ScopeAnalyzer : public QObject {
+    Q_OBJECT
+
+public:
+    // Slot i is players[i].
+    explicit ScopeAnalyzer(const QList<MpvWidget *> &players, QObject *parent = nullptr);
+    ~ScopeAnalyzer();
+
+    static const int MaxLines = 360;
+    static const int DefaultRate = 5;        // Frames per second per player.
+
+    void setEnabled(bool enabled);           // Off by default.
+    void setRate(int framesPerSecond);
+
+    // Finish the work in flight and stop - before the players shut down.
+    void stop();
+
+    QSharedPointer<const ScopeFrame> frame(int slot) const;   // Latest, or null.
+    int skipped(int slot) const;             // Ticks skipped under load so far.
+
+signals:
+    void updated(int slot);
+
+private:
+    struct Slot;
+    class ScopeTask;
+
+    void tick();
+    void publish(int slot, QSharedPointer<const ScopeFrame> frame);
+
+    QList<MpvWidget *> players;
+    QList<QSharedPointer<Slot>> states;
+    QVector<QSharedPointer<const ScopeFrame>> frames;
+    QThreadPool *pool;
+    QTimer *timer;
+};
+
+#endif // VIDEOSCOPES_H
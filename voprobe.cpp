@@ -0,0 +1,383 @@
+// ============================================================================
+// voprobe.cpp - Implementation of VoProbe
+// ============================================================================
+
+#include "voprobe.h"
+#include "playerbackend.h"
+
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QSysInfo>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>             // std::min_element
+
+namespace {
+
+// 120 frames of 720p each. testsrc2 is cheap to generate, so the time goes
+// into uploading and drawing the frames - which is what's compared.
+const char *UntimedSource = "av://lavfi:testsrc2=size=1280x720:rate=60:duration=2";
+const char *TimedSource = "av://lavfi:testsrc2=size=1280x720:rate=60:duration=1";
+
+const int TimeoutMs = 8000;      // Per candidate, both runs.
+const int Players = 2;           // Side by side, as in the app.
+const int PollMs = 2;            // Between rounds when neither had an event.
+const int Version = 1;           // Of the stored format; bump to re-probe.
+
+const quint64 EofId = 1;
+
+// GUI thread only; a VoProber hands its results over in adopt().
+QString chosen;
+QList<VoResult> measured;
+bool cached = false;
+bool pending = false;
+
+QString fingerprint() {
+    return QString("%1|%2|%3|%4")
+        .arg(Version)
+        .arg(QSysInfo::prettyProductName(), QSysInfo::currentCpuArchitecture(),
+             QString::fromLatin1(QSysInfo::machineUniqueId().toHex()));
+}
+
+// ----------------------------------------------------------------------------
+// runTogether() - Play One Clip to Its End in Every Player at Once
+// ----------------------------------------------------------------------------
+// Returns the time from the first frame until the last player reached the
+// end in ms, or -1 with `error` set. keep-open holds the players on their
+// last frame, so the counters can be read afterwards. The players are
+// polled in turn, so neither waits on the other's event queue.
+// ----------------------------------------------------------------------------
+qint64 runTogether(const QList<PlayerBackend *> &players, const char *source, QElapsedTimer &deadline,
+                   const std::atomic<bool> &cancelled, QString &error) {
+    const char *cmd[] = {"loadfile", source, "replace", NULL};
+    for (PlayerBackend *player : players) {
+        if (player->command(cmd) < 0) {
+            error = "testsrc2 not available";
+            return -1;
+        }
+    }
+
+    QElapsedTimer clock;
+    QVector<bool> loading(players.size(), true);     // eof-reached of the previous run.
+    QVector<bool> ended(players.size(), false);
+    int running = players.size();
+
+    while (deadline.elapsed() < TimeoutMs && !cancelled) {
+        bool quiet = true;
+        for (int i = 0; i < players.size(); i++) {
+            PlayerEvent event = players[i]->waitEvent(0);
+            if (event.type == PlayerEvent::None) continue;
+            quiet = false;
+
+            switch (event.type) {
+            case PlayerEvent::PlaybackRestart:
+                if (!clock.isValid()) clock.start();
+                loading[i] = false;
+                break;
+            case PlayerEvent::PropertyChange:
+                if (event.id == EofId && !loading[i] && !ended[i] && event.value.toBool()) {
+                    ended[i] = true;
+                    if (--running == 0) return clock.isValid() ? clock.elapsed() : -1;
+                }
+                break;
+            case PlayerEvent::EndFile:
+                if (event.error < 0) {
+                    error = PlayerBackend::errorString(event.error);
+                    return -1;
+                }
+                break;
+            case PlayerEvent::Shutdown:
+                error = "player shut down";
+                return -1;
+            default:
+                break;
+            }
+        }
+        if (quiet) QThread::msleep(PollMs);
+    }
+    error = cancelled ? "cancelled" : "timed out";
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+// measure() - Both Runs for One Candidate, With Two Players
+// ----------------------------------------------------------------------------
+// The app always runs two players, and an output that is fast with one
+// window can fall over with two (a shared GPU context, a compositor that
+// serializes them) - so two windows play side by side, and the candidate
+// only counts if both show their frames. Its frame time is that of the
+// pair, its drops those of both.
+// ----------------------------------------------------------------------------
+PlayerBackend *createPlayer(const QString &vo, int index) {
+    PlayerBackend *player = PlayerBackend::create();
+    if (!player->isValid()) {
+        delete player;
+        return nullptr;
+    }
+
+    QByteArray voBytes = vo.toUtf8();
+    QByteArray geometry = QString("640x360+%1+0").arg(index * 660).toUtf8();
+    player->setOption("vo", voBytes.constData());
+    player->setOption("audio", "no");
+    player->setOption("untimed", "yes");
+    player->setOption("keep-open", "yes");
+    player->setOption("hwdec", "no");
+    player->setOption("osc", "no");
+    player->setOption("osd-level", "0");
+    player->setOption("border", "no");
+    player->setOption("geometry", geometry.constData());
+    player->setOption("title", "mpv-watchalong: testing video output");
+    player->setOption("input-default-bindings", "no");
+    player->setOption("input-vo-keyboard", "no");
+    player->setOption("terminal", "no");
+
+    if (player->initialize() < 0) {
+        delete player;
+        return nullptr;
+    }
+    player->observeProperty(EofId, "eof-reached");
+    return player;
+}
+
+VoResult measure(const QString &vo, const std::atomic<bool> &cancelled) {
+    VoResult result;
+    result.vo = vo;
+
+    QList<PlayerBackend *> players;
+    for (int i = 0; i < Players; i++) {
+        PlayerBackend *player = createPlayer(vo, i);
+        if (!player) {
+            result.error = "MPV could not be created";
+            break;
+        }
+        players.append(player);
+    }
+
+    if (players.size() == Players) {
+        QElapsedTimer deadline;
+        deadline.start();
+
+        qint64 untimedMs = runTogether(players, UntimedSource, deadline, cancelled, result.error);
+
+        // A vo that fails to open leaves the player running without video:
+        // the clip "plays" instantly and nothing was drawn.
+        bool shown = true;
+        qint64 fewest = -1;
+        for (PlayerBackend *player : players) {
+            bool configured = false;
+            qint64 frames = 0;
+            player->getFlag("vo-configured", &configured);
+            player->getInt("estimated-frame-number", &frames);
+            if (!configured || frames <= 0) shown = false;
+            fewest = fewest < 0 ? frames : qMin(fewest, frames);
+        }
+
+        if (untimedMs >= 0 && !shown) {
+            result.error = "no video shown in both windows";
+        } else if (untimedMs >= 0) {
+            result.frames = int(fewest);
+            result.frameMs = double(untimedMs) / fewest;
+
+            for (PlayerBackend *player : players) player->setFlag("untimed", false);
+            if (runTogether(players, TimedSource, deadline, cancelled, result.error) >= 0) {
+                for (PlayerBackend *player : players) {
+                    qint64 voDrops = 0, decoderDrops = 0;
+                    player->getInt("frame-drop-count", &voDrops);
+                    player->getInt("decoder-frame-drop-count", &decoderDrops);
+                    result.dropped += voDrops + decoderDrops;
+                }
+                result.ok = true;
+            }
+        }
+    }
+
+    for (PlayerBackend *player : players) {
+        player->terminate();             // Closes the window before the next one.
+        delete player;
+    }
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// choose() - Fewest Drops, Then Fastest
+// ----------------------------------------------------------------------------
+QString choose(const QList<VoResult> &results) {
+    auto better = [](const VoResult &a, const VoResult &b) {
+        if (a.ok != b.ok) return a.ok;
+        if (a.dropped != b.dropped) return a.dropped < b.dropped;
+        return a.frameMs < b.frameMs;
+    };
+    auto best = std::min_element(results.begin(), results.end(), better);
+    return best != results.end() && best->ok ? best->vo : QString();
+}
+
+// ----------------------------------------------------------------------------
+// store() / restore() - The Settings Entry
+// ----------------------------------------------------------------------------
+// One string per candidate: "vo|ok|frameMs|frames|dropped|error".
+// ----------------------------------------------------------------------------
+void store() {
+    QStringList lines;
+    for (const VoResult &r : measured) {
+        lines << QString("%1|%2|%3|%4|%5|%6")
+                     .arg(r.vo).arg(r.ok ? 1 : 0).arg(r.frameMs, 0, 'f', 3)
+                     .arg(r.frames).arg(r.dropped).arg(QString(r.error).replace('|', '/'));
+    }
+
+    QSettings settings("MPV-watchalong", "MPV-watchalong");
+    settings.setValue("vo-probe/fingerprint", fingerprint());
+    settings.setValue("vo-probe/selected", chosen);
+    settings.setValue("vo-probe/results", lines);
+}
+
+bool restore() {
+    QSettings settings("MPV-watchalong", "MPV-watchalong");
+    if (settings.value("vo-probe/fingerprint").toString() != fingerprint()) return false;
+
+    chosen = settings.value("vo-probe/selected").toString();
+    measured.clear();
+    const QStringList lines = settings.value("vo-probe/results").toStringList();
+    for (const QString &line : lines) {
+        QStringList parts = line.split('|');
+        if (parts.size() < 6) continue;
+        VoResult r;
+        r.vo = parts[0];
+        r.ok = parts[1] == "1";
+        r.frameMs = parts[2].toDouble();
+        r.frames = parts[3].toInt();
+        r.dropped = parts[4].toLongLong();
+        r.error = parts[5];
+        measured.append(r);
+    }
+    return true;
+}
+
+} // namespace
+
+namespace VoProbe {
+
+// ----------------------------------------------------------------------------
+// candidates()
+// ----------------------------------------------------------------------------
+// Only outputs that can open a window of their own - the players aren't
+// embedded (no "wid"), so e.g. "libmpv" doesn't apply.
+// ----------------------------------------------------------------------------
+QStringList candidates() {
+#if defined(Q_OS_LINUX)
+    return { "gpu-next", "gpu", "xv", "x11" };
+#elif defined(Q_OS_WIN)
+    return { "gpu-next", "gpu", "direct3d" };
+#else
+    return { "gpu-next", "gpu" };
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// load() / needsProbe()
+// ----------------------------------------------------------------------------
+bool load(bool force) {
+    pending = false;
+    if (PlayerBackend::defaultKind() != PlayerBackend::Mpv) return true;
+    if (!force && restore()) {
+        cached = true;
+        return true;
+    }
+    pending = true;
+    return false;
+}
+
+bool needsProbe() {
+    return pending;
+}
+
+QString selected() {
+    return chosen;
+}
+
+QList<VoResult> results() {
+    return measured;
+}
+
+bool fromCache() {
+    return cached;
+}
+
+// ----------------------------------------------------------------------------
+// summary() / table()
+// ----------------------------------------------------------------------------
+QString summary() {
+    for (const VoResult &r : measured) {
+        if (r.vo != chosen) continue;
+        return QString("%1: %2 ms/frame, %3 dropped%4")
+            .arg(r.vo).arg(r.frameMs, 0, 'f', 2).arg(r.dropped)
+            .arg(cached ? " (cached)" : "");
+    }
+    return measured.isEmpty() ? QString("default (not probed)") : QString("default (no candidate worked)");
+}
+
+QString table() {
+    QStringList lines;
+    for (const VoResult &r : measured) {
+        lines << (r.ok ? QString("%1  %2 ms/frame over %3 frames, %4 dropped at 60 fps")
+                             .arg(r.vo, -9).arg(r.frameMs, 0, 'f', 2).arg(r.frames).arg(r.dropped)
+                       : QString("%1  failed: %2").arg(r.vo, -9).arg(r.error));
+    }
+    return lines.join('\n');
+}
+
+} // namespace VoProbe
+
+// ============================================================================
+// VoProber
+// ============================================================================
+VoProber::VoProber(QObject *parent) : QObject(parent), thread(nullptr), cancelled(false) {}
+
+// A candidate being measured notices within one event wait (0.1 s).
+VoProber::~VoProber() {
+    cancelled = true;
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+bool VoProber::isRunning() const {
+    return thread != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// start() - Measure on the Probe Thread, Adopt on the GUI Thread
+// ----------------------------------------------------------------------------
+// The players may be playing meanwhile; that costs every candidate alike.
+// ----------------------------------------------------------------------------
+void VoProber::start() {
+    if (thread) return;
+    cancelled = false;
+
+    const QStringList vos = VoProbe::candidates();
+    thread = QThread::create([this, vos]() {
+        QList<VoResult> results;
+        for (int i = 0; i < vos.size() && !cancelled; i++) {
+            emit progress(i, vos.size(), vos[i]);
+            results.append(measure(vos[i], cancelled));
+        }
+        if (cancelled) return;
+        QMetaObject::invokeMethod(this, [this, results]() { adopt(results); }, Qt::QueuedConnection);
+    });
+    thread->setObjectName("VO probe");
+    thread->start();
+}
+
+void VoProber::adopt(const QList<VoResult> &results) {
+    thread->wait();                      // Its last step was queuing this call.
+    delete thread;
+    thread = nullptr;
+
+    measured = results;
+    chosen = choose(results);
+    cached = false;
+    pending = false;
+    store();
+    emit finished();
+}
@@ -0,0 +1,106 @@
+// ============================================================================
+// voprobe.h - Pick the Fastest Video Output on This Machine
+// ============================================================================
+// MPV can draw video through several outputs ("vo"): gpu-next and gpu
+// (OpenGL/Vulkan/D3D11 shaders), plain x11 or xv on Linux, direct3d on
+// Windows... Which one is fastest depends on the GPU, the driver and the
+// desktop, and the slow ones drop frames with two players running.
+//
+// So on first start every candidate is tried with a short synthetic render
+// (a testsrc2 pattern from libavfilter - no file needed) in two throwaway
+// players side by side, as the app runs them:
+//   1. untimed - frames are drawn as fast as the output can take them,
+//      which gives the average frame time
+//   2. timed at 60 fps - the frames the player had to drop to keep up
+// A candidate that can't open both windows or doesn't show frames in both
+// is out. The winner drops the fewest frames, then has the lowest frame
+// time; if none works with two players, they stay on the fallback.
+//
+// That takes a few seconds per candidate, so a VoProber does it on a thread
+// of its own while the window is already up; the players start on the
+// fallback output (see MpvWidget) and switch once the result is in.
+//
+// The result is stored in the settings together with a fingerprint of the
+// machine (OS, CPU architecture, machine id), so it's only probed again
+// when the system changes, or when asked to (load(true)). The kernel isn't
+// part of it: it changes with every update, the outputs' speed doesn't.
+// ============================================================================
+
+#ifndef VOPROBE_H
+#define VOPROBE_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+
+class QThread;
+
+// ----------------------------------------------------------------------------
+// VoResult - One Candidate's Numbers
+// ----------------------------------------------------------------------------
+struct VoResult {
+    QString vo;
+    bool ok = false;
+    double frameMs = 0.0;        // Untimed average time per frame, both players drawing.
+    int frames = 0;              // Frames shown in the untimed run (per player).
+    qint64 dropped = 0;          // Dropped in the timed 60 fps run, both players.
+    QString error;               // Why it failed, when !ok.
+};
+
+namespace VoProbe {
+
+// The outputs worth trying on this platform, best guess first.
+QStringList candidates();
+
+// Load the stored choice for this machine - call it before the players
+// exist. Returns false if there is none (or `force`): the outputs then have
+// to be measured with a VoProber. Always true with the fake player backend.
+bool load(bool force = false);
+bool needsProbe();                       // load() returned false, not measured yet.
+
+// The output the players should use ("" = MPV's own default) and the
+// numbers behind that choice.
+QString selected();
+QList<VoResult> results();
+bool fromCache();                        // True if loaded, not measured.
+
+// "gpu-next: 2.1 ms/frame, 0 dropped" - for the stats line. The full
+// table (one line per candidate) for its tooltip.
+QString summary();
+QString table();
+
+} // namespace VoProbe
+
+// ============================================================================
+// VoProber - Measure Every Candidate in the Background
+// ============================================================================
+// start() measures the candidates one after another on a thread of its own
+// (each opens two small windows). progress() is emitted before each one;
+// finished() once VoProbe::selected() and results() hold the new numbers
+// and they are stored.
+// ============================================================================
+class VoProber : public QObject {
+    Q_OBJECT
+
+public:
+    explicit VoProber(QObject *parent = nullptr);
+    ~VoProber();                         // Abandons a running probe and waits.
+
+    void start();                        // Does nothing while running.
+    bool isRunning() const;
+
+signals:
+    void progress(int done, int total, const QString &vo);
+    void finished();
+
+private:
+    void adopt(const QList<VoResult> &results);     // GUI thread.
+
+    QThread *thread;
+    std::atomic<bool> cancelled;
+};
+
+#endif // VOPROBE_H
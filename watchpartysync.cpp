@@ -0,0 +1,712 @@
+// ============================================================================
+// watchpartysync.cpp - Implementation of the Watch-Party Sync Protocol
+// ============================================================================
+// Wire format: every datagram starts with the same small header
+//
+//     quint32 magic ("WASY")   quint8 version   quint8 packet type
+//
+// followed by a type-specific payload, all written with QDataStream (which is
+// big-endian and identical on every platform and on Qt 5 and Qt 6).
+//
+//   PING   qint64 t0                         follower -> leader
+//   PONG   qint64 t0, t1, t2                 leader -> follower
+//   STATE  quint32 seq, qint64 leaderClock,  leader -> all followers
+//          double position, quint8 paused,
+//          double speed
+//   BYE    (no payload)                      either direction
+//
+// All timestamps are nanoseconds on the SENDER's monotonic clock. Clocks of
+// different machines (or even different processes) have unrelated starting
+// points, which is exactly what ClockEstimator works out.
+// ============================================================================
+
+#include "watchpartysync.h"
+#include "playergroup.h"
+
+#include <QUdpSocket>            // UDP socket (QtNetwork).
+#include <QNetworkDatagram>      // One received datagram + sender address.
+#include <QTimer>
+#include <QPointer>              // A pointer that becomes null when its QObject dies.
+#include <QRandomGenerator>      // Used only by the network simulation.
+#include <QStringList>
+
+#include <cmath>                 // std::abs, std::round
+
+// ----------------------------------------------------------------------------
+// Protocol and Tuning Constants
+// ----------------------------------------------------------------------------
+namespace {
+
+const quint32 Magic = 0x57415359;            // "WASY" in ASCII.
+const quint8 ProtocolVersion = 1;
+
+const qint64 Millisecond = 1000000LL;        // In nanoseconds.
+const qint64 BroadcastIntervalNs = 100 * Millisecond;
+const qint64 PeerTimeoutNs = 5000 * Millisecond;
+const qint64 LeaderTimeoutNs = 3000 * Millisecond;
+const qint64 FastPingIntervalNs = 50 * Millisecond;   // While the clock estimate
+const int FastPingCount = 10;                         // is still settling...
+const qint64 PingIntervalNs = 250 * Millisecond;      // ...and afterwards.
+const qint64 StatusIntervalNs = 500 * Millisecond;
+const qint64 SeekCooldownNs = 1500 * Millisecond;
+
+const int MaxClockSamples = 16;              // Clock filter window (4 s at 4 Hz).
+
+const double SeekJumpThreshold = 0.25;       // Leader: position jump = seek.
+const double HardSeekThreshold = 0.5;        // Follower: seek instead of speeding up.
+const double PausedTolerance = 0.02;         // Follower: re-seek while paused.
+const double EngageThreshold = 0.015;        // Start a speed correction...
+const double ReleaseThreshold = 0.004;       // ...and stop it again.
+const double RateGain = 0.5;                 // Speed change per second of error.
+const double MaxRateCorrection = 0.05;       // Never more than +/- 5%.
+
+} // namespace
+
+// ============================================================================
+//
+//                        ClockEstimator IMPLEMENTATION
+//
+// ============================================================================
+
+ClockEstimator::ClockEstimator() : bestIndex(-1) {
+}
+
+void ClockEstimator::reset() {
+    window.clear();
+    bestIndex = -1;
+}
+
+void ClockEstimator::addSample(qint64 t0, qint64 t1, qint64 t2, qint64 t3) {
+    qint64 rtt = (t3 - t0) - (t2 - t1);
+    if (rtt < 0) rtt = 0;    // Possible on loopback with coarse clocks.
+
+    qint64 offset = ((t1 - t0) + (t2 - t3)) / 2;
+
+    Sample sample;
+    sample.offset = offset;
+    sample.rtt = rtt;
+    window.append(sample);
+    if (window.size() > MaxClockSamples) window.removeFirst();
+
+    // Pick the sample with the smallest round trip. With only 16 entries a
+    // linear scan is cheaper than keeping anything sorted.
+    bestIndex = 0;
+    for (int i = 1; i < window.size(); i++) {
+        if (window[i].rtt < window[bestIndex].rtt) bestIndex = i;
+    }
+}
+
+bool ClockEstimator::isValid() const {
+    return bestIndex >= 0;
+}
+
+qint64 ClockEstimator::offsetNs() const {
+    return isValid() ? window[bestIndex].offset : 0;
+}
+
+qint64 ClockEstimator::rttNs() const {
+    return isValid() ? window[bestIndex].rtt : 0;
+}
+
+// ============================================================================
+//
+//                       PositionTracker IMPLEMENTATION
+//
+// ============================================================================
+
+PositionTracker::PositionTracker()
+    : valid(false), anchorNs(0), anchorPos(0.0), paused(true), speed(1.0) {
+}
+
+void PositionTracker::reset() {
+    valid = false;
+}
+
+void PositionTracker::addSample(qint64 nowNs, double position, bool isPaused, double rate) {
+    // A paused player doesn't move, so the raw sample is already exact.
+    if (!valid || isPaused || isPaused != paused) {
+        valid = true;
+        anchorNs = nowNs;
+        anchorPos = position;
+        paused = isPaused;
+        speed = rate;
+        return;
+    }
+
+    // Speed changed: continue the line from where it is now, with the new
+    // slope, instead of jumping to the (stair-stepped) sample.
+    if (rate != speed) {
+        anchorPos = estimate(nowNs);
+        anchorNs = nowNs;
+        speed = rate;
+    }
+
+    double predicted = estimate(nowNs);
+    double residual = position - predicted;
+
+    if (std::abs(residual) > SeekJumpThreshold) {
+        // Far off the line - the player seeked. Start over from the sample.
+        anchorNs = nowNs;
+        anchorPos = position;
+        return;
+    }
+
+    // Pull the line 10% of the way towards the sample.
+    anchorNs = nowNs;
+    anchorPos = predicted + 0.1 * residual;
+}
+
+double PositionTracker::estimate(qint64 nowNs) const {
+    if (!valid) return 0.0;
+    if (paused) return anchorPos;
+    return anchorPos + static_cast<double>(nowNs - anchorNs) / 1e9 * speed;
+}
+
+// ============================================================================
+//
+//                        WatchPartySync IMPLEMENTATION
+//
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Constructor / Destructor
+// ----------------------------------------------------------------------------
+WatchPartySync::WatchPartySync(PlayerGroup *group, QObject *parent)
+    : QObject(parent)
+    , group(group)
+    , socket(nullptr)
+    , tickTimer(new QTimer(this))
+    , currentRole(Off)
+    , stateSeq(0)
+    , lastBroadcastNs(0)
+    , lastBroadcastPos(0.0)
+    , lastBroadcastPaused(true)
+    , leaderPort(0)
+    , pingsSent(0)
+    , lastPingNs(0)
+    , lastSeekNs(0)
+    , errorEma(0.0)
+    , correcting(false)
+    , rateCorrection(1.0)
+    , seekLead(0.15)
+    , seekCheckPending(false)
+    , pausedSeekDone(false)
+    , pausedSeekTarget(0.0)
+    , lastStatusNs(0)
+    , simJitterMs(0)
+    , simLossPercent(0.0)
+{
+    clock.start();
+
+    tickTimer->setInterval(TickMs);
+    tickTimer->setTimerType(Qt::PreciseTimer);   // Default timers may be 5% late.
+    connect(tickTimer, &QTimer::timeout, this, &WatchPartySync::onTick);
+
+    // ------------------------------------------------------------------------
+    // Optional Network Simulation
+    // ------------------------------------------------------------------------
+    // Format: "jitter=<max ms>,loss=<percent>", either part optional.
+    // ------------------------------------------------------------------------
+    QString sim = qEnvironmentVariable("WATCHALONG_SYNC_SIMULATE");
+    for (const QString &part : sim.split(',', Qt::SkipEmptyParts)) {
+        QStringList kv = part.split('=');
+        if (kv.size() != 2) continue;
+        if (kv[0].trimmed() == "jitter") simJitterMs = kv[1].toInt();
+        else if (kv[0].trimmed() == "loss") simLossPercent = kv[1].toDouble();
+    }
+}
+
+WatchPartySync::~WatchPartySync() {
+    stop();
+}
+
+WatchPartySync::Role WatchPartySync::role() const {
+    return currentRole;
+}
+
+void WatchPartySync::setClock(const std::function<qint64()> &now) {
+    testClock = now;
+    if (testClock) tickTimer->stop();
+}
+
+qint64 WatchPartySync::nowNs() const {
+    return testClock ? testClock() : clock.nsecsElapsed();
+}
+
+// ----------------------------------------------------------------------------
+// startLeader() - Host a Watch Party
+// ----------------------------------------------------------------------------
+// Binds the well-known port and waits for followers to ping us.
+// Returns false if the port is already in use.
+// ----------------------------------------------------------------------------
+bool WatchPartySync::startLeader(quint16 port) {
+    stop();
+
+    socket = new QUdpSocket(this);
+    if (!socket->bind(QHostAddress::AnyIPv4, port)) {
+        emit statusChanged(QString("Cannot use port %1: %2").arg(port).arg(socket->errorString()));
+        socket->deleteLater();
+        socket = nullptr;
+        return false;
+    }
+    connect(socket, &QUdpSocket::readyRead, this, &WatchPartySync::onReadyRead);
+
+    currentRole = Leader;
+    peers.clear();
+    localTracker.reset();
+    lastBroadcastNs = 0;
+    lastBroadcastPaused = group->isPaused();
+    lastBroadcastPos = group->position();
+
+    if (!testClock) tickTimer->start();
+    emit statusChanged(QString("Hosting on port %1 - waiting for followers").arg(port));
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// startFollower() - Join a Watch Party
+// ----------------------------------------------------------------------------
+// Binds an arbitrary free port (0 = let the OS choose), so any number of
+// followers can run on the same machine as the leader.
+// ----------------------------------------------------------------------------
+bool WatchPartySync::startFollower(const QHostAddress &leader, quint16 port) {
+    stop();
+
+    socket = new QUdpSocket(this);
+    if (!socket->bind(QHostAddress::AnyIPv4, 0)) {
+        emit statusChanged(QString("Cannot open socket: %1").arg(socket->errorString()));
+        socket->deleteLater();
+        socket = nullptr;
+        return false;
+    }
+    connect(socket, &QUdpSocket::readyRead, this, &WatchPartySync::onReadyRead);
+
+    currentRole = Follower;
+    leaderAddress = leader;
+    leaderPort = port;
+    clockEstimator.reset();
+    leaderState = LeaderState();
+    localTracker.reset();
+    pingsSent = 0;
+    lastPingNs = 0;
+    lastSeekNs = 0;
+    errorEma = 0.0;
+    correcting = false;
+    seekCheckPending = false;
+    pausedSeekDone = false;
+
+    if (!testClock) tickTimer->start();
+    emit statusChanged(QString("Joining %1:%2...").arg(leader.toString()).arg(port));
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// stop() - Leave the Party
+// ----------------------------------------------------------------------------
+// Says goodbye so the other side doesn't have to wait for a timeout, and
+// hands speed control back to the user.
+// ----------------------------------------------------------------------------
+void WatchPartySync::stop() {
+    tickTimer->stop();
+
+    if (socket) {
+        QByteArray packet;
+        QDataStream out(&packet, QIODevice::WriteOnly);
+        writeHeader(out, PacketBye);
+
+        // Send directly (not through send()) so the simulation can't drop or
+        // delay the goodbye past the socket's lifetime.
+        if (currentRole == Leader) {
+            for (const Peer &peer : peers) {
+                socket->writeDatagram(packet, peer.address, peer.port);
+            }
+        } else if (currentRole == Follower) {
+            socket->writeDatagram(packet, leaderAddress, leaderPort);
+        }
+
+        socket->close();
+        socket->deleteLater();
+        socket = nullptr;
+    }
+
+    if (currentRole == Follower) setRateCorrection(1.0);
+
+    if (currentRole != Off) {
+        currentRole = Off;
+        peers.clear();
+        emit statusChanged("Not connected");
+    }
+}
+
+// ----------------------------------------------------------------------------
+// writeHeader() / send()
+// ----------------------------------------------------------------------------
+void WatchPartySync::writeHeader(QDataStream &out, PacketType type) const {
+    // Pin the stream format so a Qt 5 build and a Qt 6 build can talk.
+    out.setVersion(QDataStream::Qt_5_12);
+    out << Magic << ProtocolVersion << static_cast<quint8>(type);
+}
+
+void WatchPartySync::send(const QByteArray &packet, const QHostAddress &to, quint16 port) {
+    if (!socket) return;
+
+    // Simulated packet loss
+    if (simLossPercent > 0 && QRandomGenerator::global()->bounded(100.0) < simLossPercent) {
+        return;
+    }
+
+    // Simulated jitter: hold the packet back for a random time. Timestamps
+    // inside the packet were taken BEFORE the delay, exactly as if the delay
+    // had happened on the network.
+    if (simJitterMs > 0) {
+        int delay = QRandomGenerator::global()->bounded(simJitterMs + 1);
+        QPointer<QUdpSocket> target(socket);
+        QTimer::singleShot(delay, this, [target, packet, to, port]() {
+            if (target) target->writeDatagram(packet, to, port);
+        });
+        return;
+    }
+
+    socket->writeDatagram(packet, to, port);
+}
+
+// ----------------------------------------------------------------------------
+// onReadyRead() - Dispatch Incoming Datagrams
+// ----------------------------------------------------------------------------
+void WatchPartySync::onReadyRead() {
+    while (socket && socket->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = socket->receiveDatagram();
+
+        // Stamp the arrival as early as possible - everything after this
+        // line would otherwise count as network delay.
+        qint64 arrival = nowNs();
+
+        QByteArray data = datagram.data();
+        QDataStream in(data);
+        in.setVersion(QDataStream::Qt_5_12);
+
+        quint32 magic = 0;
+        quint8 version = 0;
+        quint8 type = 0;
+        in >> magic >> version >> type;
+        if (in.status() != QDataStream::Ok || magic != Magic || version != ProtocolVersion) {
+            continue;   // Not ours, or from an incompatible version.
+        }
+
+        QHostAddress from = datagram.senderAddress();
+        quint16 fromPort = static_cast<quint16>(datagram.senderPort());
+
+        // Followers only listen to the leader they joined.
+        if (currentRole == Follower
+            && (!from.isEqual(leaderAddress, QHostAddress::TolerantConversion) || fromPort != leaderPort)) {
+            continue;
+        }
+
+        switch (type) {
+        case PacketPing:
+            handlePing(in, from, fromPort, arrival);
+            break;
+        case PacketPong:
+            handlePong(in, arrival);
+            break;
+        case PacketState:
+            handleState(in, arrival);
+            break;
+        case PacketBye:
+            if (currentRole == Leader) {
+                peers.remove(QString("%1:%2").arg(from.toString()).arg(fromPort));
+            } else if (currentRole == Follower) {
+                leaderState.valid = false;
+                setRateCorrection(1.0);
+                emit statusChanged("The leader left the party");
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// handlePing() - Leader Side of the Clock Exchange
+// ----------------------------------------------------------------------------
+// A ping doubles as a "hello": any address that pings us is added to the
+// list of followers that receive STATE broadcasts.
+// ----------------------------------------------------------------------------
+void WatchPartySync::handlePing(QDataStream &in, const QHostAddress &from, quint16 port, qint64 arrivalNs) {
+    if (currentRole != Leader) return;
+
+    qint64 t0 = 0;
+    in >> t0;
+    if (in.status() != QDataStream::Ok) return;
+
+    QString key = QString("%1:%2").arg(from.toString()).arg(port);
+    peers[key] = Peer{from, port, arrivalNs};
+
+    QByteArray packet;
+    QDataStream out(&packet, QIODevice::WriteOnly);
+    writeHeader(out, PacketPong);
+    out << t0 << arrivalNs << nowNs();   // t2 is taken as late as possible.
+    send(packet, from, port);
+}
+
+// ----------------------------------------------------------------------------
+// handlePong() - Follower Side of the Clock Exchange
+// ----------------------------------------------------------------------------
+void WatchPartySync::handlePong(QDataStream &in, qint64 arrivalNs) {
+    if (currentRole != Follower) return;
+
+    qint64 t0 = 0, t1 = 0, t2 = 0;
+    in >> t0 >> t1 >> t2;
+    if (in.status() != QDataStream::Ok) return;
+
+    clockEstimator.addSample(t0, t1, t2, arrivalNs);
+}
+
+// ----------------------------------------------------------------------------
+// handleState() - Follower Receives the Leader's Position
+// ----------------------------------------------------------------------------
+void WatchPartySync::handleState(QDataStream &in, qint64 arrivalNs) {
+    if (currentRole != Follower) return;
+
+    LeaderState state;
+    quint8 paused = 0;
+    in >> state.seq >> state.leaderClockNs >> state.position >> paused >> state.speed;
+    if (in.status() != QDataStream::Ok) return;
+
+    // Drop packets that were overtaken by newer ones (UDP may reorder).
+    // A big jump backwards means the leader restarted, which we accept.
+    if (leaderState.valid && state.seq <= leaderState.seq && leaderState.seq - state.seq < 100) {
+        return;
+    }
+
+    bool pauseChanged = !leaderState.valid || leaderState.paused != (paused != 0);
+
+    state.valid = true;
+    state.paused = (paused != 0);
+    state.receivedNs = arrivalNs;
+    leaderState = state;
+
+    // Play/pause should be mirrored right away, not at the next tick, so the
+    // "3, 2, 1, play" moment lines up as closely as possible.
+    if (pauseChanged) applyCorrection(arrivalNs);
+}
+
+// ----------------------------------------------------------------------------
+// onTick() / notifyLocalChange()
+// ----------------------------------------------------------------------------
+void WatchPartySync::onTick() {
+    qint64 now = nowNs();
+
+    if (currentRole == Leader) leaderTick(now);
+    else if (currentRole == Follower) followerTick(now);
+}
+
+void WatchPartySync::notifyLocalChange() {
+    if (currentRole != Leader || !group->hasMedia()) return;
+
+    qint64 now = nowNs();
+    bool paused = group->isPaused();
+    localTracker.addSample(now, group->position(), paused, group->speed());
+    broadcastState(now, paused);
+}
+
+// ----------------------------------------------------------------------------
+// leaderTick() - Periodic Leader Work
+// ----------------------------------------------------------------------------
+// Broadcasts at a steady 10 Hz, and immediately whenever the state changes
+// in a way followers can't predict (pause toggled, or a seek).
+// ----------------------------------------------------------------------------
+void WatchPartySync::leaderTick(qint64 now) {
+    // Forget followers that stopped pinging.
+    for (auto it = peers.begin(); it != peers.end();) {
+        if (now - it->lastSeenNs > PeerTimeoutNs) it = peers.erase(it);
+        else ++it;
+    }
+
+    if (now - lastStatusNs > StatusIntervalNs) {
+        lastStatusNs = now;
+        emit statusChanged(QString("Hosting on port %1 - %2 follower(s)")
+                               .arg(socket ? socket->localPort() : 0)
+                               .arg(peers.size()));
+    }
+
+    if (!group->hasMedia()) return;
+
+    bool paused = group->isPaused();
+    localTracker.addSample(now, group->position(), paused, group->speed());
+
+    double predicted = lastBroadcastPos;
+    if (!lastBroadcastPaused) {
+        predicted += static_cast<double>(now - lastBroadcastNs) / 1e9 * group->speed();
+    }
+    bool jumped = std::abs(localTracker.estimate(now) - predicted) > SeekJumpThreshold;
+
+    if (paused != lastBroadcastPaused || jumped || now - lastBroadcastNs >= BroadcastIntervalNs) {
+        broadcastState(now, paused);
+    }
+}
+
+void WatchPartySync::broadcastState(qint64 now, bool paused) {
+    double position = localTracker.estimate(now);
+
+    QByteArray packet;
+    QDataStream out(&packet, QIODevice::WriteOnly);
+    writeHeader(out, PacketState);
+    out << ++stateSeq << now << position << static_cast<quint8>(paused ? 1 : 0) << group->speed();
+
+    for (const Peer &peer : peers) {
+        send(packet, peer.address, peer.port);
+    }
+
+    lastBroadcastNs = now;
+    lastBroadcastPos = position;
+    lastBroadcastPaused = paused;
+}
+
+// ----------------------------------------------------------------------------
+// followerTick() - Periodic Follower Work
+// ----------------------------------------------------------------------------
+void WatchPartySync::followerTick(qint64 now) {
+    // Ping quickly at first so the clock estimate converges within half a
+    // second, then slow down - the clocks don't drift apart that fast.
+    qint64 interval = pingsSent < FastPingCount ? FastPingIntervalNs : PingIntervalNs;
+    if (now - lastPingNs >= interval) {
+        QByteArray packet;
+        QDataStream out(&packet, QIODevice::WriteOnly);
+        writeHeader(out, PacketPing);
+        out << now;
+        send(packet, leaderAddress, leaderPort);
+        pingsSent++;
+        lastPingNs = now;
+    }
+
+    if (leaderState.valid && now - leaderState.receivedNs > LeaderTimeoutNs) {
+        leaderState.valid = false;
+        setRateCorrection(1.0);
+    }
+
+    applyCorrection(now);
+
+    if (now - lastStatusNs > StatusIntervalNs) {
+        lastStatusNs = now;
+        if (!leaderState.valid || !clockEstimator.isValid()) {
+            emit statusChanged(QString("Waiting for leader %1:%2...")
+                                   .arg(leaderAddress.toString()).arg(leaderPort));
+        } else {
+            emit statusChanged(QString("Following %1 | clock %2 ms (rtt %3 ms) | error %4 ms")
+                                   .arg(leaderAddress.toString())
+                                   .arg(clockEstimator.offsetNs() / 1e6, 0, 'f', 1)
+                                   .arg(clockEstimator.rttNs() / 1e6, 0, 'f', 1)
+                                   .arg(errorEma * 1000.0, 0, 'f', 0));
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// applyCorrection() - The Follower's Drift Controller
+// ----------------------------------------------------------------------------
+// 1. Work out where the leader is right now:
+//        target = position + (leader's now - leader's timestamp) * speed
+// 2. Compare with our own (smoothed) group position.
+// 3. Paused: seek exactly onto the leader's frame.
+//    Playing, far off: one exact seek, slightly ahead to cover the time the
+//    seek itself takes.
+//    Playing, close: run up to 5% faster or slower until the error is gone.
+// ----------------------------------------------------------------------------
+void WatchPartySync::applyCorrection(qint64 now) {
+    if (!leaderState.valid || !clockEstimator.isValid() || !group->hasMedia()) return;
+
+    if (group->speed() != leaderState.speed) group->setSpeed(leaderState.speed);
+
+    // While the buffering barrier holds the players, only pass on the
+    // leader's pause state. Corrections start again once the hold ends -
+    // seeking now would just restart the buffering.
+    if (group->isHeld()) {
+        group->setPaused(leaderState.paused);
+        setRateCorrection(1.0);
+        localTracker.reset();
+        return;
+    }
+
+    bool localPaused = group->isPaused();
+    if (localPaused != leaderState.paused) {
+        group->setPaused(leaderState.paused);
+        localPaused = leaderState.paused;
+    }
+
+    localTracker.addSample(now, group->position(), localPaused, group->speed() * rateCorrection);
+
+    qint64 leaderNow = now + clockEstimator.offsetNs();
+    double target = leaderState.position;
+    if (!leaderState.paused) {
+        target += static_cast<double>(leaderNow - leaderState.leaderClockNs) / 1e9 * leaderState.speed;
+    }
+
+    double error = target - localTracker.estimate(now);   // > 0 means we're behind.
+
+    // ------------------------------------------------------------------------
+    // Paused: line up on the same frame, once per leader position
+    // ------------------------------------------------------------------------
+    if (leaderState.paused) {
+        setRateCorrection(1.0);
+        errorEma = error;
+        correcting = false;
+
+        // Files with a different frame rate can never match to the
+        // millisecond, so only seek again when the LEADER moved.
+        bool targetMoved = !pausedSeekDone || std::abs(target - pausedSeekTarget) > 0.001;
+        if (std::abs(error) > PausedTolerance && targetMoved) {
+            group->seekTo(target);
+            localTracker.reset();
+            pausedSeekDone = true;
+            pausedSeekTarget = target;
+        }
+        return;
+    }
+    pausedSeekDone = false;
+
+    if (now - lastSeekNs < SeekCooldownNs) return;   // Let the last seek settle.
+
+    // Learn how long seeks take: right after a hard seek, whatever error is
+    // left over is (mostly) the time the seek cost us.
+    if (seekCheckPending) {
+        seekCheckPending = false;
+        seekLead = qBound(0.0, seekLead + 0.7 * error, 2.0);
+    }
+
+    // ------------------------------------------------------------------------
+    // Playing, far off: seek
+    // ------------------------------------------------------------------------
+    if (std::abs(error) > HardSeekThreshold) {
+        setRateCorrection(1.0);
+        group->seekTo(target + seekLead);
+        localTracker.reset();
+        lastSeekNs = now;
+        seekCheckPending = true;
+        errorEma = 0.0;
+        correcting = false;
+        return;
+    }
+
+    // ------------------------------------------------------------------------
+    // Playing, close: adjust speed
+    // ------------------------------------------------------------------------
+    errorEma += 0.25 * (error - errorEma);
+
+    double absError = std::abs(errorEma);
+    if (!correcting && absError > EngageThreshold) correcting = true;
+    else if (correcting && absError < ReleaseThreshold) correcting = false;
+
+    double factor = 1.0;
+    if (correcting) {
+        factor = 1.0 + qBound(-MaxRateCorrection, errorEma * RateGain, MaxRateCorrection);
+        factor = std::round(factor * 1000.0) / 1000.0;   // Avoid a property write per tick.
+    }
+    setRateCorrection(factor);
+}
+
+void WatchPartySync::setRateCorrection(double factor) {
+    rateCorrection = factor;
+    group->setRateCorrection(factor);
+}
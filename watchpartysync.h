@@ -0,0 +1,232 @@
+// ============================================================================
+// watchpartysync.h - Multi-Instance Watch-Party Sync over UDP
+// ============================================================================
+// Lets several copies of MPV-watchalong (usually on different machines) play
+// in lockstep. One instance is the LEADER; all the others are FOLLOWERS.
+//
+//   * The leader broadcasts its group position, pause state and speed a
+//     few times per second.
+//   * Each follower estimates the difference between its own clock and the
+//     leader's clock (NTP-style, see ClockEstimator below), uses it to work
+//     out where the leader is RIGHT NOW, and nudges its own PlayerGroup
+//     towards that position.
+//
+// Small errors are corrected by running slightly faster or slower (a few
+// percent, pitch-corrected, so nobody hears it). Large errors, e.g. after
+// the leader seeks, are corrected with one exact seek.
+//
+// For testing on a single machine, start one instance as leader and any
+// number of instances as followers of 127.0.0.1. Network trouble can be
+// simulated with an environment variable:
+//
+//     WATCHALONG_SYNC_SIMULATE="jitter=40,loss=10"
+//
+// which delays every outgoing packet by a random 0-40 ms and drops 10% of
+// them.
+// ============================================================================
+
+#ifndef WATCHPARTYSYNC_H
+#define WATCHPARTYSYNC_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QDataStream>       // Binary (de)serialization of packets.
+#include <QHostAddress>      // IP address + helpers (QtNetwork).
+#include <QElapsedTimer>     // Monotonic clock - never jumps when the wall
+// clock is adjusted, unlike QDateTime.
+
+#include <functional>
+
+class QUdpSocket;
+class QTimer;
+class PlayerGroup;
+
+// ============================================================================
+// ClockEstimator - NTP-Style Offset/Round-Trip Estimation
+// ============================================================================
+// A follower sends PING at local time t0. The leader stamps the arrival (t1)
+// and departure (t2) with ITS clock and sends PONG back, which arrives at
+// local time t3. Then:
+//
+//     round trip  = (t3 - t0) - (t2 - t1)
+//     offset      = ((t1 - t0) + (t2 - t3)) / 2      (leader minus local)
+//
+// The offset is exact if the packet took equally long in both directions.
+// Queuing delay makes that false for most packets, but the packets with the
+// SHORTEST round trip were delayed least, so we keep a small window of
+// samples and trust the one with the minimum round trip - the same "clock
+// filter" idea NTP uses.
+// ============================================================================
+class ClockEstimator {
+public:
+    ClockEstimator();
+
+    void reset();
+    void addSample(qint64 t0, qint64 t1, qint64 t2, qint64 t3);
+
+    bool isValid() const;        // True once at least one sample arrived.
+    qint64 offsetNs() const;     // Leader clock minus local clock.
+    qint64 rttNs() const;        // Round trip of the sample being trusted.
+
+private:
+    struct Sample {
+        qint64 offset;
+        qint64 rtt;
+    };
+
+    QVector<Sample> window;      // Most recent samples, oldest first.
+    int bestIndex;               // Index into window of the min-RTT sample.
+};
+
+// ============================================================================
+// PositionTracker - Smooth Playback Position Estimate
+// ============================================================================
+// MPV's time-pos only changes when a new video frame is shown, so at 24 fps
+// it moves in 42 ms steps. That is too coarse to measure a 10 ms error.
+// The tracker fits a straight line (position = anchor + elapsed * speed)
+// through the samples and gently pulls it towards each new sample, which
+// averages the stair-steps out. Jumps larger than a quarter of a second
+// (seeks) re-anchor the line immediately.
+// ============================================================================
+class PositionTracker {
+public:
+    PositionTracker();
+
+    void reset();
+    void addSample(qint64 nowNs, double position, bool paused, double speed);
+    double estimate(qint64 nowNs) const;
+
+private:
+    bool valid;
+    qint64 anchorNs;
+    double anchorPos;
+    bool paused;
+    double speed;
+};
+
+// ============================================================================
+// WatchPartySync
+// ============================================================================
+class WatchPartySync : public QObject {
+    Q_OBJECT
+
+public:
+    enum Role {
+        Off,
+        Leader,
+        Follower
+    };
+
+    static const quint16 DefaultPort = 45454;
+    static const int TickMs = 50;            // Control loop period.
+
+    explicit WatchPartySync(PlayerGroup *group, QObject *parent = nullptr);
+    ~WatchPartySync();
+
+    bool startLeader(quint16 port);                               // Host a party.
+    bool startFollower(const QHostAddress &leader, quint16 port); // Join a party.
+    void stop();                                                  // Leave/close.
+
+    Role role() const;
+
+    // For tests: read the time from `now` (nanoseconds, any origin) instead
+    // of the monotonic clock. The tick timer then stays off; whoever moves
+    // the clock also calls onTick() every TickMs.
+    void setClock(const std::function<qint64()> &now);
+
+public slots:
+    void notifyLocalChange();  // The leader's own state just changed (e.g. the
+    // user pressed Global Play) - broadcast now
+    // instead of waiting for the next tick.
+    void onTick();             // Every TickMs, from the timer (see setClock()).
+
+signals:
+    void statusChanged(const QString &text);   // Human-readable status line.
+
+private slots:
+    void onReadyRead();      // Called by the socket when datagrams arrive.
+
+private:
+    // Packet types. The numeric values are part of the wire format - never
+    // renumber them, only append.
+    enum PacketType : quint8 {
+        PacketPing  = 1,
+        PacketPong  = 2,
+        PacketState = 3,
+        PacketBye   = 4
+    };
+
+    // The leader's view of a connected follower.
+    struct Peer {
+        QHostAddress address;
+        quint16 port;
+        qint64 lastSeenNs;
+    };
+
+    // The most recent STATE packet received from the leader.
+    struct LeaderState {
+        bool valid = false;
+        quint32 seq = 0;
+        qint64 leaderClockNs = 0;
+        double position = 0.0;
+        bool paused = true;
+        double speed = 1.0;
+        qint64 receivedNs = 0;
+    };
+
+    qint64 nowNs() const;
+
+    void send(const QByteArray &packet, const QHostAddress &to, quint16 port);
+    void writeHeader(QDataStream &out, PacketType type) const;
+
+    void handlePing(QDataStream &in, const QHostAddress &from, quint16 port, qint64 arrivalNs);
+    void handlePong(QDataStream &in, qint64 arrivalNs);
+    void handleState(QDataStream &in, qint64 arrivalNs);
+
+    void leaderTick(qint64 now);
+    void broadcastState(qint64 now, bool paused);
+    void followerTick(qint64 now);
+    void applyCorrection(qint64 now);
+    void setRateCorrection(double factor);
+
+    PlayerGroup *group;
+    QUdpSocket *socket;
+    QTimer *tickTimer;
+    QElapsedTimer clock;
+    std::function<qint64()> testClock;     // Replaces `clock` if set.
+    Role currentRole;
+
+    // Leader state
+    QHash<QString, Peer> peers;            // Key: "address:port".
+    quint32 stateSeq;
+    qint64 lastBroadcastNs;
+    double lastBroadcastPos;
+    bool lastBroadcastPaused;
+
+    // Follower state
+    QHostAddress leaderAddress;
+    quint16 leaderPort;
+    ClockEstimator clockEstimator;
+    LeaderState leaderState;
+    PositionTracker localTracker;
+    int pingsSent;
+    qint64 lastPingNs;
+    qint64 lastSeekNs;
+    double errorEma;               // Smoothed position error (seconds).
+    bool correcting;               // True while a speed correction is active.
+    double rateCorrection;         // Factor currently applied to the group.
+    double seekLead;               // How far ahead of the target to seek, learned
+    // from how far behind we land after a seek.
+    bool seekCheckPending;         // Measure seekLead on the next correction.
+    bool pausedSeekDone;           // Already seeked to pausedSeekTarget.
+    double pausedSeekTarget;
+
+    qint64 lastStatusNs;
+
+    // Network simulation (see WATCHALONG_SYNC_SIMULATE above)
+    int simJitterMs;
+    double simLossPercent;
+};
+
+#endif // WATCHPARTYSYNC_H
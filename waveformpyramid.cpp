@@ -0,0 +1,306 @@
+// ============================================================================
+// waveformpyramid.cpp - Implementation of WaveformPyramid and WaveformBuilder
+// ============================================================================
+
+#include "waveformpyramid.h"
+#include "mediadecoder.h"
+#include "simdkernels.h"
+#include "analysiscache.h"
+
+#include <QSaveFile>
+
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// File Format
+// ----------------------------------------------------------------------------
+// A fixed-size header followed by the levels, finest first. The file lives
+// in the local cache only, so native byte order is fine - the magic number
+// doubles as a byte order check.
+// ----------------------------------------------------------------------------
+static const quint32 FileMagic = 0x57415746;     // "WAWF"
+static const quint32 FileVersion = 1;
+static const int MaxLevels = 40;                 // 2^40 buckets - far beyond any file.
+
+static const int SampleRate = 48000;
+static const int BucketFrames = 256;             // Level-0 resolution.
+
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 sampleRate;
+    quint32 bucketFrames;
+    quint32 levelCount;
+    quint32 reserved;
+    quint64 offsets[MaxLevels];
+    quint64 counts[MaxLevels];
+};
+
+static_assert(sizeof(WaveformPyramid::Bucket) == 4, "Bucket must stay 4 bytes - it's the file format");
+
+// ============================================================================
+// WaveformPyramid
+// ============================================================================
+
+WaveformPyramid::~WaveformPyramid() {
+    if (mapped) file.unmap(const_cast<uchar *>(mapped));
+}
+
+QSharedPointer<WaveformPyramid> WaveformPyramid::open(const QString &cacheFile) {
+    if (cacheFile.isEmpty()) return {};
+
+    QSharedPointer<WaveformPyramid> pyramid(new WaveformPyramid);
+    pyramid->file.setFileName(cacheFile);
+    if (!pyramid->file.open(QIODevice::ReadOnly)) return {};
+
+    qint64 size = pyramid->file.size();
+    if (size < static_cast<qint64>(sizeof(FileHeader))) return {};
+
+    pyramid->mapped = pyramid->file.map(0, size);
+    if (!pyramid->mapped) return {};
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(pyramid->mapped);
+    if (header->magic != FileMagic || header->version != FileVersion) return {};
+    if (header->levelCount == 0 || header->levelCount > static_cast<quint32>(MaxLevels)) return {};
+    if (header->sampleRate == 0 || header->bucketFrames == 0) return {};
+
+    // Every level must lie completely inside the file.
+    for (quint32 i = 0; i < header->levelCount; i++) {
+        quint64 end = header->offsets[i] + header->counts[i] * sizeof(Bucket);
+        if (header->offsets[i] < sizeof(FileHeader) || end > static_cast<quint64>(size)) return {};
+        pyramid->offsets.append(static_cast<qint64>(header->offsets[i]));
+        pyramid->counts.append(static_cast<qint64>(header->counts[i]));
+    }
+    pyramid->sampleRate = static_cast<int>(header->sampleRate);
+    pyramid->bucketFrames = static_cast<int>(header->bucketFrames);
+    return pyramid;
+}
+
+// ----------------------------------------------------------------------------
+// write() - Build the Upper Levels and Save
+// ----------------------------------------------------------------------------
+// Each level halves the previous one: min of mins, max of maxes, and the
+// RMS of two equal-length buckets is sqrt((a^2 + b^2) / 2).
+// ----------------------------------------------------------------------------
+bool WaveformPyramid::write(const QString &cacheFile, const QVector<Bucket> &base,
+                            int sampleRate, int bucketFrames) {
+    if (cacheFile.isEmpty() || base.isEmpty()) return false;
+
+    QVector<QVector<Bucket>> levels;
+    levels.append(base);
+    while (levels.last().size() > 1 && levels.size() < MaxLevels) {
+        const QVector<Bucket> &fine = levels.last();
+        QVector<Bucket> coarse((fine.size() + 1) / 2);
+        for (int i = 0; i < coarse.size(); i++) {
+            const Bucket &a = fine[2 * i];
+            if (2 * i + 1 >= fine.size()) {
+                coarse[i] = a;
+                continue;
+            }
+            const Bucket &b = fine[2 * i + 1];
+            double power = (double(a.rms) * a.rms + double(b.rms) * b.rms) / 2.0;
+            coarse[i].min = qMin(a.min, b.min);
+            coarse[i].max = qMax(a.max, b.max);
+            coarse[i].rms = static_cast<quint8>(qMin(255L, std::lround(std::sqrt(power))));
+            coarse[i].reserved = 0;
+        }
+        levels.append(coarse);
+    }
+
+    FileHeader header = {};
+    header.magic = FileMagic;
+    header.version = FileVersion;
+    header.sampleRate = static_cast<quint32>(sampleRate);
+    header.bucketFrames = static_cast<quint32>(bucketFrames);
+    header.levelCount = static_cast<quint32>(levels.size());
+    quint64 offset = sizeof(FileHeader);
+    for (int i = 0; i < levels.size(); i++) {
+        header.offsets[i] = offset;
+        header.counts[i] = static_cast<quint64>(levels[i].size());
+        offset += header.counts[i] * sizeof(Bucket);
+    }
+
+    QSaveFile out(cacheFile);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const QVector<Bucket> &level : levels) {
+        out.write(reinterpret_cast<const char *>(level.constData()),
+                  static_cast<qint64>(level.size()) * static_cast<qint64>(sizeof(Bucket)));
+    }
+    return out.commit();
+}
+
+int WaveformPyramid::levelCount() const {
+    return offsets.size();
+}
+
+qint64 WaveformPyramid::bucketCount(int level) const {
+    return counts.value(level, 0);
+}
+
+double WaveformPyramid::bucketSeconds(int level) const {
+    return double(bucketFrames) * double(qint64(1) << level) / sampleRate;
+}
+
+const WaveformPyramid::Bucket *WaveformPyramid::buckets(int level) const {
+    if (level < 0 || level >= offsets.size()) return nullptr;
+    return reinterpret_cast<const Bucket *>(mapped + offsets[level]);
+}
+
+double WaveformPyramid::duration() const {
+    return counts.isEmpty() ? 0.0 : counts[0] * bucketSeconds(0);
+}
+
+// ============================================================================
+// WaveformBuilder
+// ============================================================================
+
+// Progress is counted in frames decoded.
+struct WaveformBuilder::Job : BackgroundAnalysis::Job {
+    // Written by the task, read by finishJob() after the task is done.
+    QSharedPointer<WaveformPyramid> result;
+};
+
+// ----------------------------------------------------------------------------
+// BuildTask - Decode Once, Fill Level 0, Write the File
+// ----------------------------------------------------------------------------
+// Audio is decoded as mono; the waveform of a downmix is what people expect
+// to see. Buckets are filled across chunk boundaries, so the decoder's
+// chunk size doesn't matter.
+// ----------------------------------------------------------------------------
+class WaveformBuilder::BuildTask : public Task {
+public:
+    explicit BuildTask(QSharedPointer<Job> job) : Task(job), job(job) {}
+
+private:
+    static qint8 quantize(float v) {
+        return static_cast<qint8>(qBound(-127L, std::lround(v * 127.0f), 127L));
+    }
+
+    void work() override {
+        MediaDecoder decoder;
+        if (!decoder.open(job->path, SampleRate, 1)) {
+            job->fail(decoder.errorString());
+            return;
+        }
+        job->total = static_cast<qint64>(decoder.duration() * SampleRate);
+
+        QVector<WaveformPyramid::Bucket> base;
+        base.reserve(static_cast<int>(job->total / BucketFrames + 1));
+
+        float lo = 1.0f, hi = -1.0f;
+        double sumSquares = 0.0;
+        int filled = 0;
+        bool anchored = false;
+
+        auto flush = [&]() {
+            WaveformPyramid::Bucket b;
+            b.min = quantize(qMin(lo, 0.0f));
+            b.max = quantize(qMax(hi, 0.0f));
+            b.rms = static_cast<quint8>(qMin(255L, std::lround(std::sqrt(sumSquares / filled) * 255.0)));
+            b.reserved = 0;
+            base.append(b);
+            lo = 1.0f;
+            hi = -1.0f;
+            sumSquares = 0.0;
+            filled = 0;
+        };
+
+        QVector<float> buffer;
+        while (!job->cancelled) {
+            buffer.clear();
+            double startTime = 0.0;
+            int frames = decoder.decode(buffer, startTime);
+            if (frames < 0 && base.isEmpty()) {
+                job->fail(decoder.errorString());
+                return;
+            }
+            if (frames <= 0) break;
+
+            // Audio that starts late (common in MKVs cut from broadcasts)
+            // gets silent buckets in front, so times line up with MPV's.
+            if (!anchored) {
+                anchored = true;
+                if (startTime > 0.0) {
+                    qint64 silent = std::llround(startTime * SampleRate) / BucketFrames;
+                    WaveformPyramid::Bucket zero = {0, 0, 0, 0};
+                    base.fill(zero, static_cast<int>(silent));
+                }
+            }
+
+            const float *samples = buffer.constData();
+            int i = 0;
+            while (i < frames) {
+                int take = qMin(frames - i, BucketFrames - filled);
+                SimdKernels::minMaxSumSquares(samples + i, static_cast<size_t>(take), lo, hi, sumSquares);
+                filled += take;
+                i += take;
+                if (filled == BucketFrames) flush();
+            }
+            job->done += frames;
+        }
+        if (job->cancelled) return;
+        if (filled > 0) flush();
+
+        QString cacheFile = AnalysisCache::cacheFile(job->path, "waveform");
+        if (!WaveformPyramid::write(cacheFile, base, SampleRate, BucketFrames)) {
+            job->fail("Can't write the waveform cache");
+            return;
+        }
+        job->result = WaveformPyramid::open(cacheFile);
+        if (!job->result) job->fail("Can't map the waveform cache");
+    }
+
+    QSharedPointer<Job> job;
+};
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+// Two threads: one per player. Each build is a single sequential decode.
+// ----------------------------------------------------------------------------
+WaveformBuilder::WaveformBuilder(QObject *parent) : BackgroundAnalysis(2, parent) {}
+
+// ----------------------------------------------------------------------------
+// build() / forget() / pyramid()
+// ----------------------------------------------------------------------------
+void WaveformBuilder::build(int slot, const QString &path) {
+    cancel(slot);
+
+    QSharedPointer<WaveformPyramid> cached = WaveformPyramid::open(AnalysisCache::cacheFile(path, "waveform"));
+    if (cached) {
+        pyramids[slot] = cached;
+        emit finished(slot);
+        return;
+    }
+
+    if (!MediaDecoder::isAvailable()) {
+        emit failed(slot, "Built without libav");
+        return;
+    }
+
+    QSharedPointer<Job> job(new Job);
+    job->path = path;
+    start(slot, job, new BuildTask(job));
+}
+
+void WaveformBuilder::forget(int slot) {
+    pyramids.remove(slot);
+}
+
+QSharedPointer<WaveformPyramid> WaveformBuilder::pyramid(int slot) const {
+    return pyramids.value(slot);
+}
+
+// ----------------------------------------------------------------------------
+// finishJob() - Hand the Mapped Pyramid Over (GUI Thread)
+// ----------------------------------------------------------------------------
+void WaveformBuilder::finishJob(QSharedPointer<BackgroundAnalysis::Job> done) {
+    QSharedPointer<Job> job = done.staticCast<Job>();
+    if (!job->result) {
+        emit failed(job->slot, job->errorOr("No audio decoded"));
+        return;
+    }
+    pyramids[job->slot] = job->result;
+    emit finished(job->slot);
+}
@@ -0,0 +1,100 @@
+// ============================================================================
+// waveformpyramid.h - Multi-Resolution Waveform Overview
+// ============================================================================
+// To line up a VOD with a movie by eye, each player shows its audio as a
+// waveform (see waveformview.h). The view must be able to show two hours
+// as well as a single second, without ever touching millions of samples
+// while painting. The data is therefore kept as a PYRAMID, like the mipmaps
+// of a texture:
+//
+//   level 0  - one bucket per 256 samples (about 5 ms at 48 kHz)
+//   level 1  - one bucket per 2 level-0 buckets
+//   level 2  - one bucket per 2 level-1 buckets ... down to a single bucket
+//
+// Every bucket stores the minimum, maximum and RMS of its samples. To draw
+// W pixels, the view picks the coarsest level that still has at least one
+// bucket per pixel, so painting costs O(W) at any zoom.
+//
+// The pyramid is built once per file by WaveformBuilder (in a background
+// thread), written to the analysis cache (see analysiscache.h) and then
+// MEMORY-MAPPED: nothing is read into RAM up front, and the OS pages in
+// only the parts that are actually drawn.
+// ============================================================================
+
+#ifndef WAVEFORMPYRAMID_H
+#define WAVEFORMPYRAMID_H
+
+#include "backgroundanalysis.h"
+
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+// ----------------------------------------------------------------------------
+// WaveformPyramid - Read-Only View of One Cache File
+// ----------------------------------------------------------------------------
+class WaveformPyramid {
+public:
+    // One bucket, quantized to 8 bits - plenty for a strip a few dozen
+    // pixels high, and a two-hour file stays around 10 MB.
+    struct Bucket {
+        qint8 min;       // -127..127 = -1.0..1.0
+        qint8 max;
+        quint8 rms;      // 0..255 = 0.0..1.0
+        quint8 reserved;
+    };
+
+    ~WaveformPyramid();
+
+    // Maps an existing cache file. Returns null if it is missing or invalid.
+    static QSharedPointer<WaveformPyramid> open(const QString &cacheFile);
+
+    // Builds the upper levels from `base` (level 0) and writes the file.
+    static bool write(const QString &cacheFile, const QVector<Bucket> &base,
+                      int sampleRate, int bucketFrames);
+
+    int levelCount() const;
+    qint64 bucketCount(int level) const;
+    double bucketSeconds(int level) const;   // Time covered by one bucket.
+    const Bucket *buckets(int level) const;  // Points into the mapped file.
+    double duration() const;
+
+private:
+    WaveformPyramid() = default;
+
+    QFile file;
+    const uchar *mapped = nullptr;
+    int sampleRate = 0;
+    int bucketFrames = 0;
+    QVector<qint64> offsets;                 // Byte offset of each level.
+    QVector<qint64> counts;                  // Buckets in each level.
+};
+
+// ----------------------------------------------------------------------------
+// WaveformBuilder - Builds Pyramids in the Background
+// ----------------------------------------------------------------------------
+// Slots work like LoudnessAnalyzer's: 0 = player 1, 1 = player 2. A cached
+// pyramid is ready at once; otherwise the file is decoded in a pool thread
+// (see backgroundanalysis.h) and finished() follows when the cache file has
+// been written.
+// ----------------------------------------------------------------------------
+class WaveformBuilder : public BackgroundAnalysis {
+    Q_OBJECT
+
+public:
+    explicit WaveformBuilder(QObject *parent = nullptr);
+
+    void build(int slot, const QString &path);
+    QSharedPointer<WaveformPyramid> pyramid(int slot) const;
+
+private:
+    struct Job;
+    class BuildTask;
+
+    void finishJob(QSharedPointer<BackgroundAnalysis::Job> done) override;
+    void forget(int slot) override;
+
+    QHash<int, QSharedPointer<WaveformPyramid>> pyramids;
+};
+
+#endif // WAVEFORMPYRAMID_H
@@ -0,0 +1,183 @@
+// ============================================================================
+// waveformview.cpp - Implementation of WaveformView
+// ============================================================================
+
+#include "waveformview.h"
+#include "waveformpyramid.h"
+#include "mpvwidget.h"           // For the full MpvWidget class definition.
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+
+#include <cmath>
+
+static const double MinSpanSeconds = 1.0;    // Deepest zoom.
+static const double ZoomStep = 1.5;          // Per wheel notch.
+
+// ----------------------------------------------------------------------------
+// Constructor
+// ----------------------------------------------------------------------------
+WaveformView::WaveformView(MpvWidget *player, QWidget *parent)
+    : QWidget(parent), player(player), playhead(0.0), zoomSpan(0.0) {
+
+    setMinimumHeight(40);
+    setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Fixed);
+    setCursor(Qt::PointingHandCursor);
+
+    // Move the playhead on every position change. Repaints are coalesced
+    // by Qt, so this is cheap even at high frame rates.
+    player->observeProperty("time-pos");
+    connect(player, &MpvWidget::propertyChanged, this, [this](const QString &name, const QVariant &value) {
+        if (name != "time-pos") return;
+        playhead = value.toDouble();
+        if (pyramid) update();
+    });
+}
+
+QSize WaveformView::sizeHint() const {
+    return QSize(200, 48);
+}
+
+void WaveformView::setPyramid(QSharedPointer<WaveformPyramid> data) {
+    pyramid = data;
+    message.clear();
+    zoomSpan = 0.0;
+    update();
+}
+
+void WaveformView::setMessage(const QString &text) {
+    pyramid.reset();
+    message = text;
+    update();
+}
+
+void WaveformView::clear() {
+    setMessage(QString());
+}
+
+// ----------------------------------------------------------------------------
+// visibleSpan() / visibleStart()
+// ----------------------------------------------------------------------------
+double WaveformView::visibleSpan() const {
+    double duration = pyramid ? pyramid->duration() : 0.0;
+    if (zoomSpan <= 0.0 || zoomSpan >= duration) return duration;
+    return zoomSpan;
+}
+
+double WaveformView::visibleStart() const {
+    double duration = pyramid ? pyramid->duration() : 0.0;
+    double span = visibleSpan();
+    if (span >= duration) return 0.0;
+    return qBound(0.0, playhead - span / 2.0, duration - span);
+}
+
+// ----------------------------------------------------------------------------
+// paintEvent()
+// ----------------------------------------------------------------------------
+// Picks the coarsest pyramid level whose buckets are still no longer than
+// one pixel, then merges the one or two buckets under each pixel column.
+// The light bar is the peak range, the dark bar the RMS.
+// ----------------------------------------------------------------------------
+void WaveformView::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+
+    const int w = width();
+    const int h = height();
+
+    if (!pyramid || pyramid->duration() <= 0.0 || w <= 0) {
+        if (!message.isEmpty()) {
+            painter.setPen(palette().color(QPalette::PlaceholderText));
+            painter.drawText(rect(), Qt::AlignCenter, message);
+        }
+        return;
+    }
+
+    const double span = visibleSpan();
+    const double start = visibleStart();
+    const double secondsPerPixel = span / w;
+
+    int level = 0;
+    while (level + 1 < pyramid->levelCount() && pyramid->bucketSeconds(level + 1) <= secondsPerPixel) {
+        level++;
+    }
+    const WaveformPyramid::Bucket *buckets = pyramid->buckets(level);
+    const qint64 count = pyramid->bucketCount(level);
+    const double bucketSeconds = pyramid->bucketSeconds(level);
+
+    const double mid = h / 2.0;
+    const double scale = (h / 2.0 - 1.0) / 127.0;
+    const QColor peakColor("#88aadd");
+    const QColor rmsColor("#0055aa");
+
+    for (int x = 0; x < w; x++) {
+        double t0 = start + x * secondsPerPixel;
+        qint64 first = static_cast<qint64>(t0 / bucketSeconds);
+        qint64 last = static_cast<qint64>((t0 + secondsPerPixel) / bucketSeconds);
+        if (first >= count) break;
+        last = qBound(first, last, count - 1);
+
+        int lo = 127, hi = -127;
+        double power = 0.0;
+        for (qint64 i = first; i <= last; i++) {
+            lo = qMin(lo, int(buckets[i].min));
+            hi = qMax(hi, int(buckets[i].max));
+            power += double(buckets[i].rms) * buckets[i].rms;
+        }
+        double rms = std::sqrt(power / double(last - first + 1)) * 127.0 / 255.0;
+
+        painter.setPen(peakColor);
+        painter.drawLine(QPointF(x + 0.5, mid - hi * scale), QPointF(x + 0.5, mid - lo * scale));
+        painter.setPen(rmsColor);
+        painter.drawLine(QPointF(x + 0.5, mid - rms * scale), QPointF(x + 0.5, mid + rms * scale));
+    }
+
+    // Playback position
+    double px = (playhead - start) / secondsPerPixel;
+    if (px >= 0.0 && px <= w) {
+        painter.setPen(QColor("#cc0000"));
+        painter.drawLine(QPointF(px, 0), QPointF(px, h));
+    }
+
+    // Zoom hint, e.g. "30 s" in the corner
+    if (span < pyramid->duration()) {
+        painter.setPen(palette().color(QPalette::Text));
+        QString label = span >= 60.0 ? QString("%1 min").arg(span / 60.0, 0, 'f', 1)
+                                     : QString("%1 s").arg(span, 0, 'f', span < 10.0 ? 1 : 0);
+        painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignRight, label);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Mouse Handling
+// ----------------------------------------------------------------------------
+void WaveformView::wheelEvent(QWheelEvent *event) {
+    if (!pyramid) return;
+
+    double steps = event->angleDelta().y() / 120.0;
+    double span = visibleSpan() / std::pow(ZoomStep, steps);
+    double duration = pyramid->duration();
+
+    zoomSpan = span >= duration ? 0.0 : qMax(MinSpanSeconds, span);
+    update();
+    event->accept();
+}
+
+void WaveformView::mousePressEvent(QMouseEvent *event) {
+    if (!pyramid || event->button() != Qt::LeftButton) return;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)         // QMouseEvent::position() is Qt 6.
+    double x = event->position().x();
+#else
+    double x = event->localPos().x();
+#endif
+    double target = visibleStart() + x * visibleSpan() / qMax(1, width());
+    player->seekAbsolute(target);
+}
+
+void WaveformView::mouseDoubleClickEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton) return;
+    zoomSpan = 0.0;
+    update();
+}
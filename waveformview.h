@@ -0,0 +1,57 @@
+// ============================================================================
+// waveformview.h - Waveform Strip Under Each Player
+// ============================================================================
+// Draws a player's audio from its WaveformPyramid (see waveformpyramid.h),
+// with a red line at the current playback position.
+//
+//   Mouse wheel  - zoom in/out (from the whole file down to one second).
+//                  While zoomed, the view follows the playback position.
+//   Click        - seek THIS player to the clicked time. Handy for lining
+//                  up the VOD with the movie by eye.
+//   Double-click - back to the whole file.
+//
+// Painting only ever reads about one bucket per pixel, so it costs the same
+// at every zoom level, and the data is memory-mapped - nothing here can
+// stall the UI or playback.
+// ============================================================================
+
+#ifndef WAVEFORMVIEW_H
+#define WAVEFORMVIEW_H
+
+#include <QWidget>
+#include <QSharedPointer>
+#include <QString>
+
+class MpvWidget;
+class WaveformPyramid;
+
+class WaveformView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit WaveformView(MpvWidget *player, QWidget *parent = nullptr);
+
+    void setPyramid(QSharedPointer<WaveformPyramid> pyramid);
+    void setMessage(const QString &text);    // Shown while there is no waveform.
+    void clear();                            // No waveform, no message.
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    double visibleSpan() const;              // Seconds across the full width.
+    double visibleStart() const;             // Time at the left edge.
+
+    MpvWidget *player;
+    QSharedPointer<WaveformPyramid> pyramid;
+    QString message;
+    double playhead;                         // Seconds.
+    double zoomSpan;                         // Seconds, or 0 for the whole file.
+};
+
+#endif // WAVEFORMVIEW_H